@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+bench_vision.py
+Micro-benchmarks for the Python side of the pipeline, with per-operation
+perf_event_open counters where the host permits them.
+
+Kernels
+-------
+  classify     - _classify(): the per-frame feature kernel (finger
+                 extension tests + pinch distance + priority ladder)
+  map          - GestureMapper.map(): classify + confirmation + smoothing
+  pen          - PenMapper.map(): depth pressure, tilt and a fractional-pixel
+                 PEN command per frame (main.py --pen)
+  orient       - hand_orientation(): the palm frame from four landmarks
+  gyro         - GyroMapper.map(): orientation + log-map rate estimate +
+                 smoothing and a GYRO command per 30 Hz frame (main.py --gyro)
+  preprocess   - cv2.flip + cv2.cvtColor(BGR→RGB) on a 640×480 frame,
+                 exactly what GestureDetector does before inference
+
+Each kernel runs --reps repetitions; per-rep ns/op and per-op counters
+are written to results/bench_vision.json (see bench/results.py) for
+comparison with bench/compare.py.
+
+Usage
+-----
+    python3 bench/bench_vision.py [--iters N] [--reps R] [--json PATH]
+"""
+
+from __future__ import annotations
+
+import argparse
+import random
+import statistics
+import sys
+import time
+from pathlib import Path
+from typing import Callable, List
+
+sys.path.insert(0, str(Path(__file__).parent.parent))
+sys.path.insert(0, str(Path(__file__).parent))
+
+import results                                              # noqa: E402
+from perf_counters import COUNTERS, PerfCounters            # noqa: E402
+from src.vision.gesture_detector import HandResult, Landmark  # noqa: E402
+from src.vision.gesture_mapper import GestureMapper, _classify  # noqa: E402
+from src.vision.gyro_mapper import GyroMapper, hand_orientation  # noqa: E402
+from src.vision.pen_mapper import PenMapper                   # noqa: E402
+
+
+def _random_hands(n: int, seed: int = 1234) -> List[HandResult]:
+    rng = random.Random(seed)
+    return [
+        HandResult(
+            landmarks=[Landmark(rng.random(), rng.random(), rng.uniform(-0.1, 0.1))
+                       for _ in range(21)],
+            handedness="Right",
+        )
+        for _ in range(n)
+    ]
+
+
+def _bench(name: str, iters: int, reps: int, op: Callable[[int], object]) -> dict:
+    for i in range(min(iters, 1000)):                       # warm-up
+        op(i)
+
+    samples = []
+    totals: dict = {}
+    for _ in range(reps):
+        pc = PerfCounters()
+        with pc:
+            t0 = time.perf_counter()
+            for i in range(iters):
+                op(i)
+            elapsed = time.perf_counter() - t0
+        pc.close()
+        samples.append(elapsed / iters * 1e9)
+        for k, v in pc.values.items():
+            if v is not None:
+                totals[k] = totals.get(k, 0) + v
+
+    row = f"{name:<12} {statistics.median(samples):10.1f}"
+    per_op = {k: totals[k] / (iters * reps) for k in totals}
+    for counter, *_ in COUNTERS:
+        value = per_op.get(counter)
+        row += f" {value:12.3f}" if value is not None else f" {'n/a':>12}"
+    print(row)
+    return results.benchmark(name, "ns/op", samples, **per_op)
+
+
+def main() -> None:
+    p = argparse.ArgumentParser(description="GestureLink vision micro-benchmarks")
+    p.add_argument("--iters", type=int, default=5_000)
+    p.add_argument("--reps",  type=int, default=10)
+    p.add_argument("--json",  type=Path, default=None,
+                   help="result file (default results/bench_vision.json)")
+    args = p.parse_args()
+
+    hands  = _random_hands(256)
+    mapper = GestureMapper()
+    pen    = PenMapper()
+    gyro   = GyroMapper()
+
+    import cv2
+    import numpy as np
+    frame = np.random.default_rng(7).integers(0, 256, (480, 640, 3), dtype=np.uint8)
+
+    def gyro_frame(i: int) -> object:
+        hand = hands[i & 255]
+        hand.timestamp_ms = i * 33.333                      # 30 Hz camera
+        return gyro.map(hand)
+
+    def preprocess(_: int) -> object:
+        return cv2.cvtColor(cv2.flip(frame, 1), cv2.COLOR_BGR2RGB)
+
+    probe = PerfCounters()
+    if not probe.available:
+        print("[bench] perf_event_open unavailable; reporting wall time only.",
+              file=sys.stderr)
+    elif probe.user_only:
+        print("[bench] perf_event_paranoid restricts counting to user space.",
+              file=sys.stderr)
+    probe.close()
+
+    header = f"{'kernel':<12} {'ns/op':>10}"
+    for name, *_ in COUNTERS:
+        header += f" {name:>12}"
+    print(header + f"   (median ns/op of {args.reps} reps; counters per op)")
+
+    benches = [
+        _bench("classify",   args.iters, args.reps, lambda i: _classify(hands[i & 255])),
+        _bench("map",        args.iters, args.reps, lambda i: mapper.map(hands[i & 255])),
+        _bench("pen",        args.iters, args.reps, lambda i: pen.map(hands[i & 255])),
+        _bench("orient",     args.iters, args.reps, lambda i: hand_orientation(hands[i & 255])),
+        _bench("gyro",       args.iters, args.reps, gyro_frame),
+        _bench("preprocess", max(args.iters // 20, 1), args.reps, preprocess),
+    ]
+    path = results.write("bench_vision", benches, args.json)
+    print(f"[bench] results written to {path}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+compare.py
+Compare two benchmark result sets and flag statistically significant
+regressions.
+
+A result set is a results directory (or a single JSON file) in the
+"gesturelink-bench/1" schema written by every benchmark and latency test
+(see bench/results.py).  Benchmarks are matched by "<suite>/<name>".
+
+For each benchmark the per-repetition samples of baseline and candidate
+are compared with a two-sided Mann-Whitney U test (normal approximation
+with tie correction; no SciPy needed).  A benchmark is a REGRESSION when
+it got worse by more than --threshold percent (on --stat) AND p < --alpha.
+
+Usage
+-----
+    cp -r results results-baseline           # before the upgrade
+    ...                                      # upgrade, rebuild, re-run benches
+    python3 bench/compare.py results-baseline results --threshold 5
+
+Exit status: 0 = no regressions, 1 = regressions found, 2 = nothing to compare.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import statistics
+import sys
+from pathlib import Path
+from typing import Dict, List, Sequence, Tuple
+
+sys.path.insert(0, str(Path(__file__).parent))
+
+from results import load   # noqa: E402
+
+_ENV_KEYS = ("cpu_model", "cpu_count", "kernel", "machine", "governor", "compiler", "python")
+
+
+def mann_whitney_p(a: Sequence[float], b: Sequence[float]) -> float:
+    """Two-sided p-value of the Mann-Whitney U test (normal approximation)."""
+    n1, n2 = len(a), len(b)
+    if n1 < 2 or n2 < 2:
+        return float("nan")
+    pooled = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    n = n1 + n2
+
+    rank_sum_a = 0.0
+    tie_term   = 0.0
+    i = 0
+    while i < n:
+        j = i
+        while j + 1 < n and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        avg_rank = (i + j) / 2.0 + 1.0
+        t = j - i + 1
+        tie_term += t ** 3 - t
+        for k in range(i, j + 1):
+            if pooled[k][1] == 0:
+                rank_sum_a += avg_rank
+        i = j + 1
+
+    u  = rank_sum_a - n1 * (n1 + 1) / 2.0
+    mu = n1 * n2 / 2.0
+    var = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+    if var <= 0:
+        return 1.0
+    z = max(abs(u - mu) - 0.5, 0.0) / math.sqrt(var)
+    return math.erfc(z / math.sqrt(2.0))
+
+
+def _stat(samples: Sequence[float], which: str) -> float:
+    if which == "mean":
+        return statistics.fmean(samples)
+    if which == "p99":
+        s = sorted(samples)
+        return s[min(len(s) - 1, int(0.99 * len(s)))]
+    return statistics.median(samples)
+
+
+def compare(base: Dict[str, dict], cand: Dict[str, dict], threshold: float,
+            alpha: float, stat: str) -> List[Tuple[str, float, float, float, float, str]]:
+    rows = []
+    for key in sorted(set(base) & set(cand)):
+        b, c = base[key], cand[key]
+        bs, cs = b.get("samples") or [], c.get("samples") or []
+        if not bs or not cs:
+            continue
+        bv, cv = _stat(bs, stat), _stat(cs, stat)
+        delta = (cv - bv) / bv * 100.0 if bv else 0.0
+        worse = delta if b.get("better", "lower") == "lower" else -delta
+        p = mann_whitney_p(bs, cs)
+        significant = p < alpha if not math.isnan(p) else True
+        if worse > threshold and significant:
+            verdict = "REGRESSION"
+        elif worse < -threshold and significant:
+            verdict = "improved"
+        else:
+            verdict = "~"
+        rows.append((key, bv, cv, delta, p, verdict))
+    return rows
+
+
+def geomean_speedup(base: Dict[str, dict], rows) -> float:
+    """Geometric mean of baseline/candidate (>1 = candidate faster) over @rows."""
+    logs = []
+    for key, bv, cv, *_ in rows:
+        if bv > 0 and cv > 0:
+            ratio = bv / cv if base[key].get("better", "lower") == "lower" else cv / bv
+            logs.append(math.log(ratio))
+    return math.exp(statistics.fmean(logs)) if logs else float("nan")
+
+
+def _env_differences(base: Dict[str, dict], cand: Dict[str, dict]) -> List[str]:
+    diffs = set()
+    for key in set(base) & set(cand):
+        be, ce = base[key].get("env", {}), cand[key].get("env", {})
+        for k in _ENV_KEYS:
+            if k in be and k in ce and be[k] != ce[k]:
+                diffs.add(f"{k}: {be[k]!r} -> {ce[k]!r}")
+    return sorted(diffs)
+
+
+def main(argv: List[str] = None) -> int:
+    p = argparse.ArgumentParser(description="Compare GestureLink benchmark result sets")
+    p.add_argument("baseline",  type=Path, help="baseline results dir or file")
+    p.add_argument("candidate", type=Path, help="candidate results dir or file")
+    p.add_argument("--threshold", type=float, default=5.0,
+                   help="regression threshold in percent (default 5)")
+    p.add_argument("--alpha", type=float, default=0.05,
+                   help="significance level (default 0.05)")
+    p.add_argument("--stat", choices=("median", "mean", "p99"), default="median",
+                   help="statistic compared against --threshold (default median)")
+    p.add_argument("--json", action="store_true", help="print machine-readable output")
+    args = p.parse_args(argv)
+
+    base, cand = load(args.baseline), load(args.candidate)
+    rows = compare(base, cand, args.threshold, args.alpha, args.stat)
+    if not rows:
+        print("[compare] no benchmarks in common", file=sys.stderr)
+        return 2
+
+    regressions = [r for r in rows if r[5] == "REGRESSION"]
+
+    if args.json:
+        print(json.dumps({
+            "threshold_pct": args.threshold, "alpha": args.alpha, "stat": args.stat,
+            "env_differences": _env_differences(base, cand),
+            "geomean_speedup": geomean_speedup(base, rows),
+            "results": [
+                {"benchmark": k, "baseline": bv, "candidate": cv,
+                 "delta_pct": d, "p_value": None if math.isnan(pv) else pv, "verdict": v}
+                for k, bv, cv, d, pv, v in rows
+            ],
+        }, indent=2))
+        return 1 if regressions else 0
+
+    for diff in _env_differences(base, cand):
+        print(f"[compare] WARNING environment differs – {diff}", file=sys.stderr)
+
+    width = max(len(r[0]) for r in rows)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'candidate':>12}  {'delta':>8}  {'p':>8}  verdict")
+    for key, bv, cv, delta, pv, verdict in rows:
+        unit = cand[key].get("unit", "")
+        p_str = "n/a" if math.isnan(pv) else f"{pv:.3g}"
+        print(f"{key:<{width}}  {bv:>12.4g}  {cv:>12.4g}  {delta:>+7.1f}%  {p_str:>8}  {verdict}"
+              f"   [{unit}]")
+
+    only = sorted(set(base) ^ set(cand))
+    if only:
+        print(f"[compare] {len(only)} benchmark(s) present in only one set", file=sys.stderr)
+    print(f"\n{len(regressions)} regression(s) beyond {args.threshold}% "
+          f"({args.stat}, alpha={args.alpha}); geomean speedup "
+          f"{geomean_speedup(base, rows):.3f}x over {len(rows)} benchmark(s)")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
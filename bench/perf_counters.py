@@ -0,0 +1,139 @@
+"""
+perf_counters.py
+perf_event_open(2) counters for the Python-side benchmarks, via ctypes.
+
+Mirrors src/driver/perf_counters.{h,cpp}: every counter is opened on its
+own so an event the host does not expose reads as ``None`` instead of
+failing the set, and kernel-side counting falls back to user-only when
+``perf_event_paranoid`` forbids it (context switches then come from
+``getrusage``).
+
+Note that counts for Python code include interpreter overhead; compare
+them between revisions, not against the C++ driver numbers.
+"""
+
+from __future__ import annotations
+
+import ctypes
+import os
+import platform
+import resource
+import struct
+from typing import Dict, Optional
+
+# ---- perf_event ABI ----------------------------------------------------------
+
+_NR_PERF_EVENT_OPEN = {
+    "x86_64": 298, "aarch64": 241, "i686": 336, "i386": 336, "armv7l": 364,
+}.get(platform.machine())
+
+_PERF_TYPE_HARDWARE = 0
+_PERF_TYPE_SOFTWARE = 1
+_PERF_TYPE_HW_CACHE = 3
+
+_HW_CPU_CYCLES    = 0
+_HW_INSTRUCTIONS  = 1
+_HW_CACHE_MISSES  = 3
+_HW_BRANCH_MISSES = 5
+_SW_CONTEXT_SWITCHES = 3
+_HW_CACHE_L1D_READ_MISS = 0 | (0 << 8) | (1 << 16)
+
+_FORMAT_TOTAL_TIME_ENABLED = 1 << 0
+_FORMAT_TOTAL_TIME_RUNNING = 1 << 1
+
+_FLAG_DISABLED       = 1 << 0
+_FLAG_EXCLUDE_KERNEL = 1 << 5
+_FLAG_EXCLUDE_HV     = 1 << 6
+
+_IOC_ENABLE  = 0x2400
+_IOC_DISABLE = 0x2401
+_IOC_RESET   = 0x2403
+
+_ATTR_SIZE_VER0 = 64
+
+COUNTERS = (
+    ("cycles",           _PERF_TYPE_HARDWARE, _HW_CPU_CYCLES),
+    ("instructions",     _PERF_TYPE_HARDWARE, _HW_INSTRUCTIONS),
+    ("branch-misses",    _PERF_TYPE_HARDWARE, _HW_BRANCH_MISSES),
+    ("L1d-misses",       _PERF_TYPE_HW_CACHE, _HW_CACHE_L1D_READ_MISS),
+    ("LLC-misses",       _PERF_TYPE_HARDWARE, _HW_CACHE_MISSES),
+    ("context-switches", _PERF_TYPE_SOFTWARE, _SW_CONTEXT_SWITCHES),
+)
+
+_libc = ctypes.CDLL(None, use_errno=True)
+
+
+def _attr(type_: int, config: int, exclude_kernel: bool) -> bytes:
+    flags = _FLAG_DISABLED | _FLAG_EXCLUDE_HV
+    if exclude_kernel:
+        flags |= _FLAG_EXCLUDE_KERNEL
+    # type, size, config, sample_period, sample_type, read_format, flags,
+    # wakeup_events, bp_type, config1
+    return struct.pack(
+        "IIQQQQQIIQ", type_, _ATTR_SIZE_VER0, config, 0, 0,
+        _FORMAT_TOTAL_TIME_ENABLED | _FORMAT_TOTAL_TIME_RUNNING,
+        flags, 0, 0, 0,
+    )
+
+
+def _ctx_switches() -> int:
+    ru = resource.getrusage(resource.RUSAGE_THREAD)
+    return ru.ru_nvcsw + ru.ru_nivcsw
+
+
+class PerfCounters:
+    """Context manager measuring the enclosed block on the calling thread."""
+
+    def __init__(self) -> None:
+        self.user_only = False
+        self._fds: Dict[str, int] = {}
+        self._csw0 = 0
+        self.values: Dict[str, Optional[int]] = {name: None for name, *_ in COUNTERS}
+        if _NR_PERF_EVENT_OPEN is None:
+            return
+        for name, type_, config in COUNTERS:
+            fd = self._open(type_, config, self.user_only)
+            if fd < 0 and ctypes.get_errno() in (1, 13) and not self.user_only:
+                self.user_only = True          # EPERM / EACCES → user-only
+                fd = self._open(type_, config, True)
+            if name == "context-switches" and self.user_only and fd >= 0:
+                os.close(fd)                   # would always read 0
+                fd = -1
+            if fd >= 0:
+                self._fds[name] = fd
+
+    @staticmethod
+    def _open(type_: int, config: int, exclude_kernel: bool) -> int:
+        buf = ctypes.create_string_buffer(_attr(type_, config, exclude_kernel))
+        return _libc.syscall(_NR_PERF_EVENT_OPEN, buf, 0, -1, -1, 0)
+
+    @property
+    def available(self) -> bool:
+        return bool(self._fds)
+
+    def __enter__(self) -> "PerfCounters":
+        self._csw0 = _ctx_switches()
+        for fd in self._fds.values():
+            _libc.ioctl(fd, _IOC_RESET, 0)
+            _libc.ioctl(fd, _IOC_ENABLE, 0)
+        return self
+
+    def __exit__(self, *exc) -> None:
+        for fd in self._fds.values():
+            _libc.ioctl(fd, _IOC_DISABLE, 0)
+        for name, fd in self._fds.items():
+            value, enabled, running = struct.unpack("QQQ", os.read(fd, 24))
+            if running:
+                self.values[name] = (
+                    int(value * enabled / running) if running < enabled else value
+                )
+        if self.values["context-switches"] is None:
+            self.values["context-switches"] = _ctx_switches() - self._csw0
+
+    def close(self) -> None:
+        for fd in self._fds.values():
+            os.close(fd)
+        self._fds.clear()
+
+    def per_op(self, ops: int) -> Dict[str, Optional[float]]:
+        return {k: (v / ops if v is not None else None) for k, v in self.values.items()}
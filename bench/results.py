@@ -0,0 +1,140 @@
+"""
+results.py
+Machine-readable benchmark results ("gesturelink-bench/1" schema).
+
+The same schema is written by the native benchmarks and latency tests
+(src/driver/bench_results.{h,cpp}) and read by bench/compare.py:
+
+    {
+      "schema": "gesturelink-bench/1",
+      "suite":  "<suite>",
+      "env":    { host / kernel / cpu / interpreter / git metadata },
+      "benchmarks": [
+        { "name": "...", "unit": "ns/op", "better": "lower",
+          "samples": [ one value per repetition ],
+          "metrics": { extra values, not compared } }
+      ]
+    }
+
+A *result set* is a directory of such files (by default ``results/`` or
+``$GESTURELINK_RESULTS_DIR``); keep a copy of it as a baseline.
+"""
+
+from __future__ import annotations
+
+import json
+import math
+import os
+import platform
+import socket
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional
+
+SCHEMA = "gesturelink-bench/1"
+
+REPO_ROOT = Path(__file__).parent.parent
+
+
+def results_dir() -> Path:
+    return Path(os.environ.get("GESTURELINK_RESULTS_DIR", REPO_ROOT / "results"))
+
+
+def _cpu_model() -> str:
+    try:
+        for line in Path("/proc/cpuinfo").read_text().splitlines():
+            if line.startswith("model name"):
+                return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return platform.processor() or "unknown"
+
+
+def _governor() -> str:
+    try:
+        return Path("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor").read_text().strip()
+    except OSError:
+        return ""
+
+
+def _git_rev() -> str:
+    if "GESTURELINK_GIT_REV" in os.environ:
+        return os.environ["GESTURELINK_GIT_REV"]
+    try:
+        return subprocess.run(
+            ["git", "rev-parse", "--short", "HEAD"], cwd=REPO_ROOT,
+            capture_output=True, text=True, timeout=5,
+        ).stdout.strip() or "unknown"
+    except (OSError, subprocess.SubprocessError):
+        return "unknown"
+
+
+def environment() -> Dict[str, object]:
+    """Metadata describing where and on what a result was produced."""
+    return {
+        "timestamp": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+        "hostname":  socket.gethostname(),
+        "kernel":    platform.release(),
+        "machine":   platform.machine(),
+        "cpu_model": _cpu_model(),
+        "cpu_count": os.cpu_count(),
+        "governor":  _governor(),
+        "python":    platform.python_version(),
+        "git_rev":   _git_rev(),
+    }
+
+
+def benchmark(name: str, unit: str, samples: Iterable[float],
+              better: str = "lower", **metrics: float) -> Dict[str, object]:
+    return {
+        "name": name, "unit": unit, "better": better,
+        "samples": [float(s) for s in samples],
+        "metrics": metrics,
+    }
+
+
+def write(suite: str, benchmarks: List[Dict[str, object]],
+          path: Optional[Path] = None) -> Path:
+    """Write a result file; defaults to results_dir()/<suite>.json."""
+    if path is None:
+        path = results_dir() / f"{suite}.json"
+    path = Path(path)
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_text(json.dumps({
+        "schema": SCHEMA,
+        "suite": suite,
+        "env": environment(),
+        "benchmarks": benchmarks,
+    }, indent=1))
+    return path
+
+
+def load(path: Path) -> Dict[str, Dict[str, object]]:
+    """
+    Load a result file or a directory of them.
+    Returns {"<suite>/<benchmark name>": benchmark dict (plus "env")}.
+    Samples that are not finite numbers (the native writer stores NaN and
+    infinities as null) are dropped with a warning naming the benchmark.
+    """
+    path = Path(path)
+    files = sorted(path.glob("*.json")) if path.is_dir() else [path]
+    out: Dict[str, Dict[str, object]] = {}
+    for f in files:
+        try:
+            doc = json.loads(f.read_text())
+        except (OSError, ValueError):
+            continue
+        if not isinstance(doc, dict) or doc.get("schema") != SCHEMA:
+            continue
+        for b in doc.get("benchmarks", []):
+            key = f"{doc['suite']}/{b['name']}"
+            raw = b.get("samples") or []
+            samples = [float(v) for v in raw if isinstance(v, (int, float))
+                       and not isinstance(v, bool) and math.isfinite(v)]
+            if len(samples) != len(raw):
+                print(f"[results] WARNING {key} in {f}: dropped {len(raw) - len(samples)} "
+                      f"non-numeric sample(s)", file=sys.stderr)
+            out[key] = {**b, "samples": samples, "env": doc.get("env", {})}
+    return out
@@ -0,0 +1,517 @@
+#!/usr/bin/env python3
+"""
+soak.py
+Long-running soak harness: replays landmark and command traffic through the
+full pipeline for hours and fails if resource usage keeps growing.
+
+Pipeline
+--------
+    trace replay → result queue → GestureMapper → command queue
+                 → CommandWriter (main.py) → hid_driver (HID_DRIVER_SINK=null)
+
+Raw command entries in the trace (including unknown and malformed lines)
+skip the mapper and go straight to the command queue, so the driver's
+logging and error paths are soaked too.  The driver writes every frame to
+/dev/null, which needs no /dev/uinput.
+
+Sampling
+--------
+Every --interval seconds, for this process and for the driver:
+RSS and VmData (heap + anonymous mappings) from /proc/<pid>/status, open
+fd count and thread count; for the Python side also
+sys.getallocatedblocks() and the number of gc-tracked objects.
+
+Verdict
+-------
+After discarding the first --warmup fraction of samples, a series "grows"
+when it is rank-correlated with time (Spearman rho >= 0.8) *and* the median
+of its last third exceeds the median of its first third by more than its
+tolerance.  Steps during warm-up, sawtooth GC patterns and noise pass; a
+steady leak fails.  Exit code 1 on growth, a dead driver or a stalled
+pipeline.
+
+Reports
+-------
+    results/soak_timeseries.csv   one row per sample, every series
+    results/soak.json             bench/results.py schema: each series with
+                                  slope/hour, rho, growth and verdict
+
+Traces
+------
+JSON lines, one entry per step:  {"dt": s, "lm": [[x, y, z] * 21]},
+{"dt": s, "cmd": "MOUSE_LEFT"} or {"dt": s} (no hand).  Without --trace a
+deterministic ~11 s gesture script is generated; --record writes it out.
+--commands writes the protocol lines the trace makes the mapper produce
+(on a simulated clock, so the output is reproducible): the driver's PGO
+training input (src/driver/Makefile, ``make pgo``).
+
+Usage
+-----
+    python3 bench/soak.py [--duration 4h] [--interval 10] [--speed 1]
+                          [--trace FILE] [--record FILE] [--commands FILE]
+                          [--driver-bin PATH] [--json PATH] [--csv PATH]
+"""
+
+from __future__ import annotations
+
+import argparse
+import csv
+import gc
+import json
+import math
+import os
+import queue
+import subprocess
+import sys
+import threading
+import time
+from pathlib import Path
+from types import SimpleNamespace
+from typing import Dict, List, Optional, Sequence
+
+sys.path.insert(0, str(Path(__file__).parent.parent))
+sys.path.insert(0, str(Path(__file__).parent))
+
+import results                                                   # noqa: E402
+from main import CommandWriter, map_result                       # noqa: E402
+from src.clock import SimulatedClock                             # noqa: E402
+from src.vision.gesture_detector import HandFrame, HandResult, Landmark  # noqa: E402
+from src.vision.gesture_mapper import GestureMapper              # noqa: E402
+
+DEFAULT_DRIVER = results.REPO_ROOT / "src" / "driver" / "build" / "default" / "hid_driver"
+
+# Series → (unit, absolute tolerance, relative tolerance)
+SERIES = {
+    "py_rss_kb":       ("kB", 2048, 0.05),
+    "py_vm_data_kb":   ("kB", 4096, 0.05),
+    "py_fds":          ("fds", 0, 0.0),
+    "py_threads":      ("threads", 0, 0.0),
+    "py_alloc_blocks": ("blocks", 5000, 0.05),
+    "py_gc_objects":   ("objects", 2000, 0.05),
+    "drv_rss_kb":      ("kB", 512, 0.05),
+    "drv_vm_data_kb":  ("kB", 1024, 0.05),
+    "drv_fds":         ("fds", 0, 0.0),
+    "drv_threads":     ("threads", 0, 0.0),
+}
+COUNTERS = ("frames", "commands", "dropped")
+
+
+# ---- Traffic -----------------------------------------------------------------
+
+_FINGERS = {1: (8, 6, 5), 2: (12, 10, 9), 3: (16, 14, 13), 4: (20, 18, 17)}   # tip, pip, mcp
+
+
+def _pose(extended: Sequence[int], x: float = 0.5, y: float = 0.4,
+          thumb: str = "in") -> List[List[float]]:
+    """21 landmarks with @extended fingers pointing up at (x, y)."""
+    lm = [[0.5, 0.5, 0.0] for _ in range(21)]
+    lm[0] = [0.5, 0.8, 0.0]                                      # wrist
+    for f, (tip, pip, mcp) in _FINGERS.items():
+        fx = x + 0.03 * (f - 1)
+        if f in extended:
+            lm[tip], lm[pip], lm[mcp] = [fx, y, 0.0], [fx, y + 0.1, 0.0], [fx, y + 0.2, 0.0]
+        else:
+            lm[tip], lm[pip], lm[mcp] = [fx, 0.7, 0.0], [fx, 0.6, 0.0], [fx, 0.55, 0.0]
+    if thumb == "pinch":
+        lm[4], lm[3] = [x + 0.02, y, 0.0], [x + 0.05, y + 0.05, 0.0]
+    elif thumb in ("up", "down"):
+        lm[4], lm[3] = [0.2, 0.5 if thumb == "up" else 0.9, 0.0], [0.4, 0.7, 0.0]
+    else:
+        lm[4], lm[3] = [0.5, 0.75, 0.0], [0.45, 0.75, 0.0]
+    return lm
+
+
+def synthetic_trace(fps: float = 60.0) -> List[dict]:
+    """Deterministic gesture script covering every mapper and driver path."""
+    dt  = 1.0 / fps
+    out: List[dict] = []
+
+    def hold(seconds: float, pose_fn) -> None:
+        n = int(seconds * fps)
+        for i in range(n):
+            out.append({"dt": dt, "lm": pose_fn(i / max(1, n - 1))})
+
+    hold(2.0, lambda p: _pose([1], 0.5 + 0.2 * math.cos(2 * math.pi * p),
+                              0.4 + 0.15 * math.sin(2 * math.pi * p)))       # pointer circle
+    hold(0.5, lambda p: _pose([1], thumb="pinch"))                           # left click
+    hold(0.5, lambda p: _pose([1], 0.45))
+    hold(0.5, lambda p: _pose([1, 2]))                                       # right click
+    hold(1.0, lambda p: _pose([1], thumb="up"))                              # scroll up
+    hold(1.0, lambda p: _pose([1], thumb="down"))                            # scroll down
+    hold(1.0, lambda p: _pose([1, 2, 3, 4], thumb="up"))                     # START
+    hold(1.0, lambda p: _pose([]))                                           # fist (A hold)
+    hold(1.0, lambda p: _pose([1, 2, 3], 0.3 + 0.4 * p))                     # stick sweep
+    out.extend({"dt": dt} for _ in range(int(fps)))                          # hand lost
+    for i in range(60):                                                      # raw traffic
+        out.append({"dt": dt / 4, "cmd": f"GAMEPAD_STICK {i * 500 - 15000} {15000 - i * 500}"})
+    out.append({"dt": dt, "cmd": "GAMEPAD_BTN Y 1"})
+    out.append({"dt": dt, "cmd": "GAMEPAD_BTN Y 0"})
+    out.append({"dt": dt, "cmd": "SOAK_UNKNOWN 1 2 3"})
+    out.append({"dt": dt, "cmd": "MOUSE_MOVE not numbers"})
+    out.append({"dt": dt, "cmd": "GAMEPAD_BTN NOPE 1"})
+    hold(1.0, lambda p: _pose([1], 0.5, 0.4))
+    return out
+
+
+def load_trace(path: Path) -> List[dict]:
+    with open(path) as f:
+        return [json.loads(line) for line in f if line.strip()]
+
+
+def save_trace(trace: List[dict], path: Path) -> None:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, "w") as f:
+        for entry in trace:
+            f.write(json.dumps(entry, separators=(",", ":")) + "\n")
+
+
+def command_stream(trace: List[dict]) -> List[str]:
+    """The driver protocol lines one pass over @trace produces, in order."""
+    clock  = SimulatedClock()
+    mapper = GestureMapper(clock=clock)
+    out: List[str] = []
+    for entry in trace:
+        clock.advance(entry.get("dt", 0.0))
+        if "lm" in entry:
+            out.extend(mapper.map(HandResult(landmarks=[Landmark(*p) for p in entry["lm"]],
+                                             handedness=entry.get("hand", "Right"))))
+        elif "cmd" in entry:
+            out.append(entry["cmd"])
+    return out
+
+
+# ---- Pipeline ----------------------------------------------------------------
+
+class Counters:
+    def __init__(self) -> None:
+        self.frames = self.commands = self.dropped = 0
+
+
+class Replayer(threading.Thread):
+    """Loops over the trace at real time × speed until stopped."""
+
+    def __init__(self, trace: List[dict], result_q: queue.Queue, cmd_q: queue.Queue,
+                 counters: Counters, speed: float = 1.0) -> None:
+        super().__init__(name="SoakReplay", daemon=True)
+        self.trace, self.result_q, self.cmd_q = trace, result_q, cmd_q
+        self.counters, self.speed = counters, speed
+        self._stop_event = threading.Event()
+
+    def stop(self) -> None:
+        self._stop_event.set()
+
+    def run(self) -> None:
+        due, frame_id = time.monotonic(), 0
+        while not self._stop_event.is_set():
+            for entry in self.trace:
+                due += entry.get("dt", 0.0) / self.speed
+                delay = due - time.monotonic()
+                if delay > 0 and self._stop_event.wait(delay):
+                    return
+                if "lm" in entry:
+                    hand = HandResult(landmarks=[Landmark(*p) for p in entry["lm"]],
+                                      handedness=entry.get("hand", "Right"))
+                    frame_id += 1
+                    try:
+                        self.result_q.put_nowait(HandFrame(frame_id, [hand]))
+                    except queue.Full:
+                        self.counters.dropped += 1
+                elif "cmd" in entry:
+                    try:
+                        self.cmd_q.put_nowait(entry["cmd"])
+                    except queue.Full:
+                        self.counters.dropped += 1
+
+
+class MapperLoop(threading.Thread):
+    """The main.py loop body: result queue → mapper → command queue."""
+
+    def __init__(self, mapper: GestureMapper, result_q: queue.Queue, cmd_q: queue.Queue,
+                 counters: Counters) -> None:
+        super().__init__(name="SoakMapper", daemon=True)
+        self.mapper, self.result_q, self.cmd_q, self.counters = mapper, result_q, cmd_q, counters
+        self._stop_event = threading.Event()
+
+    def stop(self) -> None:
+        self._stop_event.set()
+
+    def run(self) -> None:
+        while not self._stop_event.is_set():
+            try:
+                frame = self.result_q.get(timeout=0.05)
+            except queue.Empty:
+                continue
+            self.counters.frames += 1
+            for c in map_result(frame, self.mapper, None, pointers=False):
+                try:
+                    self.cmd_q.put_nowait(c)
+                    self.counters.commands += 1
+                except queue.Full:
+                    self.counters.dropped += 1
+
+
+# ---- Sampling ----------------------------------------------------------------
+
+def proc_stats(pid) -> Dict[str, int]:
+    """RSS / VmData (kB), threads and open fds of @pid ("self" or an int)."""
+    out = {"rss_kb": 0, "vm_data_kb": 0, "threads": 0, "fds": 0}
+    try:
+        for line in Path(f"/proc/{pid}/status").read_text().splitlines():
+            key, _, val = line.partition(":")
+            if key == "VmRSS":
+                out["rss_kb"] = int(val.split()[0])
+            elif key == "VmData":
+                out["vm_data_kb"] = int(val.split()[0])
+            elif key == "Threads":
+                out["threads"] = int(val)
+        out["fds"] = len(os.listdir(f"/proc/{pid}/fd"))
+    except (OSError, ValueError):
+        pass
+    return out
+
+
+def sample(t: float, driver_pid: Optional[int], counters: Counters) -> Dict[str, float]:
+    row: Dict[str, float] = {"t_s": round(t, 3)}
+    for k, v in proc_stats("self").items():
+        row[f"py_{k}"] = v
+    row["py_alloc_blocks"] = sys.getallocatedblocks()
+    row["py_gc_objects"]   = len(gc.get_objects())
+    if driver_pid is not None:
+        for k, v in proc_stats(driver_pid).items():
+            row[f"drv_{k}"] = v
+    row["frames"], row["commands"], row["dropped"] = (
+        counters.frames, counters.commands, counters.dropped)
+    return row
+
+
+# ---- Growth analysis ---------------------------------------------------------
+
+def _ranks(values: Sequence[float]) -> List[float]:
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    ranks = [0.0] * len(values)
+    i = 0
+    while i < len(order):
+        j = i
+        while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[order[k]] = (i + j) / 2.0
+        i = j + 1
+    return ranks
+
+
+def spearman(xs: Sequence[float], ys: Sequence[float]) -> float:
+    """Rank correlation; 0 when either series is constant."""
+    rx, ry = _ranks(xs), _ranks(ys)
+    n  = len(rx)
+    mx, my = sum(rx) / n, sum(ry) / n
+    cov = sum((a - mx) * (b - my) for a, b in zip(rx, ry))
+    vx  = sum((a - mx) ** 2 for a in rx)
+    vy  = sum((b - my) ** 2 for b in ry)
+    return cov / math.sqrt(vx * vy) if vx > 0 and vy > 0 else 0.0
+
+
+def _median(values: Sequence[float]) -> float:
+    s = sorted(values)
+    n = len(s)
+    return s[n // 2] if n % 2 else (s[n // 2 - 1] + s[n // 2]) / 2.0
+
+
+def analyse(ts: Sequence[float], values: Sequence[float], abs_tol: float, rel_tol: float,
+            warmup: float = 0.2, rho_min: float = 0.8) -> Dict[str, float]:
+    """Growth verdict for one series (see module docstring)."""
+    start = int(len(values) * warmup)
+    ts, values = list(ts[start:]), list(values[start:])
+    if len(values) < 6:
+        return {"leak": 0, "rho": 0.0, "growth": 0.0, "slope_per_hour": 0.0, "tolerance": abs_tol}
+    third = len(values) // 3
+    base  = _median(values[:third])
+    growth = _median(values[-third:]) - base
+    rho    = spearman(ts, values)
+    mt, mv = sum(ts) / len(ts), sum(values) / len(values)
+    var_t  = sum((t - mt) ** 2 for t in ts)
+    slope  = sum((t - mt) * (v - mv) for t, v in zip(ts, values)) / var_t if var_t else 0.0
+    tol    = max(abs_tol, rel_tol * abs(base))
+    return {"leak": int(rho >= rho_min and growth > tol), "rho": round(rho, 3),
+            "growth": growth, "slope_per_hour": slope * 3600.0, "tolerance": tol}
+
+
+# ---- Driver ------------------------------------------------------------------
+
+def start_driver(driver_bin: Path, verbose: bool) -> subprocess.Popen:
+    env = dict(os.environ, HID_DRIVER_SINK="null")
+    out = None if verbose else subprocess.DEVNULL
+    return subprocess.Popen([str(driver_bin), "1920", "1080"], stdin=subprocess.PIPE,
+                            stdout=out, stderr=out, env=env)
+
+
+def stop_driver(proc: subprocess.Popen) -> int:
+    try:
+        proc.stdin.write(b"QUIT\n")
+        proc.stdin.flush()
+        proc.stdin.close()
+    except OSError:
+        pass
+    try:
+        return proc.wait(timeout=5)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+        return proc.wait()
+
+
+# ---- Run ---------------------------------------------------------------------
+
+def soak(trace: List[dict], duration: float, interval: float, speed: float = 1.0,
+         driver_bin: Optional[Path] = DEFAULT_DRIVER, verbose: bool = False) -> List[Dict[str, float]]:
+    """Run the pipeline for @duration seconds; return the sampled time series."""
+    counters = Counters()
+    result_q: queue.Queue = queue.Queue(maxsize=8)
+    cmd_q:    queue.Queue = queue.Queue(maxsize=32)
+
+    driver = start_driver(driver_bin, verbose) if driver_bin else None
+    devnull = None
+    if driver is None:                          # Python side only: write into /dev/null
+        devnull = open(os.devnull, "wb")
+    writer = CommandWriter(cmd_q, driver or SimpleNamespace(stdin=devnull))
+    mapper = MapperLoop(GestureMapper(), result_q, cmd_q, counters)
+    replay = Replayer(trace, result_q, cmd_q, counters, speed)
+
+    rows: List[Dict[str, float]] = []
+    t0 = time.monotonic()
+    writer.start()
+    mapper.start()
+    replay.start()
+    try:
+        next_t = t0
+        while True:
+            now = time.monotonic()
+            if now - t0 > duration:
+                break
+            rows.append(sample(now - t0, driver.pid if driver else None, counters))
+            if driver is not None and driver.poll() is not None:
+                print(f"[soak] hid_driver exited with {driver.returncode}", file=sys.stderr)
+                break
+            next_t += interval
+            time.sleep(max(0.0, next_t - time.monotonic()))
+    finally:
+        replay.stop()
+        mapper.stop()
+        replay.join(timeout=2)
+        mapper.join(timeout=2)
+        while not cmd_q.empty() and writer.is_alive():
+            time.sleep(0.01)
+        writer.stop()
+        writer.join(timeout=2)
+        if devnull is not None:
+            devnull.close()
+        if driver is not None:
+            rc = stop_driver(driver)
+            if rows:
+                rows[-1]["driver_rc"] = rc
+    return rows
+
+
+def verdicts(rows: List[Dict[str, float]], warmup: float) -> Dict[str, Dict[str, float]]:
+    ts = [r["t_s"] for r in rows]
+    out = {}
+    for name, (_, abs_tol, rel_tol) in SERIES.items():
+        if rows and name in rows[0]:
+            out[name] = analyse(ts, [r.get(name, 0) for r in rows], abs_tol, rel_tol, warmup)
+    return out
+
+
+def write_csv(rows: List[Dict[str, float]], path: Path) -> Path:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    cols = ["t_s"] + [s for s in SERIES if rows and s in rows[0]] + list(COUNTERS)
+    with open(path, "w", newline="") as f:
+        w = csv.DictWriter(f, fieldnames=cols, extrasaction="ignore")
+        w.writeheader()
+        w.writerows(rows)
+    return path
+
+
+def write_json(rows: List[Dict[str, float]], verdict: Dict[str, Dict[str, float]],
+               path: Optional[Path]) -> Path:
+    benches = [results.benchmark(name, SERIES[name][0], [r.get(name, 0) for r in rows], **v)
+               for name, v in verdict.items()]
+    return results.write("soak", benches, path)
+
+
+def _parse_duration(s: str) -> float:
+    mult = {"s": 1, "m": 60, "h": 3600}
+    return float(s[:-1]) * mult[s[-1]] if s and s[-1] in mult else float(s)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    p = argparse.ArgumentParser(description="GestureLink soak harness")
+    p.add_argument("--duration", type=_parse_duration, default=3600.0,
+                   help="run time, e.g. 900, 30m, 4h (default 1h)")
+    p.add_argument("--interval", type=float, default=10.0, help="sampling interval (s)")
+    p.add_argument("--speed",    type=float, default=1.0, help="replay speed multiplier")
+    p.add_argument("--warmup",   type=float, default=0.2,
+                   help="fraction of samples ignored by the growth check")
+    p.add_argument("--trace",    type=Path, help="replay this JSONL trace")
+    p.add_argument("--record",   type=Path, help="write the synthetic trace here and exit")
+    p.add_argument("--commands", type=Path,
+                   help="write the command stream the trace produces here and exit")
+    p.add_argument("--driver-bin", type=Path, default=DEFAULT_DRIVER)
+    p.add_argument("--no-driver", action="store_true", help="soak the Python side only")
+    p.add_argument("--verbose",  action="store_true", help="show driver output")
+    p.add_argument("--json",     type=Path, default=None)
+    p.add_argument("--csv",      type=Path, default=None)
+    args = p.parse_args(argv)
+
+    trace = load_trace(args.trace) if args.trace else synthetic_trace()
+    if args.record:
+        save_trace(trace, args.record)
+        print(f"[soak] {len(trace)} entries written to {args.record}")
+        return 0
+    if args.commands:
+        lines = command_stream(trace)
+        args.commands.parent.mkdir(parents=True, exist_ok=True)
+        source = args.trace or "the built-in script"
+        args.commands.write_text(f"# gesturelink command trace: {len(lines)} commands from {source}\n"
+                                 + "".join(c + "\n" for c in lines))
+        print(f"[soak] {len(lines)} commands written to {args.commands}")
+        return 0
+
+    driver_bin = None if args.no_driver else args.driver_bin
+    if driver_bin is not None and not driver_bin.exists():
+        print(f"[soak] driver binary not found at {driver_bin}; build it with "
+              f"'make -C src/driver' or pass --no-driver", file=sys.stderr)
+        return 2
+
+    print(f"[soak] {args.duration:.0f} s, sampling every {args.interval} s, "
+          f"{len(trace)}-entry trace at {args.speed}x", file=sys.stderr)
+    rows = soak(trace, args.duration, args.interval, args.speed, driver_bin, args.verbose)
+    verdict = verdicts(rows, args.warmup)
+
+    csv_path  = write_csv(rows, args.csv or results.results_dir() / "soak_timeseries.csv")
+    json_path = write_json(rows, verdict, args.json)
+
+    failed = []
+    print(f"{'series':<17}{'first':>12}{'last':>12}{'growth':>12}{'tol':>10}{'rho':>7}  verdict")
+    for name, v in verdict.items():
+        first, last = rows[0].get(name, 0), rows[-1].get(name, 0)
+        flag = "GROWING" if v["leak"] else "ok"
+        print(f"{name:<17}{first:>12}{last:>12}{v['growth']:>12.0f}{v['tolerance']:>10.0f}"
+              f"{v['rho']:>7.2f}  {flag}")
+        if v["leak"]:
+            failed.append(name)
+
+    frames = rows[-1]["frames"] if rows else 0
+    if frames == 0:
+        failed.append("pipeline stalled (no frames mapped)")
+    if rows and rows[-1].get("driver_rc", 0) != 0:
+        failed.append(f"hid_driver exit code {rows[-1]['driver_rc']}")
+
+    print(f"[soak] {frames} frames, {rows[-1]['commands'] if rows else 0} commands, "
+          f"{rows[-1]['dropped'] if rows else 0} dropped; reports: {csv_path}, {json_path}")
+    if failed:
+        print("[soak] FAILED: " + ", ".join(failed), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
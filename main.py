@@ -18,7 +18,28 @@ Options
     --preview           Show a live annotated camera preview window
     --no-driver         Print commands to stdout instead of piping to hid_driver
                         (useful for testing without /dev/uinput access)
-    --driver-bin PATH   Path to hid_driver binary (default: src/driver/hid_driver)
+    --driver-bin PATH   Path to hid_driver binary (default: src/driver/build/default/hid_driver)
+    --metrics ADDR      Serve Prometheus metrics on unix:/path or a loopback port
+                        (default: $GESTURELINK_METRICS; the driver reads
+                        $HID_DRIVER_METRICS for its own endpoint)
+    --warm-start        Load the landmarker, open the camera and start the driver
+                        concurrently, run a dummy inference, and only report
+                        ready once everything is hot
+    --startup-report PATH
+                        Print the startup timeline and write it as JSON to PATH
+    --idle-after SEC    Enter low-power idle after SEC seconds without a hand
+                        (default: 10, 0 disables)
+    --idle-fps FPS      Camera rate while idle (default: 5)
+    --pen               Drive the virtual pen tablet (position, depth pressure,
+                        tilt) instead of the gesture → mouse/gamepad mapping
+    --inertia FRICTION  Let a flicked cursor coast after pointing ends, slowing
+                        by FRICTION per second (e.g. 4; default 0 = off)
+    --turbo HZ          Autofire gamepad A at HZ (1-60) while the fist is held,
+                        timed by the driver (default 0 = hold A)
+    --pointers          One independent cursor per hand (left → pointer 0, right
+                        → pointer 1, pinch clicks) on the driver's virtual pointers
+    --gyro              Also drive the virtual motion sensor from the palm's
+                        rotation (gyro aiming), upsampled by the driver
 """
 
 from __future__ import annotations
@@ -46,9 +67,33 @@ import cv2
 # Allow running from repo root
 sys.path.insert(0, str(Path(__file__).parent))
 
-from src.vision.gesture_detector import GestureDetector
+from src.vision.gesture_detector import GestureDetector, HandFrame
 from src.vision.gesture_mapper import GestureMapper
+from src.vision.gyro_mapper import GyroMapper
+from src.vision.pen_mapper import PenMapper
+from src.vision.pointer_mapper import PointerMapper
 from src.vision.hud_overlay import HudOverlay
+from src import metrics
+from src.feedback import FeedbackReader, RumbleState
+from src.idle import IDLE_FPS, IdleController
+from src.startup import StartupTimeline, run_concurrently
+
+M_GESTURES  = metrics.counter("gesturelink_gestures_total", "Hand results mapped to commands.")
+M_COMMANDS  = metrics.counter("gesturelink_commands_total", "Commands produced, by type.")
+M_DROPPED   = metrics.counter("gesturelink_commands_dropped_total", "Commands dropped, by reason.")
+M_QUEUE     = metrics.gauge("gesturelink_queue_depth", "Items waiting in pipeline queues.")
+M_DRIVER_UP = metrics.gauge("gesturelink_driver_up", "1 while the hid_driver subprocess runs.")
+M_MAP_LAG   = metrics.histogram("gesturelink_detect_to_map_seconds",
+                                "Hand result creation to command mapping (incl. queue wait).")
+M_WRITE     = metrics.histogram("gesturelink_driver_write_seconds",
+                                "Time to write one command into the driver pipe.")
+M_IDLE      = metrics.gauge("gesturelink_idle", "1 while in low-power idle (no hand seen).")
+M_WAKE      = metrics.histogram("gesturelink_idle_wake_seconds",
+                                "Idle frame with a hand to first full-rate result.")
+M_RUMBLE    = metrics.gauge("gesturelink_rumble_active",
+                            "Rumble effects a game is playing on the virtual gamepad.")
+
+DRIVER_READY_TIMEOUT_S = 5.0
 
 
 def parse_args() -> argparse.Namespace:
@@ -67,9 +112,37 @@ def parse_args() -> argparse.Namespace:
                    help="Disable the live preview window")
     p.add_argument("--no-driver",  action="store_true",
                    help="Print commands to stdout instead of piping to hid_driver")
-    p.add_argument("--driver-bin", default="src/driver/hid_driver",
+    p.add_argument("--driver-bin", default="src/driver/build/default/hid_driver",
                    help="Path to compiled hid_driver binary")
-    return p.parse_args()
+    p.add_argument("--metrics",    default=os.environ.get("GESTURELINK_METRICS"),
+                   help="Serve Prometheus metrics on unix:/path or [127.0.0.1:]port")
+    p.add_argument("--warm-start", action="store_true",
+                   help="Initialise landmarker, camera and driver concurrently and "
+                        "warm them up before reporting ready")
+    p.add_argument("--startup-report", metavar="PATH", type=Path,
+                   help="Print the startup timeline and write it as JSON to PATH")
+    p.add_argument("--idle-after", type=float, default=10.0, metavar="SEC",
+                   help="Seconds without a hand before low-power idle (0 disables)")
+    p.add_argument("--idle-fps",   type=float, default=IDLE_FPS,
+                   help="Camera frame rate while idle")
+    p.add_argument("--pen",        action="store_true",
+                   help="Map the index fingertip to the virtual pen tablet")
+    p.add_argument("--inertia",    type=float, default=0.0, metavar="FRICTION",
+                   help="Flick inertia: velocity decay per second (0 disables)")
+    p.add_argument("--turbo",      type=int, default=0, metavar="HZ",
+                   help="Autofire gamepad A at HZ while the fist is held (0 = hold)")
+    p.add_argument("--pointers",   action="store_true",
+                   help="Two-hand control: one virtual pointer per hand")
+    p.add_argument("--gyro",       action="store_true",
+                   help="Send palm rotation rates to the virtual motion sensor")
+    args = p.parse_args()
+    if args.pen and args.pointers:
+        p.error("--pen and --pointers are exclusive")
+    if args.gyro and args.pointers:
+        p.error("--gyro and --pointers are exclusive")
+    if not 0 <= args.turbo <= 60:
+        p.error("--turbo must be between 1 and 60 Hz (0 disables)")
+    return args
 
 
 # --------------------------------------------------------------------------- #
@@ -83,19 +156,20 @@ class CommandWriter(threading.Thread):
         self.cmd_q   = cmd_q
         self.dest    = dest      # subprocess.Popen or None (dry-run → stdout)
         self.dry_run = dry_run
-        self._stop   = threading.Event()
+        self._stop_event = threading.Event()
 
     def stop(self) -> None:
-        self._stop.set()
+        self._stop_event.set()
 
     def run(self) -> None:
-        while not self._stop.is_set():
+        while not self._stop_event.is_set():
             try:
-                cmd: str = self.cmd_q.get(timeout=0.05)
+                cmd: str = self.cmd_q.get(timeout=0.25)
             except queue.Empty:
                 continue
 
             line = cmd + "\n"
+            t0 = time.monotonic()
             try:
                 if self.dry_run or self.dest is None:
                     sys.stdout.write(line)
@@ -104,51 +178,199 @@ class CommandWriter(threading.Thread):
                     self.dest.stdin.write(line.encode())
                     self.dest.stdin.flush()
             except (BrokenPipeError, OSError):
+                M_DROPPED.inc(reason="driver_pipe")
                 break
+            M_WRITE.observe(time.monotonic() - t0)
+
+
+# --------------------------------------------------------------------------- #
+#  Driver subprocess                                                           #
+# --------------------------------------------------------------------------- #
+def spawn_driver(cmd: list, timeline: StartupTimeline, env: dict | None = None,
+                 pass_fds: tuple = ()) -> tuple[subprocess.Popen, threading.Event]:
+    """
+    Start hid_driver and forward its stderr.  The returned event is set once
+    the driver prints its Ready line; the time to get there (and the
+    UI_DEV_CREATE timings it reports) is added to @timeline as "driver_start".
+    """
+    start = timeline.now()
+    proc  = subprocess.Popen(cmd, stdin=subprocess.PIPE, stderr=subprocess.PIPE, env=env,
+                             pass_fds=pass_fds)
+    ready = threading.Event()
+
+    def _forward() -> None:
+        for raw in proc.stderr:
+            line = raw.decode(errors="replace")
+            if not ready.is_set() and "Ready." in line:
+                detail = line[line.find("(") + 1:line.rfind(")")] if "(" in line else ""
+                timeline.add("driver_start", start, timeline.now(), "hid_driver", detail)
+                ready.set()
+            sys.stderr.write(line)
+            sys.stderr.flush()
+
+    threading.Thread(target=_forward, name="DriverStderr", daemon=True).start()
+    return proc, ready
+
+
+def start_driver(args: argparse.Namespace, timeline: StartupTimeline,
+                 rumble: RumbleState | None = None) -> tuple[subprocess.Popen, threading.Event]:
+    """Start the driver; with @rumble, its force-feedback back-channel feeds it."""
+    driver_bin = Path(args.driver_bin)
+    if not driver_bin.exists():
+        print(
+            f"[main] Driver binary not found at '{driver_bin}'.\n"
+            f"       Build it first:  cd src/driver && make\n"
+            f"       Or use --no-driver to print commands instead.",
+            file=sys.stderr,
+        )
+        sys.exit(1)
+
+    cmd = [str(driver_bin), str(args.width), str(args.height)]
+    env = dict(os.environ)
+    if args.inertia > 0:
+        env["HID_DRIVER_INERTIA_FRICTION"] = str(args.inertia)
+    if rumble is None:
+        driver_proc, ready = spawn_driver(cmd, timeline, env=env)
+    else:
+        read_fd, write_fd = os.pipe()
+        env["HID_DRIVER_FEEDBACK_FD"] = str(write_fd)
+        try:
+            driver_proc, ready = spawn_driver(cmd, timeline, env=env, pass_fds=(write_fd,))
+        finally:
+            os.close(write_fd)                  # the driver holds the only write end
+        FeedbackReader(read_fd, rumble).start()
+        M_RUMBLE.set_function(rumble.active)
+    print(f"[main] Started hid_driver (PID {driver_proc.pid})", file=sys.stderr)
+    M_DRIVER_UP.set_function(lambda: driver_proc.poll() is None)
+    return driver_proc, ready
+
+
+def warm_start(args: argparse.Namespace, detector: GestureDetector,
+               timeline: StartupTimeline, rumble: RumbleState | None = None) -> subprocess.Popen | None:
+    """
+    Bring up landmarker (+ dummy inference), camera and driver concurrently.
+    Returns the driver process once all of them are hot; exits on failure.
+    """
+    spawned: list = []
+
+    def _driver() -> subprocess.Popen:
+        proc, ready = start_driver(args, timeline, rumble)
+        spawned.append(proc)
+        if not ready.wait(DRIVER_READY_TIMEOUT_S):
+            raise RuntimeError(f"hid_driver not ready after {DRIVER_READY_TIMEOUT_S:.0f} s")
+        return proc
+
+    tasks = {"landmarker": detector.warm_up, "camera": detector.open_camera}
+    if not args.no_driver:
+        tasks["driver"] = _driver
+    try:
+        hot = run_concurrently(tasks, timeline)
+    except Exception as e:
+        print(f"[main] Warm start failed: {e}", file=sys.stderr)
+        for proc in spawned:
+            proc.kill()
+        sys.exit(1)
+    return hot.get("driver")
+
+
+def send_power(cmd_q: queue.Queue, idle: IdleController) -> None:
+    """Tell the driver to put its timers to sleep, or to wake them up."""
+    if idle.idle:
+        print(f"[main] No hand for {idle.idle_after_s:g} s – idling "
+              f"(camera {idle.idle_size[0]}x{idle.idle_size[1]} @ {idle.idle_fps:g} fps, "
+              f"preview and HUD paused).", file=sys.stderr)
+    try:
+        cmd_q.put_nowait("POWER IDLE" if idle.idle else "POWER ACTIVE")
+    except queue.Full:
+        M_DROPPED.inc(reason="queue_full")
+
+
+def map_result(result: HandFrame | None, mapper, gyro: GyroMapper | None,
+               pointers: bool) -> list[str]:
+    """
+    Commands for one detector result.  Only a processed frame without a hand
+    releases what the hand held; no result at all (a slow or idle-throttled
+    detector) maps to nothing.
+    """
+    if result is None:
+        return []
+    if not result.hands:
+        return mapper.lost() + (gyro.lost() if gyro else [])
+    if pointers:
+        # Every hand of the frame goes into the same POINTER line.
+        return mapper.map_frame(result.hands)
+    hand = result.hands[0]
+    return mapper.map(hand) + (gyro.map(hand) if gyro else [])
+
+
+def report_startup(timeline: StartupTimeline, path: Path | None) -> None:
+    if "first_command" in timeline.marks:
+        print(f"[main] First command {timeline.marks['first_command'] * 1e3:.0f} ms "
+              f"after launch.", file=sys.stderr)
+    else:
+        print(f"[main] No command produced in {timeline.now() * 1e3:.0f} ms.", file=sys.stderr)
+    if path is not None:
+        print(timeline.report(), file=sys.stderr)
+        timeline.write(path)
+        print(f"[main] Startup timeline written to {path}", file=sys.stderr)
 
 
 # --------------------------------------------------------------------------- #
 #  Main                                                                        #
 # --------------------------------------------------------------------------- #
 def main() -> None:
+    timeline = StartupTimeline()
+    timeline.add("interpreter+imports", 0.0, timeline.now())
     args = parse_args()
 
-    # ---- Start C++ driver subprocess ----------------------------------------
-    driver_proc: subprocess.Popen | None = None
-    if not args.no_driver:
-        driver_bin = Path(args.driver_bin)
-        if not driver_bin.exists():
-            print(
-                f"[main] Driver binary not found at '{driver_bin}'.\n"
-                f"       Build it first:  cd src/driver && make\n"
-                f"       Or use --no-driver to print commands instead.",
-                file=sys.stderr,
-            )
-            sys.exit(1)
-
-        driver_proc = subprocess.Popen(
-            [str(driver_bin), str(args.width), str(args.height)],
-            stdin=subprocess.PIPE,
-            stderr=sys.stderr,
-        )
-        print(f"[main] Started hid_driver (PID {driver_proc.pid})", file=sys.stderr)
-    else:
-        print("[main] --no-driver: commands will be printed to stdout.", file=sys.stderr)
-
     # ---- Gesture detection pipeline -----------------------------------------
     result_q: queue.Queue = queue.Queue(maxsize=8)
     cmd_q:    queue.Queue = queue.Queue(maxsize=32)
 
+    idle = IdleController(idle_after_s=args.idle_after, idle_fps=args.idle_fps)
     detector = GestureDetector(
         camera_index=args.camera,
-        max_hands=1,
+        max_hands=2 if args.pointers else 1,
         output_queue=result_q,
         frame_width=640,
         frame_height=480,
+        timeline=timeline,
+        idle=idle,
     )
-    mapper = GestureMapper(screen_w=args.width, screen_h=args.height)
-    writer = CommandWriter(cmd_q, driver_proc, dry_run=args.no_driver)
+    if args.pen:
+        mapper = PenMapper(screen_w=args.width, screen_h=args.height)
+    elif args.pointers:
+        mapper = PointerMapper(screen_w=args.width, screen_h=args.height)
+    else:
+        mapper = GestureMapper(screen_w=args.width, screen_h=args.height, turbo_hz=args.turbo)
+    gyro   = GyroMapper() if args.gyro else None
     hud    = HudOverlay()
+    rumble = RumbleState()
+
+    # ---- Start C++ driver subprocess (concurrently with the rest if warm) ----
+    driver_proc: subprocess.Popen | None = None
+    if args.warm_start:
+        driver_proc = warm_start(args, detector, timeline, rumble)
+        timeline.mark("ready")
+        print(f"[main] Warm start: everything hot after "
+              f"{timeline.marks['ready'] * 1e3:.0f} ms.", file=sys.stderr)
+    elif not args.no_driver:
+        driver_proc, _ = start_driver(args, timeline, rumble)
+    if args.no_driver:
+        print("[main] --no-driver: commands will be printed to stdout.", file=sys.stderr)
+
+    writer = CommandWriter(cmd_q, driver_proc, dry_run=args.no_driver)
+
+    M_QUEUE.set_function(result_q.qsize, queue="result")
+    M_QUEUE.set_function(cmd_q.qsize,    queue="command")
+    M_IDLE.set_function(lambda: idle.idle)
+    exporter = None
+    if args.metrics:
+        try:
+            exporter = metrics.serve(args.metrics)
+            print(f"[main] Metrics on {args.metrics}", file=sys.stderr)
+        except (OSError, ValueError) as e:
+            print(f"[main] Cannot serve metrics on {args.metrics!r}: {e}", file=sys.stderr)
 
     # ---- Graceful shutdown ---------------------------------------------------
     shutdown = threading.Event()
@@ -168,6 +390,8 @@ def main() -> None:
     fps_count = 0
 
     preview_ok = args.preview  # may be disabled on first failure
+    power      = idle.state    # last state sent to the driver
+    woken      = 0             # idle periods whose wake has been reported
 
     print("[main] Pipeline running. Press Ctrl+C to stop.", file=sys.stderr)
     if preview_ok:
@@ -178,13 +402,37 @@ def main() -> None:
         while not shutdown.is_set():
             # Drain detector queue → mapper → command queue
             try:
-                hand = result_q.get(timeout=0.05)
+                result = result_q.get(timeout=0.5 if idle.idle else 0.05)
             except queue.Empty:
+                result = None               # slow or throttled detector, not a lost hand
+            hand = result.hands[0] if result is not None and result.hands else None
+
+            # The detector flips the state before publishing the waking hand,
+            # so POWER ACTIVE always reaches the driver ahead of its commands.
+            if idle.state != power:
+                power = idle.state
+                send_power(cmd_q, idle)
+            if woken < len(idle.periods) and idle.periods[woken].wake_latency is not None:
+                print(f"[main] {idle.periods[woken].summary()}", file=sys.stderr)
+                M_WAKE.observe(idle.periods[woken].wake_latency)
+                woken += 1
+
+            if hand is None:
+                for c in map_result(result, mapper, gyro, args.pointers):
+                    try:
+                        cmd_q.put_nowait(c)
+                    except queue.Full:
+                        M_DROPPED.inc(reason="queue_full")
+                if idle.idle:
+                    # Preview and HUD are paused; only keep the window responsive
+                    if preview_ok and cv2.waitKey(1) & 0xFF == ord("q"):
+                        shutdown.set()
+                    continue
                 # Even without a hand, keep the preview alive
                 if preview_ok:
                     frame = detector.latest_frame()
                     if frame is not None:
-                        hud.update(None, [])
+                        hud.update(None, [], rumble.intensity())
                         hud.draw(frame)
                         try:
                             cv2.imshow("GestureLink Preview", frame)
@@ -194,15 +442,21 @@ def main() -> None:
                             shutdown.set()
                 continue
 
-            cmds = mapper.map(hand)
+            M_MAP_LAG.observe(time.monotonic() - result.timestamp_ms / 1000.0)
+            cmds = map_result(result, mapper, gyro, args.pointers)
+            M_GESTURES.inc()
+            if cmds and "first_command" not in timeline.marks:
+                timeline.mark("first_command")
+                report_startup(timeline, args.startup_report)
             for c in cmds:
+                M_COMMANDS.inc(command=c.split(" ", 1)[0])
                 try:
                     cmd_q.put_nowait(c)
                 except queue.Full:
-                    pass  # Drop if writer can't keep up
+                    M_DROPPED.inc(reason="queue_full")  # Drop if writer can't keep up
 
             # Update the HUD with latest gesture & commands
-            hud.update(hand, cmds)
+            hud.update(hand, cmds, rumble.intensity())
 
             fps_count += 1
             elapsed = time.monotonic() - fps_t0
@@ -226,8 +480,14 @@ def main() -> None:
                         shutdown.set()
 
     finally:
+        if args.startup_report is not None and "first_command" not in timeline.marks:
+            report_startup(timeline, args.startup_report)
+        if idle.idle:
+            print(f"[main] {idle.in_progress().summary()}", file=sys.stderr)
         detector.stop()
         writer.stop()
+        if exporter is not None:
+            exporter.close()
         if preview_ok:
             cv2.destroyAllWindows()
         if driver_proc is not None:
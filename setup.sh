@@ -124,7 +124,7 @@ fi
 cd src/driver
 make clean && make
 cd ../..
-echo "  Driver built: src/driver/hid_driver"
+echo "  Driver built: src/driver/build/default/hid_driver"
 
 # ---- 4. Python dependencies ---------------------------------------------------
 echo "[4/6] Installing Python dependencies..."
@@ -153,7 +153,7 @@ echo "  (no camera or /dev/uinput access required)"
 # ---- 6. Summary ---------------------------------------------------------------
 echo ""
 echo "[6/6] Verifying installation..."
-echo "  ✓ C++ driver:  $(file src/driver/hid_driver | cut -d: -f2)"
+echo "  ✓ C++ driver:  $(file src/driver/build/default/hid_driver | cut -d: -f2)"
 echo "  ✓ ML model:    $(du -sh models/hand_landmarker.task | cut -f1)"
 echo "  ✓ Python venv: $VENV_DIR"
 
@@ -0,0 +1,46 @@
+"""
+clock.py
+Injectable monotonic clocks.
+
+Anything with time-dependent behaviour (cooldowns, hold timers, soak
+harnesses) takes a ``clock`` callable returning seconds instead of calling
+``time.monotonic`` directly.  Production code passes the default; tests pass
+a SimulatedClock and advance it explicitly, which makes timing behaviour
+deterministic and lets a 24-hour session run in seconds.
+
+    clock  = SimulatedClock()
+    mapper = GestureMapper(clock=clock)
+    mapper.map(hand); clock.advance(1 / 30)
+
+The driver has the equivalent in C++ (EventLoop::Clock, src/driver/event_loop.h).
+"""
+
+from __future__ import annotations
+
+import time
+from typing import Callable
+
+Clock = Callable[[], float]
+
+monotonic: Clock = time.monotonic
+
+
+class SimulatedClock:
+    """A clock that only moves when told to."""
+
+    def __init__(self, start: float = 0.0) -> None:
+        self._t = float(start)
+
+    def __call__(self) -> float:
+        return self._t
+
+    def advance(self, seconds: float) -> float:
+        if seconds < 0:
+            raise ValueError("a monotonic clock cannot go backwards")
+        self._t += seconds
+        return self._t
+
+    def set(self, t: float) -> None:
+        if t < self._t:
+            raise ValueError("a monotonic clock cannot go backwards")
+        self._t = float(t)
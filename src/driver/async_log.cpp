@@ -0,0 +1,363 @@
+/*
+ * async_log.cpp
+ * Bounded MPSC record ring and the drain thread that formats it.
+ *
+ * The ring is Vyukov's bounded queue: every cell carries a sequence number
+ * that tells producers whether it is free for lap n and tells the consumer
+ * whether it has been published.  Producers claim a position with a single
+ * CAS on g_enqueue; a full ring is detected without waiting and the record
+ * is counted in g_dropped.  Only the drain thread advances g_dequeue.
+ *
+ * An idle drain thread parks on a futex instead of polling: it raises
+ * g_parked, re-checks the ring and sleeps while the word stays raised.  A
+ * producer that publishes and then sees g_parked clears it and wakes the
+ * thread, so only the record that ends an idle stretch makes a syscall.
+ * The fences on both sides order the publish against the park (neither
+ * can miss the other).  A timed wait bounds any missed wake-up anyway.
+ */
+
+#include "async_log.h"
+
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace AsyncLog {
+
+static_assert((kRingCapacity & (kRingCapacity - 1)) == 0, "kRingCapacity must be a power of two");
+
+std::atomic<uint8_t> g_min_level{static_cast<uint8_t>(Level::Info)};
+
+namespace {
+
+struct Cell {
+    std::atomic<uint64_t> seq{0};
+    Record                rec;
+};
+
+struct Ring {
+    Cell cells[kRingCapacity];
+    Ring()
+    {
+        for (size_t i = 0; i < kRingCapacity; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+};
+
+Ring                  g_ring;
+std::atomic<uint64_t> g_enqueue{0};
+std::atomic<uint64_t> g_dequeue{0};            // written by the drain thread only
+std::atomic<uint64_t> g_dropped{0};
+
+std::atomic<uint32_t> g_rate{20};
+std::atomic<bool>     g_json{false};
+std::atomic<int>      g_out_fd{STDERR_FILENO};
+
+std::atomic<bool>     g_running{false};
+std::thread           g_drain;
+
+std::atomic<int>      g_drain_idle_ms{1000};
+std::atomic<uint32_t> g_parked{0};             // futex word: 1 while the drain thread waits
+
+inline uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline uint32_t coarse_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint32_t>(ts.tv_sec);
+}
+
+const char* level_name(Level l)
+{
+    switch (l) {
+    case Level::Debug: return "debug";
+    case Level::Info:  return "info";
+    case Level::Warn:  return "warn";
+    case Level::Error: return "error";
+    }
+    return "?";
+}
+
+// ---- Formatting (drain thread) --------------------------------------------------
+
+struct Buf {
+    char   data[8192];
+    size_t len = 0;
+
+    void put(const char* s, size_t n)
+    {
+        if (n > sizeof(data) - len) n = sizeof(data) - len;
+        std::memcpy(data + len, s, n);
+        len += n;
+    }
+    void put(const char* s) { put(s, std::strlen(s)); }
+    void put(char c)        { put(&c, 1); }
+
+    void flush(int fd)
+    {
+        size_t off = 0;
+        while (off < len) {
+            const ssize_t n = ::write(fd, data + off, len - off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            off += static_cast<size_t>(n);
+        }
+        len = 0;
+    }
+};
+
+/** Render one argument as plain text into @p out (NUL-terminated). */
+void render_arg(const Arg& a, char* out, size_t cap)
+{
+    switch (a.type) {
+    case ArgType::Int:    std::snprintf(out, cap, "%lld", static_cast<long long>(a.i)); break;
+    case ArgType::Uint:   std::snprintf(out, cap, "%llu", static_cast<unsigned long long>(a.u)); break;
+    case ArgType::Double: std::snprintf(out, cap, "%g", a.d); break;
+    case ArgType::CStr:   std::snprintf(out, cap, "%s", a.cstr ? a.cstr : "(null)"); break;
+    case ArgType::Str:    std::snprintf(out, cap, "%.*s", static_cast<int>(a.len), a.str); break;
+    case ArgType::Err:    std::snprintf(out, cap, "%s", std::strerror(static_cast<int>(a.i))); break;
+    case ArgType::None:   out[0] = '\0'; break;
+    }
+}
+
+/** Substitute "{}" placeholders of the record's format string. */
+size_t render_message(const Record& r, char* out, size_t cap)
+{
+    size_t len = 0, next = 0;
+    for (const char* p = r.site->fmt; *p && len + 1 < cap; ++p) {
+        if (p[0] == '{' && p[1] == '}' && next < r.nargs) {
+            char tmp[256];
+            render_arg(r.args[next++], tmp, sizeof(tmp));
+            for (const char* t = tmp; *t && len + 1 < cap; ++t) out[len++] = *t;
+            ++p;
+        } else {
+            out[len++] = *p;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+void put_json_string(Buf& b, const char* s)
+{
+    b.put('"');
+    for (; *s; ++s) {
+        const unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') { b.put('\\'); b.put(static_cast<char>(c)); }
+        else if (c == '\n')        b.put("\\n");
+        else if (c < 0x20)         b.put(' ');
+        else                       b.put(static_cast<char>(c));
+    }
+    b.put('"');
+}
+
+void format_record(Buf& b, const Record& r)
+{
+    char msg[512];
+    render_message(r, msg, sizeof(msg));
+    char num[64];
+
+    if (g_json.load(std::memory_order_relaxed)) {
+        const char* file = std::strrchr(r.site->file, '/');
+        file = file ? file + 1 : r.site->file;
+        std::snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(r.t_ns));
+        b.put("{\"t_ns\":");         b.put(num);
+        b.put(",\"level\":\"");      b.put(level_name(r.site->level));
+        b.put("\",\"site\":\"");     b.put(file);
+        std::snprintf(num, sizeof(num), ":%d\"", r.site->line);
+        b.put(num);
+        b.put(",\"msg\":");          put_json_string(b, msg);
+        if (r.suppressed) {
+            std::snprintf(num, sizeof(num), ",\"suppressed\":%u", r.suppressed);
+            b.put(num);
+        }
+        b.put("}\n");
+    } else {
+        b.put(msg);
+        if (r.suppressed) {
+            std::snprintf(num, sizeof(num), " (%u similar suppressed)", r.suppressed);
+            b.put(num);
+        }
+        b.put('\n');
+    }
+}
+
+/** Pop everything currently published; returns the number of records written. */
+size_t drain_once()
+{
+    static Buf buf;
+    size_t n = 0;
+    uint64_t pos = g_dequeue.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& c = g_ring.cells[pos & (kRingCapacity - 1)];
+        if (c.seq.load(std::memory_order_acquire) != pos + 1) break;
+        const Record rec = c.rec;
+        c.seq.store(pos + kRingCapacity, std::memory_order_release);
+        g_dequeue.store(++pos, std::memory_order_relaxed);
+
+        if (sizeof(buf.data) - buf.len < 1024) buf.flush(g_out_fd.load(std::memory_order_relaxed));
+        format_record(buf, rec);
+        ++n;
+    }
+
+    static uint64_t reported_drops = 0;
+    const uint64_t drops = g_dropped.load(std::memory_order_relaxed);
+    if (drops != reported_drops) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "[async_log] %llu record(s) dropped (ring full)\n",
+                      static_cast<unsigned long long>(drops - reported_drops));
+        buf.put(line);
+        reported_drops = drops;
+    }
+
+    if (buf.len) buf.flush(g_out_fd.load(std::memory_order_relaxed));
+    return n;
+}
+
+long futex(std::atomic<uint32_t>& word, int op, uint32_t val, const struct timespec* timeout)
+{
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain uint32_t");
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, val, timeout, nullptr, 0);
+}
+
+/** Wake the drain thread if it is parked (producers and stop()). */
+void wake_drain()
+{
+    if (g_parked.exchange(0, std::memory_order_relaxed)) futex(g_parked, FUTEX_WAKE_PRIVATE, 1, nullptr);
+}
+
+bool ring_empty()
+{
+    const uint64_t pos = g_dequeue.load(std::memory_order_relaxed);
+    return g_ring.cells[pos & (kRingCapacity - 1)].seq.load(std::memory_order_acquire) != pos + 1;
+}
+
+void drain_loop()
+{
+    pthread_setname_np(pthread_self(), "hid_log");
+    while (g_running.load(std::memory_order_acquire)) {
+        if (drain_once() > 0) continue;
+
+        g_parked.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_empty() && g_running.load(std::memory_order_relaxed)) {
+            const int ms = g_drain_idle_ms.load(std::memory_order_relaxed);
+            const struct timespec timeout = {ms / 1000, (ms % 1000) * 1000000L};
+            futex(g_parked, FUTEX_WAIT_PRIVATE, 1, &timeout);      // returns at once if already woken
+        }
+        g_parked.store(0, std::memory_order_relaxed);
+    }
+    drain_once();
+}
+
+} // namespace
+
+// ---- Configuration ----------------------------------------------------------------
+
+void set_level(Level l)               { g_min_level.store(static_cast<uint8_t>(l), std::memory_order_relaxed); }
+void set_json(bool json)              { g_json.store(json, std::memory_order_relaxed); }
+void set_rate_limit(uint32_t per_sec) { g_rate.store(per_sec ? per_sec : 1, std::memory_order_relaxed); }
+void set_output_fd(int fd)            { g_out_fd.store(fd, std::memory_order_relaxed); }
+void set_drain_interval_ms(int ms)    { g_drain_idle_ms.store(ms > 0 ? ms : 1, std::memory_order_relaxed); }
+
+bool parse_level(std::string_view s, Level& out)
+{
+    if (s == "debug") { out = Level::Debug; return true; }
+    if (s == "info")  { out = Level::Info;  return true; }
+    if (s == "warn")  { out = Level::Warn;  return true; }
+    if (s == "error") { out = Level::Error; return true; }
+    return false;
+}
+
+void start()
+{
+    if (const char* env = std::getenv("HID_DRIVER_LOG_LEVEL")) {
+        Level l;
+        if (parse_level(env, l)) set_level(l);
+        else std::fprintf(stderr, "[async_log] Ignoring unknown HID_DRIVER_LOG_LEVEL=%s\n", env);
+    }
+    if (const char* env = std::getenv("HID_DRIVER_LOG_FORMAT")) {
+        set_json(std::string_view(env) == "json");
+    }
+    if (const char* env = std::getenv("HID_DRIVER_LOG_RATE")) {
+        set_rate_limit(static_cast<uint32_t>(std::strtoul(env, nullptr, 10)));
+    }
+
+    if (g_running.exchange(true)) return;
+    g_drain = std::thread(drain_loop);
+}
+
+void stop()
+{
+    if (!g_running.exchange(false)) return;
+    wake_drain();
+    g_drain.join();
+}
+
+uint64_t dropped()
+{
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+size_t depth()
+{
+    const uint64_t enq = g_enqueue.load(std::memory_order_relaxed);
+    const uint64_t deq = g_dequeue.load(std::memory_order_relaxed);
+    return enq > deq ? static_cast<size_t>(enq - deq) : 0;
+}
+
+// ---- Hot path ---------------------------------------------------------------------
+
+bool admit(Site& site, uint32_t& suppressed_out)
+{
+    const uint32_t now = coarse_seconds();
+    uint32_t window = site.window_s.load(std::memory_order_relaxed);
+    if (window != now && site.window_s.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+        site.in_window.store(0, std::memory_order_relaxed);
+    }
+    if (site.in_window.fetch_add(1, std::memory_order_relaxed) >= g_rate.load(std::memory_order_relaxed)) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed_out = site.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void submit(Record& rec)
+{
+    rec.t_ns = now_ns();
+    uint64_t pos = g_enqueue.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& c = g_ring.cells[pos & (kRingCapacity - 1)];
+        const uint64_t seq = c.seq.load(std::memory_order_acquire);
+        const int64_t  dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (dif == 0) {
+            if (g_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                c.rec = rec;
+                c.seq.store(pos + 1, std::memory_order_release);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (g_parked.load(std::memory_order_relaxed)) wake_drain();
+                return;
+            }
+        } else if (dif < 0) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = g_enqueue.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace AsyncLog
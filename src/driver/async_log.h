@@ -0,0 +1,192 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+/*
+ * async_log.h
+ * Structured asynchronous logger for the driver hot path.
+ *
+ * A log call copies its arguments into a fixed-size binary record and
+ * pushes it onto a bounded lock-free MPSC ring; a background thread
+ * formats records and writes them to stderr.  The caller never formats,
+ * never allocates and never takes a lock; the only syscall is the futex
+ * wake made by the first record after the drain thread went idle.  When
+ * the ring is full the record is dropped and counted instead of blocking.
+ *
+ * Each call site owns a static Site with a per-second rate limit, so a
+ * misbehaving producer spamming one message cannot flood the ring; the
+ * next message that gets through reports how many were suppressed.
+ *
+ *   HID_LOG(AsyncLog::Level::Warn, "[hid_driver] Unknown command: {}", cmd);
+ *
+ * Placeholders are "{}", filled in order.  Supported arguments: integers,
+ * double, const char* (must outlive the drain, e.g. literals),
+ * std::string_view / std::string (copied, truncated to kMaxStringArg), and
+ * AsyncLog::Errno (rendered with strerror by the drain thread).
+ *
+ * Runtime configuration (read by start(), changeable later via setters):
+ *   HID_DRIVER_LOG_LEVEL  = debug | info | warn | error   (default info)
+ *   HID_DRIVER_LOG_FORMAT = text | json                   (default text)
+ *   HID_DRIVER_LOG_RATE   = max messages per site per second (default 20)
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace AsyncLog {
+
+enum class Level : uint8_t { Debug = 0, Info = 1, Warn = 2, Error = 3 };
+
+constexpr size_t kMaxArgs       = 4;
+constexpr size_t kMaxStringArg  = 30;
+constexpr size_t kRingCapacity  = 1024;     // power of two
+
+/** Wrap an errno value so the drain thread renders it with strerror(). */
+struct Errno { int value; };
+
+/** Static per-call-site descriptor (one per HID_LOG expansion). */
+struct Site {
+    Level       level;
+    const char* file;
+    int         line;
+    const char* fmt;
+    std::atomic<uint32_t> window_s{0};      // current rate-limit window (coarse seconds)
+    std::atomic<uint32_t> in_window{0};     // messages accepted in that window
+    std::atomic<uint32_t> suppressed{0};    // dropped by the rate limiter since last emit
+
+    Site(Level l, const char* f, int ln, const char* fm)
+        : level(l), file(f), line(ln), fmt(fm) {}
+};
+
+// ---- Binary record ------------------------------------------------------------
+
+enum class ArgType : uint8_t { None, Int, Uint, Double, CStr, Str, Err };
+
+struct Arg {
+    ArgType type = ArgType::None;
+    uint8_t len  = 0;
+    union {
+        int64_t     i;
+        uint64_t    u;
+        double      d;
+        const char* cstr;
+        char        str[kMaxStringArg];
+    };
+    Arg() : i(0) {}
+};
+
+struct Record {
+    uint64_t    t_ns       = 0;
+    const Site* site       = nullptr;
+    uint32_t    suppressed = 0;
+    uint8_t     nargs      = 0;
+    Arg         args[kMaxArgs];
+};
+
+// ---- Configuration ------------------------------------------------------------
+
+extern std::atomic<uint8_t> g_min_level;
+
+inline bool enabled(Level l)
+{
+    return static_cast<uint8_t>(l) >= g_min_level.load(std::memory_order_relaxed);
+}
+
+void set_level(Level l);
+void set_json(bool json);
+void set_rate_limit(uint32_t per_second);
+
+/** Where the drain thread writes (default STDERR_FILENO; tests use a pipe). */
+void set_output_fd(int fd);
+
+/**
+ * Longest the drain thread stays parked on an empty ring before it checks
+ * again (default 1000 ms).  A record wakes it at once; this is a fallback.
+ */
+void set_drain_interval_ms(int ms);
+
+/** Parse "debug" / "info" / "warn" / "error"; returns false if unknown. */
+bool parse_level(std::string_view s, Level& out);
+
+/** Read the HID_DRIVER_LOG_* environment and start the drain thread. */
+void start();
+
+/** Drain everything still queued, then stop the drain thread. */
+void stop();
+
+/** Records dropped because the ring was full (since start). */
+uint64_t dropped();
+
+/** Records queued but not yet written (approximate; for metrics). */
+size_t depth();
+
+// ---- Hot path -----------------------------------------------------------------
+
+/** Rate-limit check; returns false if this site is over budget this second. */
+bool admit(Site& site, uint32_t& suppressed_out);
+
+/** Push a filled record (t_ns is stamped here); drops it if the ring is full. */
+void submit(Record& rec);
+
+namespace detail {
+
+inline void pack(Arg& a, std::string_view s)
+{
+    a.type = ArgType::Str;
+    a.len  = static_cast<uint8_t>(s.size() < kMaxStringArg ? s.size() : kMaxStringArg);
+    std::memcpy(a.str, s.data(), a.len);
+}
+inline void pack(Arg& a, const std::string& s) { pack(a, std::string_view(s)); }
+inline void pack(Arg& a, const char* s)        { a.type = ArgType::CStr; a.cstr = s; }
+inline void pack(Arg& a, Errno e)              { a.type = ArgType::Err;  a.i = e.value; }
+inline void pack(Arg& a, double d)             { a.type = ArgType::Double; a.d = d; }
+
+template <typename T>
+inline std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>> pack(Arg& a, T v)
+{
+    a.type = ArgType::Int; a.i = v;
+}
+template <typename T>
+inline std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T>> pack(Arg& a, T v)
+{
+    a.type = ArgType::Uint; a.u = v;
+}
+
+template <typename... Rest>
+constexpr const char* format_of(const char* fmt, const Rest&...) { return fmt; }
+
+} // namespace detail
+
+/** Called by HID_LOG; @p fmt is already stored in @p site. */
+template <typename... Args>
+inline void log(Site& site, const char* /*fmt*/, const Args&... args)
+{
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+    uint32_t suppressed;
+    if (!admit(site, suppressed)) return;
+    Record rec;
+    rec.site       = &site;
+    rec.suppressed = suppressed;
+    rec.nargs      = static_cast<uint8_t>(sizeof...(Args));
+    size_t i = 0;
+    (detail::pack(rec.args[i++], args), ...);
+    (void)i;
+    submit(rec);
+}
+
+} // namespace AsyncLog
+
+// HID_LOG(level, fmt, args...)
+#define HID_LOG(level, ...)                                                          \
+    do {                                                                             \
+        if (::AsyncLog::enabled(level)) {                                            \
+            static ::AsyncLog::Site hid_log_site_{                                   \
+                level, __FILE__, __LINE__, ::AsyncLog::detail::format_of(__VA_ARGS__)}; \
+            ::AsyncLog::log(hid_log_site_, __VA_ARGS__);                             \
+        }                                                                            \
+    } while (0)
+
+#endif // ASYNC_LOG_H
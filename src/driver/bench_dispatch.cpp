@@ -0,0 +1,976 @@
+/*
+ * bench_dispatch.cpp
+ * Micro-benchmarks for the hid_driver command path, with per-operation
+ * hardware counters from perf_event_open(2) where the host permits them.
+ *
+ * Scenarios
+ * ---------
+ *   parse     - full dispatch with devices closed (fd = -1): parsing, lookup
+ *               and flight recording only, no syscalls
+ *   move      - MOUSE_MOVE stream written to /dev/null
+ *   mixed     - the command mix GestureMapper produces while pointing,
+ *               clicking, scrolling and steering, written to /dev/null
+ *   unknown   - a producer spamming unrecognised commands: every line hits
+ *               the rate-limited AsyncLog path (drained to /dev/null)
+ *   chord     - KEY_CHORD shortcuts (CTRL+TAB, CTRL+SHIFT+T, ...) to
+ *               /dev/null: the receive-to-written latency of one chord
+ *   touch     - two-hand pinch-to-zoom on the touchscreen: both contacts
+ *               move every frame, lifted and put down again every 64 frames
+ *   pen       - pen strokes: hover in, touch down, 60 fractional-pixel samples
+ *               with varying pressure and tilt, lift, out (no glide ticks)
+ *   ptr1/2/4  - one POINTER line per camera frame moving 1, 2 or 4
+ *               independent pointers, each pressing and releasing LEFT every
+ *               32 frames: the per-frame cost as pointers are added
+ *   type      - TYPE lines of 16-128 characters to /dev/null with no batch
+ *               gap: layout compile + batched writes, reported as chars/s
+ *
+ * Each scenario runs --reps repetitions of --iters operations; the per-rep
+ * ns/op values and the per-op counters are written to
+ * $GESTURELINK_RESULTS_DIR/bench_dispatch.json (see bench_results.h) for
+ * comparison with bench/compare.py.
+ *
+ * Loop latency
+ * ------------
+ *   MOUSE_MOVE lines written one at a time (100 us apart) into a pipe that
+ *   EventLoop::run() reads, timed from before the pipe write to dispatch()
+ *   returning, i.e. the input path of hid_driver's main loop:
+ *
+ *   stdin     - stdin only, as with HID_DRIVER_SINK=null
+ *   ff_idle   - the gamepad fd is watched too (force feedback), no requests
+ *   ff_busy   - ... while a game starts or stops rumble 1000 times a second,
+ *               each change forwarded as a back-channel line
+ *
+ *   p50 / p99 / max of every line are reported and written as loop/<name>.
+ *
+ * Inertia
+ * -------
+ *   tick      - ns per mouse_inertia_tick() of a 2000 px/s flick with friction
+ *               4/s, written to /dev/null (a new flick whenever one stops)
+ *   cancel    - the loop above with hid_driver's coast timer: a flick is
+ *               released, coasts for ~6 ms, then a MOUSE_MOVE arrives; timed
+ *               from its pipe write until the coast is stopped and its timer
+ *               cancelled.  Written as inertia/tick and inertia/cancel.
+ *
+ * Turbo
+ * -----
+ *   tick      - ns per gamepad_turbo_tick() with A, B, X and Y autofiring at
+ *               15, 20, 30 and 60 Hz, written to /dev/null, stepping the
+ *               clock from edge to edge as hid_driver's timer does
+ *   edges     - the loop above with hid_driver's turbo timer on the real
+ *               clock: A at 15 Hz, B at 30 Hz and X at 20 Hz / 25 % for 2 s.
+ *               Reports each edge's distance from its ideal time (p50 / p99
+ *               / max), the achieved rate per button and edges per frame.
+ *               Written as turbo/tick and turbo/edges.
+ *
+ * Macro
+ * -----
+ *   tick      - ns per Macro::tick() of a 60-frame stick sweep (one frame per
+ *               ms), written to /dev/null, restarted whenever it finishes
+ *   drift     - the loop above with hid_driver's macro timer on the real
+ *               clock: a 6-frame fighting-game combo plus a 60 Hz sweep, each
+ *               played 10 times back to back.  Reports each frame's distance
+ *               from its defined time (p50 / p99 / max) and the worst error in
+ *               a whole macro's length.  Written as macro/tick and macro/drift.
+ *
+ * Usage
+ * -----
+ *   make bench
+ *   ./bench_dispatch [--iters N] [--reps R] [--json PATH]
+ */
+
+#include "async_log.h"
+#include "bench_results.h"
+#include "command_dispatch.h"
+#include "perf_counters.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Scenario {
+    const char*              name;
+    bool                     null_sink;
+    std::vector<std::string> lines;
+    double                   chars_per_op = 0;   // TYPE text per line, for chars/s
+    int                      pointers     = 0;   // pointer devices opened (POINTER scenarios)
+};
+
+std::vector<std::string> move_stream()
+{
+    std::vector<std::string> v;
+    for (int i = 0; i < 256; ++i) {
+        v.push_back("MOUSE_MOVE " + std::to_string(100 + i * 7 % 1700) + " " +
+                    std::to_string(80 + i * 13 % 900));
+    }
+    return v;
+}
+
+std::vector<std::string> mixed_stream()
+{
+    std::vector<std::string> v;
+    for (int i = 0; i < 256; ++i) {
+        switch (i % 16) {
+            case 3:  v.push_back("MOUSE_LEFT");                         break;
+            case 7:  v.push_back("MOUSE_SCROLL " + std::to_string(i % 2 ? 3 : -3)); break;
+            case 9:  v.push_back("GAMEPAD_BTN A 1");                    break;
+            case 10: v.push_back("GAMEPAD_BTN A 0");                    break;
+            case 12: v.push_back("GAMEPAD_STICK " + std::to_string(i * 97 % 65534 - 32767) +
+                                 " " + std::to_string(-(i * 31 % 32767)));  break;
+            case 14: v.push_back("MOUSE_RIGHT");                        break;
+            default: v.push_back("MOUSE_MOVE " + std::to_string(i * 7 % 1920) + " " +
+                                 std::to_string(i * 3 % 1080));         break;
+        }
+    }
+    return v;
+}
+
+std::vector<std::string> unknown_stream()
+{
+    std::vector<std::string> v;
+    for (int i = 0; i < 256; ++i) {
+        v.push_back(i % 2 ? "GAMEPAD_BTN Z" + std::to_string(i) + " 1"
+                          : "MOUSE_WARP " + std::to_string(i) + " 0");
+    }
+    return v;
+}
+
+std::vector<std::string> chord_stream()
+{
+    const char* const chords[] = {"CTRL+TAB", "CTRL+SHIFT+TAB", "CTRL+SHIFT+T", "ALT+F4",
+                                  "SUPER+LEFT", "CTRL+ALT+DELETE", "CTRL+C", "CTRL+V"};
+    std::vector<std::string> v;
+    for (int i = 0; i < 256; ++i) v.push_back(std::string("KEY_CHORD ") + chords[i % 8]);
+    return v;
+}
+
+std::vector<std::string> touch_stream()
+{
+    std::vector<std::string> v;
+    for (int i = 0; i < 256; ++i) {
+        const int spread = 100 + i % 64 * 10;
+        if (i % 64 == 63) {
+            v.push_back("TOUCH 0 UP 1 UP");
+            continue;
+        }
+        v.push_back("TOUCH 0 " + std::to_string(960 - spread) + " " + std::to_string(540 - spread / 2) +
+                    " 1 " + std::to_string(960 + spread) + " " + std::to_string(540 + spread / 2));
+    }
+    return v;
+}
+
+std::vector<std::string> pen_stream()
+{
+    std::vector<std::string> v;
+    char line[64];
+    for (int i = 0; i < 256; ++i) {
+        const int k = i % 64;
+        if (k == 63) {
+            v.push_back("PEN OUT");
+            continue;
+        }
+        const int pressure = k == 0 ? 0 : k == 62 ? 100 : 600 + k * 40 % 2000;
+        std::snprintf(line, sizeof(line), "PEN %.2f %.2f %d %d %d", 400 + k * 7.37, 300 + k * 3.11,
+                      pressure, k % 40 - 20, 15 - k % 30);
+        v.push_back(line);
+    }
+    return v;
+}
+
+std::vector<std::string> pointer_stream(int pointers)
+{
+    std::vector<std::string> v;
+    for (int i = 0; i < 256; ++i) {
+        std::string line = "POINTER";
+        for (int p = 0; p < pointers; ++p) {
+            const int k = (i + p * 8) % 32;
+            line += " " + std::to_string(p) + " " + std::to_string(200 + p * 400 + i * 3 % 300) + " " +
+                    std::to_string(150 + i * 7 % 700);
+            if (k == 0) line += " " + std::to_string(p) + " DOWN LEFT";
+            if (k == 4) line += " " + std::to_string(p) + " UP LEFT";
+        }
+        v.push_back(line);
+    }
+    return v;
+}
+
+std::vector<std::string> type_stream(double& chars_per_line)
+{
+    const std::string words = "The quick brown fox jumps over the lazy dog; PACK MY BOX with "
+                              "five dozen liquor jugs! 0123456789 (a+b)*c == d\\n ";
+    std::vector<std::string> v;
+    size_t chars = 0;
+    for (int i = 0; i < 256; ++i) {
+        const size_t len = 16 + static_cast<size_t>(i * 37 % 113);   // 16..128
+        std::string text;
+        while (text.size() < len) text += words;
+        text.resize(len);
+        for (size_t j = 0; j < text.size(); ++j, ++chars) {
+            if (text[j] == '\\') ++j;                                   // "\n" is one character
+        }
+        v.push_back("TYPE " + text);
+    }
+    chars_per_line = static_cast<double>(chars) / static_cast<double>(v.size());
+    return v;
+}
+
+BenchResults::Benchmark run(const Scenario& sc, long iters, int reps,
+                            PerfCounters::CounterSet& cs, bool have_perf)
+{
+    HidDriver::Devices dev;
+    if (sc.null_sink) {
+        dev.mouse.fd   = open("/dev/null", O_WRONLY);
+        dev.gamepad.fd  = open("/dev/null", O_WRONLY);
+        dev.keyboard.fd = open("/dev/null", O_WRONLY);
+        dev.keyboard.gap_ns = 0;        // the text path itself; the driver paces long TYPEs for readers
+        dev.touch.fd    = open("/dev/null", O_WRONLY);
+        dev.pen.fd      = open("/dev/null", O_WRONLY);
+        for (int p = 0; p < sc.pointers; ++p) dev.pointers.p[p].fd = open("/dev/null", O_WRONLY);
+    }
+    dev.pointers.count = sc.pointers;
+
+    BenchResults::Benchmark out;
+    out.name = std::string("dispatch/") + sc.name;
+    out.unit = "ns/op";
+
+    const size_t n = sc.lines.size();
+    for (size_t i = 0; i < n * 4; ++i) HidDriver::dispatch(dev, sc.lines[i % n]);   // warm-up
+
+    PerfCounters::Reading total;
+    for (int rep = 0; rep < reps; ++rep) {
+        if (have_perf) PerfCounters::start(cs);
+        const auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < iters; ++i) {
+            HidDriver::dispatch(dev, sc.lines[static_cast<size_t>(i) % n]);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        if (have_perf) {
+            const PerfCounters::Reading r = PerfCounters::stop(cs);
+            for (int c = 0; c < PerfCounters::kNumCounters; ++c) {
+                total.valid[c]  = r.valid[c];
+                total.value[c] += r.value[c];
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        out.samples.push_back(ns / static_cast<double>(iters));
+    }
+
+    std::vector<double> sorted = out.samples;
+    std::sort(sorted.begin(), sorted.end());
+    const double median = sorted[sorted.size() / 2];
+    const double ops    = static_cast<double>(iters) * reps;
+
+    if (sc.chars_per_op > 0) {
+        out.metrics.emplace_back("chars_per_s", sc.chars_per_op * 1e9 / median);
+    }
+    if (sc.pointers > 0) out.metrics.emplace_back("ns_per_pointer", median / sc.pointers);
+
+    std::printf("%-8s %10.1f", sc.name, median);
+    for (int c = 0; c < PerfCounters::kNumCounters; ++c) {
+        if (total.valid[c]) {
+            const double per_op = static_cast<double>(total.value[c]) / ops;
+            std::printf(" %12.3f", per_op);
+            out.metrics.emplace_back(PerfCounters::kCounterNames[c], per_op);
+        } else {
+            std::printf(" %12s", "n/a");
+        }
+    }
+    if (sc.chars_per_op > 0) std::printf("   %.1f M chars/s", sc.chars_per_op * 1e3 / median);
+    std::printf("\n");
+
+    if (dev.mouse.fd >= 0)    close(dev.mouse.fd);
+    if (dev.gamepad.fd >= 0)  close(dev.gamepad.fd);
+    if (dev.keyboard.fd >= 0) close(dev.keyboard.fd);
+    if (dev.touch.fd >= 0)    close(dev.touch.fd);
+    if (dev.pen.fd >= 0)      close(dev.pen.fd);
+    for (const VirtualHID::Pointer& p : dev.pointers.p) {
+        if (p.fd >= 0) close(p.fd);
+    }
+    return out;
+}
+
+// ---- Loop latency ------------------------------------------------------------------
+
+constexpr int     kLoopLines   = 5000;
+constexpr int64_t kLoopGapNs   = 100000;
+constexpr int64_t kRumbleGapNs = 1000000;
+
+struct LoopBench {
+    HidDriver::Devices    dev;
+    int                   feedback_fd = -1;
+    std::atomic<int64_t>  sent_ns{0};
+    std::atomic<int>      done{0};
+    std::vector<double>   latency_us;
+};
+
+BenchResults::Benchmark run_loop(const char* name, bool watch, bool rumble)
+{
+    int in[2], pad[2];
+    if (pipe(in) < 0 || socketpair(AF_UNIX, SOCK_SEQPACKET, 0, pad) < 0) {
+        std::perror("[bench] pipe/socketpair");
+        std::exit(1);
+    }
+    fcntl(pad[0], F_SETFL, O_NONBLOCK);
+
+    LoopBench b;
+    b.dev.mouse.fd   = open("/dev/null", O_WRONLY);
+    b.dev.gamepad.fd = pad[0];                       // the kernel side is pad[1]
+    b.dev.gamepad.ff[0].used   = true;
+    b.dev.gamepad.ff[0].strong = 0x8000;
+    b.feedback_fd    = open("/dev/null", O_WRONLY);
+    b.latency_us.reserve(kLoopLines);
+
+    EventLoop::TimerWheel timers(EventLoop::monotonic_clock());
+    EventLoop::LoopHooks  hooks;
+    hooks.ctx     = &b;
+    hooks.on_line = [](void* ctx, std::string_view line) {
+        LoopBench& lb = *static_cast<LoopBench*>(ctx);
+        HidDriver::dispatch(lb.dev, line);
+        const int64_t now = EventLoop::monotonic_clock().now_ns();
+        lb.latency_us.push_back((now - lb.sent_ns.load(std::memory_order_acquire)) / 1e3);
+        lb.done.fetch_add(1, std::memory_order_release);
+        return true;
+    };
+    if (watch) {
+        // As hid_driver's on_gamepad_readable.
+        hooks.watch_fd    = pad[0];
+        hooks.on_readable = [](void* ctx, int) {
+            LoopBench& lb = *static_cast<LoopBench*>(ctx);
+            VirtualHID::FfEvent changes[VirtualHID::kMaxFfEffects];
+            const int n = VirtualHID::gamepad_service(lb.dev.gamepad, changes, VirtualHID::kMaxFfEffects);
+            char line[64];
+            for (int i = 0; i < n; ++i) {
+                const size_t len = HidDriver::format_feedback(changes[i], line, sizeof(line));
+                if (write(lb.feedback_fd, line, len) < 0) break;
+            }
+        };
+    }
+    std::atomic<bool> running{true};
+    std::thread loop([&] { EventLoop::run(in[0], timers, hooks, running); });
+
+    std::atomic<bool> producing{true};
+    std::thread game([&] {
+        input_event ev{};
+        ev.type = EV_FF;
+        for (int i = 0; rumble && producing.load(); ++i) {
+            ev.value = i % 2;
+            if (send(pad[1], &ev, sizeof(ev), MSG_DONTWAIT) < 0) break;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(kRumbleGapNs));
+        }
+    });
+
+    char line[32];
+    for (int i = 0; i < kLoopLines; ++i) {
+        const int len = std::snprintf(line, sizeof(line), "MOUSE_MOVE %d %d\n", i * 7 % 1920, i * 3 % 1080);
+        b.sent_ns.store(EventLoop::monotonic_clock().now_ns(), std::memory_order_release);
+        if (write(in[1], line, static_cast<size_t>(len)) != len) break;
+        while (b.done.load(std::memory_order_acquire) <= i) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::nanoseconds(kLoopGapNs));
+    }
+    producing = false;
+    game.join();
+    close(in[1]);                                    // EOF stops the loop
+    loop.join();
+
+    BenchResults::Benchmark out;
+    out.name    = std::string("loop/") + name;
+    out.unit    = "us";
+    out.samples = b.latency_us;
+    std::vector<double> sorted = b.latency_us;
+    std::sort(sorted.begin(), sorted.end());
+    const double p50 = sorted[sorted.size() / 2];
+    const double p99 = sorted[sorted.size() * 99 / 100];
+    out.metrics = {{"p50_us", p50}, {"p99_us", p99}, {"max_us", sorted.back()}};
+    std::printf("%-8s %10.1f %10.1f %10.1f\n", name, p50, p99, sorted.back());
+
+    for (int fd : {in[0], pad[0], pad[1], b.dev.mouse.fd, b.feedback_fd}) close(fd);
+    return out;
+}
+
+// ---- Inertia ---------------------------------------------------------------------
+
+constexpr double  kBenchFriction = 4.0;
+constexpr int     kCancelTrials  = 200;
+
+/** Start a 2000 px/s flick to the right from x = 100 at @p now. */
+void flick(VirtualHID::MouseState& ms, int64_t now)
+{
+    VirtualHID::mouse_sample(ms, 100, 500, now - 20000000);
+    VirtualHID::mouse_sample(ms, 120, 500, now - 10000000);
+    VirtualHID::mouse_sample(ms, 140, 500, now);
+    VirtualHID::mouse_release(ms, now);
+}
+
+BenchResults::Benchmark run_inertia_tick(long iters, int reps)
+{
+    VirtualHID::MouseState ms;
+    ms.fd       = open("/dev/null", O_WRONLY);
+    ms.friction = kBenchFriction;
+
+    BenchResults::Benchmark out;
+    out.name = "inertia/tick";
+    out.unit = "ns/op";
+    int64_t now = 1000000000;
+    for (int rep = 0; rep < reps; ++rep) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < iters; ++i) {
+            now += ms.tick_ns;
+            if (!VirtualHID::mouse_inertia_tick(ms, now)) flick(ms, now);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        out.samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                              static_cast<double>(iters));
+    }
+    std::vector<double> sorted = out.samples;
+    std::sort(sorted.begin(), sorted.end());
+    std::printf("%-8s %10.1f   (ns per tick, median of %d reps)\n", "tick", sorted[sorted.size() / 2], reps);
+    close(ms.fd);
+    return out;
+}
+
+struct CoastBench {
+    HidDriver::Devices     dev;
+    EventLoop::TimerWheel* timers = nullptr;
+    EventLoop::TimerId     timer  = EventLoop::kNoTimer;
+    std::atomic<int64_t>   sent_ns{0};         // 0 = the next line is not timed
+    std::atomic<int>       done{0};
+    int                    coasting = 0;       // trials whose cancel found a coast
+    std::vector<double>    latency_us;
+};
+
+void on_bench_coast_tick(void* ctx, int64_t now)
+{
+    CoastBench& cb = *static_cast<CoastBench*>(ctx);
+    cb.timer = VirtualHID::mouse_inertia_tick(cb.dev.mouse, now)
+                   ? cb.timers->schedule_at(now + cb.dev.mouse.tick_ns, on_bench_coast_tick, &cb)
+                   : EventLoop::kNoTimer;
+}
+
+BenchResults::Benchmark run_inertia_cancel()
+{
+    int in[2];
+    if (pipe(in) < 0) {
+        std::perror("[bench] pipe");
+        std::exit(1);
+    }
+    CoastBench cb;
+    cb.dev.mouse.fd       = open("/dev/null", O_WRONLY);
+    cb.dev.mouse.friction = kBenchFriction;
+    cb.latency_us.reserve(kCancelTrials);
+
+    EventLoop::TimerWheel timers(EventLoop::monotonic_clock());
+    cb.timers = &timers;
+    EventLoop::LoopHooks hooks;
+    hooks.ctx     = &cb;
+    hooks.on_line = [](void* ctx, std::string_view line) {
+        // As hid_driver's on_line: arm the coast timer on a flick, cancel it on new input.
+        CoastBench& b = *static_cast<CoastBench*>(ctx);
+        const bool was_coasting = b.dev.mouse.coasting;
+        HidDriver::dispatch(b.dev, line);
+        if (b.dev.mouse.coasting != (b.timer != EventLoop::kNoTimer)) {
+            if (b.dev.mouse.coasting) {
+                b.timer = b.timers->schedule_in(b.dev.mouse.tick_ns, on_bench_coast_tick, &b);
+            } else {
+                b.timers->cancel(b.timer);
+                b.timer = EventLoop::kNoTimer;
+            }
+        }
+        const int64_t sent = b.sent_ns.exchange(0, std::memory_order_acq_rel);
+        if (sent != 0) {
+            b.latency_us.push_back((EventLoop::monotonic_clock().now_ns() - sent) / 1e3);
+            b.coasting += was_coasting;
+        }
+        b.done.fetch_add(1, std::memory_order_release);
+        return true;
+    };
+    std::atomic<bool> running{true};
+    std::thread loop([&] { EventLoop::run(in[0], timers, hooks, running); });
+
+    int sent = 0;
+    auto send_line = [&](const char* line, bool timed) {
+        if (timed) cb.sent_ns.store(EventLoop::monotonic_clock().now_ns(), std::memory_order_release);
+        const size_t len = std::strlen(line);
+        if (write(in[1], line, len) != static_cast<ssize_t>(len)) return;
+        ++sent;
+        while (cb.done.load(std::memory_order_acquire) < sent) std::this_thread::yield();
+    };
+    // 20 px every 5 ms = 4000 px/s; the cancelling move starts the next stroke.
+    send_line("MOUSE_MOVE 100 500\n", false);
+    for (int i = 0; i < kCancelTrials; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        send_line("MOUSE_MOVE 120 500\n", false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        send_line("MOUSE_MOVE 140 500\n", false);
+        send_line("MOUSE_RELEASE\n", false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(6));
+        send_line("MOUSE_MOVE 100 500\n", true);
+    }
+    close(in[1]);
+    loop.join();
+
+    BenchResults::Benchmark out;
+    out.name    = "inertia/cancel";
+    out.unit    = "us";
+    out.samples = cb.latency_us;
+    std::vector<double> sorted = cb.latency_us;
+    std::sort(sorted.begin(), sorted.end());
+    const double p50 = sorted[sorted.size() / 2];
+    const double p99 = sorted[sorted.size() * 99 / 100];
+    out.metrics = {{"p50_us", p50}, {"p99_us", p99}, {"max_us", sorted.back()},
+                   {"coasting", static_cast<double>(cb.coasting) / kCancelTrials}};
+    std::printf("%-8s %10.1f %10.1f %10.1f   (us; %d/%d trials were coasting)\n", "cancel", p50, p99,
+                sorted.back(), cb.coasting, kCancelTrials);
+
+    close(in[0]);
+    close(cb.dev.mouse.fd);
+    return out;
+}
+
+// ---- Turbo -----------------------------------------------------------------------
+
+BenchResults::Benchmark run_turbo_tick(long iters, int reps)
+{
+    VirtualHID::GamepadState gs;
+    gs.fd = open("/dev/null", O_WRONLY);
+    int64_t now = 1000000000;
+    VirtualHID::gamepad_turbo(gs, VirtualHID::GamepadBtn::A, 15, 50, now);
+    VirtualHID::gamepad_turbo(gs, VirtualHID::GamepadBtn::B, 20, 50, now);
+    VirtualHID::gamepad_turbo(gs, VirtualHID::GamepadBtn::X, 30, 50, now);
+    VirtualHID::gamepad_turbo(gs, VirtualHID::GamepadBtn::Y, 60, 50, now);
+
+    BenchResults::Benchmark out;
+    out.name = "turbo/tick";
+    out.unit = "ns/op";
+    for (int rep = 0; rep < reps; ++rep) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < iters; ++i) {
+            now = std::max(now, gs.turbo_next_ns - VirtualHID::kTurboCoalesceNs / 2);
+            VirtualHID::gamepad_turbo_tick(gs, now);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        out.samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                              static_cast<double>(iters));
+    }
+    std::vector<double> sorted = out.samples;
+    std::sort(sorted.begin(), sorted.end());
+    std::printf("%-8s %10.1f   (ns per tick, 4 buttons, median of %d reps)\n", "tick",
+                sorted[sorted.size() / 2], reps);
+    close(gs.fd);
+    return out;
+}
+
+constexpr int64_t kTurboRunNs = 2000000000;
+
+struct TurboEdge { int64_t t_ns; uint16_t code; int32_t value; };
+
+int                    g_turbo_fd = -1;
+std::vector<TurboEdge> g_turbo_edges;        // EV_KEY and SYN_REPORT on g_turbo_fd
+std::vector<TurboEdge> g_turbo_frames;
+
+void record_turbo(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+    if (fd != g_turbo_fd) return;
+    const int64_t now = EventLoop::monotonic_clock().now_ns();
+    if (type == EV_KEY) g_turbo_edges.push_back({now, code, value});
+    else if (type == EV_SYN) g_turbo_frames.push_back({now, code, value});
+}
+
+struct TurboBench {
+    HidDriver::Devices     dev;
+    EventLoop::TimerWheel* timers = nullptr;
+    EventLoop::TimerId     timer  = EventLoop::kNoTimer;
+    int64_t                at     = 0;
+    std::atomic<int>       done{0};
+};
+
+void on_bench_turbo_tick(void* ctx, int64_t now);
+
+/** As hid_driver's arm_turbo(): half a wheel tick before the next edge. */
+void arm_bench_turbo(TurboBench& tb)
+{
+    const int64_t next = tb.dev.gamepad.turbo_next_ns;
+    if (next == tb.at) return;
+    if (tb.timer != EventLoop::kNoTimer) tb.timers->cancel(tb.timer);
+    tb.timer = next != 0
+                   ? tb.timers->schedule_at(next - VirtualHID::kTurboCoalesceNs / 2, on_bench_turbo_tick, &tb)
+                   : EventLoop::kNoTimer;
+    tb.at = next;
+}
+
+void on_bench_turbo_tick(void* ctx, int64_t now)
+{
+    TurboBench& tb = *static_cast<TurboBench*>(ctx);
+    tb.timer = EventLoop::kNoTimer;
+    tb.at    = 0;
+    VirtualHID::gamepad_turbo_tick(tb.dev.gamepad, now);
+    arm_bench_turbo(tb);
+}
+
+/** Distance of an edge at @p t_ns from the nearest ideal edge of @p t. */
+double turbo_error_us(const VirtualHID::TurboButton& t, int64_t t_ns)
+{
+    int64_t off = (t_ns - t.start_ns) % t.period_ns;
+    if (off < 0) off += t.period_ns;
+    const int64_t err = std::min<int64_t>({off, std::llabs(off - t.on_ns), t.period_ns - off});
+    return static_cast<double>(err) / 1e3;
+}
+
+BenchResults::Benchmark run_turbo_edges()
+{
+    int in[2];
+    if (pipe(in) < 0) {
+        std::perror("[bench] pipe");
+        std::exit(1);
+    }
+    TurboBench tb;
+    tb.dev.gamepad.fd = open("/dev/null", O_WRONLY);
+    g_turbo_fd = tb.dev.gamepad.fd;
+    g_turbo_edges.reserve(1024);
+    g_turbo_frames.reserve(1024);
+    VirtualHID::set_emit_hook(record_turbo);
+
+    EventLoop::TimerWheel timers(EventLoop::monotonic_clock());
+    tb.timers = &timers;
+    EventLoop::LoopHooks hooks;
+    hooks.ctx     = &tb;
+    hooks.on_line = [](void* ctx, std::string_view line) {
+        TurboBench& b = *static_cast<TurboBench*>(ctx);
+        HidDriver::dispatch(b.dev, line);
+        arm_bench_turbo(b);
+        b.done.fetch_add(1, std::memory_order_release);
+        return true;
+    };
+    std::atomic<bool> running{true};
+    std::thread loop([&] { EventLoop::run(in[0], timers, hooks, running); });
+
+    int sent = 0;
+    auto send_line = [&](const char* line) {
+        const size_t len = std::strlen(line);
+        if (write(in[1], line, len) != static_cast<ssize_t>(len)) return;
+        ++sent;
+        while (tb.done.load(std::memory_order_acquire) < sent) std::this_thread::yield();
+    };
+    send_line("GAMEPAD_TURBO A 15 50\n");
+    send_line("GAMEPAD_TURBO B 30 50\n");
+    send_line("GAMEPAD_TURBO X 20 25\n");
+    std::this_thread::sleep_for(std::chrono::nanoseconds(kTurboRunNs));
+    const VirtualHID::GamepadState gs = tb.dev.gamepad;        // schedules, before they stop
+    send_line("GAMEPAD_TURBO A 0\n");
+    send_line("GAMEPAD_TURBO B 0\n");
+    send_line("GAMEPAD_TURBO X 0\n");
+    close(in[1]);
+    loop.join();
+    VirtualHID::set_emit_hook(nullptr);
+
+    BenchResults::Benchmark out;
+    out.name = "turbo/edges";
+    out.unit = "us";
+    std::printf("%-8s", "edges");
+    std::vector<std::pair<std::string, double>> rates;
+    for (const VirtualHID::TurboButton& t : gs.turbo) {
+        if (t.period_ns == 0) continue;
+        int64_t first = 0, last = 0;
+        int presses = 0;
+        for (const TurboEdge& e : g_turbo_edges) {
+            if (e.code != static_cast<uint16_t>(t.btn) || e.t_ns > t.start_ns + kTurboRunNs) continue;
+            out.samples.push_back(turbo_error_us(t, e.t_ns));
+            if (e.value == 1) {
+                if (presses++ == 0) first = e.t_ns;
+                last = e.t_ns;
+            }
+        }
+        const double hz = presses > 1 ? (presses - 1) * 1e9 / static_cast<double>(last - first) : 0;
+        const double want = 1e9 / static_cast<double>(t.period_ns);
+        rates.emplace_back("hz_" + std::to_string(static_cast<int>(std::lround(want))), hz);
+        std::printf("   %.0f Hz -> %.3f Hz", want, hz);
+    }
+    std::vector<double> sorted = out.samples;
+    std::sort(sorted.begin(), sorted.end());
+    const double p50 = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    const double p99 = sorted.empty() ? 0 : sorted[sorted.size() * 99 / 100];
+    const double max = sorted.empty() ? 0 : sorted.back();
+    const double per_frame = g_turbo_frames.empty() ? 0
+                           : static_cast<double>(g_turbo_edges.size()) / static_cast<double>(g_turbo_frames.size());
+    out.metrics = {{"p50_us", p50}, {"p99_us", p99}, {"max_us", max}, {"edges_per_frame", per_frame}};
+    out.metrics.insert(out.metrics.end(), rates.begin(), rates.end());
+    std::printf("\n%-8s %10.1f %10.1f %10.1f   (us from the ideal edge; %zu edges, %.2f per frame)\n",
+                "jitter", p50, p99, max, sorted.size(), per_frame);
+
+    close(in[0]);
+    close(tb.dev.gamepad.fd);
+    return out;
+}
+
+// ---- Macro -----------------------------------------------------------------------
+
+/** A combo, and a 60 Hz sweep of the stick around a circle (kMacroSweepFrames frames). */
+constexpr int kMacroSweepFrames = 30;
+
+std::string bench_macros(int sweep_gap_us)
+{
+    std::string text = "[combo]\n"
+                       "0    GAMEPAD_STICK 0 32767\n"
+                       "40   GAMEPAD_STICK 23170 23170\n"
+                       "80   GAMEPAD_STICK 32767 0\n"
+                       "80   GAMEPAD_BTN A 1\n"
+                       "130  GAMEPAD_BTN A 0\n"
+                       "130  GAMEPAD_STICK 0 0\n"
+                       "[sweep]\n";
+    char step[96];
+    for (int i = 0; i < kMacroSweepFrames; ++i) {
+        const double a = 2 * 3.14159265358979 * i / kMacroSweepFrames;
+        std::snprintf(step, sizeof(step), "%d.%03d GAMEPAD_STICK %ld %ld\n", i * sweep_gap_us / 1000,
+                      i * sweep_gap_us % 1000, std::lround(32767 * std::cos(a)), std::lround(32767 * std::sin(a)));
+        text += step;
+    }
+    return text;
+}
+
+BenchResults::Benchmark run_macro_tick(long iters, int reps)
+{
+    Macro::Set set;
+    std::string error;
+    HidDriver::compile_macros(bench_macros(1000), set, error);
+    Macro::Player p;
+    p.set            = &set;
+    p.fd[Macro::kGamepad] = open("/dev/null", O_WRONLY);
+    int64_t now = 1000000000;
+
+    BenchResults::Benchmark out;
+    out.name = "macro/tick";
+    out.unit = "ns/op";
+    for (int rep = 0; rep < reps; ++rep) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < iters; ++i) {
+            if (p.next_ns == 0) Macro::start(p, "sweep", now);
+            now = std::max(now, p.next_ns - Macro::kSlackNs / 2);
+            Macro::tick(p, now);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        out.samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                              static_cast<double>(iters));
+    }
+    std::vector<double> sorted = out.samples;
+    std::sort(sorted.begin(), sorted.end());
+    std::printf("%-8s %10.1f   (ns per tick, one frame each, median of %d reps)\n", "tick",
+                sorted[sorted.size() / 2], reps);
+    close(p.fd[Macro::kGamepad]);
+    return out;
+}
+
+constexpr int kMacroPlays = 10;
+
+int                  g_macro_fd = -1;
+std::vector<int64_t> g_macro_frames;          // SYN_REPORT times on g_macro_fd
+
+void record_macro(int fd, uint16_t type, uint16_t /*code*/, int32_t /*value*/)
+{
+    if (fd == g_macro_fd && type == EV_SYN) g_macro_frames.push_back(EventLoop::monotonic_clock().now_ns());
+}
+
+struct MacroBench {
+    HidDriver::Devices     dev;
+    EventLoop::TimerWheel* timers = nullptr;
+    EventLoop::TimerId     timer  = EventLoop::kNoTimer;
+    int64_t                at     = 0;
+    std::vector<int64_t>   starts;             // start_ns of each MACRO line
+    std::atomic<int>       done{0};
+};
+
+void on_bench_macro_tick(void* ctx, int64_t now);
+
+/** As hid_driver's arm_macros(): half a wheel tick before the next frame. */
+void arm_bench_macro(MacroBench& mb)
+{
+    const int64_t next = mb.dev.macros.next_ns;
+    if (next == mb.at) return;
+    if (mb.timer != EventLoop::kNoTimer) mb.timers->cancel(mb.timer);
+    mb.timer = next != 0 ? mb.timers->schedule_at(next - Macro::kSlackNs / 2, on_bench_macro_tick, &mb)
+                         : EventLoop::kNoTimer;
+    mb.at = next;
+}
+
+void on_bench_macro_tick(void* ctx, int64_t now)
+{
+    MacroBench& mb = *static_cast<MacroBench*>(ctx);
+    mb.timer = EventLoop::kNoTimer;
+    mb.at    = 0;
+    Macro::tick(mb.dev.macros, now);
+    arm_bench_macro(mb);
+}
+
+BenchResults::Benchmark run_macro_drift()
+{
+    int in[2];
+    if (pipe(in) < 0) {
+        std::perror("[bench] pipe");
+        std::exit(1);
+    }
+    Macro::Set set;
+    std::string error;
+    HidDriver::compile_macros(bench_macros(16667), set, error);
+    MacroBench mb;
+    mb.dev.gamepad.fd = open("/dev/null", O_WRONLY);
+    mb.dev.macros.fd[Macro::kGamepad] = mb.dev.gamepad.fd;
+    mb.dev.macros.set = &set;
+    g_macro_fd = mb.dev.gamepad.fd;
+    g_macro_frames.reserve(2 * kMacroPlays * (kMacroSweepFrames + 4));
+    VirtualHID::set_emit_hook(record_macro);
+
+    EventLoop::TimerWheel timers(EventLoop::monotonic_clock());
+    mb.timers = &timers;
+    EventLoop::LoopHooks hooks;
+    hooks.ctx     = &mb;
+    hooks.on_line = [](void* ctx, std::string_view line) {
+        MacroBench& b = *static_cast<MacroBench*>(ctx);
+        HidDriver::dispatch(b.dev, line);
+        for (const Macro::Playing& m : b.dev.macros.playing) {
+            if (m.def) b.starts.push_back(m.start_ns);
+        }
+        arm_bench_macro(b);
+        b.done.fetch_add(1, std::memory_order_release);
+        return true;
+    };
+    std::atomic<bool> running{true};
+    std::thread loop([&] { EventLoop::run(in[0], timers, hooks, running); });
+
+    // One macro at a time, so every frame belongs to the last start.
+    std::vector<const Macro::Def*> plays;
+    int sent = 0;
+    for (int i = 0; i < 2 * kMacroPlays; ++i) {
+        const Macro::Def* def = &set.defs[i % 2];
+        const std::string line = "MACRO " + def->name + "\n";
+        if (write(in[1], line.data(), line.size()) != static_cast<ssize_t>(line.size())) break;
+        ++sent;
+        while (mb.done.load(std::memory_order_acquire) < sent) std::this_thread::yield();
+        plays.push_back(def);
+        while (mb.dev.macros.active > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    close(in[1]);
+    loop.join();
+    VirtualHID::set_emit_hook(nullptr);
+
+    // Frame k of a play is due at start + the time of its k-th SYN_REPORT.
+    BenchResults::Benchmark out;
+    out.name = "macro/drift";
+    out.unit = "us";
+    size_t f = 0;
+    double worst_length_us = 0;
+    for (size_t i = 0; i < plays.size() && i < mb.starts.size(); ++i) {
+        const Macro::Event* ev = set.events.data() + plays[i]->first;
+        int64_t first = 0, last = 0;
+        for (uint32_t k = 0; k < plays[i]->count && f < g_macro_frames.size(); ++k) {
+            if (ev[k].type != EV_SYN) continue;
+            const int64_t t = g_macro_frames[f++];
+            out.samples.push_back(std::llabs(t - (mb.starts[i] + ev[k].t_ns)) / 1e3);
+            if (k == plays[i]->count - 1) last = t;
+            if (first == 0) first = t;
+        }
+        worst_length_us = std::max(worst_length_us, std::llabs(last - first - plays[i]->length_ns) / 1e3);
+    }
+    std::vector<double> sorted = out.samples;
+    std::sort(sorted.begin(), sorted.end());
+    const double p50 = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    const double p99 = sorted.empty() ? 0 : sorted[sorted.size() * 99 / 100];
+    const double max = sorted.empty() ? 0 : sorted.back();
+    out.metrics = {{"p50_us", p50}, {"p99_us", p99}, {"max_us", max}, {"length_error_max_us", worst_length_us}};
+    std::printf("%-8s %10.1f %10.1f %10.1f   (us from the defined time; %zu frames, length off by <= %.1f us)\n",
+                "drift", p50, p99, max, sorted.size(), worst_length_us);
+
+    close(in[0]);
+    close(mb.dev.gamepad.fd);
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    long        iters = 50000;
+    int         reps  = 10;
+    std::string json_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if      (std::strcmp(argv[i], "--iters") == 0) iters     = std::atol(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--reps")  == 0) reps      = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--json")  == 0) json_path = argv[i + 1];
+    }
+    if (iters < 1) iters = 1;
+    if (reps < 1)  reps  = 1;
+
+    const int log_sink = open("/dev/null", O_WRONLY);
+    AsyncLog::set_output_fd(log_sink);
+    AsyncLog::start();
+
+    PerfCounters::CounterSet cs;
+    const bool have_perf = PerfCounters::open_counters(cs) > 0;
+    if (!have_perf) {
+        std::fprintf(stderr, "[bench] perf_event_open unavailable; reporting wall time only.\n");
+    } else if (cs.user_only) {
+        std::fprintf(stderr, "[bench] perf_event_paranoid restricts counting to user space.\n");
+    }
+
+    double chars_per_line = 0;
+    const Scenario scenarios[] = {
+        {"parse",   false, mixed_stream()},
+        {"move",    true,  move_stream()},
+        {"mixed",   true,  mixed_stream()},
+        {"unknown", false, unknown_stream()},
+        {"chord",   true,  chord_stream()},
+        {"touch",   true,  touch_stream()},
+        {"pen",     true,  pen_stream()},
+        {"ptr1",    true,  pointer_stream(1), 0, 1},
+        {"ptr2",    true,  pointer_stream(2), 0, 2},
+        {"ptr4",    true,  pointer_stream(4), 0, 4},
+        {"type",    true,  type_stream(chars_per_line), chars_per_line},
+    };
+
+    std::printf("%-8s %10s", "scenario", "ns/op");
+    for (const char* name : PerfCounters::kCounterNames) std::printf(" %12s", name);
+    std::printf("   (median ns/op of %d reps; counters per op)\n", reps);
+
+    std::vector<BenchResults::Benchmark> results;
+    for (const Scenario& sc : scenarios) results.push_back(run(sc, iters, reps, cs, have_perf));
+
+    std::printf("\n%-8s %10s %10s %10s   (us, %d lines: pipe write -> dispatched)\n", "loop", "p50", "p99",
+                "max", kLoopLines);
+    results.push_back(run_loop("stdin",   false, false));
+    results.push_back(run_loop("ff_idle", true,  false));
+    results.push_back(run_loop("ff_busy", true,  true));
+
+    std::printf("\n%-8s %10s %10s %10s\n", "inertia", "p50", "p99", "max");
+    results.push_back(run_inertia_tick(iters, reps));
+    results.push_back(run_inertia_cancel());
+
+    std::printf("\n%-8s %10s %10s %10s\n", "turbo", "p50", "p99", "max");
+    results.push_back(run_turbo_tick(iters, reps));
+    results.push_back(run_turbo_edges());
+
+    std::printf("\n%-8s %10s %10s %10s\n", "macro", "p50", "p99", "max");
+    results.push_back(run_macro_tick(iters, reps));
+    results.push_back(run_macro_drift());
+
+    PerfCounters::close_counters(cs);
+    AsyncLog::stop();
+    close(log_sink);
+
+    const std::string written = BenchResults::write("bench_dispatch", results, json_path);
+    if (written.empty()) {
+        std::fprintf(stderr, "[bench] failed to write results\n");
+        return 1;
+    }
+    std::fprintf(stderr, "[bench] results written to %s\n", written.c_str());
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * bench_results.cpp
+ * JSON writer for the "gesturelink-bench/1" result schema.
+ */
+
+#include "bench_results.h"
+
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+// <repo>/results, as bench/results.py defaults to; the Makefile passes it in
+#ifndef GESTURELINK_RESULTS_DIR
+#define GESTURELINK_RESULTS_DIR "results"
+#endif
+
+namespace BenchResults {
+
+static std::string escape(const std::string& s)
+{
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+static std::string number(double v)
+{
+    if (!std::isfinite(v)) return "null";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", v);
+    return buf;
+}
+
+static std::string cpu_model()
+{
+    std::ifstream f("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(colon + 2);
+        }
+    }
+    return "unknown";
+}
+
+static std::string read_first_line(const char* path)
+{
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+static std::string git_rev()
+{
+    if (const char* env = std::getenv("GESTURELINK_GIT_REV")) return env;
+    std::string rev;
+    if (FILE* p = popen("git rev-parse --short HEAD 2>/dev/null", "r")) {
+        char buf[64];
+        if (std::fgets(buf, sizeof(buf), p)) rev = buf;
+        pclose(p);
+    }
+    while (!rev.empty() && (rev.back() == '\n' || rev.back() == '\r')) rev.pop_back();
+    return rev.empty() ? "unknown" : rev;
+}
+
+/** mkdir -p: create @p dir and any missing parents.  @return false with errno set. */
+static bool make_dirs(const std::string& dir)
+{
+    for (size_t slash = dir.find('/', 1);; slash = dir.find('/', slash + 1)) {
+        const std::string part = dir.substr(0, slash);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (slash == std::string::npos) return true;
+    }
+}
+
+std::string results_dir()
+{
+    const char* env = std::getenv("GESTURELINK_RESULTS_DIR");
+    return env ? env : GESTURELINK_RESULTS_DIR;
+}
+
+std::string write(const std::string& suite,
+                  const std::vector<Benchmark>& benches,
+                  const std::string& path)
+{
+    std::string out_path = path;
+    if (out_path.empty()) {
+        const std::string dir = results_dir();
+        if (!make_dirs(dir)) {
+            std::fprintf(stderr, "[results] cannot create %s: %s\n", dir.c_str(), std::strerror(errno));
+            return "";
+        }
+        out_path = dir + "/" + suite + ".json";
+    }
+
+    std::ofstream f(out_path);
+    if (!f) {
+        std::fprintf(stderr, "[results] cannot write %s: %s\n", out_path.c_str(), std::strerror(errno));
+        return "";
+    }
+
+    struct utsname un{};
+    uname(&un);
+    char stamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    f << "{\n"
+      << "  \"schema\": \"gesturelink-bench/1\",\n"
+      << "  \"suite\": \"" << escape(suite) << "\",\n"
+      << "  \"env\": {\n"
+      << "    \"timestamp\": \"" << stamp << "\",\n"
+      << "    \"hostname\": \"" << escape(un.nodename) << "\",\n"
+      << "    \"kernel\": \"" << escape(un.release) << "\",\n"
+      << "    \"machine\": \"" << escape(un.machine) << "\",\n"
+      << "    \"cpu_model\": \"" << escape(cpu_model()) << "\",\n"
+      << "    \"cpu_count\": " << sysconf(_SC_NPROCESSORS_ONLN) << ",\n"
+      << "    \"governor\": \"" << escape(read_first_line(
+             "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor")) << "\",\n"
+      << "    \"compiler\": \"" << escape(__VERSION__) << "\",\n"
+#ifdef __OPTIMIZE__
+      << "    \"optimized\": true,\n"
+#else
+      << "    \"optimized\": false,\n"
+#endif
+      << "    \"git_rev\": \"" << escape(git_rev()) << "\"\n"
+      << "  },\n"
+      << "  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < benches.size(); ++i) {
+        const Benchmark& b = benches[i];
+        f << "    {\"name\": \"" << escape(b.name) << "\", \"unit\": \"" << escape(b.unit)
+          << "\", \"better\": \"" << (b.lower_is_better ? "lower" : "higher") << "\",\n"
+          << "     \"samples\": [";
+        for (size_t s = 0; s < b.samples.size(); ++s) {
+            f << (s ? ", " : "") << number(b.samples[s]);
+        }
+        f << "],\n     \"metrics\": {";
+        for (size_t m = 0; m < b.metrics.size(); ++m) {
+            f << (m ? ", " : "") << '"' << escape(b.metrics[m].first) << "\": "
+              << number(b.metrics[m].second);
+        }
+        f << "}}" << (i + 1 < benches.size() ? "," : "") << "\n";
+    }
+    f << "  ]\n}\n";
+    f.flush();
+    if (!f) {
+        std::fprintf(stderr, "[results] write to %s failed\n", out_path.c_str());
+        return "";
+    }
+    return out_path;
+}
+
+} // namespace BenchResults
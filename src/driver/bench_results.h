@@ -0,0 +1,52 @@
+#ifndef BENCH_RESULTS_H
+#define BENCH_RESULTS_H
+/*
+ * bench_results.h
+ * Machine-readable benchmark output shared by every native benchmark and
+ * latency test.  Files follow the "gesturelink-bench/1" schema also written
+ * by bench/results.py and read by bench/compare.py:
+ *
+ *   {
+ *     "schema": "gesturelink-bench/1",
+ *     "suite":  "<suite>",
+ *     "env":    { host / kernel / cpu / compiler / git metadata },
+ *     "benchmarks": [
+ *       { "name": "...", "unit": "ns/op", "better": "lower",
+ *         "samples": [ one value per repetition ],
+ *         "metrics": { "cycles": ..., ... } }
+ *     ]
+ *   }
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BenchResults {
+
+struct Benchmark {
+    std::string         name;
+    std::string         unit;
+    bool                lower_is_better = true;
+    std::vector<double> samples;                                  // per repetition
+    std::vector<std::pair<std::string, double>> metrics;          // extra, not compared
+};
+
+/**
+ * $GESTURELINK_RESULTS_DIR, or <repo>/results (resolved at build time, the
+ * same default as bench/results.py) wherever the binary is run from.
+ */
+std::string results_dir();
+
+/**
+ * Write @p benches for @p suite to @p path (default: results_dir()/<suite>.json),
+ * creating the directory and its parents if needed.
+ * @return the path written, or an empty string on failure (reported on stderr).
+ */
+std::string write(const std::string& suite,
+                  const std::vector<Benchmark>& benches,
+                  const std::string& path = "");
+
+} // namespace BenchResults
+
+#endif // BENCH_RESULTS_H
@@ -0,0 +1,174 @@
+/*
+ * bench_simd.cpp
+ * Per-ISA benchmarks for every SIMD kernel (simd.h), with libc as a
+ * reference where one exists.
+ *
+ * Scenarios (find_byte)
+ * ---------------------
+ *   line      - 16 bytes, newline at the end: one short protocol line
+ *   block     - 256 bytes, no newline: a partial read carried over
+ *   page      - 4096 bytes, no newline: a full stdin buffer
+ *   stream    - a 4096-byte buffer of protocol lines split the way
+ *               EventLoop::run does it (ns per line)
+ *
+ * Tiers the CPU cannot run are skipped.  Results go to
+ * $GESTURELINK_RESULTS_DIR/bench_simd.json as "find_byte/<scenario>/<isa>".
+ *
+ * Usage
+ * -----
+ *   make bench
+ *   ./bench_simd [--iters N] [--reps R] [--json PATH]
+ */
+
+#include "bench_results.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* find_byte_libc(const char* p, size_t n, char c)
+{
+    const void* hit = std::memchr(p, c, n);
+    return hit ? static_cast<const char*>(hit) : p + n;
+}
+
+struct Variant {
+    const char*      name;
+    Simd::FindByteFn fn;
+};
+
+struct Scenario {
+    const char* name;
+    std::string data;
+    bool        split_lines;   // scan line by line, ns per line
+};
+
+std::string protocol_lines(size_t bytes)
+{
+    std::string s;
+    for (int i = 0; s.size() < bytes; ++i) {
+        s += i % 8 == 3 ? "MOUSE_LEFT\n"
+                        : "MOUSE_MOVE " + std::to_string(i * 7 % 1920) + " " +
+                              std::to_string(i * 3 % 1080) + "\n";
+    }
+    s.resize(bytes);
+    return s;
+}
+
+volatile size_t g_sink;
+
+BenchResults::Benchmark run(const Scenario& sc, const Variant& v, long iters, int reps)
+{
+    // 64-byte aligned like EventLoop::run's buffer
+    alignas(64) static char buf[4096];
+    std::memcpy(buf, sc.data.data(), sc.data.size());
+    const char* const end = buf + sc.data.size();
+
+    size_t lines = 0;
+    for (const char* p = buf; p < end; ) {
+        const char* nl = v.fn(p, static_cast<size_t>(end - p), '\n');
+        ++lines;
+        p = nl + 1;
+    }
+    const size_t per_iter = sc.split_lines ? lines : 1;
+
+    BenchResults::Benchmark out;
+    out.name = std::string("find_byte/") + sc.name + "/" + v.name;
+    out.unit = "ns/op";
+
+    for (int rep = 0; rep < reps; ++rep) {
+        size_t acc = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < iters; ++i) {
+            if (sc.split_lines) {
+                for (const char* p = buf; p < end; ) {
+                    const char* nl = v.fn(p, static_cast<size_t>(end - p), '\n');
+                    acc += static_cast<size_t>(nl - p);
+                    p = nl + 1;
+                }
+            } else {
+                acc += static_cast<size_t>(v.fn(buf, sc.data.size(), '\n') - buf);
+            }
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        g_sink = acc;
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        out.samples.push_back(ns / static_cast<double>(iters * static_cast<long>(per_iter)));
+    }
+    out.metrics.emplace_back("bytes", static_cast<double>(sc.data.size()) / per_iter);
+    return out;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    long        iters = 200000;
+    int         reps  = 10;
+    std::string json_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if      (std::strcmp(argv[i], "--iters") == 0) iters     = std::atol(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--reps")  == 0) reps      = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--json")  == 0) json_path = argv[i + 1];
+    }
+    if (iters < 1) iters = 1;
+    if (reps < 1)  reps  = 1;
+
+    std::vector<Variant> variants;
+    for (int i = 0; i < Simd::kNumIsas; ++i) {
+        const Simd::Isa isa = static_cast<Simd::Isa>(i);
+        if (const Simd::Kernels* k = Simd::kernels_for(isa)) {
+            variants.push_back({Simd::isa_name(isa), k->find_byte});
+        } else {
+            std::fprintf(stderr, "[bench] %s not supported by this CPU, skipped.\n",
+                         Simd::isa_name(isa));
+        }
+    }
+    variants.push_back({"libc", find_byte_libc});
+
+    const Scenario scenarios[] = {
+        {"line",   std::string(15, 'x') + "\n", false},
+        {"block",  std::string(256, 'x'),       false},
+        {"page",   std::string(4096, 'x'),      false},
+        {"stream", protocol_lines(4096),        true},
+    };
+
+    std::printf("active tier: %s (cpu supports %s)\n", Simd::isa_name(Simd::active_isa()),
+                Simd::isa_name(Simd::cpu_isa()));
+    std::printf("%-8s", "scenario");
+    for (const Variant& v : variants) std::printf(" %10s", v.name);
+    std::printf("   (median ns/op of %d reps)\n", reps);
+
+    std::vector<BenchResults::Benchmark> results;
+    for (const Scenario& sc : scenarios) {
+        // The page scan is ~100x the line scan; keep each row's wall time similar.
+        const long n = sc.data.size() > 256 ? std::max(1L, iters / 32) : iters;
+        std::printf("%-8s", sc.name);
+        for (const Variant& v : variants) {
+            results.push_back(run(sc, v, n, reps));
+            std::printf(" %10.2f", median(results.back().samples));
+        }
+        std::printf("\n");
+    }
+
+    const std::string written = BenchResults::write("bench_simd", results, json_path);
+    if (written.empty()) {
+        std::fprintf(stderr, "[bench] failed to write results\n");
+        return 1;
+    }
+    std::fprintf(stderr, "[bench] results written to %s\n", written.c_str());
+    return 0;
+}
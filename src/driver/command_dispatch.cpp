@@ -0,0 +1,576 @@
+/*
+ * command_dispatch.cpp
+ * Text protocol parser / dispatcher shared by hid_driver, benchmarks and tests.
+ *
+ * The parser works on string_views over the caller's line buffer and uses
+ * std::from_chars for integers, so steady-state dispatch performs no heap
+ * allocation (enforced by tests/driver/test_budget.cpp).  Diagnostics go
+ * through the asynchronous, rate-limited AsyncLog so a producer spamming bad
+ * commands costs a ring push per line, not a blocking stderr write.
+ */
+
+#include "command_dispatch.h"
+#include "async_log.h"
+#include "flight_recorder.h"
+#include "keymap.h"
+#include "metrics.h"
+
+#include <linux/input-event-codes.h>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+namespace HidDriver {
+
+namespace {
+
+struct BtnName {
+    std::string_view       name;
+    VirtualHID::GamepadBtn btn;
+};
+
+constexpr BtnName kBtnMap[] = {
+    {"A",      VirtualHID::GamepadBtn::A},
+    {"B",      VirtualHID::GamepadBtn::B},
+    {"X",      VirtualHID::GamepadBtn::X},
+    {"Y",      VirtualHID::GamepadBtn::Y},
+    {"LB",     VirtualHID::GamepadBtn::LB},
+    {"RB",     VirtualHID::GamepadBtn::RB},
+    {"START",  VirtualHID::GamepadBtn::START},
+    {"SELECT", VirtualHID::GamepadBtn::SELECT},
+};
+
+bool gamepad_button(std::string_view name, VirtualHID::GamepadBtn& btn)
+{
+    for (const BtnName& b : kBtnMap) {
+        if (b.name == name) {
+            btn = b.btn;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool pointer_button(std::string_view name, uint16_t& code)
+{
+    constexpr std::string_view kNames[] = {"LEFT", "RIGHT", "MIDDLE"};
+    static_assert(sizeof(kNames) / sizeof(kNames[0]) ==
+                  sizeof(VirtualHID::kPointerButtons) / sizeof(VirtualHID::kPointerButtons[0]));
+    for (size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); ++i) {
+        if (name == kNames[i]) {
+            code = VirtualHID::kPointerButtons[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Whitespace-separated token cursor over a line. */
+struct Tokens {
+    std::string_view rest;
+
+    std::string_view next()
+    {
+        size_t b = 0;
+        while (b < rest.size() && (rest[b] == ' ' || rest[b] == '\t' || rest[b] == '\r')) ++b;
+        size_t e = b;
+        while (e < rest.size() && rest[e] != ' ' && rest[e] != '\t' && rest[e] != '\r') ++e;
+        std::string_view tok = rest.substr(b, e - b);
+        rest.remove_prefix(e);
+        return tok;
+    }
+
+    bool next_int(int& out)
+    {
+        std::string_view tok = next();
+        if (!tok.empty() && tok[0] == '+') tok.remove_prefix(1);
+        if (tok.empty()) return false;
+        const auto r = std::from_chars(tok.data(), tok.data() + tok.size(), out);
+        return r.ec == std::errc() && r.ptr == tok.data() + tok.size();
+    }
+
+    /** A decimal ("512", "-3.25") in 1/@p scale units, rounded to nearest. */
+    bool next_fixed(int& out, int scale)
+    {
+        std::string_view tok = next();
+        if (!tok.empty() && tok[0] == '+') tok.remove_prefix(1);
+        const bool neg = !tok.empty() && tok[0] == '-';
+        if (neg) tok.remove_prefix(1);
+        const size_t dot = tok.find('.');
+        const std::string_view whole = tok.substr(0, dot);
+        const std::string_view frac  = dot == std::string_view::npos ? std::string_view{}
+                                                                     : tok.substr(dot + 1);
+        if (whole.empty() && frac.empty()) return false;
+
+        int w = 0;
+        if (!whole.empty()) {
+            if (whole[0] < '0' || whole[0] > '9') return false;
+            const auto r = std::from_chars(whole.data(), whole.data() + whole.size(), w);
+            if (r.ec != std::errc() || r.ptr != whole.data() + whole.size()) return false;
+        }
+        int64_t num = 0, den = 1;
+        for (const char c : frac) {
+            if (c < '0' || c > '9') return false;
+            if (den < 1000000) {
+                num = num * 10 + (c - '0');
+                den *= 10;
+            }
+        }
+        if (w > INT_MAX / scale - 1) return false;
+        const int v = w * scale + static_cast<int>((num * scale + den / 2) / den);
+        out = neg ? -v : v;
+        return true;
+    }
+};
+
+DispatchResult unknown_button(std::string_view name)
+{
+    HID_LOG(AsyncLog::Level::Warn, "[hid_driver] Unknown gamepad button: {}", name);
+    Metrics::inc(Metrics::kCmdUnknown);
+    return DispatchResult::Unknown;
+}
+
+DispatchResult keyboard_busy(std::string_view cmd)
+{
+    HID_LOG(AsyncLog::Level::Warn, "[hid_driver] {}: keyboard queue full, dropped", cmd);
+    return DispatchResult::Ignored;
+}
+
+DispatchResult macro_busy(std::string_view name)
+{
+    HID_LOG(AsyncLog::Level::Warn, "[hid_driver] MACRO {}: {} macros already running, dropped", name,
+            Macro::kMaxPlaying);
+    return DispatchResult::Ignored;
+}
+
+DispatchResult unknown_key(std::string_view name)
+{
+    HID_LOG(AsyncLog::Level::Warn, "[hid_driver] Unknown key: {}", name);
+    Metrics::inc(Metrics::kCmdUnknown);
+    return DispatchResult::Unknown;
+}
+
+} // namespace
+
+DispatchResult dispatch(Devices& dev, std::string_view line)
+{
+    if (line.empty() || line[0] == '#') return DispatchResult::Ignored;
+
+    FlightRecorder::record_command(line.data(), line.size());
+
+    Tokens ss{line};
+    const std::string_view cmd = ss.next();
+
+    // Any new hand input ends a flick; POWER only reports that no hand is seen.
+    if (dev.mouse.coasting && cmd != "MOUSE_RELEASE" && cmd != "POWER") VirtualHID::mouse_stop(dev.mouse);
+
+    if (cmd == "QUIT") {
+        Metrics::inc(Metrics::kCmdQuit);
+        return DispatchResult::Quit;
+    }
+    else if (cmd == "MOUSE_MOVE") {
+        int x, y;
+        if (ss.next_int(x) && ss.next_int(y)) {
+            if (dev.mouse.friction > 0) VirtualHID::mouse_sample(dev.mouse, x, y, dev.clock->now_ns());
+            VirtualHID::mouse_move_abs(dev.mouse, x, y);
+            Metrics::inc(Metrics::kCmdMouseMove);
+            Metrics::set_gauge(Metrics::kCursorX, x);
+            Metrics::set_gauge(Metrics::kCursorY, y);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "MOUSE_RELEASE") {
+        // Pointing ended: coast on if it was a flick (inertia on), else nothing.
+        if (dev.mouse.friction > 0) VirtualHID::mouse_release(dev.mouse, dev.clock->now_ns());
+        Metrics::inc(Metrics::kCmdMouseRelease);
+        return DispatchResult::Handled;
+    }
+    else if (cmd == "MOUSE_LEFT") {
+        VirtualHID::mouse_click(dev.mouse, BTN_LEFT);
+        Metrics::inc(Metrics::kCmdMouseLeft);
+        return DispatchResult::Handled;
+    }
+    else if (cmd == "MOUSE_RIGHT") {
+        VirtualHID::mouse_click(dev.mouse, BTN_RIGHT);
+        Metrics::inc(Metrics::kCmdMouseRight);
+        return DispatchResult::Handled;
+    }
+    else if (cmd == "MOUSE_SCROLL") {
+        int delta;
+        if (ss.next_int(delta)) {
+            VirtualHID::mouse_scroll(dev.mouse, delta);
+            Metrics::inc(Metrics::kCmdMouseScroll);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "GAMEPAD_BTN") {
+        const std::string_view name = ss.next();
+        int state;
+        if (!name.empty() && ss.next_int(state)) {
+            VirtualHID::GamepadBtn btn;
+            if (!gamepad_button(name, btn)) return unknown_button(name);
+            // Holding or releasing a button by hand ends its autofire.
+            if (dev.gamepad.turbo_count > 0) {
+                VirtualHID::gamepad_turbo(dev.gamepad, btn, 0, 0, 0);
+                Metrics::set_gauge(Metrics::kTurboButtons, dev.gamepad.turbo_count);
+            }
+            VirtualHID::gamepad_button(dev.gamepad, btn, state != 0);
+            Metrics::inc(Metrics::kCmdGamepadBtn);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "GAMEPAD_TURBO") {
+        // GAMEPAD_TURBO <btn> <hz> <duty%> starts (or retunes) autofire; <hz> 0 stops it.
+        const std::string_view name = ss.next();
+        int hz, duty = 0;
+        if (!name.empty() && ss.next_int(hz) && (hz == 0 || ss.next_int(duty))) {
+            VirtualHID::GamepadBtn btn;
+            if (!gamepad_button(name, btn)) return unknown_button(name);
+            if (VirtualHID::gamepad_turbo(dev.gamepad, btn, hz, duty, dev.clock->now_ns())) {
+                Metrics::inc(Metrics::kCmdGamepadTurbo);
+                Metrics::set_gauge(Metrics::kTurboButtons, dev.gamepad.turbo_count);
+                return DispatchResult::Handled;
+            }
+        }
+    }
+    else if (cmd == "GAMEPAD_STICK") {
+        int x, y;
+        if (ss.next_int(x) && ss.next_int(y)) {
+            VirtualHID::gamepad_stick(dev.gamepad, x, y);
+            Metrics::inc(Metrics::kCmdGamepadStick);
+            Metrics::set_gauge(Metrics::kStickX, x);
+            Metrics::set_gauge(Metrics::kStickY, y);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "KEY_DOWN" || cmd == "KEY_UP") {
+        const std::string_view name = ss.next();
+        uint16_t code;
+        if (!name.empty()) {
+            if (!Keymap::key_code(name, code)) return unknown_key(name);
+            const bool down = cmd == "KEY_DOWN";
+            if (!VirtualHID::keyboard_key(dev.keyboard, code, down)) return keyboard_busy(cmd);
+            Metrics::inc(down ? Metrics::kCmdKeyDown : Metrics::kCmdKeyUp);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "KEY_CHORD") {
+        // CTRL+SHIFT+TAB: keys joined by '+', pressed left to right; an empty key
+        // (CTRL+, +A, CTRL++A) is malformed
+        std::string_view keys = ss.next();
+        uint16_t codes[VirtualHID::kMaxChord];
+        int n = 0;
+        while (!keys.empty() && keys.back() != '+' && n < VirtualHID::kMaxChord) {
+            const size_t plus = keys.find('+');
+            const std::string_view name = keys.substr(0, plus);
+            if (name.empty()) break;
+            if (!Keymap::key_code(name, codes[n++])) return unknown_key(name);
+            keys.remove_prefix(plus == std::string_view::npos ? keys.size() : plus + 1);
+        }
+        if (n > 0 && keys.empty()) {
+            if (!VirtualHID::keyboard_chord(dev.keyboard, codes, n)) return keyboard_busy(cmd);
+            Metrics::inc(Metrics::kCmdKeyChord);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "TYPE") {
+        // Everything after the single separating space is text.
+        std::string_view text = ss.rest;
+        if (!text.empty()) text.remove_prefix(1);
+        if (text.size() > VirtualHID::kMaxTypeLen) {                // refused whole, not cut short
+            HID_LOG(AsyncLog::Level::Warn, "[hid_driver] TYPE: {} bytes of text, limit {}", text.size(),
+                    VirtualHID::kMaxTypeLen);
+            return DispatchResult::Ignored;
+        }
+        if (!text.empty()) {
+            size_t unmapped = 0;
+            if (!VirtualHID::keyboard_type(dev.keyboard, text, unmapped)) return keyboard_busy(cmd);
+            Metrics::inc(Metrics::kCmdType);
+            if (unmapped) {
+                HID_LOG(AsyncLog::Level::Warn, "[hid_driver] TYPE: {} characters not on the layout",
+                        unmapped);
+                Metrics::inc(Metrics::kKeysUnmapped, unmapped);
+            }
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "TOUCH") {
+        // <slot> <x> <y> | <slot> UP, repeated: every change lands in one frame.
+        // Parsed in full before anything is applied, so a bad item changes nothing.
+        VirtualHID::TouchUpdate updates[VirtualHID::kMaxTouchSlots];
+        int  n  = 0;
+        bool ok = true;
+        while (ok && !Tokens{ss}.next().empty()) {
+            VirtualHID::TouchUpdate& u = updates[n];
+            ok = n < VirtualHID::kMaxTouchSlots && ss.next_int(u.slot) &&
+                 u.slot >= 0 && u.slot < VirtualHID::kMaxTouchSlots;
+            if (!ok) break;
+            const Tokens after_slot = ss;
+            u.up = ss.next() == "UP";
+            if (!u.up) {
+                ss = after_slot;
+                ok = ss.next_int(u.x) && ss.next_int(u.y);
+            }
+            ++n;
+        }
+        if (ok && n > 0) {
+            const int contacts = VirtualHID::touch_frame(dev.touch, updates, n);
+            Metrics::inc(Metrics::kCmdTouch);
+            Metrics::set_gauge(Metrics::kTouchContacts, contacts);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "POINTER") {
+        // <id> <x> <y> | <id> DOWN|UP LEFT|RIGHT|MIDDLE, repeated: one frame per pointer
+        // that changed.  Parsed in full first, like TOUCH.
+        VirtualHID::PointerUpdate updates[VirtualHID::kMaxPointerUpdates];
+        int  n  = 0;
+        bool ok = true;
+        while (ok && !Tokens{ss}.next().empty()) {
+            VirtualHID::PointerUpdate& u = updates[n];
+            ok = n < VirtualHID::kMaxPointerUpdates && ss.next_int(u.id) && u.id >= 0 &&
+                 u.id < dev.pointers.count;
+            if (!ok) break;
+            const Tokens after_id = ss;
+            const std::string_view verb = ss.next();
+            if (verb == "DOWN" || verb == "UP") {
+                u.pressed = verb == "DOWN";
+                ok = pointer_button(ss.next(), u.button);
+            } else {
+                ss = after_id;
+                ok = ss.next_int(u.x) && ss.next_int(u.y);
+            }
+            ++n;
+        }
+        if (ok && n > 0) {
+            VirtualHID::pointers_frame(dev.pointers, updates, n);
+            Metrics::inc(Metrics::kCmdPointer);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "PEN") {
+        // PEN <x> <y> <pressure> <tilt_x> <tilt_y> | PEN OUT; x and y may be fractional.
+        const Tokens args = ss;
+        if (ss.next() == "OUT") {
+            VirtualHID::pen_out(dev.pen);
+            Metrics::inc(Metrics::kCmdPen);
+            Metrics::set_gauge(Metrics::kPenPressure, 0);
+            return DispatchResult::Handled;
+        }
+        ss = args;
+        VirtualHID::PenSample s;
+        if (ss.next_fixed(s.x, VirtualHID::kPenSubpixel) && ss.next_fixed(s.y, VirtualHID::kPenSubpixel) &&
+            ss.next_int(s.pressure) && ss.next_int(s.tilt_x) && ss.next_int(s.tilt_y)) {
+            VirtualHID::pen_frame(dev.pen, s, dev.clock->now_ns());
+            Metrics::inc(Metrics::kCmdPen);
+            Metrics::set_gauge(Metrics::kPenPressure, dev.pen.abs.get<ABS_PRESSURE>());
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "GYRO") {
+        // GYRO <rx> <ry> <rz> in deg/s, fractional | GYRO OFF
+        const Tokens args = ss;
+        if (ss.next() == "OFF") {
+            VirtualHID::gyro_stop(dev.gyro, dev.clock->now_ns());
+            Metrics::inc(Metrics::kCmdGyro);
+            return DispatchResult::Handled;
+        }
+        ss = args;
+        int rate[3];
+        if (ss.next_fixed(rate[0], VirtualHID::kGyroResPerDps) && ss.next_fixed(rate[1], VirtualHID::kGyroResPerDps) &&
+            ss.next_fixed(rate[2], VirtualHID::kGyroResPerDps)) {
+            VirtualHID::gyro_sample(dev.gyro, rate, dev.clock->now_ns());
+            Metrics::inc(Metrics::kCmdGyro);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "MACRO") {
+        const std::string_view name = ss.next();
+        if (!name.empty()) {
+            if (!dev.macros.set || !dev.macros.set->find(name)) {
+                HID_LOG(AsyncLog::Level::Warn, "[hid_driver] Unknown macro: {}", name);
+                Metrics::inc(Metrics::kCmdUnknown);
+                return DispatchResult::Unknown;
+            }
+            if (!Macro::start(dev.macros, name, dev.clock->now_ns())) return macro_busy(name);
+            Metrics::inc(Metrics::kCmdMacro);
+            Metrics::set_gauge(Metrics::kMacrosRunning, dev.macros.active);
+            return DispatchResult::Handled;
+        }
+    }
+    else if (cmd == "MACRO_STOP") {
+        // MACRO_STOP [<name>]: cancel one macro, or all of them.
+        Macro::stop(dev.macros, ss.next());
+        Metrics::inc(Metrics::kCmdMacroStop);
+        Metrics::set_gauge(Metrics::kMacrosRunning, dev.macros.active);
+        return DispatchResult::Handled;
+    }
+    else if (cmd == "POWER") {
+        const std::string_view state = ss.next();
+        if (state == "IDLE" || state == "ACTIVE") {
+            dev.idle = state == "IDLE";
+            Metrics::inc(Metrics::kCmdPower);
+            Metrics::set_gauge(Metrics::kPowerIdle, dev.idle);
+            return DispatchResult::Handled;
+        }
+    }
+    else {
+        HID_LOG(AsyncLog::Level::Warn, "[hid_driver] Unknown command: {}", cmd);
+        Metrics::inc(Metrics::kCmdUnknown);
+        return DispatchResult::Unknown;
+    }
+
+    Metrics::inc(Metrics::kCmdMalformed);
+    return DispatchResult::Ignored;
+}
+
+size_t format_feedback(const VirtualHID::FfEvent& ev, char* out, size_t cap)
+{
+    const int n = ev.play ? std::snprintf(out, cap, "FF PLAY %d %u %u %u\n", ev.id, ev.strong, ev.weak,
+                                          ev.length_ms)
+                          : std::snprintf(out, cap, "FF STOP %d\n", ev.id);
+    return n > 0 && static_cast<size_t>(n) < cap ? static_cast<size_t>(n) : 0;
+}
+
+// ---- Macro files -------------------------------------------------------------
+
+namespace {
+
+/** One parsed macro step: up to two events for one device. */
+struct MacroStep {
+    int64_t      t_ns;
+    Macro::Event ev[2];
+    int          n;
+};
+
+/** Parse "<ms> <command> <args>" into @p step; @p why says what is wrong. */
+bool parse_step(std::string_view line, MacroStep& step, std::string& why)
+{
+    Tokens ss{line};
+    int t_us;
+    if (!ss.next_fixed(t_us, 1000) || t_us < 0) {
+        why = "expected a time in ms";
+        return false;
+    }
+    step.t_ns = int64_t{t_us} * 1000;
+    step.n    = 0;
+    auto add = [&](uint8_t target, uint16_t type, uint16_t code, int32_t value) {
+        step.ev[step.n++] = Macro::Event{step.t_ns, target, type, code, value};
+    };
+    const std::string_view cmd = ss.next();
+    if (cmd == "GAMEPAD_BTN") {
+        const std::string_view name = ss.next();
+        VirtualHID::GamepadBtn btn;
+        int state;
+        if (!gamepad_button(name, btn)) {
+            why = "unknown gamepad button '" + std::string(name) + "'";
+            return false;
+        }
+        if (!ss.next_int(state)) {
+            why = "expected GAMEPAD_BTN <name> <1|0>";
+            return false;
+        }
+        add(Macro::kGamepad, EV_KEY, static_cast<uint16_t>(btn), state != 0);
+    } else if (cmd == "GAMEPAD_STICK") {
+        int x, y;
+        if (!ss.next_int(x) || !ss.next_int(y)) {
+            why = "expected GAMEPAD_STICK <x> <y>";
+            return false;
+        }
+        auto clamp = [](int v) { return v < -32767 ? -32767 : v > 32767 ? 32767 : v; };
+        add(Macro::kGamepad, EV_ABS, ABS_X, clamp(x));
+        add(Macro::kGamepad, EV_ABS, ABS_Y, clamp(y));
+    } else if (cmd == "KEY_DOWN" || cmd == "KEY_UP") {
+        const std::string_view name = ss.next();
+        uint16_t code;
+        if (!Keymap::key_code(name, code)) {
+            why = "unknown key '" + std::string(name) + "'";
+            return false;
+        }
+        add(Macro::kKeyboard, EV_KEY, code, cmd == "KEY_DOWN");
+    } else {
+        why = "'" + std::string(cmd) + "' cannot be used in a macro";
+        return false;
+    }
+    if (!ss.next().empty()) {
+        why = "unexpected text after " + std::string(cmd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Append @p steps as macro @p def's events: sorted by time (stable), with a
+ * SYN_REPORT closing each run of steps that share a time and device.
+ */
+void emit_macro(Macro::Set& out, Macro::Def& def, std::vector<MacroStep>& steps)
+{
+    std::stable_sort(steps.begin(), steps.end(),
+                     [](const MacroStep& a, const MacroStep& b) { return a.t_ns < b.t_ns; });
+    def.first = static_cast<uint32_t>(out.events.size());
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const MacroStep& st = steps[i];
+        out.events.insert(out.events.end(), st.ev, st.ev + st.n);
+        if (i + 1 == steps.size() || steps[i + 1].t_ns != st.t_ns || steps[i + 1].ev[0].target != st.ev[0].target) {
+            out.events.push_back(Macro::Event{st.t_ns, st.ev[0].target, EV_SYN, SYN_REPORT, 0});
+        }
+    }
+    def.count     = static_cast<uint32_t>(out.events.size()) - def.first;
+    def.length_ns = steps.back().t_ns;
+    out.defs.push_back(std::move(def));
+    steps.clear();
+}
+
+} // namespace
+
+bool compile_macros(std::string_view text, Macro::Set& out, std::string& error)
+{
+    out = Macro::Set{};
+    Macro::Def             def;
+    std::vector<MacroStep> steps;
+    int                    def_line = 0;
+    std::string            why;
+
+    auto fail = [&](int line_no, const std::string& reason) {
+        error = "line " + std::to_string(line_no) + ": " + reason;
+        out   = Macro::Set{};
+        return false;
+    };
+
+    for (int line_no = 1; !text.empty(); ++line_no) {
+        const size_t nl = text.find('\n');
+        Tokens line{text.substr(0, nl)};
+        text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+
+        const Tokens rest = line;
+        const std::string_view first = line.next();
+        if (first.empty() || first[0] == '#') continue;
+        if (first.front() == '[') {
+            if (first.size() < 3 || first.back() != ']' || !line.next().empty()) {
+                return fail(line_no, "expected [<name>]");
+            }
+            if (def_line != 0) {
+                if (steps.empty()) return fail(def_line, "macro [" + def.name + "] has no steps");
+                emit_macro(out, def, steps);
+            }
+            def      = Macro::Def{};
+            def.name = std::string(first.substr(1, first.size() - 2));
+            def_line = line_no;
+            if (out.find(def.name)) return fail(line_no, "macro [" + def.name + "] defined twice");
+            continue;
+        }
+        if (def_line == 0) return fail(line_no, "step before the first [<name>]");
+        MacroStep step;
+        if (!parse_step(rest.rest, step, why)) return fail(line_no, why);
+        steps.push_back(step);
+    }
+    if (def_line != 0) {
+        if (steps.empty()) return fail(def_line, "macro [" + def.name + "] has no steps");
+        emit_macro(out, def, steps);
+    }
+    return true;
+}
+
+} // namespace HidDriver
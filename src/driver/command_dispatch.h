@@ -0,0 +1,68 @@
+#ifndef COMMAND_DISPATCH_H
+#define COMMAND_DISPATCH_H
+/*
+ * command_dispatch.h
+ * Parses one line of the hid_driver text protocol and dispatches it to the
+ * virtual devices, formats the force-feedback back-channel and compiles macro
+ * files with the same names.  Split out of hid_driver.cpp so that benchmarks and
+ * tests can drive the exact production path against any fd (e.g. /dev/null
+ * or a socketpair) instead of a real uinput device.
+ */
+
+#include "event_loop.h"
+#include "macro.h"
+#include "virtual_hid.h"
+
+#include <string>
+#include <string_view>
+
+namespace HidDriver {
+
+/** The set of virtual devices a command stream is dispatched to. */
+struct Devices {
+    VirtualHID::MouseState    mouse;
+    VirtualHID::GamepadState  gamepad;
+    VirtualHID::KeyboardState keyboard;
+    VirtualHID::TouchState    touch;
+    VirtualHID::PenState      pen;
+    VirtualHID::PointerSet    pointers;
+    VirtualHID::GyroState     gyro;
+    Macro::Player             macros;   // its fd[] are the gamepad and keyboard fds, set on open
+    bool                      idle = false;   // POWER IDLE seen; the loop backs off its timers
+    const EventLoop::Clock*   clock = &EventLoop::monotonic_clock();   // stamps PEN / GYRO / MOUSE_MOVE / GAMEPAD_TURBO / MACRO
+};
+
+enum class DispatchResult {
+    Handled,    // command recognised and executed
+    Ignored,    // blank line, comment, or malformed arguments
+    Unknown,    // unrecognised command, gamepad button or key
+    Quit,       // QUIT received
+};
+
+/**
+ * Parse and execute a single protocol line (without trailing newline).
+ * Records the line in the flight recorder before executing it.
+ * Does not allocate.
+ */
+DispatchResult dispatch(Devices& dev, std::string_view line);
+
+/**
+ * Format one force-feedback change as a back-channel line to the producer
+ * (newline-terminated, magnitudes 0..65535 with the gain applied):
+ *   FF PLAY <id> <strong> <weak> <length_ms>   - effect started or changed
+ *   FF STOP <id>                               - effect stopped or erased
+ * @return the line's length; 0 if it does not fit in @p cap bytes.
+ */
+size_t format_feedback(const VirtualHID::FfEvent& ev, char* out, size_t cap);
+
+/**
+ * Compile a macro file (syntax in macro.h) into @p out, replacing what it
+ * held.  Steps are parsed with the protocol's own button and key names.
+ * @return false with "line <n>: <reason>" in @p error on the first bad line.
+ * Allocates; meant for startup, not the hot path.
+ */
+bool compile_macros(std::string_view text, Macro::Set& out, std::string& error);
+
+} // namespace HidDriver
+
+#endif // COMMAND_DISPATCH_H
@@ -0,0 +1,104 @@
+/*
+ * device_descriptor.cpp
+ * Runs a device's generated setup against /dev/uinput.
+ */
+
+#include "device_descriptor.h"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace VirtualHID {
+
+namespace {
+
+int open_uinput(int access)
+{
+    int fd = open("/dev/uinput", access | O_NONBLOCK);
+    if (fd < 0) {
+        // Fallback path used on some distros
+        fd = open("/dev/input/uinput", access | O_NONBLOCK);
+    }
+    if (fd < 0) {
+        std::cerr << "[VirtualHID] Cannot open /dev/uinput: " << strerror(errno)
+                  << ". Ensure the uinput kernel module is loaded (modprobe uinput) and "
+                     "that your user is in the 'input' group or run with appropriate permissions.\n";
+    }
+    return fd;
+}
+
+/** Log @p what for @p d with errno, close @p fd and return -1. */
+int fail(const DeviceDesc& d, int fd, const char* what)
+{
+    std::cerr << "[VirtualHID] " << what << " (" << d.tag << ") failed: " << strerror(errno) << '\n';
+    close(fd);
+    return -1;
+}
+
+} // namespace
+
+void fill_user_dev(const DeviceDesc& d, int screen_w, int screen_h, const char* name, uinput_user_dev& out)
+{
+    out = uinput_user_dev{};
+    snprintf(out.name, UINPUT_MAX_NAME_SIZE, "%s", name ? name : d.name);
+    out.id.bustype     = BUS_VIRTUAL;
+    out.id.vendor      = 0x1357;
+    out.id.product     = d.product;
+    out.id.version     = 1;
+    out.ff_effects_max = static_cast<uint32_t>(d.ff_effects_max);
+    for (int code = 0; code < ABS_CNT; ++code) {
+        if (!d.axes.test(code)) continue;
+        const AbsAxis& a = d.abs_info[code];
+        const AbsRange r = axis_range(a, screen_w, screen_h);
+        out.absmin[code]  = r.min;
+        out.absmax[code]  = r.max;
+        out.absfuzz[code] = a.fuzz;
+        out.absflat[code] = a.flat;
+    }
+}
+
+int open_device(const DeviceDesc& d, const SetupOp* program, size_t n, int screen_w, int screen_h,
+                const char* name)
+{
+    const int fd = open_uinput(d.ffs.count() > 0 ? O_RDWR : O_WRONLY);
+    if (fd < 0) return -1;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (ioctl(fd, program[i].request, program[i].arg) < 0) return fail(d, fd, "capability setup");
+    }
+
+    uinput_user_dev uidev;
+    fill_user_dev(d, screen_w, screen_h, name, uidev);
+    if (!d.needs_abs_setup()) {
+        if (write(fd, &uidev, sizeof(uidev)) != static_cast<ssize_t>(sizeof(uidev))) {
+            return fail(d, fd, "write uidev");
+        }
+    } else {
+        for (int code = 0; code < ABS_CNT; ++code) {
+            if (!d.axes.test(code)) continue;
+            uinput_abs_setup abs{};
+            abs.code               = static_cast<uint16_t>(code);
+            abs.absinfo.minimum    = uidev.absmin[code];
+            abs.absinfo.maximum    = uidev.absmax[code];
+            abs.absinfo.fuzz       = uidev.absfuzz[code];
+            abs.absinfo.flat       = uidev.absflat[code];
+            abs.absinfo.resolution = d.abs_info[code].res;
+            if (ioctl(fd, UI_ABS_SETUP, &abs) < 0) return fail(d, fd, "UI_ABS_SETUP");
+        }
+        uinput_setup setup{};
+        std::memcpy(setup.name, uidev.name, sizeof(setup.name));
+        setup.id             = uidev.id;
+        setup.ff_effects_max = uidev.ff_effects_max;
+        if (ioctl(fd, UI_DEV_SETUP, &setup) < 0) return fail(d, fd, "UI_DEV_SETUP");
+    }
+
+    if (ioctl(fd, UI_DEV_CREATE) < 0) return fail(d, fd, "UI_DEV_CREATE");
+    return fd;
+}
+
+} // namespace VirtualHID
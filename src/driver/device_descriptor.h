@@ -0,0 +1,290 @@
+#ifndef DEVICE_DESCRIPTOR_H
+#define DEVICE_DESCRIPTOR_H
+/*
+ * device_descriptor.h
+ * Compile-time descriptions of what a virtual device can report, and the
+ * uinput setup generated from them.
+ *
+ * A device is one constexpr DeviceDesc built by chaining:
+ *
+ *   inline constexpr DeviceDesc kMouseDevice =
+ *       DeviceDesc("mouse", "GestureLink Virtual Mouse", 0x0001)
+ *           .key(BTN_LEFT).key(BTN_RIGHT).key(BTN_MIDDLE)
+ *           .abs({ABS_X, 0, 1, Extent::kScreenW})
+ *           .abs({ABS_Y, 0, 1, Extent::kScreenH})
+ *           .rel(REL_WHEEL);
+ *
+ * Event types follow from the codes listed.  A code out of range, a code
+ * listed twice or an axis range the kernel would refuse throws inside the
+ * builder, which fails the constant evaluation and so the build.  From a
+ * descriptor the build generates:
+ *   setup_program<D>       the flat UI_SET_*BIT sequence open_device() runs
+ *   DeviceDesc::supports() capability tests; VirtualHID::add<D, type, code>
+ *                          does not compile for an event D never advertised
+ *   DeviceDesc::abs_slot() dense axis indices, the layout of
+ *                          VirtualHID::AbsCache<D>
+ *
+ * uinput has no call that sets several capability bits, so the batching is
+ * in what is left out: open_device() registers every axis range with the
+ * one write(2) of uinput_user_dev, and only a device with an axis
+ * resolution (which that struct lacks) falls back to UI_DEV_SETUP plus one
+ * UI_ABS_SETUP per axis.  UI_ABS_SETUP sets the axis bit itself, so the
+ * program then leaves UI_SET_ABSBIT out.
+ */
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace VirtualHID {
+
+/** Where an axis maximum comes from. */
+enum class Extent : uint8_t {
+    kFixed,     // max as given
+    kScreenW,   // max is units per pixel: the range is [min, screen_w * max - 1]
+    kScreenH,
+};
+
+struct AbsAxis {
+    uint16_t code   = 0;
+    int32_t  min    = 0;
+    int32_t  max    = 0;
+    Extent   extent = Extent::kFixed;
+    int32_t  fuzz   = 0;
+    int32_t  flat   = 0;
+    int32_t  res    = 0;        // units per mm (per radian, per deg/s for rates); 0 = none
+};
+
+/** The range @p a has on a @p screen_w x @p screen_h screen. */
+struct AbsRange {
+    int32_t min, max;
+};
+
+constexpr AbsRange axis_range(const AbsAxis& a, int screen_w, int screen_h)
+{
+    switch (a.extent) {
+    case Extent::kScreenW: return {a.min, screen_w * a.max - 1};
+    case Extent::kScreenH: return {a.min, screen_h * a.max - 1};
+    default:               return {a.min, a.max};
+    }
+}
+
+/** A fixed-size bit set usable in constant expressions. */
+template <size_t N>
+struct CapBits {
+    uint64_t word[(N + 63) / 64] = {};
+
+    constexpr bool test(size_t i) const { return i < N && (word[i / 64] >> (i % 64) & 1u); }
+
+    constexpr int count() const
+    {
+        int n = 0;
+        for (size_t i = 0; i < N; ++i) n += test(i);
+        return n;
+    }
+
+    constexpr void add(size_t i)
+    {
+        if (i >= N) throw "capability code out of range";
+        if (test(i)) throw "capability listed twice";
+        word[i / 64] |= uint64_t{1} << (i % 64);
+    }
+};
+
+/** One step of a device's setup: ioctl(fd, request, arg). */
+struct SetupOp {
+    unsigned long request;
+    uint16_t      arg;
+};
+
+struct DeviceDesc {
+    const char* tag;             // "mouse": log messages
+    const char* name;            // evdev device name (at most UINPUT_MAX_NAME_SIZE - 1)
+    uint16_t    product;         // vendor is 0x1357, bus BUS_VIRTUAL
+    int         ff_effects_max = 0;
+
+    CapBits<INPUT_PROP_CNT> props;
+    CapBits<KEY_CNT>        keys;
+    CapBits<ABS_CNT>        axes;
+    CapBits<REL_CNT>        rels;
+    CapBits<MSC_CNT>        mscs;
+    CapBits<FF_CNT>         ffs;
+    AbsAxis                 abs_info[ABS_CNT] = {};
+
+    constexpr DeviceDesc(const char* tag_, const char* name_, uint16_t product_)
+        : tag(tag_), name(name_), product(product_) {}
+
+    // ---- Builder: each returns a copy with one more capability ----
+
+    constexpr DeviceDesc prop(uint16_t p) const
+    {
+        DeviceDesc d = *this;
+        d.props.add(p);
+        return d;
+    }
+
+    constexpr DeviceDesc key(uint16_t code) const
+    {
+        DeviceDesc d = *this;
+        d.keys.add(code);
+        return d;
+    }
+
+    /** Every key from @p first to @p last inclusive. */
+    constexpr DeviceDesc keys_range(uint16_t first, uint16_t last) const
+    {
+        DeviceDesc d = *this;
+        for (int code = first; code <= last; ++code) d.keys.add(static_cast<size_t>(code));
+        return d;
+    }
+
+    constexpr DeviceDesc abs(const AbsAxis& a) const
+    {
+        // The checks uinput_validate_absinfo() would fail at UI_DEV_CREATE
+        if (a.extent == Extent::kFixed ? a.min >= a.max : a.max < 1 || a.min != 0) throw "empty axis range";
+        if (a.fuzz < 0 || a.flat < 0 || a.res < 0) throw "negative fuzz, flat or resolution";
+        if (a.extent == Extent::kFixed && (a.fuzz > a.max - a.min || a.flat > a.max - a.min)) {
+            throw "fuzz or flat wider than the axis range";
+        }
+        DeviceDesc d = *this;
+        d.axes.add(a.code);
+        d.abs_info[a.code] = a;
+        return d;
+    }
+
+    constexpr DeviceDesc rel(uint16_t code) const
+    {
+        DeviceDesc d = *this;
+        d.rels.add(code);
+        return d;
+    }
+
+    constexpr DeviceDesc msc(uint16_t code) const
+    {
+        DeviceDesc d = *this;
+        d.mscs.add(code);
+        return d;
+    }
+
+    /** Force-feedback effect types, uploaded into at most @p effects_max slots. */
+    constexpr DeviceDesc ff(uint16_t code, int effects_max) const
+    {
+        if (effects_max <= 0 || (ff_effects_max != 0 && effects_max != ff_effects_max)) {
+            throw "inconsistent force-feedback effect count";
+        }
+        DeviceDesc d = *this;
+        d.ffs.add(code);
+        d.ff_effects_max = effects_max;
+        return d;
+    }
+
+    // ---- Queries ----
+
+    /** Whether the device advertises event @p type / @p code (SYN always). */
+    constexpr bool supports(uint16_t type, uint16_t code) const
+    {
+        switch (type) {
+        case EV_SYN: return true;
+        case EV_KEY: return keys.test(code);
+        case EV_ABS: return axes.test(code);
+        case EV_REL: return rels.test(code);
+        case EV_MSC: return mscs.test(code);
+        case EV_FF:  return ffs.test(code);
+        default:     return false;
+        }
+    }
+
+    constexpr int abs_count() const { return axes.count(); }
+
+    /** Index of axis @p code among the device's axes in code order; -1 if absent. */
+    constexpr int abs_slot(uint16_t code) const
+    {
+        if (!axes.test(code)) return -1;
+        int slot = 0;
+        for (uint16_t c = 0; c < code; ++c) slot += axes.test(c);
+        return slot;
+    }
+
+    /** Whether an axis needs UI_ABS_SETUP (a resolution) rather than uinput_user_dev. */
+    constexpr bool needs_abs_setup() const
+    {
+        for (size_t code = 0; code < ABS_CNT; ++code) {
+            if (axes.test(code) && abs_info[code].res != 0) return true;
+        }
+        return false;
+    }
+
+    /** Length of setup_program<*this>. */
+    constexpr size_t setup_ops() const
+    {
+        const int types = (keys.count() > 0) + (rels.count() > 0) + (axes.count() > 0) + (mscs.count() > 0) +
+                          (ffs.count() > 0);
+        return static_cast<size_t>(props.count() + types + keys.count() + (needs_abs_setup() ? 0 : axes.count()) +
+                                   rels.count() + mscs.count() + ffs.count());
+    }
+};
+
+namespace detail {
+
+template <size_t N, size_t Bits>
+constexpr void append_bits(std::array<SetupOp, N>& p, size_t& n, unsigned long request, const CapBits<Bits>& bits)
+{
+    for (size_t i = 0; i < Bits; ++i) {
+        if (bits.test(i)) p[n++] = {request, static_cast<uint16_t>(i)};
+    }
+}
+
+template <size_t N>
+constexpr std::array<SetupOp, N> make_program(const DeviceDesc& d)
+{
+    std::array<SetupOp, N> p{};
+    size_t n = 0;
+    append_bits(p, n, UI_SET_PROPBIT, d.props);
+    if (d.keys.count() > 0) p[n++] = {UI_SET_EVBIT, EV_KEY};
+    if (d.rels.count() > 0) p[n++] = {UI_SET_EVBIT, EV_REL};
+    if (d.axes.count() > 0) p[n++] = {UI_SET_EVBIT, EV_ABS};
+    if (d.mscs.count() > 0) p[n++] = {UI_SET_EVBIT, EV_MSC};
+    if (d.ffs.count() > 0)  p[n++] = {UI_SET_EVBIT, EV_FF};
+    append_bits(p, n, UI_SET_KEYBIT, d.keys);
+    if (!d.needs_abs_setup()) append_bits(p, n, UI_SET_ABSBIT, d.axes);
+    append_bits(p, n, UI_SET_RELBIT, d.rels);
+    append_bits(p, n, UI_SET_MSCBIT, d.mscs);
+    append_bits(p, n, UI_SET_FFBIT, d.ffs);
+    if (n != N) throw "setup program length mismatch";
+    return p;
+}
+
+} // namespace detail
+
+/** Capability ioctls of device @p D, generated at compile time. */
+template <const DeviceDesc& D>
+inline constexpr std::array<SetupOp, D.setup_ops()> setup_program = detail::make_program<D.setup_ops()>(D);
+
+/**
+ * The uinput_user_dev that registers @p d on a @p screen_w x @p screen_h
+ * screen: name (@p name, or d.name if null), ids, effect slots and every
+ * axis range.
+ */
+void fill_user_dev(const DeviceDesc& d, int screen_w, int screen_h, const char* name, uinput_user_dev& out);
+
+/**
+ * Open /dev/uinput, run @p program, register the axes of @p d for a
+ * @p screen_w x @p screen_h screen and create the device, named @p name or
+ * d.name.  The fd is opened read-write when the device takes force feedback
+ * (requests come back on it).
+ * @return the fd, or -1 after logging what failed.
+ */
+int open_device(const DeviceDesc& d, const SetupOp* program, size_t n, int screen_w, int screen_h,
+                const char* name = nullptr);
+
+template <const DeviceDesc& D>
+int open_device(int screen_w = 0, int screen_h = 0, const char* name = nullptr)
+{
+    return open_device(D, setup_program<D>.data(), setup_program<D>.size(), screen_w, screen_h, name);
+}
+
+} // namespace VirtualHID
+
+#endif // DEVICE_DESCRIPTOR_H
@@ -0,0 +1,240 @@
+/*
+ * event_loop.cpp
+ * Clocks, hashed timer wheel and the poll(2) stdin loop.
+ */
+
+#include "event_loop.h"
+#include "simd.h"
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace EventLoop {
+
+static_assert(TimerWheel::kMaxTimers <= INT16_MAX, "pool indices are int16_t");
+
+// ---- Clocks -------------------------------------------------------------------
+
+int64_t MonotonicClock::now_ns() const
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t{ts.tv_sec} * 1000000000 + ts.tv_nsec;
+}
+
+const Clock& monotonic_clock()
+{
+    static const MonotonicClock clock;
+    return clock;
+}
+
+// ---- Timer wheel --------------------------------------------------------------
+
+namespace {
+
+inline int64_t tick_of(int64_t ns)
+{
+    return ns >= 0 ? ns / TimerWheel::kTickNs : (ns - TimerWheel::kTickNs + 1) / TimerWheel::kTickNs;
+}
+
+inline TimerId make_id(int16_t idx, uint16_t gen)
+{
+    return (static_cast<TimerId>(gen) << 16) | static_cast<TimerId>(idx + 1);
+}
+
+} // namespace
+
+TimerWheel::TimerWheel(const Clock& clock)
+    : clock_(clock), free_head_(0), tick_(tick_of(clock.now_ns()))
+{
+    for (size_t s = 0; s < kSlots; ++s) heads_[s] = -1;
+    for (size_t i = 0; i < kMaxTimers; ++i) {
+        pool_[i].next = (i + 1 < kMaxTimers) ? static_cast<int16_t>(i + 1) : -1;
+    }
+}
+
+void TimerWheel::link(int16_t idx)
+{
+    Timer& t = pool_[idx];
+    // Past-due timers go into the next slot to be processed.
+    const int64_t tick = std::max(tick_of(t.deadline), tick_ + 1);
+    t.slot = static_cast<int16_t>(static_cast<uint64_t>(tick) % kSlots);
+    t.prev = -1;
+    t.next = heads_[t.slot];
+    if (t.next >= 0) pool_[t.next].prev = idx;
+    heads_[t.slot] = idx;
+}
+
+void TimerWheel::unlink(int16_t idx)
+{
+    Timer& t = pool_[idx];
+    if (t.prev >= 0) pool_[t.prev].next = t.next;
+    else             heads_[t.slot]     = t.next;
+    if (t.next >= 0) pool_[t.next].prev = t.prev;
+    t.prev = t.next = -1;
+}
+
+TimerId TimerWheel::schedule_at(int64_t deadline_ns, TimerFn fn, void* ctx)
+{
+    if (free_head_ < 0 || !fn) return kNoTimer;
+    const int16_t idx = free_head_;
+    Timer& t = pool_[idx];
+    free_head_ = t.next;
+
+    t.deadline = deadline_ns;
+    t.fn       = fn;
+    t.ctx      = ctx;
+    t.gen      = static_cast<uint16_t>(t.gen + 1);
+    link(idx);
+    ++active_;
+    return make_id(idx, t.gen);
+}
+
+TimerId TimerWheel::schedule_in(int64_t delay_ns, TimerFn fn, void* ctx)
+{
+    return schedule_at(clock_.now_ns() + delay_ns, fn, ctx);
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    if (id == kNoTimer) return false;
+    const int idx = static_cast<int>(id & 0xffff) - 1;
+    if (idx < 0 || idx >= static_cast<int>(kMaxTimers)) return false;
+    Timer& t = pool_[idx];
+    if (t.slot < 0 || t.gen != static_cast<uint16_t>(id >> 16)) return false;
+
+    unlink(static_cast<int16_t>(idx));
+    t.slot = -1;
+    t.fn   = nullptr;
+    t.next = free_head_;
+    free_head_ = static_cast<int16_t>(idx);
+    --active_;
+    return true;
+}
+
+size_t TimerWheel::advance()
+{
+    const int64_t now      = clock_.now_ns();
+    const int64_t now_tick = tick_of(now);
+    size_t fired = 0;
+
+    // Visit every slot from the last processed tick up to and including the
+    // current (partial) one, but never more than one full revolution.
+    const int64_t last = std::min(now_tick, tick_ + static_cast<int64_t>(kSlots));
+
+    for (int64_t tick = tick_ + 1; tick <= last; ++tick) {
+        const size_t slot = static_cast<uint64_t>(tick) % kSlots;
+        for (;;) {
+            // Fire the earliest due timer in this slot, then rescan: callbacks
+            // may add or cancel timers in the same slot.
+            int16_t best = -1;
+            for (int16_t i = heads_[slot]; i >= 0; i = pool_[i].next) {
+                if (pool_[i].deadline <= now && (best < 0 || pool_[i].deadline < pool_[best].deadline)) {
+                    best = i;
+                }
+            }
+            if (best < 0) break;
+            Timer& t = pool_[best];
+            const TimerFn fn  = t.fn;
+            void* const   ctx = t.ctx;
+            cancel(make_id(best, t.gen));
+            fn(ctx, now);
+            ++fired;
+        }
+    }
+    // The current tick is only partially elapsed; revisit it next time.
+    tick_ = std::max(tick_, now_tick - 1);
+    return fired;
+}
+
+int64_t TimerWheel::next_deadline() const
+{
+    if (active_ == 0) return INT64_MAX;
+    // Within one revolution the first non-empty slot holding a timer of this
+    // round wins; otherwise fall back to a full scan of the pool.
+    for (size_t k = 1; k <= kSlots; ++k) {
+        const int64_t tick = tick_ + static_cast<int64_t>(k);
+        int64_t best = INT64_MAX;
+        for (int16_t i = heads_[static_cast<uint64_t>(tick) % kSlots]; i >= 0; i = pool_[i].next) {
+            if (tick_of(pool_[i].deadline) <= tick) best = std::min(best, pool_[i].deadline);
+        }
+        if (best != INT64_MAX) return best;
+    }
+    int64_t best = INT64_MAX;
+    for (const Timer& t : pool_) if (t.slot >= 0) best = std::min(best, t.deadline);
+    return best;
+}
+
+// ---- stdin loop ---------------------------------------------------------------
+
+void run(int fd, TimerWheel& timers, const LoopHooks& hooks, const std::atomic<bool>& running)
+{
+    alignas(64) char buf[4096];
+    size_t len       = 0;
+    bool   discarding = false;      // inside an over-long line
+    int    watch     = hooks.on_readable ? hooks.watch_fd : -1;
+
+    while (running.load(std::memory_order_relaxed)) {
+        int timeout = hooks.max_wait_ms;
+        const int64_t deadline = timers.next_deadline();
+        if (deadline != INT64_MAX) {
+            const int64_t wait_ns = deadline - timers.clock().now_ns();
+            const int64_t wait_ms = wait_ns <= 0 ? 0 : (wait_ns + 999999) / 1000000;
+            timeout = static_cast<int>(std::min<int64_t>(wait_ms, hooks.max_wait_ms));
+        }
+
+        struct pollfd pfd[2] = {{fd, POLLIN, 0}, {watch, POLLIN, 0}};
+        const int pr = poll(pfd, watch >= 0 ? 2 : 1, timeout);
+        if (pr < 0 && errno != EINTR) return;
+
+        if (hooks.on_wake) hooks.on_wake(hooks.ctx, timers.clock().now_ns());
+
+        if (pr > 0 && pfd[0].revents) {
+            const ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+            if (n == 0) {                                       // EOF
+                // A last command without a trailing newline still runs
+                if (len > 0 && !discarding && hooks.on_line) hooks.on_line(hooks.ctx, std::string_view(buf, len));
+                return;
+            }
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN) continue;
+                return;
+            }
+            const size_t scanned = len;             // carried-over bytes hold no newline
+            len += static_cast<size_t>(n);
+
+            size_t start = 0;
+            const char* const end = buf + len;
+            for (const char* nl = Simd::find_byte(buf + scanned, len - scanned, '\n'); nl != end;
+                 nl = Simd::find_byte(nl + 1, static_cast<size_t>(end - nl - 1), '\n')) {
+                const size_t i = static_cast<size_t>(nl - buf);
+                if (!discarding && hooks.on_line &&
+                    !hooks.on_line(hooks.ctx, std::string_view(buf + start, i - start))) {
+                    return;
+                }
+                discarding = false;
+                start = i + 1;
+            }
+            if (start == 0 && len == sizeof(buf)) {             // no newline in a full buffer
+                discarding = true;
+                len = 0;
+            } else {
+                std::memmove(buf, buf + start, len - start);
+                len -= start;
+            }
+        }
+        if (pr > 0 && watch >= 0 && pfd[1].revents) {
+            if (pfd[1].revents & POLLIN) hooks.on_readable(hooks.ctx, watch);
+            if (pfd[1].revents & (POLLERR | POLLHUP | POLLNVAL)) watch = -1;
+        }
+
+        timers.advance();
+    }
+}
+
+} // namespace EventLoop
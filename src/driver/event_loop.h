@@ -0,0 +1,146 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+/*
+ * event_loop.h
+ * Clock abstraction, timer wheel and the poll(2)-based stdin loop that
+ * drives hid_driver.
+ *
+ * Everything time-dependent in the driver asks a Clock for "now" and
+ * schedules work on a TimerWheel instead of sleeping, so tests can swap in
+ * a SimulatedClock and run hours of timer traffic in milliseconds.
+ *
+ * The wheel is a hashed timing wheel: kSlots buckets of kTickNs each, timers
+ * further out than one revolution simply stay in their bucket until their
+ * round comes up.  Timers live in a fixed pool (no allocation after
+ * construction) and callbacks are plain function pointers + context.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace EventLoop {
+
+// ---- Clocks -------------------------------------------------------------------
+
+class Clock {
+public:
+    virtual ~Clock() = default;
+    virtual int64_t now_ns() const = 0;
+};
+
+/** CLOCK_MONOTONIC. */
+class MonotonicClock final : public Clock {
+public:
+    int64_t now_ns() const override;
+};
+
+/** Manually advanced clock for deterministic and faster-than-real-time tests. */
+class SimulatedClock final : public Clock {
+public:
+    explicit SimulatedClock(int64_t start_ns = 0) : t_(start_ns) {}
+    int64_t now_ns() const override { return t_; }
+    void    advance(int64_t ns)     { t_ += ns; }
+    void    set(int64_t ns)         { t_ = ns; }
+private:
+    int64_t t_;
+};
+
+/** The process-wide real clock. */
+const Clock& monotonic_clock();
+
+// ---- Timer wheel --------------------------------------------------------------
+
+using TimerFn = void (*)(void* ctx, int64_t now_ns);
+using TimerId = uint32_t;
+constexpr TimerId kNoTimer = 0;
+
+class TimerWheel {
+public:
+    static constexpr int64_t kTickNs    = 1000000;   // 1 ms resolution
+    static constexpr size_t  kSlots     = 256;        // one revolution = 256 ms
+    static constexpr size_t  kMaxTimers = 256;
+
+    explicit TimerWheel(const Clock& clock);
+
+    const Clock& clock() const { return clock_; }
+
+    /**
+     * Run @p fn(ctx, now) once the clock reaches @p deadline_ns.  Callbacks
+     * may schedule or cancel timers (including re-arming themselves).
+     * @return kNoTimer if the pool is exhausted.
+     */
+    TimerId schedule_at(int64_t deadline_ns, TimerFn fn, void* ctx);
+    TimerId schedule_in(int64_t delay_ns, TimerFn fn, void* ctx);
+
+    /** @return false if @p id already fired or was cancelled. */
+    bool cancel(TimerId id);
+
+    /** Fire every timer due at clock().now_ns(), earliest first; returns the count. */
+    size_t advance();
+
+    /** Earliest pending deadline, or INT64_MAX when idle. */
+    int64_t next_deadline() const;
+
+    size_t active() const { return active_; }
+
+private:
+    struct Timer {
+        int64_t  deadline = 0;
+        TimerFn  fn       = nullptr;
+        void*    ctx      = nullptr;
+        uint16_t gen      = 0;
+        int16_t  prev     = -1;      // slot list links (pool indices)
+        int16_t  next     = -1;
+        int16_t  slot     = -1;      // -1 = free
+    };
+
+    void link(int16_t idx);
+    void unlink(int16_t idx);
+
+    const Clock& clock_;
+    Timer        pool_[kMaxTimers];
+    int16_t      heads_[kSlots];
+    int16_t      free_head_;
+    int64_t      tick_;              // last tick fully processed
+    size_t       active_ = 0;
+};
+
+// ---- stdin loop ---------------------------------------------------------------
+
+/** Called once per complete line (without newline); return false to stop. */
+using LineFn = bool (*)(void* ctx, std::string_view line);
+
+/** Called after each poll(2) wake-up (input or timer), before timers fire. */
+using WakeFn = void (*)(void* ctx, int64_t now_ns);
+
+/** Called when LoopHooks::watch_fd polls readable; must not block. */
+using ReadableFn = void (*)(void* ctx, int fd);
+
+struct LoopHooks {
+    LineFn     on_line     = nullptr;
+    WakeFn     on_wake     = nullptr;
+    ReadableFn on_readable = nullptr;
+    void*      ctx         = nullptr;
+    int        watch_fd    = -1;     // polled alongside the input, e.g. a uinput device
+                                     // whose force-feedback requests need answering
+    int        max_wait_ms = 250;    // longest poll(2) sleep with no timer due; re-read
+                                     // every iteration, so a hook may raise it when idle
+};
+
+/**
+ * Read newline-delimited commands from @p fd and fire @p timers, sleeping in
+ * poll(2) until whichever comes first.  Lines longer than the internal
+ * buffer are discarded; an unterminated last line is delivered at EOF.  A
+ * readable hooks.watch_fd is handed to on_readable() after the input of the
+ * same wake-up, so input lines never wait behind it; a watch_fd that
+ * reports an error or hang-up is dropped.  Returns on EOF, read error,
+ * on_line() returning false, or @p running becoming false (checked at least
+ * every hooks.max_wait_ms; signals interrupt the poll(2) immediately).
+ */
+void run(int fd, TimerWheel& timers, const LoopHooks& hooks, const std::atomic<bool>& running);
+
+} // namespace EventLoop
+
+#endif // EVENT_LOOP_H
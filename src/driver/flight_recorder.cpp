@@ -0,0 +1,258 @@
+/*
+ * flight_recorder.cpp
+ * Lock-free ring of recent commands / events with an async-signal-safe dump.
+ *
+ * Each slot is a tiny seqlock: a writer claims a global sequence number,
+ * invalidates the slot, fills it and then publishes the sequence.  A reader
+ * (the dumper, possibly running inside a signal handler on the writer's own
+ * thread) only emits slots whose sequence is stable across the copy, so a
+ * record interrupted half-way through is skipped rather than printed torn.
+ */
+
+#include "flight_recorder.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+
+namespace FlightRecorder {
+
+static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+static_assert(kMaxCommandLen <= UINT8_MAX, "Slot::len is a uint8_t");
+
+namespace {
+
+enum : uint8_t { kKindCommand = 1, kKindEvent = 2 };
+
+struct Slot {
+    std::atomic<uint64_t> seq{0};   // 0 = empty / being written, else n + 1
+    uint64_t t_ns  = 0;
+    int32_t  fd    = -1;
+    int32_t  value = 0;
+    uint16_t type  = 0;
+    uint16_t code  = 0;
+    uint8_t  kind  = 0;
+    uint8_t  len   = 0;             // bytes stored in text
+    uint32_t full_len = 0;          // length of the command as received
+    char     text[kMaxCommandLen] = {};
+};
+
+Slot                  g_ring[kCapacity];
+std::atomic<uint64_t> g_head{0};
+char                  g_path[256] = "hid_driver.flight";
+
+inline uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline Slot& claim(uint64_t& n)
+{
+    n = g_head.fetch_add(1, std::memory_order_relaxed);
+    Slot& s = g_ring[n & (kCapacity - 1)];
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return s;
+}
+
+inline void publish(Slot& s, uint64_t n)
+{
+    s.seq.store(n + 1, std::memory_order_release);
+}
+
+// ---- async-signal-safe formatting -------------------------------------------
+
+struct Out {
+    int    fd;
+    char   buf[4096];
+    size_t len = 0;
+    bool   ok  = true;
+
+    void flush()
+    {
+        size_t off = 0;
+        while (off < len) {
+            ssize_t n = ::write(fd, buf + off, len - off);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                ok = false;
+                break;
+            }
+            off += static_cast<size_t>(n);
+        }
+        len = 0;
+    }
+
+    void put(const char* s, size_t n)
+    {
+        if (len + n > sizeof(buf)) flush();
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+
+    void str(const char* s) { put(s, strlen(s)); }
+
+    void u64(uint64_t v)
+    {
+        char tmp[20];
+        size_t i = sizeof(tmp);
+        do { tmp[--i] = static_cast<char>('0' + v % 10); v /= 10; } while (v);
+        put(tmp + i, sizeof(tmp) - i);
+    }
+
+    void i64(int64_t v)
+    {
+        if (v < 0) { put("-", 1); u64(static_cast<uint64_t>(-(v + 1)) + 1); }
+        else       { u64(static_cast<uint64_t>(v)); }
+    }
+};
+
+void fatal_handler(int sig)
+{
+    const char* reason = "fatal-signal";
+    switch (sig) {
+        case SIGSEGV: reason = "SIGSEGV"; break;
+        case SIGBUS:  reason = "SIGBUS";  break;
+        case SIGFPE:  reason = "SIGFPE";  break;
+        case SIGILL:  reason = "SIGILL";  break;
+        case SIGABRT: reason = "SIGABRT"; break;
+        default: break;
+    }
+    dump(reason);
+    // SA_RESETHAND restored the default action; re-raise to crash as usual.
+    raise(sig);
+}
+
+void usr2_handler(int /*sig*/)
+{
+    int saved = errno;
+    dump("SIGUSR2");
+    errno = saved;
+}
+
+} // namespace
+
+// ---- Recording ---------------------------------------------------------------
+
+void record_command(const char* line, size_t len)
+{
+    uint64_t n;
+    Slot& s = claim(n);
+    s.full_len = len > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(len);
+    if (len > kMaxCommandLen) len = kMaxCommandLen;
+    s.t_ns = now_ns();
+    s.kind = kKindCommand;
+    s.len  = static_cast<uint8_t>(len);
+    memcpy(s.text, line, len);
+    publish(s, n);
+}
+
+void record_event(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+    uint64_t n;
+    Slot& s = claim(n);
+    s.t_ns  = now_ns();
+    s.kind  = kKindEvent;
+    s.fd    = fd;
+    s.type  = type;
+    s.code  = code;
+    s.value = value;
+    publish(s, n);
+}
+
+// ---- Dumping -----------------------------------------------------------------
+
+void set_dump_path(const char* path)
+{
+    strncpy(g_path, path, sizeof(g_path) - 1);
+    g_path[sizeof(g_path) - 1] = '\0';
+}
+
+bool dump(const char* reason)
+{
+    int fd = ::open(g_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    Out out{fd, {}};
+    out.str("# gesturelink flight recorder v1 pid=");
+    out.u64(static_cast<uint64_t>(getpid()));
+    out.str(" reason=");
+    out.str(reason);
+    out.str("\n");
+
+    const uint64_t head  = g_head.load(std::memory_order_acquire);
+    const uint64_t first = head > kCapacity ? head - kCapacity : 0;
+
+    for (uint64_t n = first; n < head; ++n) {
+        const Slot& s = g_ring[n & (kCapacity - 1)];
+        const uint64_t seq = s.seq.load(std::memory_order_acquire);
+        if (seq != n + 1) continue;                 // overwritten or in flight
+
+        Slot copy;
+        copy.t_ns  = s.t_ns;
+        copy.fd    = s.fd;
+        copy.value = s.value;
+        copy.type  = s.type;
+        copy.code  = s.code;
+        copy.kind  = s.kind;
+        copy.len   = s.len > kMaxCommandLen ? kMaxCommandLen : s.len;
+        copy.full_len = s.full_len;
+        memcpy(copy.text, s.text, copy.len);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != seq) continue;   // torn
+
+        if (copy.kind == kKindCommand && copy.full_len > copy.len) {
+            // Replaying a prefix would run a different command: keep it on
+            // the metadata line, which hid_driver ignores.
+            out.str("#T ");  out.u64(copy.t_ns);
+            out.str(" ");    out.u64(n);
+            out.str(" ");    out.u64(copy.full_len);
+            out.str(" ");    out.put(copy.text, copy.len);
+            out.str("\n");
+        } else if (copy.kind == kKindCommand) {
+            out.str("#C ");  out.u64(copy.t_ns);
+            out.str(" ");    out.u64(n);
+            out.str("\n");
+            out.put(copy.text, copy.len);
+            out.str("\n");
+        } else if (copy.kind == kKindEvent) {
+            out.str("#E ");  out.u64(copy.t_ns);
+            out.str(" ");    out.u64(n);
+            out.str(" ");    out.i64(copy.fd);
+            out.str(" ");    out.u64(copy.type);
+            out.str(" ");    out.u64(copy.code);
+            out.str(" ");    out.i64(copy.value);
+            out.str("\n");
+        }
+    }
+
+    out.flush();
+    ::close(fd);
+    return out.ok;
+}
+
+void install_signal_handlers()
+{
+    struct sigaction sa{};
+    sigemptyset(&sa.sa_mask);
+
+    sa.sa_handler = usr2_handler;
+    sa.sa_flags   = SA_RESTART;
+    sigaction(SIGUSR2, &sa, nullptr);
+
+    sa.sa_handler = fatal_handler;
+    sa.sa_flags   = SA_RESETHAND;
+    for (int sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+        sigaction(sig, &sa, nullptr);
+    }
+}
+
+} // namespace FlightRecorder
@@ -0,0 +1,69 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+/*
+ * flight_recorder.h
+ * Crash-safe, fixed-size ring of the most recent driver activity.
+ *
+ * Every decoded command line and every input_event written to a virtual
+ * device is stamped with CLOCK_MONOTONIC and stored in a lock-free ring of
+ * kCapacity slots.  Recording never blocks and never allocates; old entries
+ * are overwritten.  The ring can be dumped to a file from a signal handler
+ * (SIGUSR2, fatal signals) or from the stall watchdog.
+ *
+ * Dump format (text, one record per line, oldest first)
+ * -----------------------------------------------------
+ *   # gesturelink flight recorder v1 pid=<pid> reason=<why>
+ *   #C <t_ns> <seq>                     - a command follows on the next line
+ *   MOUSE_MOVE 960 540                  - the command exactly as received
+ *   #T <t_ns> <seq> <len> <prefix>      - a command longer than kMaxCommandLen:
+ *                                         its length and first kMaxCommandLen bytes
+ *   #E <t_ns> <seq> <fd> <type> <code> <value>   - an emitted input_event
+ *
+ * Because metadata lines start with '#', which hid_driver ignores, a dump
+ * can be replayed directly:   ./hid_driver 1920 1080 < hid_driver.flight
+ * Truncated commands are skipped on replay rather than run half-parsed.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FlightRecorder {
+
+/** Number of slots in the ring (power of two). */
+constexpr size_t kCapacity = 2048;
+
+/**
+ * Longest command stored per record: a TOUCH frame with all ten contacts at
+ * four-digit coordinates.  Longer lines keep this prefix and dump as #T.
+ */
+constexpr size_t kMaxCommandLen = 160;
+
+/** Record a decoded command line (without trailing newline). */
+void record_command(const char* line, size_t len);
+
+/** Record an input_event written to the device behind @p fd. */
+void record_event(int fd, uint16_t type, uint16_t code, int32_t value);
+
+/**
+ * Set the file that dump() writes to.  Must be called before
+ * install_signal_handlers(); the path is copied into static storage.
+ */
+void set_dump_path(const char* path);
+
+/**
+ * Write the ring contents to the dump path.
+ * Async-signal-safe: uses only open/write/close and no allocation.
+ * @return true if the file was written completely.
+ */
+bool dump(const char* reason);
+
+/**
+ * Install handlers that dump on SIGUSR2 (and keep running) and on
+ * SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT (then re-raise with the default
+ * action so the process still crashes / cores as before).
+ */
+void install_signal_handlers();
+
+} // namespace FlightRecorder
+
+#endif // FLIGHT_RECORDER_H
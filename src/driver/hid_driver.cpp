@@ -3,7 +3,9 @@
  * Main entry point for the GestureLink HID driver.
  *
  * Reads a simple text-based command protocol from stdin (one command per line)
- * and dispatches to the appropriate uinput virtual device.
+ * and dispatches to the appropriate uinput virtual device.  The main loop is
+ * an EventLoop: poll(2) on stdin plus a TimerWheel for anything time-driven,
+ * all timed through an injectable Clock (see event_loop.h).
  *
  * Protocol
  * --------
@@ -11,27 +13,138 @@
  *   MOUSE_LEFT                    - left click
  *   MOUSE_RIGHT                   - right click
  *   MOUSE_SCROLL  <delta>         - scroll wheel (+up / -down)
+ *   MOUSE_RELEASE                 - pointing ended: the cursor coasts if it was
+ *                                   a flick and inertia is on
  *   GAMEPAD_BTN   <name> <1|0>    - press / release button (A/B/X/Y/LB/RB/START/SELECT)
  *   GAMEPAD_STICK <x> <y>         - left stick (-32767..32767)
+ *   GAMEPAD_TURBO <name> <hz> <duty%> | <name> 0
+ *                                 - autofire a button at 1..60 Hz, held for 1..99 %
+ *                                   of each period (press and release >= 2 ms) /
+ *                                   stop and release it
+ *   KEY_DOWN <key> / KEY_UP <key> - press / release a key (LEFTCTRL, TAB, F5, A, ...)
+ *   KEY_CHORD <key>+<key>[+...]   - press in order, release in reverse (CTRL+TAB)
+ *   TYPE <text>                   - type UTF-8 text on a US layout; \n \t \\ escapes
+ *   TOUCH <slot> <x> <y> | <slot> UP [...]
+ *                                 - touch contacts 0-9 down / moved / lifted, one frame
+ *   PEN <x> <y> <pressure> <tilt_x> <tilt_y> | PEN OUT
+ *                                 - pen tablet sample (fractional pixels, 0..4095,
+ *                                   degrees) / pen leaves proximity
+ *   GYRO <rx> <ry> <rz> | GYRO OFF
+ *                                 - hand angular rates in deg/s (fractional, +-2000)
+ *                                   for the motion sensor / zero them and stop
+ *   POINTER <id> <x> <y> | <id> DOWN|UP <LEFT|RIGHT|MIDDLE> [...]
+ *                                 - independent pointers 0..HID_DRIVER_POINTERS-1
+ *                                   moved / clicked, one frame per pointer
+ *   MACRO <name>                  - play a macro from $HID_DRIVER_MACROS (restarts it
+ *                                   if it is running)
+ *   MACRO_STOP [<name>]           - cancel one / every running macro, releasing
+ *                                   the keys and buttons it holds
+ *   POWER <IDLE|ACTIVE>           - producer sees no hand / a hand again
  *   QUIT                          - graceful shutdown
  *
+ * Back-channel
+ * ------------
+ *   Rumble effects games play on the virtual gamepad are written, one line
+ *   per change, to the fd named by $HID_DRIVER_FEEDBACK_FD (inherited from
+ *   the producer, e.g. a pipe main.py reads for the HUD):
+ *     FF PLAY <id> <strong> <weak> <length_ms>  - magnitudes 0..65535, gain applied
+ *     FF STOP <id>
+ *   The fd is non-blocking; lines the producer does not read in time are
+ *   dropped and counted, so a stalled reader never delays input.
+ *
  * Usage
  * -----
  *   ./hid_driver [screen_width] [screen_height]
  *   python3 main.py | ./hid_driver 1920 1080
+ *
+ * Diagnostics
+ * -----------
+ *   The last FlightRecorder::kCapacity commands and events are kept in a
+ *   flight recorder and written to $HID_DRIVER_FLIGHT_LOG
+ *   (default /tmp/hid_driver-<pid>.flight) on SIGUSR2, on a fatal signal,
+ *   or when a single command stalls for longer than kWatchdogStallMs.
+ *
+ *   Hot-path diagnostics (unknown commands, failed writes) go through the
+ *   asynchronous AsyncLog; see async_log.h for HID_DRIVER_LOG_LEVEL,
+ *   HID_DRIVER_LOG_FORMAT=json and HID_DRIVER_LOG_RATE.
+ *
+ *   With $HID_DRIVER_METRICS set (unix:/path or a loopback port) command,
+ *   event, latency, queue, device and per-thread CPU metrics are served in
+ *   Prometheus text format; see metrics.h.
+ *
+ *   Between POWER IDLE and POWER ACTIVE the poll(2) timeout and the
+ *   watchdog sleep kIdleWaitMs instead of a few ms (the log drain thread
+ *   only wakes for records either way), and the driver's CPU time and
+ *   wake-ups over the idle period are logged on wake.
+ *
+ *   Vectorised kernels (simd.h) run at the best ISA tier the CPU supports;
+ *   HID_DRIVER_ISA=scalar|sse4.2|avx2|avx512 caps it.
+ *
+ *   A TYPE longer than one 64-event batch is written in batches
+ *   $HID_DRIVER_TYPE_GAP_US apart (default 500, at the timer wheel's 1 ms
+ *   granularity) so evdev readers can keep up; the batches go out from the
+ *   timer wheel, so other commands and timers run in between.  0 writes
+ *   them back to back.  TYPE text is limited to kMaxTypeLen (512) bytes.
+ *
+ *   Pen positions glide from sample to sample in HID_DRIVER_PEN_TICK_US
+ *   steps (default 4000, i.e. 250 Hz) so strokes are smooth at camera frame
+ *   rates; 0 jumps straight to each sample instead.
+ *
+ *   The motion sensor reports every HID_DRIVER_GYRO_TICK_US (default 2000,
+ *   i.e. 500 Hz; at least 1000) with MSC_TIMESTAMP, gliding between GYRO
+ *   samples, on a timer phase-locked to the first sample so the rate does
+ *   not sag with wake-up latency; 0 writes one frame per sample.  It stops
+ *   at GYRO OFF or kGyroStaleNs after the last sample.
+ *
+ *   With HID_DRIVER_INERTIA_FRICTION > 0 (velocity decay per second, e.g.
+ *   4; default 0 = off) a MOUSE_RELEASE after a fast MOUSE_MOVE stroke
+ *   keeps the cursor moving, integrated every HID_DRIVER_INERTIA_TICK_US
+ *   (default 4000); any other command except POWER stops it at once.
+ *
+ *   GAMEPAD_TURBO edges run on the event loop's timer wheel, phase-locked
+ *   to the command that started them; edges of several buttons that fall
+ *   within VirtualHID::kTurboCoalesceNs share one frame.  How far each edge
+ *   lands from its ideal time is exported as a metrics histogram.
+ *
+ *   HID_DRIVER_MACROS names a macro file (syntax in macro.h) compiled at
+ *   startup; a bad line stops the driver with its line number.  MACRO frames
+ *   are played from the timer wheel like turbo edges, and their drift from
+ *   the defined times is exported as a metrics histogram.
+ *
+ *   HID_DRIVER_POINTERS (default 2, at most VirtualHID::kMaxPointers) sets
+ *   how many independent absolute pointers POINTER drives, one per hand.
+ *
+ *   HID_DRIVER_SINK=null writes every frame to /dev/null instead of creating
+ *   uinput devices, so the whole pipeline can be soaked (bench/soak.py) on
+ *   hosts without /dev/uinput.
  */
 
 #include "virtual_hid.h"
+#include "async_log.h"
+#include "command_dispatch.h"
+#include "event_loop.h"
+#include "flight_recorder.h"
+#include "metrics.h"
+#include "simd.h"
 
-#include <linux/input-event-codes.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <iterator>
 #include <string>
-#include <unordered_map>
 #include <csignal>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 static std::atomic<bool> g_running{true};
 
@@ -39,22 +152,407 @@ static void signal_handler(int /*sig*/) {
     g_running = false;
 }
 
-static const std::unordered_map<std::string, VirtualHID::GamepadBtn> kBtnMap = {
-    {"A",      VirtualHID::GamepadBtn::A},
-    {"B",      VirtualHID::GamepadBtn::B},
-    {"X",      VirtualHID::GamepadBtn::X},
-    {"Y",      VirtualHID::GamepadBtn::Y},
-    {"LB",     VirtualHID::GamepadBtn::LB},
-    {"RB",     VirtualHID::GamepadBtn::RB},
-    {"START",  VirtualHID::GamepadBtn::START},
-    {"SELECT", VirtualHID::GamepadBtn::SELECT},
+// ---- Stall watchdog ----------------------------------------------------------
+// The main loop stamps g_dispatch_start while it is handling a command.  If a
+// single command takes longer than kWatchdogStallMs (e.g. a wedged uinput
+// write) the watchdog dumps the flight recorder once for that stall.
+
+static constexpr int kWatchdogStallMs = 250;
+
+static std::atomic<int64_t> g_dispatch_start{0};   // monotonic ns, 0 = no command
+
+// ---- Power state ---------------------------------------------------------------
+// POWER IDLE stretches every periodic sleep in the driver to kIdleWaitMs so
+// an idle driver wakes a handful of times per second instead of hundreds.
+
+static constexpr int kPenTickUs     = 4000;
+static constexpr int kInertiaTickUs = 4000;
+static constexpr int kGyroTickUs    = 2000;
+static constexpr int kActivePollMs  = 250;
+static constexpr int kIdleWaitMs    = 1000;
+
+static std::atomic<bool>       g_idle{false};
+static std::mutex              g_wake_mutex;
+static std::condition_variable g_wake_cv;
+
+static int64_t steady_ns()
+{
+    return EventLoop::monotonic_clock().now_ns();
+}
+
+static void watchdog_loop()
+{
+    pthread_setname_np(pthread_self(), "hid_watchdog");
+    int64_t reported = 0;
+    while (g_running) {
+        {
+            const int wait_ms = g_idle ? kIdleWaitMs : kWatchdogStallMs / 2;
+            std::unique_lock<std::mutex> lock(g_wake_mutex);
+            g_wake_cv.wait_for(lock, std::chrono::milliseconds(wait_ms));
+        }
+        const int64_t start = g_dispatch_start.load(std::memory_order_relaxed);
+        if (start != 0 && start != reported &&
+            steady_ns() - start > int64_t{kWatchdogStallMs} * 1000000) {
+            FlightRecorder::dump("watchdog");
+            std::cerr << "[hid_driver] Watchdog: command stalled > "
+                      << kWatchdogStallMs << " ms, flight recorder dumped.\n";
+            reported = start;
+        }
+    }
+}
+
+struct Session {
+    HidDriver::Devices     dev;
+    EventLoop::LoopHooks*  hooks = nullptr;
+    EventLoop::TimerWheel* timers = nullptr;
+    EventLoop::TimerId     pen_timer = EventLoop::kNoTimer;
+    EventLoop::TimerId     coast_timer = EventLoop::kNoTimer;
+    EventLoop::TimerId     type_timer = EventLoop::kNoTimer;
+    EventLoop::TimerId     gyro_timer = EventLoop::kNoTimer;
+    int64_t                gyro_due = 0;     // the report gyro_timer is armed for
+    EventLoop::TimerId     turbo_timer = EventLoop::kNoTimer;
+    int64_t                turbo_at = 0;     // the edge turbo_timer is armed for
+    EventLoop::TimerId     macro_timer = EventLoop::kNoTimer;
+    int64_t                macro_at = 0;     // the frame macro_timer is armed for
+    int                    feedback_fd = -1;
+    int64_t                idle_since_ns = 0;
+    struct rusage          idle_usage{};
+};
+
+static double cpu_seconds(const struct rusage& u)
+{
+    return static_cast<double>(u.ru_utime.tv_sec + u.ru_stime.tv_sec) +
+           static_cast<double>(u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1e6;
+}
+
+static void set_power(Session& s, bool idle, int64_t now)
+{
+    g_idle = idle;
+    s.hooks->max_wait_ms = idle ? kIdleWaitMs : kActivePollMs;
+    if (idle) {
+        s.idle_since_ns = now;
+        getrusage(RUSAGE_SELF, &s.idle_usage);
+        return;
+    }
+    g_wake_cv.notify_all();
+
+    struct rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    const double secs = (now - s.idle_since_ns) / 1e9;
+    if (secs <= 0) return;
+    std::fprintf(stderr, "[hid_driver] Idle for %.1f s: %.2f%% CPU, %.1f wakeups/s\n", secs,
+                 100.0 * (cpu_seconds(u) - cpu_seconds(s.idle_usage)) / secs,
+                 static_cast<double>(u.ru_nvcsw - s.idle_usage.ru_nvcsw) / secs);
+}
+
+static void on_pen_tick(void* ctx, int64_t now)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    s.pen_timer = VirtualHID::pen_tick(s.dev.pen, now)
+                      ? s.timers->schedule_at(now + s.dev.pen.tick_ns, on_pen_tick, &s)
+                      : EventLoop::kNoTimer;
+}
+
+static void on_coast_tick(void* ctx, int64_t now)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    s.coast_timer = VirtualHID::mouse_inertia_tick(s.dev.mouse, now)
+                        ? s.timers->schedule_at(now + s.dev.mouse.tick_ns, on_coast_tick, &s)
+                        : EventLoop::kNoTimer;
+}
+
+/** The next batch of a long TYPE, gap_ns after the last one. */
+static void on_type_tick(void* ctx, int64_t now)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    s.type_timer = VirtualHID::keyboard_type_tick(s.dev.keyboard)
+                       ? s.timers->schedule_at(now + s.dev.keyboard.gap_ns, on_type_tick, &s)
+                       : EventLoop::kNoTimer;
+}
+
+/**
+ * Motion sensor reports land on gyro_due + k * tick_ns and are stamped with
+ * that time, like a sensor's sample clock; a late wake-up skips, never drifts.
+ */
+static void on_gyro_tick(void* ctx, int64_t now)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    s.gyro_timer = EventLoop::kNoTimer;
+    if (!VirtualHID::gyro_tick(s.dev.gyro, s.gyro_due)) return;
+    const int64_t tick = s.dev.gyro.tick_ns;
+    s.gyro_due += tick;
+    if (s.gyro_due <= now) s.gyro_due += (now - s.gyro_due) / tick * tick + tick;
+    s.gyro_timer = s.timers->schedule_at(s.gyro_due, on_gyro_tick, &s);
+}
+
+static void on_turbo_tick(void* ctx, int64_t now);
+static void on_macro_tick(void* ctx, int64_t now);
+
+/**
+ * Arm @p timer for something due at @p next (0 = nothing), half a
+ * timer-wheel tick early: poll(2) rounds its timeout up to whole
+ * milliseconds, and work up to @p slack_ns ahead is written anyway, so this
+ * centres the timing error on zero instead of making everything late.
+ */
+static void arm_early(Session& s, EventLoop::TimerId& timer, int64_t& armed_at, int64_t next, int64_t slack_ns,
+                      EventLoop::TimerFn fn)
+{
+    if (next == armed_at) return;
+    if (timer != EventLoop::kNoTimer) s.timers->cancel(timer);
+    timer    = next != 0 ? s.timers->schedule_at(next - slack_ns / 2, fn, &s) : EventLoop::kNoTimer;
+    armed_at = next;
+}
+
+/** Arm the turbo timer for the gamepad's next edge. */
+static void arm_turbo(Session& s)
+{
+    arm_early(s, s.turbo_timer, s.turbo_at, s.dev.gamepad.turbo_next_ns, VirtualHID::kTurboCoalesceNs,
+              on_turbo_tick);
+}
+
+static void on_turbo_tick(void* ctx, int64_t now)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    s.turbo_timer = EventLoop::kNoTimer;
+    s.turbo_at    = 0;
+    VirtualHID::gamepad_turbo_tick(s.dev.gamepad, now);
+    arm_turbo(s);
+}
+
+/** Arm the macro timer for the next frame of any running macro. */
+static void arm_macros(Session& s)
+{
+    arm_early(s, s.macro_timer, s.macro_at, s.dev.macros.next_ns, Macro::kSlackNs, on_macro_tick);
+}
+
+static void on_macro_tick(void* ctx, int64_t now)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    s.macro_timer = EventLoop::kNoTimer;
+    s.macro_at    = 0;
+    Macro::tick(s.dev.macros, now);
+    Metrics::set_gauge(Metrics::kMacrosRunning, s.dev.macros.active);
+    arm_macros(s);
+}
+
+static bool on_line(void* ctx, std::string_view line)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    const bool was_idle = s.dev.idle;
+    const int64_t t0 = steady_ns();
+    g_dispatch_start.store(t0, std::memory_order_relaxed);
+    const HidDriver::DispatchResult r = HidDriver::dispatch(s.dev, line);
+    g_dispatch_start.store(0, std::memory_order_relaxed);
+    if (r == HidDriver::DispatchResult::Handled) {
+        Metrics::observe_dispatch_ns(static_cast<uint64_t>(steady_ns() - t0));
+    }
+    if (s.dev.idle != was_idle) set_power(s, s.dev.idle, t0);
+    if (s.dev.pen.gliding && s.pen_timer == EventLoop::kNoTimer) {
+        s.pen_timer = s.timers->schedule_in(s.dev.pen.tick_ns, on_pen_tick, &s);
+    }
+    if (s.dev.keyboard.typing && s.type_timer == EventLoop::kNoTimer) {
+        s.type_timer = s.timers->schedule_in(s.dev.keyboard.gap_ns, on_type_tick, &s);
+    }
+    if (s.dev.gyro.streaming && s.dev.gyro.tick_ns > 0 && s.gyro_timer == EventLoop::kNoTimer) {
+        s.gyro_due   = t0 + s.dev.gyro.tick_ns;
+        s.gyro_timer = s.timers->schedule_at(s.gyro_due, on_gyro_tick, &s);
+    } else if (!s.dev.gyro.streaming && s.gyro_timer != EventLoop::kNoTimer) {
+        s.timers->cancel(s.gyro_timer);
+        s.gyro_timer = EventLoop::kNoTimer;
+    }
+    if (s.dev.mouse.coasting != (s.coast_timer != EventLoop::kNoTimer)) {
+        if (s.dev.mouse.coasting) {
+            s.coast_timer = s.timers->schedule_in(s.dev.mouse.tick_ns, on_coast_tick, &s);
+        } else {
+            s.timers->cancel(s.coast_timer);
+            s.coast_timer = EventLoop::kNoTimer;
+        }
+    }
+    arm_turbo(s);
+    arm_macros(s);
+    return r != HidDriver::DispatchResult::Quit;
+}
+
+/** The game side of the gamepad: answer FF requests and forward rumble changes. */
+static void on_gamepad_readable(void* ctx, int /*fd*/)
+{
+    Session& s = *static_cast<Session*>(ctx);
+    VirtualHID::FfEvent changes[VirtualHID::kMaxFfEffects];
+    const int n = VirtualHID::gamepad_service(s.dev.gamepad, changes, VirtualHID::kMaxFfEffects);
+    if (n == 0) return;
+
+    int playing = 0;
+    for (const VirtualHID::FfEffect& e : s.dev.gamepad.ff) playing += e.playing;
+    Metrics::set_gauge(Metrics::kFfPlaying, playing);
+    if (s.feedback_fd < 0) return;
+
+    char line[64];
+    for (int i = 0; i < n; ++i) {
+        const size_t len = HidDriver::format_feedback(changes[i], line, sizeof(line));
+        if (write(s.feedback_fd, line, len) != static_cast<ssize_t>(len)) {
+            Metrics::inc(Metrics::kFeedbackDropped);
+        }
+    }
+}
+
+static void on_emit(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+    FlightRecorder::record_event(fd, type, code, value);
+    Metrics::inc(Metrics::kEventsEmitted);
+}
+
+// ---- Devices ---------------------------------------------------------------------
+// Opened in this order, closed in reverse.  A failure closes the ones already open.
+// With the null sink (HID_DRIVER_SINK=null) every device fd is /dev/null instead
+// of a uinput device; every emit path still runs.
+
+static constexpr int kDefaultPointers = 2;   // one per hand; HID_DRIVER_POINTERS
+
+struct DeviceStep {
+    const char*    name;
+    Metrics::Gauge open_gauge;
+    bool (*open)(HidDriver::Devices&, int screen_w, int screen_h, bool null_sink);
+    void (*close)(HidDriver::Devices&);
 };
 
+static bool open_null(int& fd)
+{
+    fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    return fd >= 0;
+}
+
+static const DeviceStep kDevices[] = {
+    {"mouse", Metrics::kMouseOpen,
+     [](HidDriver::Devices& d, int w, int h, bool null_sink) {
+         if (!null_sink) return VirtualHID::mouse_open(d.mouse, w, h);
+         d.mouse.screen_w = w;
+         d.mouse.screen_h = h;
+         return open_null(d.mouse.fd);
+     },
+     [](HidDriver::Devices& d) { VirtualHID::mouse_close(d.mouse); }},
+    {"gamepad", Metrics::kGamepadOpen,
+     [](HidDriver::Devices& d, int, int, bool null_sink) {
+         return null_sink ? open_null(d.gamepad.fd) : VirtualHID::gamepad_open(d.gamepad);
+     },
+     [](HidDriver::Devices& d) { VirtualHID::gamepad_close(d.gamepad); }},
+    {"keyboard", Metrics::kKeyboardOpen,
+     [](HidDriver::Devices& d, int, int, bool null_sink) {
+         return null_sink ? open_null(d.keyboard.fd) : VirtualHID::keyboard_open(d.keyboard);
+     },
+     [](HidDriver::Devices& d) { VirtualHID::keyboard_close(d.keyboard); }},
+    {"touchscreen", Metrics::kTouchOpen,
+     [](HidDriver::Devices& d, int w, int h, bool null_sink) {
+         if (!null_sink) return VirtualHID::touch_open(d.touch, w, h);
+         d.touch.screen_w = w;
+         d.touch.screen_h = h;
+         return open_null(d.touch.fd);
+     },
+     [](HidDriver::Devices& d) { VirtualHID::touch_close(d.touch); }},
+    {"pen", Metrics::kPenOpen,
+     [](HidDriver::Devices& d, int w, int h, bool null_sink) {
+         if (!null_sink) return VirtualHID::pen_open(d.pen, w, h);
+         d.pen.screen_w = w;
+         d.pen.screen_h = h;
+         return open_null(d.pen.fd);
+     },
+     [](HidDriver::Devices& d) { VirtualHID::pen_close(d.pen); }},
+    {"gyro", Metrics::kGyroOpen,
+     [](HidDriver::Devices& d, int, int, bool null_sink) {
+         return null_sink ? open_null(d.gyro.fd) : VirtualHID::gyro_open(d.gyro);
+     },
+     [](HidDriver::Devices& d) { VirtualHID::gyro_close(d.gyro); }},
+    {"pointers", Metrics::kPointersOpen,
+     [](HidDriver::Devices& d, int w, int h, bool null_sink) {
+         if (!null_sink) return VirtualHID::pointers_open(d.pointers, w, h);
+         d.pointers.screen_w = w;
+         d.pointers.screen_h = h;
+         for (int i = 0; i < d.pointers.count; ++i) {
+             if (open_null(d.pointers.p[i].fd)) continue;
+             VirtualHID::pointers_close(d.pointers);
+             return false;
+         }
+         return true;
+     },
+     [](HidDriver::Devices& d) { VirtualHID::pointers_close(d.pointers); }},
+};
+static constexpr int kNumDevices = sizeof(kDevices) / sizeof(kDevices[0]);
+
+static void close_devices(HidDriver::Devices& dev, int n)
+{
+    while (n-- > 0) kDevices[n].close(dev);
+}
+
+/** Open every device; appends "mouse 1.2 ms, gamepad 0.9 ms, ..." to @p timing. */
+static bool open_devices(HidDriver::Devices& dev, int screen_w, int screen_h, bool null_sink,
+                         std::string& timing)
+{
+    if (null_sink) std::cerr << "[hid_driver] HID_DRIVER_SINK=null: writing frames to /dev/null.\n";
+    for (int i = 0; i < kNumDevices; ++i) {
+        const int64_t t0 = steady_ns();
+        if (!kDevices[i].open(dev, screen_w, screen_h, null_sink)) {
+            std::cerr << "[hid_driver] Failed to create virtual " << kDevices[i].name << ".\n";
+            close_devices(dev, i);
+            return false;
+        }
+        char part[48];
+        std::snprintf(part, sizeof(part), "%s%s %.1f ms", i ? ", " : "", kDevices[i].name,
+                      (steady_ns() - t0) / 1e6);
+        timing += part;
+    }
+    dev.macros.fd[Macro::kGamepad]  = dev.gamepad.fd;
+    dev.macros.fd[Macro::kKeyboard] = dev.keyboard.fd;
+    return true;
+}
+
+/** Compile the macro file at @p path into @p macros; says why not and returns false. */
+static bool load_macros(const char* path, Macro::Set& macros)
+{
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[hid_driver] Cannot read macro file " << path << ".\n";
+        return false;
+    }
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string error;
+    if (!HidDriver::compile_macros(text, macros, error)) {
+        std::cerr << "[hid_driver] " << path << ": " << error << '\n';
+        return false;
+    }
+    std::cerr << "[hid_driver] Macros: " << macros.defs.size() << " from " << path << " ("
+              << macros.events.size() << " events).\n";
+    return true;
+}
+
+static void set_open_gauges(int open)
+{
+    for (const DeviceStep& d : kDevices) Metrics::set_gauge(d.open_gauge, open);
+}
+
 int main(int argc, char* argv[])
 {
     std::signal(SIGINT,  signal_handler);
     std::signal(SIGTERM, signal_handler);
 
+    std::string flight_path;
+    if (const char* env = std::getenv("HID_DRIVER_FLIGHT_LOG")) {
+        flight_path = env;
+    } else {
+        flight_path = "/tmp/hid_driver-" + std::to_string(getpid()) + ".flight";
+    }
+    AsyncLog::start();
+
+    FlightRecorder::set_dump_path(flight_path.c_str());
+    FlightRecorder::install_signal_handlers();
+    VirtualHID::set_emit_hook(on_emit);
+
+    const Simd::Isa isa = Simd::active_isa();
+    std::cerr << "[hid_driver] SIMD kernels: " << Simd::isa_name(isa)
+              << " (cpu supports " << Simd::isa_name(Simd::cpu_isa()) << ")\n";
+
+    if (const char* env = std::getenv("HID_DRIVER_METRICS")) {
+        if (Metrics::serve(env)) std::cerr << "[hid_driver] Metrics on " << env << '\n';
+    }
+
     int screen_w = 1920;
     int screen_h = 1080;
     if (argc >= 3) {
@@ -62,75 +560,96 @@ int main(int argc, char* argv[])
         screen_h = std::atoi(argv[2]);
     }
 
-    VirtualHID::MouseState   mouse;
-    VirtualHID::GamepadState gamepad;
-
-    if (!VirtualHID::mouse_open(mouse, screen_w, screen_h)) {
-        std::cerr << "[hid_driver] Failed to create virtual mouse.\n";
+    // Compiled before any device exists: a bad macro file stops the driver here.
+    Macro::Set macros;
+    const char* macro_path = std::getenv("HID_DRIVER_MACROS");
+    if (macro_path && !load_macros(macro_path, macros)) {
+        Metrics::stop();
+        AsyncLog::stop();
         return 1;
     }
-    if (!VirtualHID::gamepad_open(gamepad)) {
-        std::cerr << "[hid_driver] Failed to create virtual gamepad.\n";
-        VirtualHID::mouse_close(mouse);
+
+    Session session;
+    HidDriver::Devices& dev = session.dev;
+    if (macro_path) dev.macros.set = &macros;
+    const char* sink = std::getenv("HID_DRIVER_SINK");
+
+    // UI_DEV_CREATE timings go on the Ready line for main.py's startup timeline.
+    std::string timing;
+    const bool null_sink = sink && std::strcmp(sink, "null") == 0;
+    dev.pointers.count = kDefaultPointers;
+    if (const char* env = std::getenv("HID_DRIVER_POINTERS")) {
+        dev.pointers.count = std::max(0, std::min(std::atoi(env), VirtualHID::kMaxPointers));
+    }
+    if (!open_devices(dev, screen_w, screen_h, null_sink, timing)) {
+        Metrics::stop();
+        AsyncLog::stop();
         return 1;
     }
+    set_open_gauges(1);
 
-    std::cerr << "[hid_driver] Ready. Listening on stdin...\n";
+    int pen_tick_us = kPenTickUs;
+    if (const char* env = std::getenv("HID_DRIVER_PEN_TICK_US")) pen_tick_us = std::max(0, std::atoi(env));
+    dev.pen.tick_ns = int64_t{pen_tick_us} * 1000;
 
-    std::string line;
-    while (g_running && std::getline(std::cin, line)) {
-        if (line.empty() || line[0] == '#') continue;
+    int gyro_tick_us = kGyroTickUs;
+    if (const char* env = std::getenv("HID_DRIVER_GYRO_TICK_US")) {
+        gyro_tick_us = std::atoi(env) > 0 ? std::max(1000, std::atoi(env)) : 0;
+    }
+    dev.gyro.tick_ns = int64_t{gyro_tick_us} * 1000;
 
-        std::istringstream ss(line);
-        std::string cmd;
-        ss >> cmd;
+    if (const char* env = std::getenv("HID_DRIVER_TYPE_GAP_US")) {
+        dev.keyboard.gap_ns = int64_t{std::max(0, std::atoi(env))} * 1000;
+    }
 
-        if (cmd == "QUIT") {
-            break;
-        }
-        else if (cmd == "MOUSE_MOVE") {
-            int x, y;
-            if (ss >> x >> y) {
-                VirtualHID::mouse_move_abs(mouse, x, y);
-            }
-        }
-        else if (cmd == "MOUSE_LEFT") {
-            VirtualHID::mouse_click(mouse, BTN_LEFT);
-        }
-        else if (cmd == "MOUSE_RIGHT") {
-            VirtualHID::mouse_click(mouse, BTN_RIGHT);
-        }
-        else if (cmd == "MOUSE_SCROLL") {
-            int delta;
-            if (ss >> delta) {
-                VirtualHID::mouse_scroll(mouse, delta);
-            }
-        }
-        else if (cmd == "GAMEPAD_BTN") {
-            std::string name;
-            int state;
-            if (ss >> name >> state) {
-                auto it = kBtnMap.find(name);
-                if (it != kBtnMap.end()) {
-                    VirtualHID::gamepad_button(gamepad, it->second, state != 0);
-                } else {
-                    std::cerr << "[hid_driver] Unknown gamepad button: " << name << '\n';
-                }
-            }
-        }
-        else if (cmd == "GAMEPAD_STICK") {
-            int x, y;
-            if (ss >> x >> y) {
-                VirtualHID::gamepad_stick(gamepad, x, y);
-            }
-        }
-        else {
-            std::cerr << "[hid_driver] Unknown command: " << cmd << '\n';
+    int inertia_tick_us = kInertiaTickUs;
+    if (const char* env = std::getenv("HID_DRIVER_INERTIA_TICK_US")) {
+        inertia_tick_us = std::max(1000, std::atoi(env));
+    }
+    dev.mouse.tick_ns = int64_t{inertia_tick_us} * 1000;
+    if (const char* env = std::getenv("HID_DRIVER_INERTIA_FRICTION")) {
+        dev.mouse.friction = std::max(0.0, std::atof(env));
+    }
+
+    if (const char* env = std::getenv("HID_DRIVER_FEEDBACK_FD")) {
+        const int fd = std::atoi(env);
+        if (fd > STDERR_FILENO && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0) {
+            session.feedback_fd = fd;
+        } else {
+            std::cerr << "[hid_driver] HID_DRIVER_FEEDBACK_FD=" << env << " is not an open fd; "
+                      << "rumble will not be forwarded.\n";
         }
     }
+    std::cerr << "[hid_driver] Ready. Listening on stdin... (" << timing << ")\n";
+
+    std::thread watchdog(watchdog_loop);
+
+    EventLoop::TimerWheel timers(EventLoop::monotonic_clock());
+    EventLoop::LoopHooks  hooks;
+    hooks.on_line  = on_line;
+    hooks.ctx      = &session;
+    if (!null_sink) {
+        hooks.watch_fd    = dev.gamepad.fd;
+        hooks.on_readable = on_gamepad_readable;
+    }
+    session.hooks  = &hooks;
+    session.timers = &timers;
+    EventLoop::run(STDIN_FILENO, timers, hooks, g_running);
+
+    // Text still queued at EOF or QUIT is typed out before the keyboard goes.
+    while (dev.keyboard.typing && g_running) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(dev.keyboard.gap_ns));
+        VirtualHID::keyboard_type_tick(dev.keyboard);
+    }
+
+    g_running = false;
+    g_wake_cv.notify_all();
+    watchdog.join();
 
-    VirtualHID::mouse_close(mouse);
-    VirtualHID::gamepad_close(gamepad);
+    close_devices(dev, kNumDevices);
+    set_open_gauges(0);
+    Metrics::stop();
+    AsyncLog::stop();
     std::cerr << "[hid_driver] Exited cleanly.\n";
     return 0;
 }
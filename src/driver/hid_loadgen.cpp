@@ -0,0 +1,342 @@
+/*
+ * hid_loadgen.cpp
+ * Synthetic input load generator built on the VirtualHID API.
+ *
+ * Creates N virtual mice and M virtual gamepads and drives them from a pool
+ * of scheduler threads (devices are split round-robin; each thread always
+ * emits the device whose next frame is due soonest).
+ *
+ * Profiles (per device, --rate is frames per second per device)
+ * --------------------------------------------------------------
+ *   constant    - one frame every 1/rate s; cursor / stick sweep
+ *   bursty      - --burst frames back-to-back, then idle, same mean rate
+ *   randomwalk  - Poisson arrivals (mean 1/rate) with random-walk motion
+ *
+ * Report
+ * ------
+ *   device creation time (UI_DEV_CREATE round trip) per device,
+ *   target vs achieved frame rate, scheduler lag (how late frames went
+ *   out), per-frame write time and failed writes.  uinput fds are
+ *   O_NONBLOCK, so kernel backpressure shows up as slow or failed writes.
+ *   Results are written to $GESTURELINK_RESULTS_DIR/loadgen.json.
+ *
+ * Usage
+ * -----
+ *   make tools
+ *   ./hid_loadgen [--mice N] [--gamepads M] [--profile constant|bursty|randomwalk]
+ *                 [--rate HZ] [--burst B] [--duration S] [--threads T]
+ *                 [--null] [--json PATH]
+ *
+ *   --null writes every frame to /dev/null instead of creating uinput
+ *   devices, to exercise the scheduler on machines without uinput.
+ */
+
+#include "bench_results.h"
+#include "metrics.h"
+#include "virtual_hid.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class Profile { Constant, Bursty, RandomWalk };
+
+struct Options {
+    int         mice     = 4;
+    int         gamepads = 2;
+    Profile     profile  = Profile::Constant;
+    double      rate_hz  = 250.0;
+    int         burst    = 10;
+    double      duration = 5.0;
+    int         threads  = 2;
+    bool        null_sink = false;
+    std::string json_path;
+};
+
+struct Device {
+    bool                     is_mouse = true;
+    VirtualHID::MouseState   mouse;
+    VirtualHID::GamepadState pad;
+    double                   create_ms = 0.0;
+
+    // scheduler state (owned by one worker)
+    int64_t      due = 0;
+    int          in_burst = 0;
+    int          x = 0, y = 0;
+    uint64_t     frames = 0;
+    std::mt19937 rng;
+};
+
+struct WorkerStats {
+    std::vector<double> write_us;
+    std::vector<double> lag_us;
+};
+
+int64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t{ts.tv_sec} * 1000000000 + ts.tv_nsec;
+}
+
+double percentile(std::vector<double> v, double q)
+{
+    if (v.empty()) return 0.0;
+    const size_t idx = std::min(v.size() - 1, static_cast<size_t>(q * static_cast<double>(v.size())));
+    std::nth_element(v.begin(), v.begin() + static_cast<long>(idx), v.end());
+    return v[idx];
+}
+
+const char* profile_name(Profile p)
+{
+    switch (p) {
+    case Profile::Constant:   return "constant";
+    case Profile::Bursty:     return "bursty";
+    case Profile::RandomWalk: return "randomwalk";
+    }
+    return "?";
+}
+
+bool parse_options(int argc, char* argv[], Options& o)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (a == "--null") { o.null_sink = true; continue; }
+        if (!v) { std::fprintf(stderr, "[loadgen] %s needs a value\n", a.c_str()); return false; }
+        ++i;
+        if      (a == "--mice")     o.mice     = std::atoi(v);
+        else if (a == "--gamepads") o.gamepads = std::atoi(v);
+        else if (a == "--rate")     o.rate_hz  = std::atof(v);
+        else if (a == "--burst")    o.burst    = std::max(1, std::atoi(v));
+        else if (a == "--duration") o.duration = std::atof(v);
+        else if (a == "--threads")  o.threads  = std::max(1, std::atoi(v));
+        else if (a == "--json")     o.json_path = v;
+        else if (a == "--profile") {
+            const std::string p = v;
+            if      (p == "constant")   o.profile = Profile::Constant;
+            else if (p == "bursty")     o.profile = Profile::Bursty;
+            else if (p == "randomwalk") o.profile = Profile::RandomWalk;
+            else { std::fprintf(stderr, "[loadgen] unknown profile '%s'\n", v); return false; }
+        }
+        else { std::fprintf(stderr, "[loadgen] unknown option %s\n", a.c_str()); return false; }
+    }
+    if (o.mice < 0 || o.gamepads < 0 || o.mice + o.gamepads == 0 || o.rate_hz <= 0 || o.duration <= 0) {
+        std::fprintf(stderr, "[loadgen] need at least one device, --rate > 0 and --duration > 0\n");
+        return false;
+    }
+    return true;
+}
+
+// ---- Frames ---------------------------------------------------------------------
+
+void emit_frame(Device& d, Profile profile)
+{
+    if (d.is_mouse) {
+        if (profile == Profile::RandomWalk) {
+            std::normal_distribution<double> step(0.0, 15.0);
+            d.x = std::clamp(d.x + static_cast<int>(step(d.rng)), 0, 1919);
+            d.y = std::clamp(d.y + static_cast<int>(step(d.rng)), 0, 1079);
+        } else {
+            d.x = (d.x + 7) % 1920;
+            d.y = (d.y + 3) % 1080;
+        }
+        VirtualHID::mouse_move_abs(d.mouse, d.x, d.y);
+    } else {
+        if (profile == Profile::RandomWalk) {
+            std::normal_distribution<double> step(0.0, 800.0);
+            d.x = std::clamp(d.x + static_cast<int>(step(d.rng)), -32767, 32767);
+            d.y = std::clamp(d.y + static_cast<int>(step(d.rng)), -32767, 32767);
+        } else {
+            const double phase = static_cast<double>(d.frames) * 0.05;
+            d.x = static_cast<int>(32000.0 * std::sin(phase));
+            d.y = static_cast<int>(32000.0 * std::cos(phase));
+        }
+        VirtualHID::gamepad_stick(d.pad, d.x, d.y);
+        if (d.frames % 50 == 0) {
+            VirtualHID::gamepad_button(d.pad, VirtualHID::GamepadBtn::A, (d.frames / 50) % 2 == 0);
+        }
+    }
+    ++d.frames;
+}
+
+void schedule_next(Device& d, const Options& o)
+{
+    const double period_ns = 1e9 / o.rate_hz;
+    switch (o.profile) {
+    case Profile::Constant:
+        d.due += static_cast<int64_t>(period_ns);
+        break;
+    case Profile::Bursty:
+        if (++d.in_burst >= o.burst) {
+            d.in_burst = 0;
+            d.due += static_cast<int64_t>(period_ns * o.burst);
+        }
+        break;
+    case Profile::RandomWalk: {
+        std::exponential_distribution<double> gap(1.0 / period_ns);
+        d.due += static_cast<int64_t>(gap(d.rng));
+        break;
+    }
+    }
+}
+
+// ---- Scheduler ------------------------------------------------------------------
+
+void worker(std::vector<Device*> mine, const Options& o, int64_t end, WorkerStats& st)
+{
+    st.write_us.reserve(static_cast<size_t>(o.rate_hz * o.duration * static_cast<double>(mine.size()) * 1.2));
+    st.lag_us.reserve(st.write_us.capacity());
+    while (!mine.empty()) {
+        Device* d = *std::min_element(mine.begin(), mine.end(),
+                                      [](const Device* a, const Device* b) { return a->due < b->due; });
+        if (d->due >= end) break;
+        struct timespec ts{static_cast<time_t>(d->due / 1000000000), static_cast<long>(d->due % 1000000000)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+
+        const int64_t t0 = now_ns();
+        emit_frame(*d, o.profile);
+        const int64_t t1 = now_ns();
+        st.lag_us.push_back(static_cast<double>(t0 - d->due) / 1000.0);
+        st.write_us.push_back(static_cast<double>(t1 - t0) / 1000.0);
+        schedule_next(*d, o);
+    }
+}
+
+bool open_device(Device& d, bool null_sink)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    bool ok;
+    if (null_sink) {
+        const int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (d.is_mouse) d.mouse.fd = fd; else d.pad.fd = fd;
+        ok = fd >= 0;
+    } else {
+        ok = d.is_mouse ? VirtualHID::mouse_open(d.mouse, 1920, 1080) : VirtualHID::gamepad_open(d.pad);
+    }
+    d.create_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return ok;
+}
+
+void close_device(Device& d, bool null_sink)
+{
+    if (null_sink) {
+        close(d.is_mouse ? d.mouse.fd : d.pad.fd);
+    } else if (d.is_mouse) {
+        VirtualHID::mouse_close(d.mouse);
+    } else {
+        VirtualHID::gamepad_close(d.pad);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options o;
+    if (!parse_options(argc, argv, o)) return 2;
+
+    const int n_dev = o.mice + o.gamepads;
+    std::vector<Device> devices(static_cast<size_t>(n_dev));
+    for (int i = 0; i < n_dev; ++i) {
+        Device& d = devices[static_cast<size_t>(i)];
+        d.is_mouse = i < o.mice;
+        d.rng.seed(static_cast<uint32_t>(0x9e3779b9u * static_cast<uint32_t>(i + 1)));
+        if (!open_device(d, o.null_sink)) {
+            std::fprintf(stderr, "[loadgen] failed to create device %d; try --null without uinput\n", i);
+            for (int j = 0; j < i; ++j) close_device(devices[static_cast<size_t>(j)], o.null_sink);
+            return 1;
+        }
+    }
+
+    const int threads = std::min(o.threads, n_dev);
+    std::vector<std::vector<Device*>> split(static_cast<size_t>(threads));
+    const int64_t start = now_ns() + 10000000;                 // 10 ms to spin up workers
+    for (int i = 0; i < n_dev; ++i) {
+        Device& d = devices[static_cast<size_t>(i)];
+        // Stagger devices across one period so they do not all fire together.
+        d.due = start + static_cast<int64_t>(1e9 / o.rate_hz * i / n_dev);
+        split[static_cast<size_t>(i % threads)].push_back(&d);
+    }
+    const int64_t end = start + static_cast<int64_t>(o.duration * 1e9);
+    const uint64_t errors_before = Metrics::counter_value(Metrics::kEmitErrors);
+
+    std::vector<WorkerStats> stats(static_cast<size_t>(threads));
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back(worker, split[static_cast<size_t>(t)], std::cref(o), end,
+                          std::ref(stats[static_cast<size_t>(t)]));
+    }
+    for (std::thread& t : pool) t.join();
+    const double elapsed = static_cast<double>(std::max(now_ns(), end) - start) / 1e9;
+    const uint64_t errors = Metrics::counter_value(Metrics::kEmitErrors) - errors_before;
+
+    for (Device& d : devices) close_device(d, o.null_sink);
+
+    // ---- Report -------------------------------------------------------------
+    std::vector<double> create_ms, write_us, lag_us, dev_hz;
+    uint64_t frames = 0;
+    for (const Device& d : devices) {
+        create_ms.push_back(d.create_ms);
+        dev_hz.push_back(static_cast<double>(d.frames) / elapsed);
+        frames += d.frames;
+    }
+    for (const WorkerStats& s : stats) {
+        write_us.insert(write_us.end(), s.write_us.begin(), s.write_us.end());
+        lag_us.insert(lag_us.end(), s.lag_us.begin(), s.lag_us.end());
+    }
+    const double target_hz   = o.rate_hz * n_dev;
+    const double achieved_hz = static_cast<double>(frames) / elapsed;
+
+    std::printf("[loadgen] %d mice + %d gamepads, profile=%s, %d thread(s), %.1f s%s\n",
+                o.mice, o.gamepads, profile_name(o.profile), threads, elapsed,
+                o.null_sink ? " (null sink)" : "");
+    std::printf("  device create   median %8.2f ms   max %8.2f ms\n",
+                percentile(create_ms, 0.5), percentile(create_ms, 1.0));
+    std::printf("  frame rate      target %8.0f /s   achieved %8.0f /s  (%.1f%%)  "
+                "per device min %.0f max %.0f\n",
+                target_hz, achieved_hz, 100.0 * achieved_hz / target_hz,
+                percentile(dev_hz, 0.0), percentile(dev_hz, 1.0));
+    std::printf("  scheduler lag   p50 %8.1f us   p99 %8.1f us   max %8.1f us\n",
+                percentile(lag_us, 0.5), percentile(lag_us, 0.99), percentile(lag_us, 1.0));
+    std::printf("  frame write     p50 %8.1f us   p99 %8.1f us   max %8.1f us   failed writes %llu\n",
+                percentile(write_us, 0.5), percentile(write_us, 0.99), percentile(write_us, 1.0),
+                static_cast<unsigned long long>(errors));
+
+    const std::string tag = std::string(profile_name(o.profile)) + "/" +
+                            std::to_string(o.mice) + "m" + std::to_string(o.gamepads) + "g";
+    BenchResults::Benchmark rate;
+    rate.name            = "achieved_rate/" + tag;
+    rate.unit            = "frames/s";
+    rate.lower_is_better = false;
+    rate.samples         = {achieved_hz};
+    rate.metrics = {
+        {"target_hz", target_hz}, {"threads", threads}, {"null_sink", o.null_sink ? 1 : 0},
+        {"lag_p99_us", percentile(lag_us, 0.99)}, {"failed_writes", static_cast<double>(errors)},
+    };
+    BenchResults::Benchmark write;
+    write.name    = "frame_write/" + tag;
+    write.unit    = "us";
+    write.samples = write_us;
+    write.metrics = {{"p50_us", percentile(write_us, 0.5)}, {"p99_us", percentile(write_us, 0.99)}};
+    BenchResults::Benchmark create;
+    create.name    = "device_create/" + tag;
+    create.unit    = "ms";
+    create.samples = create_ms;
+
+    const std::string path = BenchResults::write("loadgen", {rate, write, create}, o.json_path);
+    if (!path.empty()) std::fprintf(stderr, "[loadgen] results written to %s\n", path.c_str());
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * keymap.cpp
+ * Key name lookup and the US QWERTY character table.
+ *
+ * The character table is built at compile time from the keyboard's rows,
+ * each of which is a run of consecutive evdev key codes, once unshifted and
+ * once shifted.  Lookups are a single array index.
+ */
+
+#include "keymap.h"
+#include "virtual_hid.h"
+
+#include <linux/input-event-codes.h>
+#include <array>
+
+namespace Keymap {
+
+namespace {
+
+struct KeyName {
+    std::string_view name;
+    uint16_t         code;
+};
+
+constexpr KeyName kKeyNames[] = {
+    // Modifiers (aliases first: they are what producers write)
+    {"CTRL", KEY_LEFTCTRL},   {"SHIFT", KEY_LEFTSHIFT}, {"ALT", KEY_LEFTALT},
+    {"META", KEY_LEFTMETA},   {"SUPER", KEY_LEFTMETA},
+    {"LEFTCTRL", KEY_LEFTCTRL},   {"RIGHTCTRL", KEY_RIGHTCTRL},
+    {"LEFTSHIFT", KEY_LEFTSHIFT}, {"RIGHTSHIFT", KEY_RIGHTSHIFT},
+    {"LEFTALT", KEY_LEFTALT},     {"RIGHTALT", KEY_RIGHTALT},
+    {"LEFTMETA", KEY_LEFTMETA},   {"RIGHTMETA", KEY_RIGHTMETA},
+
+    // Editing and navigation
+    {"ESC", KEY_ESC},             {"ENTER", KEY_ENTER},       {"TAB", KEY_TAB},
+    {"SPACE", KEY_SPACE},         {"BACKSPACE", KEY_BACKSPACE}, {"DELETE", KEY_DELETE},
+    {"INSERT", KEY_INSERT},       {"HOME", KEY_HOME},         {"END", KEY_END},
+    {"PAGEUP", KEY_PAGEUP},       {"PAGEDOWN", KEY_PAGEDOWN},
+    {"UP", KEY_UP},               {"DOWN", KEY_DOWN},         {"LEFT", KEY_LEFT},
+    {"RIGHT", KEY_RIGHT},         {"CAPSLOCK", KEY_CAPSLOCK}, {"SYSRQ", KEY_SYSRQ},
+
+    // Letters, digits and punctuation
+    {"A", KEY_A}, {"B", KEY_B}, {"C", KEY_C}, {"D", KEY_D}, {"E", KEY_E}, {"F", KEY_F},
+    {"G", KEY_G}, {"H", KEY_H}, {"I", KEY_I}, {"J", KEY_J}, {"K", KEY_K}, {"L", KEY_L},
+    {"M", KEY_M}, {"N", KEY_N}, {"O", KEY_O}, {"P", KEY_P}, {"Q", KEY_Q}, {"R", KEY_R},
+    {"S", KEY_S}, {"T", KEY_T}, {"U", KEY_U}, {"V", KEY_V}, {"W", KEY_W}, {"X", KEY_X},
+    {"Y", KEY_Y}, {"Z", KEY_Z},
+    {"0", KEY_0}, {"1", KEY_1}, {"2", KEY_2}, {"3", KEY_3}, {"4", KEY_4},
+    {"5", KEY_5}, {"6", KEY_6}, {"7", KEY_7}, {"8", KEY_8}, {"9", KEY_9},
+    {"MINUS", KEY_MINUS},         {"EQUAL", KEY_EQUAL},
+    {"LEFTBRACE", KEY_LEFTBRACE}, {"RIGHTBRACE", KEY_RIGHTBRACE},
+    {"SEMICOLON", KEY_SEMICOLON}, {"APOSTROPHE", KEY_APOSTROPHE}, {"GRAVE", KEY_GRAVE},
+    {"BACKSLASH", KEY_BACKSLASH}, {"COMMA", KEY_COMMA},       {"DOT", KEY_DOT},
+    {"SLASH", KEY_SLASH},
+
+    // Function and media keys
+    {"F1", KEY_F1}, {"F2", KEY_F2}, {"F3", KEY_F3},   {"F4", KEY_F4},
+    {"F5", KEY_F5}, {"F6", KEY_F6}, {"F7", KEY_F7},   {"F8", KEY_F8},
+    {"F9", KEY_F9}, {"F10", KEY_F10}, {"F11", KEY_F11}, {"F12", KEY_F12},
+    {"MUTE", KEY_MUTE},           {"VOLUMEDOWN", KEY_VOLUMEDOWN}, {"VOLUMEUP", KEY_VOLUMEUP},
+    {"PLAYPAUSE", KEY_PLAYPAUSE}, {"NEXTSONG", KEY_NEXTSONG},     {"PREVIOUSSONG", KEY_PREVIOUSSONG},
+};
+
+struct Entry {
+    uint8_t code  = 0;       // 0 = no key for this character
+    bool    shift = false;
+};
+
+using Table = std::array<Entry, 128>;
+
+/** Characters @p chars sit on consecutive keys starting at @p first. */
+constexpr void row(Table& t, std::string_view chars, uint8_t first, bool shift)
+{
+    for (size_t i = 0; i < chars.size(); ++i) {
+        t[static_cast<unsigned char>(chars[i])] = {static_cast<uint8_t>(first + i), shift};
+    }
+}
+
+constexpr Table make_us_qwerty()
+{
+    Table t{};
+    row(t, "1234567890-=",  KEY_1, false);          row(t, "!@#$%^&*()_+",  KEY_1, true);
+    row(t, "qwertyuiop[]",  KEY_Q, false);          row(t, "QWERTYUIOP{}",  KEY_Q, true);
+    row(t, "asdfghjkl;'`",  KEY_A, false);          row(t, "ASDFGHJKL:\"~", KEY_A, true);
+    row(t, "\\zxcvbnm,./",  KEY_BACKSLASH, false);  row(t, "|ZXCVBNM<>?",   KEY_BACKSLASH, true);
+    row(t, " ",  KEY_SPACE, false);
+    row(t, "\t", KEY_TAB,   false);
+    row(t, "\n", KEY_ENTER, false);
+    return t;
+}
+
+constexpr Table kUsQwerty = make_us_qwerty();
+
+static_assert(kUsQwerty['a'].code == KEY_A && kUsQwerty['L'].code == KEY_L && kUsQwerty['L'].shift,
+              "home row");
+static_assert(kUsQwerty['/'].code == KEY_SLASH && kUsQwerty['~'].code == KEY_GRAVE, "row ends");
+
+/** Every key a name or character resolves to exists on the virtual keyboard. */
+constexpr bool on_keyboard()
+{
+    for (const KeyName& k : kKeyNames) {
+        if (!VirtualHID::kKeyboardDevice.supports(EV_KEY, k.code)) return false;
+    }
+    for (const Entry& e : kUsQwerty) {
+        if (e.code != 0 && !VirtualHID::kKeyboardDevice.supports(EV_KEY, e.code)) return false;
+    }
+    return VirtualHID::kKeyboardDevice.supports(EV_KEY, KEY_LEFTSHIFT);
+}
+
+static_assert(on_keyboard(), "a key outside kKeyboardDevice");
+
+} // namespace
+
+bool key_code(std::string_view name, uint16_t& code)
+{
+    if (name.substr(0, 4) == "KEY_") name.remove_prefix(4);
+    for (const KeyName& k : kKeyNames) {
+        if (k.name == name) {
+            code = k.code;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool next_stroke(std::string_view& text, Stroke& out)
+{
+    const unsigned char c = static_cast<unsigned char>(text[0]);
+
+    if (c >= 0x80) {
+        // Non-ASCII: skip the whole code point (lead byte + continuations).
+        size_t n = 1;
+        while (n < text.size() && (static_cast<unsigned char>(text[n]) & 0xc0) == 0x80) ++n;
+        text.remove_prefix(n);
+        return false;
+    }
+
+    char ch = static_cast<char>(c);
+    text.remove_prefix(1);
+    if (ch == '\\' && !text.empty()) {
+        const char e = text[0];
+        if (e == 'n' || e == 't' || e == '\\') {
+            ch = e == 'n' ? '\n' : e == 't' ? '\t' : '\\';
+            text.remove_prefix(1);
+        }
+    }
+
+    const Entry& k = kUsQwerty[static_cast<unsigned char>(ch)];
+    if (k.code == 0) return false;
+    out = {k.code, k.shift};
+    return true;
+}
+
+} // namespace Keymap
@@ -0,0 +1,38 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+/*
+ * keymap.h
+ * Key names and the text layout table behind the keyboard commands.
+ *
+ * Key names are evdev KEY_* names without the prefix ("LEFTCTRL", "TAB",
+ * "F5", "A"), plus the aliases CTRL / SHIFT / ALT / META / SUPER for the
+ * left-hand modifiers.  Text is compiled against a US QWERTY layout: evdev
+ * carries key positions, not characters, so the host must use a US keymap
+ * for TYPE to produce the intended characters.
+ */
+
+#include <cstdint>
+#include <string_view>
+
+namespace Keymap {
+
+/** One key press that produces a character. */
+struct Stroke {
+    uint16_t code;      // KEY_*
+    bool     shift;     // needs LEFTSHIFT held
+};
+
+/** Look up a key name; returns false if unknown.  Accepts an optional "KEY_" prefix. */
+bool key_code(std::string_view name, uint16_t& code);
+
+/**
+ * Consume one character from the front of @p text and look it up.  A
+ * character is a UTF-8 code point or one of the escapes \n (Enter), \t
+ * (Tab) and \\.  Returns false for a character the layout has no key for;
+ * it is still consumed.  @p text must not be empty.  Does not allocate.
+ */
+bool next_stroke(std::string_view& text, Stroke& out);
+
+} // namespace Keymap
+
+#endif // KEYMAP_H
@@ -0,0 +1,131 @@
+/*
+ * macro.cpp
+ * Macro playback: a cursor per running macro over its compiled events.
+ */
+
+#include "macro.h"
+#include "metrics.h"
+#include "virtual_hid.h"
+
+#include <linux/input-event-codes.h>
+
+namespace Macro {
+
+const Def* Set::find(std::string_view name) const
+{
+    for (const Def& d : defs) {
+        if (d.name == name) return &d;
+    }
+    return nullptr;
+}
+
+namespace {
+
+constexpr uint16_t kTargetBit = 1u << 15;
+
+uint16_t held_key(uint8_t target, uint16_t code)
+{
+    return static_cast<uint16_t>(target ? kTargetBit | code : code);
+}
+
+/** Note a key press or release so stop() knows what to let go of. */
+void track(Playing& m, const Event& e)
+{
+    const uint16_t key = held_key(e.target, e.code);
+    for (int i = 0; i < m.held_count; ++i) {
+        if (m.held[i] == key) {
+            if (e.value == 0) m.held[i] = m.held[--m.held_count];
+            return;
+        }
+    }
+    if (e.value != 0 && m.held_count < kMaxHeld) m.held[m.held_count++] = key;
+}
+
+/** Release everything @p m holds, one frame per device, and free the slot. */
+void release(Player& p, Playing& m)
+{
+    VirtualHID::EventBatch gamepad(p.fd[kGamepad]), keyboard(p.fd[kKeyboard]);
+    for (int i = 0; i < m.held_count; ++i) {
+        VirtualHID::EventBatch& b = m.held[i] & kTargetBit ? keyboard : gamepad;
+        b.add(EV_KEY, static_cast<uint16_t>(m.held[i] & ~kTargetBit), 0);
+    }
+    if (gamepad.count > 0) gamepad.syn();
+    if (keyboard.count > 0) keyboard.syn();
+    m = Playing{};
+    --p.active;
+}
+
+int64_t next_due(const Player& p)
+{
+    int64_t next = 0;
+    for (const Playing& m : p.playing) {
+        if (!m.def) continue;
+        const int64_t due = m.start_ns + p.set->events[m.def->first + m.next].t_ns;
+        if (next == 0 || due < next) next = due;
+    }
+    return next;
+}
+
+} // namespace
+
+bool start(Player& p, std::string_view name, int64_t now_ns)
+{
+    const Def* def = p.set ? p.set->find(name) : nullptr;
+    if (!def) return false;
+    Playing* slot = nullptr;
+    for (Playing& m : p.playing) {
+        if (m.def == def) release(p, m);
+    }
+    for (Playing& m : p.playing) {
+        if (!m.def) {
+            slot = &m;
+            break;
+        }
+    }
+    if (!slot) return false;
+    slot->def      = def;
+    slot->start_ns = now_ns;
+    ++p.active;
+    tick(p, now_ns);
+    return true;
+}
+
+int stop(Player& p, std::string_view name)
+{
+    int n = 0;
+    for (Playing& m : p.playing) {
+        if (m.def && (name.empty() || m.def->name == name)) {
+            release(p, m);
+            ++n;
+        }
+    }
+    p.next_ns = next_due(p);
+    return n;
+}
+
+int64_t tick(Player& p, int64_t now_ns)
+{
+    VirtualHID::EventBatch batch[kNumTargets] = {VirtualHID::EventBatch(p.fd[kGamepad]),
+                                                 VirtualHID::EventBatch(p.fd[kKeyboard])};
+    for (Playing& m : p.playing) {
+        if (!m.def) continue;
+        const Event* ev = p.set->events.data() + m.def->first;
+        while (m.next < m.def->count && m.start_ns + ev[m.next].t_ns <= now_ns + kSlackNs) {
+            const Event& e = ev[m.next++];
+            batch[e.target].add(e.type, e.code, e.value);
+            if (e.type == EV_KEY) {
+                track(m, e);
+            } else if (e.type == EV_SYN) {
+                const int64_t due = m.start_ns + e.t_ns;
+                Metrics::observe_macro_drift_ns(static_cast<uint64_t>(now_ns > due ? now_ns - due : due - now_ns));
+            }
+        }
+        if (m.next == m.def->count) {
+            m = Playing{};
+            --p.active;
+        }
+    }
+    return p.next_ns = next_due(p);
+}
+
+} // namespace Macro
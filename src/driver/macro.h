@@ -0,0 +1,114 @@
+#ifndef MACRO_H
+#define MACRO_H
+/*
+ * macro.h
+ * Timed input sequences ("combos") compiled once at load and played back
+ * from the driver's timer wheel by a single MACRO command.
+ *
+ * Macro file (HID_DRIVER_MACROS), one step per line:
+ *   # down, down-forward, forward + A inside 200 ms
+ *   [hadouken]
+ *   0    GAMEPAD_STICK 0 32767
+ *   40   GAMEPAD_STICK 23170 23170
+ *   80   GAMEPAD_STICK 32767 0
+ *   80   GAMEPAD_BTN A 1
+ *   130  GAMEPAD_BTN A 0
+ *   130  GAMEPAD_STICK 0 0
+ *
+ * Each step is "<ms> <command>": milliseconds after the macro starts (to
+ * 1 µs, e.g. 16.667) and one of GAMEPAD_BTN, GAMEPAD_STICK, KEY_DOWN or
+ * KEY_UP with the protocol's own arguments.  Steps may be listed in any
+ * order; equal times keep file order.  Compilation (HidDriver::
+ * compile_macros) turns every macro into a run of a flat Event array:
+ * input_events with their offset and target device, SYN_REPORTs already in
+ * place, so playback is a cursor walk that neither parses nor allocates.
+ *
+ * Steps due within kSlackNs of a tick are written by that tick, in order;
+ * how far each frame lands from its defined time is exported as the
+ * hid_driver_macro_drift_seconds histogram.  Stopping a macro releases
+ * every key and button it still holds.
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Macro {
+
+/** Device a compiled event goes to. */
+enum Target : uint8_t { kGamepad, kKeyboard, kNumTargets };
+
+/** One compiled input_event, @p t_ns after its macro started. */
+struct Event {
+    int64_t  t_ns;
+    uint8_t  target;
+    uint16_t type;
+    uint16_t code;
+    int32_t  value;
+};
+
+/** A macro: events [first, first + count) of Set::events. */
+struct Def {
+    std::string name;
+    uint32_t    first     = 0;
+    uint32_t    count     = 0;
+    int64_t     length_ns = 0;   // offset of the last step
+};
+
+/** Every macro of one file, sharing a single event array. */
+struct Set {
+    std::vector<Def>   defs;
+    std::vector<Event> events;
+
+    const Def* find(std::string_view name) const;
+};
+
+/** Macros that may run at once. */
+constexpr int kMaxPlaying = 4;
+
+/** Keys / buttons one running macro can hold down at a time. */
+constexpr int kMaxHeld = 16;
+
+/** Frames due up to this far ahead of a tick are written by it (one wheel tick). */
+constexpr int64_t kSlackNs = 1000000;
+
+/** A running macro. */
+struct Playing {
+    const Def* def = nullptr;    // nullptr: slot free
+    int64_t    start_ns = 0;
+    uint32_t   next = 0;         // index of the next event within def
+    uint16_t   held[kMaxHeld];   // (target << 15) | code of every key it holds
+    int        held_count = 0;
+};
+
+struct Player {
+    const Set* set = nullptr;    // nullptr: no macros loaded
+    int        fd[kNumTargets] = {-1, -1};
+    Playing    playing[kMaxPlaying];
+    int        active = 0;
+    int64_t    next_ns = 0;      // next frame due (0 = none)
+};
+
+/**
+ * Start macro @p name at @p now_ns and write its frames that are already
+ * due.  Starting a macro that is running restarts it (after releasing what
+ * it holds).  @return false if there is no such macro or every slot is busy.
+ */
+bool start(Player& p, std::string_view name, int64_t now_ns);
+
+/**
+ * Cancel macro @p name, or every running macro if @p name is empty,
+ * releasing the keys and buttons it holds.  @return how many were stopped.
+ */
+int stop(Player& p, std::string_view name);
+
+/**
+ * Write every frame due up to @p now_ns + kSlackNs and retire finished
+ * macros.  @return the time the next frame is due (0 if nothing is running).
+ */
+int64_t tick(Player& p, int64_t now_ns);
+
+} // namespace Macro
+
+#endif // MACRO_H
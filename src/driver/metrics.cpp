@@ -0,0 +1,434 @@
+/*
+ * metrics.cpp
+ * Per-thread sharded metric storage and the Prometheus text exporter.
+ *
+ * A thread claims a shard on its first inc()/observe; with more recording
+ * threads than kMaxShards, shards are shared, which is still correct
+ * because every update is an atomic fetch_add.  The exporter thread serves
+ * one HTTP/1.0 request per connection and renders a fresh snapshot each
+ * time; it never blocks the recording threads.
+ */
+
+#include "metrics.h"
+#include "async_log.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace Metrics {
+
+namespace {
+
+constexpr int kMaxShards = 16;
+
+struct Histogram {
+    std::atomic<uint64_t> buckets[kNumLatencyBuckets + 1];     // last = +Inf
+    std::atomic<uint64_t> sum_ns;
+};
+
+struct alignas(64) Shard {
+    std::atomic<uint64_t> counters[kNumCounters];
+    Histogram             dispatch;
+    Histogram             turbo_edge;
+    Histogram             macro_drift;
+};
+
+Shard                g_shards[kMaxShards];
+std::atomic<int>     g_next_shard{0};
+std::atomic<int64_t> g_gauges[kNumGauges];
+
+std::atomic<bool>    g_running{false};
+std::thread          g_server;
+int                  g_listen_fd = -1;
+std::string          g_unix_path;
+
+Shard& my_shard()
+{
+    thread_local Shard* shard =
+        &g_shards[g_next_shard.fetch_add(1, std::memory_order_relaxed) % kMaxShards];
+    return *shard;
+}
+
+void observe(Histogram Shard::*h, uint64_t ns)
+{
+    Histogram& hist = my_shard().*h;
+    const double us = static_cast<double>(ns) / 1000.0;
+    int b = 0;
+    while (b < kNumLatencyBuckets && us > kLatencyBucketsUs[b]) ++b;
+    hist.buckets[b].fetch_add(1, std::memory_order_relaxed);
+    hist.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+const char* const kCommandNames[] = {
+    "MOUSE_MOVE", "MOUSE_LEFT", "MOUSE_RIGHT", "MOUSE_SCROLL", "MOUSE_RELEASE",
+    "GAMEPAD_BTN", "GAMEPAD_STICK", "GAMEPAD_TURBO", "KEY_DOWN", "KEY_UP", "KEY_CHORD", "TYPE",
+    "TOUCH", "PEN", "POINTER", "GYRO", "POWER", "MACRO", "MACRO_STOP", "QUIT",
+};
+static_assert(sizeof(kCommandNames) / sizeof(kCommandNames[0]) == kCmdQuit + 1,
+              "one name per command counter");
+
+// ---- Rendering ------------------------------------------------------------------
+
+void append(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+void append(std::string& out, const char* fmt, ...)
+{
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    const int n = std::vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > 0) out.append(buf, static_cast<size_t>(n) < sizeof(buf) ? static_cast<size_t>(n) : sizeof(buf) - 1);
+}
+
+void header(std::string& out, const char* name, const char* type, const char* help)
+{
+    append(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/** One histogram summed over all shards. */
+void render_histogram(std::string& out, Histogram Shard::*h, const char* name, const char* help)
+{
+    header(out, name, "histogram", help);
+    uint64_t cumulative = 0, sum_ns = 0;
+    for (int b = 0; b <= kNumLatencyBuckets; ++b) {
+        for (const Shard& s : g_shards) cumulative += (s.*h).buckets[b].load(std::memory_order_relaxed);
+        if (b < kNumLatencyBuckets) {
+            append(out, "%s_bucket{le=\"%g\"} %llu\n", name, kLatencyBucketsUs[b] / 1e6,
+                   static_cast<unsigned long long>(cumulative));
+        } else {
+            append(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, static_cast<unsigned long long>(cumulative));
+        }
+    }
+    for (const Shard& s : g_shards) sum_ns += (s.*h).sum_ns.load(std::memory_order_relaxed);
+    append(out, "%s_sum %.9f\n", name, static_cast<double>(sum_ns) / 1e9);
+    append(out, "%s_count %llu\n", name, static_cast<unsigned long long>(cumulative));
+}
+
+/** utime + stime of every thread in this process, from /proc/self/task. */
+void render_thread_cpu(std::string& out)
+{
+    header(out, "hid_driver_thread_cpu_seconds_total", "counter", "CPU time consumed per thread.");
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return;
+    const double tick = static_cast<double>(sysconf(_SC_CLK_TCK));
+    while (struct dirent* de = readdir(dir)) {
+        if (de->d_name[0] == '.') continue;
+        std::ifstream f(std::string("/proc/self/task/") + de->d_name + "/stat");
+        std::string stat;
+        if (!std::getline(f, stat)) continue;
+        const size_t lp = stat.find('('), rp = stat.rfind(')');
+        if (lp == std::string::npos || rp == std::string::npos) continue;
+        const std::string comm = stat.substr(lp + 1, rp - lp - 1);
+        // Fields after "comm": state(3) ... utime(14) stime(15).
+        unsigned long long utime = 0, stime = 0;
+        if (std::sscanf(stat.c_str() + rp + 2,
+                        "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                        &utime, &stime) != 2) continue;
+        append(out, "hid_driver_thread_cpu_seconds_total{tid=\"%s\",thread=\"%s\",mode=\"user\"} %.2f\n",
+               de->d_name, comm.c_str(), static_cast<double>(utime) / tick);
+        append(out, "hid_driver_thread_cpu_seconds_total{tid=\"%s\",thread=\"%s\",mode=\"system\"} %.2f\n",
+               de->d_name, comm.c_str(), static_cast<double>(stime) / tick);
+    }
+    closedir(dir);
+}
+
+// ---- HTTP exporter --------------------------------------------------------------
+
+/** Whether @p req is a GET of exactly @p path (ending at a space or a query). */
+bool is_get(const char* req, const char* path)
+{
+    const size_t n = std::strlen(path);
+    return std::strncmp(req, "GET ", 4) == 0 && std::strncmp(req + 4, path, n) == 0 &&
+           (req[4 + n] == ' ' || req[4 + n] == '?');
+}
+
+void handle(int fd)
+{
+    struct timeval tv{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    char req[2048];
+    size_t len = 0;
+    while (len < sizeof(req) - 1) {
+        const ssize_t n = recv(fd, req + len, sizeof(req) - 1 - len, 0);
+        if (n <= 0) break;
+        len += static_cast<size_t>(n);
+        req[len] = '\0';
+        if (std::strstr(req, "\r\n\r\n") || std::strstr(req, "\n\n")) break;
+    }
+    req[len] = '\0';
+
+    std::string body, status = "200 OK";
+    if (is_get(req, "/metrics") || is_get(req, "/")) {
+        body = render();
+    } else {
+        status = "404 Not Found";
+        body   = "try GET /metrics\n";
+    }
+    std::string resp = "HTTP/1.0 " + status + "\r\n"
+                       "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+    size_t off = 0;
+    while (off < resp.size()) {
+        const ssize_t n = send(fd, resp.data() + off, resp.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        off += static_cast<size_t>(n);
+    }
+}
+
+void server_loop()
+{
+    pthread_setname_np(pthread_self(), "hid_metrics");
+    while (g_running.load(std::memory_order_acquire)) {
+        struct pollfd pfd{g_listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        const int fd = accept(g_listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+        handle(fd);
+        close(fd);
+    }
+}
+
+int bind_unix(const std::string& path)
+{
+    struct sockaddr_un addr{};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    // Replace a stale socket, but never delete anything else a typo names
+    struct stat st{};
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            close(fd);
+            errno = EEXIST;
+            return -1;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int bind_loopback(const std::string& spec)
+{
+    std::string host = "127.0.0.1", port = spec;
+    const size_t colon = spec.rfind(':');
+    if (colon != std::string::npos) {
+        host = spec.substr(0, colon);
+        port = spec.substr(colon + 1);
+    }
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+        (ntohl(addr.sin_addr.s_addr) >> 24) != 127) {
+        errno = EINVAL;                                     // loopback only
+        return -1;
+    }
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+// ---- Recording ------------------------------------------------------------------
+
+void inc(Counter c, uint64_t n)
+{
+    my_shard().counters[c].fetch_add(n, std::memory_order_relaxed);
+}
+
+void observe_dispatch_ns(uint64_t ns)
+{
+    observe(&Shard::dispatch, ns);
+}
+
+void observe_turbo_edge_ns(uint64_t ns)
+{
+    observe(&Shard::turbo_edge, ns);
+}
+
+void observe_macro_drift_ns(uint64_t ns)
+{
+    observe(&Shard::macro_drift, ns);
+}
+
+void set_gauge(Gauge g, int64_t value)
+{
+    g_gauges[g].store(value, std::memory_order_relaxed);
+}
+
+uint64_t counter_value(Counter c)
+{
+    uint64_t v = 0;
+    for (const Shard& s : g_shards) v += s.counters[c].load(std::memory_order_relaxed);
+    return v;
+}
+
+std::string render()
+{
+    std::string out;
+    out.reserve(8192);
+
+    header(out, "hid_driver_commands_total", "counter", "Protocol commands received, by type.");
+    for (int c = kCmdMouseMove; c <= kCmdQuit; ++c) {
+        append(out, "hid_driver_commands_total{command=\"%s\"} %llu\n", kCommandNames[c],
+               static_cast<unsigned long long>(counter_value(static_cast<Counter>(c))));
+    }
+    append(out, "hid_driver_commands_total{command=\"unknown\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kCmdUnknown)));
+    append(out, "hid_driver_commands_total{command=\"malformed\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kCmdMalformed)));
+
+    header(out, "hid_driver_events_emitted_total", "counter", "input_events written to uinput devices.");
+    append(out, "hid_driver_events_emitted_total %llu\n",
+           static_cast<unsigned long long>(counter_value(kEventsEmitted)));
+
+    header(out, "hid_driver_events_dropped_total", "counter", "Events or records lost, by reason.");
+    append(out, "hid_driver_events_dropped_total{reason=\"emit_error\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kEmitErrors)));
+    append(out, "hid_driver_events_dropped_total{reason=\"unmapped_char\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kKeysUnmapped)));
+    append(out, "hid_driver_events_dropped_total{reason=\"log_ring_full\"} %llu\n",
+           static_cast<unsigned long long>(AsyncLog::dropped()));
+    append(out, "hid_driver_events_dropped_total{reason=\"feedback_full\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kFeedbackDropped)));
+
+    header(out, "hid_driver_ff_requests_total", "counter", "Force-feedback requests answered, by type.");
+    append(out, "hid_driver_ff_requests_total{request=\"upload\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kFfUploads)));
+    append(out, "hid_driver_ff_requests_total{request=\"erase\"} %llu\n",
+           static_cast<unsigned long long>(counter_value(kFfErases)));
+
+    header(out, "hid_driver_queue_depth", "gauge", "Items waiting in driver queues.");
+    int pending = 0;
+    if (ioctl(STDIN_FILENO, FIONREAD, &pending) < 0) pending = 0;
+    append(out, "hid_driver_queue_depth{queue=\"stdin_bytes\"} %d\n", pending);
+    append(out, "hid_driver_queue_depth{queue=\"log\"} %zu\n", AsyncLog::depth());
+
+    render_histogram(out, &Shard::dispatch, "hid_driver_dispatch_latency_seconds",
+                     "Time from a command line being read to its events being written.");
+    render_histogram(out, &Shard::turbo_edge, "hid_driver_turbo_edge_error_seconds",
+                     "Distance of each turbo button edge from its ideal time.");
+    render_histogram(out, &Shard::macro_drift, "hid_driver_macro_drift_seconds",
+                     "Distance of each macro frame from its defined time.");
+
+    header(out, "hid_driver_device_open", "gauge", "1 if the virtual device is registered.");
+    append(out, "hid_driver_device_open{device=\"mouse\"} %lld\n",
+           static_cast<long long>(g_gauges[kMouseOpen].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_open{device=\"gamepad\"} %lld\n",
+           static_cast<long long>(g_gauges[kGamepadOpen].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_open{device=\"keyboard\"} %lld\n",
+           static_cast<long long>(g_gauges[kKeyboardOpen].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_open{device=\"touch\"} %lld\n",
+           static_cast<long long>(g_gauges[kTouchOpen].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_open{device=\"pen\"} %lld\n",
+           static_cast<long long>(g_gauges[kPenOpen].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_open{device=\"pointers\"} %lld\n",
+           static_cast<long long>(g_gauges[kPointersOpen].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_open{device=\"gyro\"} %lld\n",
+           static_cast<long long>(g_gauges[kGyroOpen].load(std::memory_order_relaxed)));
+
+    header(out, "hid_driver_device_axis", "gauge", "Last absolute axis value sent to a device.");
+    append(out, "hid_driver_device_axis{device=\"mouse\",axis=\"x\"} %lld\n",
+           static_cast<long long>(g_gauges[kCursorX].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_axis{device=\"mouse\",axis=\"y\"} %lld\n",
+           static_cast<long long>(g_gauges[kCursorY].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_axis{device=\"gamepad\",axis=\"x\"} %lld\n",
+           static_cast<long long>(g_gauges[kStickX].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_axis{device=\"gamepad\",axis=\"y\"} %lld\n",
+           static_cast<long long>(g_gauges[kStickY].load(std::memory_order_relaxed)));
+    append(out, "hid_driver_device_axis{device=\"pen\",axis=\"pressure\"} %lld\n",
+           static_cast<long long>(g_gauges[kPenPressure].load(std::memory_order_relaxed)));
+
+    header(out, "hid_driver_power_idle", "gauge", "1 while the producer reports no hand (POWER IDLE).");
+    append(out, "hid_driver_power_idle %lld\n",
+           static_cast<long long>(g_gauges[kPowerIdle].load(std::memory_order_relaxed)));
+
+    header(out, "hid_driver_touch_contacts", "gauge", "Contacts currently down on the touchscreen.");
+    append(out, "hid_driver_touch_contacts %lld\n",
+           static_cast<long long>(g_gauges[kTouchContacts].load(std::memory_order_relaxed)));
+
+    header(out, "hid_driver_ff_playing", "gauge", "Rumble effects currently playing on the gamepad.");
+    append(out, "hid_driver_ff_playing %lld\n",
+           static_cast<long long>(g_gauges[kFfPlaying].load(std::memory_order_relaxed)));
+
+    header(out, "hid_driver_turbo_buttons", "gauge", "Gamepad buttons currently autofiring (GAMEPAD_TURBO).");
+    append(out, "hid_driver_turbo_buttons %lld\n",
+           static_cast<long long>(g_gauges[kTurboButtons].load(std::memory_order_relaxed)));
+
+    header(out, "hid_driver_macros_running", "gauge", "Macros currently playing (MACRO).");
+    append(out, "hid_driver_macros_running %lld\n",
+           static_cast<long long>(g_gauges[kMacrosRunning].load(std::memory_order_relaxed)));
+
+    render_thread_cpu(out);
+    return out;
+}
+
+// ---- Exporter -------------------------------------------------------------------
+
+bool serve(const std::string& endpoint)
+{
+    if (g_running.load()) return true;
+
+    if (endpoint.rfind("unix:", 0) == 0) {
+        g_unix_path = endpoint.substr(5);
+        g_listen_fd = bind_unix(g_unix_path);
+    } else {
+        g_unix_path.clear();
+        g_listen_fd = bind_loopback(endpoint);
+    }
+    if (g_listen_fd < 0) {
+        std::cerr << "[hid_driver] Cannot serve metrics on '" << endpoint << "': "
+                  << strerror(errno) << " (expected unix:/path or a 127.x.x.x port)\n";
+        return false;
+    }
+
+    g_running.store(true, std::memory_order_release);
+    g_server = std::thread(server_loop);
+    return true;
+}
+
+void stop()
+{
+    if (!g_running.exchange(false)) return;
+    g_server.join();
+    close(g_listen_fd);
+    g_listen_fd = -1;
+    if (!g_unix_path.empty()) unlink(g_unix_path.c_str());
+}
+
+} // namespace Metrics
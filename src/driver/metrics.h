@@ -0,0 +1,116 @@
+#ifndef METRICS_H
+#define METRICS_H
+/*
+ * metrics.h
+ * Driver counters, gauges and latency histograms, exported in Prometheus
+ * text format (version 0.0.4) over loopback HTTP or a Unix socket.
+ *
+ * Counters and histograms are sharded per thread: each thread that records
+ * gets its own cache-line-aligned shard, so the hot path only ever touches
+ * a line it owns and a scrape (which sums all shards) never contends with
+ * it.  Gauges are single relaxed atomics written by whoever owns the state.
+ *
+ * Endpoint syntax (HID_DRIVER_METRICS or serve()):
+ *   unix:/run/user/1000/hid_driver.metrics   - HTTP over a Unix socket
+ *   9464 | 127.0.0.1:9464                    - HTTP on loopback only
+ *
+ *   curl --unix-socket /run/user/1000/hid_driver.metrics http://x/metrics
+ *   curl http://127.0.0.1:9464/metrics
+ */
+
+#include <cstdint>
+#include <string>
+
+namespace Metrics {
+
+enum Counter : int {
+    kCmdMouseMove,
+    kCmdMouseLeft,
+    kCmdMouseRight,
+    kCmdMouseScroll,
+    kCmdMouseRelease,
+    kCmdGamepadBtn,
+    kCmdGamepadStick,
+    kCmdGamepadTurbo,
+    kCmdKeyDown,
+    kCmdKeyUp,
+    kCmdKeyChord,
+    kCmdType,
+    kCmdTouch,
+    kCmdPen,
+    kCmdPointer,
+    kCmdGyro,
+    kCmdPower,
+    kCmdMacro,
+    kCmdMacroStop,
+    kCmdQuit,
+    kCmdUnknown,        // unrecognised command, gamepad button or key
+    kCmdMalformed,      // recognised command with bad arguments
+    kEventsEmitted,     // input_events written (incl. SYN_REPORT)
+    kEmitErrors,        // failed input_event writes (event lost)
+    kKeysUnmapped,      // TYPE characters with no key on the layout (skipped)
+    kFfUploads,         // rumble effects uploaded to the gamepad
+    kFfErases,          // rumble effects erased
+    kFeedbackDropped,   // back-channel lines lost (producer not reading)
+    kNumCounters
+};
+
+enum Gauge : int {
+    kMouseOpen,
+    kGamepadOpen,
+    kKeyboardOpen,
+    kTouchOpen,
+    kPenOpen,
+    kPointersOpen,
+    kGyroOpen,
+    kCursorX,
+    kCursorY,
+    kStickX,
+    kStickY,
+    kPowerIdle,         // 1 between POWER IDLE and POWER ACTIVE
+    kTouchContacts,     // fingers currently down on the touchscreen
+    kPenPressure,       // last ABS_PRESSURE sent (0 while hovering or out)
+    kFfPlaying,         // rumble effects currently playing on the gamepad
+    kTurboButtons,      // gamepad buttons currently autofiring
+    kMacrosRunning,     // macros currently playing
+    kNumGauges
+};
+
+/** Histogram bucket upper bounds for dispatch latency, turbo edge error and macro drift, microseconds. */
+constexpr double kLatencyBucketsUs[] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000,
+};
+constexpr int kNumLatencyBuckets = sizeof(kLatencyBucketsUs) / sizeof(kLatencyBucketsUs[0]);
+
+/** Add @p n to a counter in the calling thread's shard. */
+void inc(Counter c, uint64_t n = 1);
+
+/** Record the receive→emit time of one command. */
+void observe_dispatch_ns(uint64_t ns);
+
+/** Record how far one turbo button edge was written from its ideal time. */
+void observe_turbo_edge_ns(uint64_t ns);
+
+/** Record how far one macro frame was written from its defined time. */
+void observe_macro_drift_ns(uint64_t ns);
+
+void set_gauge(Gauge g, int64_t value);
+
+/** Sum of a counter over all shards (for tests and diagnostics). */
+uint64_t counter_value(Counter c);
+
+/** Render every metric, plus per-thread CPU time and queue depths. */
+std::string render();
+
+/**
+ * Start the exporter thread listening on @p endpoint (see syntax above).
+ * @return false (and logs why) if the endpoint cannot be bound.
+ */
+bool serve(const std::string& endpoint);
+
+/** Stop the exporter thread and remove a Unix socket it created. */
+void stop();
+
+} // namespace Metrics
+
+#endif // METRICS_H
@@ -0,0 +1,147 @@
+/*
+ * perf_counters.cpp
+ * perf_event_open(2) hardware / software counters for the benchmark harness.
+ */
+
+#include "perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace PerfCounters {
+
+const char* const kCounterNames[kNumCounters] = {
+    "cycles",
+    "instructions",
+    "branch-misses",
+    "L1d-misses",
+    "LLC-misses",
+    "context-switches",
+};
+
+static void describe(Counter c, perf_event_attr& attr)
+{
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    switch (c) {
+        case kCycles:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case kInstructions:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case kBranchMisses:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case kL1dMisses:
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case kLlcMisses:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case kContextSwitches:
+            attr.type   = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+            break;
+        default:
+            break;
+    }
+    attr.disabled    = 1;
+    attr.exclude_hv  = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+static long thread_context_switches()
+{
+    struct rusage ru{};
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+static int perf_open(perf_event_attr& attr)
+{
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0 /*self*/,
+                                    -1 /*any cpu*/, -1 /*no group*/, 0));
+}
+
+int open_counters(CounterSet& cs)
+{
+    int opened = 0;
+    cs.user_only = false;
+    for (int i = 0; i < kNumCounters; ++i) {
+        perf_event_attr attr;
+        describe(static_cast<Counter>(i), attr);
+        attr.exclude_kernel = cs.user_only ? 1 : 0;
+
+        int fd = perf_open(attr);
+        if (fd < 0 && (errno == EACCES || errno == EPERM) && !cs.user_only) {
+            // perf_event_paranoid >= 2: retry counting user space only
+            cs.user_only = true;
+            attr.exclude_kernel = 1;
+            fd = perf_open(attr);
+        }
+        if (i == kContextSwitches && cs.user_only && fd >= 0) {
+            close(fd);          // would only ever read 0; use rusage instead
+            fd = -1;
+        }
+        cs.fd[i] = fd;
+        if (fd >= 0) ++opened;
+    }
+    return opened;
+}
+
+void start(CounterSet& cs)
+{
+    cs.csw_start = thread_context_switches();
+    for (int fd : cs.fd) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+Reading stop(CounterSet& cs)
+{
+    Reading r;
+    for (int fd : cs.fd) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int i = 0; i < kNumCounters; ++i) {
+        if (cs.fd[i] < 0) continue;
+        uint64_t buf[3] = {};   // value, time_enabled, time_running
+        if (read(cs.fd[i], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) continue;
+        if (buf[2] == 0) continue;                         // never scheduled
+        r.valid[i] = true;
+        r.value[i] = buf[2] < buf[1]
+            ? static_cast<uint64_t>(static_cast<double>(buf[0]) * buf[1] / buf[2])
+            : buf[0];
+    }
+    if (!r.valid[kContextSwitches]) {
+        r.valid[kContextSwitches] = true;
+        r.value[kContextSwitches] =
+            static_cast<uint64_t>(thread_context_switches() - cs.csw_start);
+    }
+    return r;
+}
+
+void close_counters(CounterSet& cs)
+{
+    for (int& fd : cs.fd) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace PerfCounters
@@ -0,0 +1,60 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+/*
+ * perf_counters.h
+ * Thin wrapper around perf_event_open(2) for the benchmark harness.
+ *
+ * Each counter is opened independently so that a PMU event the host does
+ * not expose (common in VMs and containers) simply reads as unavailable
+ * instead of failing the whole set.  Kernel-side counting is attempted
+ * first and dropped to user-only when perf_event_paranoid forbids it; in
+ * that case context switches come from getrusage(RUSAGE_THREAD) instead,
+ * since a user-only software switch counter always reads zero.
+ */
+
+#include <cstdint>
+
+namespace PerfCounters {
+
+enum Counter {
+    kCycles = 0,
+    kInstructions,
+    kBranchMisses,
+    kL1dMisses,
+    kLlcMisses,
+    kContextSwitches,
+    kNumCounters,
+};
+
+/** Human-readable counter names, indexed by Counter. */
+extern const char* const kCounterNames[kNumCounters];
+
+struct CounterSet {
+    int  fd[kNumCounters];
+    bool user_only = false;     // true if kernel-side counting was refused
+    long csw_start = 0;         // rusage fallback for kContextSwitches
+};
+
+struct Reading {
+    bool     valid[kNumCounters] = {};
+    uint64_t value[kNumCounters] = {};   // scaled for multiplexing
+};
+
+/**
+ * Open all counters for the calling thread (disabled).
+ * @return number of counters that could be opened (0 = perf unavailable).
+ */
+int open_counters(CounterSet& cs);
+
+/** Reset and enable every open counter. */
+void start(CounterSet& cs);
+
+/** Disable every open counter and return the values since start(). */
+Reading stop(CounterSet& cs);
+
+/** Close every open counter. */
+void close_counters(CounterSet& cs);
+
+} // namespace PerfCounters
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,154 @@
+/*
+ * simd.cpp
+ * CPU feature detection, tier selection and the scalar kernels.
+ *
+ * Built with the baseline flags only: nothing here may use an instruction
+ * the oldest supported CPU lacks, including the code that asks whether the
+ * newer ones are there.
+ */
+
+#include "simd.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define SIMD_X86 1
+#endif
+
+namespace Simd {
+
+namespace detail {
+
+const char* find_byte_scalar(const char* p, size_t n, char c)
+{
+    const char* end = p + n;
+    while (p != end && *p != c) ++p;
+    return p;
+}
+
+} // namespace detail
+
+namespace {
+
+#ifdef SIMD_X86
+uint64_t xgetbv0()
+{
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+Isa detect()
+{
+    unsigned a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return Isa::Scalar;
+    const bool sse42   = c & bit_SSE4_2;
+    const bool avx     = c & bit_AVX;
+    const bool osxsave = c & bit_OSXSAVE;
+
+    // The OS must save the wider registers on context switch, or using them
+    // corrupts state: XCR0 bits 1-2 for YMM, plus 5-7 for ZMM / opmask.
+    const uint64_t xcr0   = osxsave ? xgetbv0() : 0;
+    const bool     ymm_os = (xcr0 & 0x06) == 0x06;
+    const bool     zmm_os = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false, avx512 = false;
+    if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, a, b, c, d);
+        avx2   = b & bit_AVX2;
+        avx512 = (b & bit_AVX512F) && (b & bit_AVX512BW);
+    }
+
+    if (avx512 && zmm_os)      return Isa::AVX512;
+    if (avx2 && avx && ymm_os) return Isa::AVX2;
+    if (sse42)                 return Isa::SSE42;
+    return Isa::Scalar;
+}
+#else
+Isa detect() { return Isa::Scalar; }
+#endif
+
+const Kernels kTables[kNumIsas] = {
+    {detail::find_byte_scalar},
+#ifdef SIMD_X86
+    {detail::find_byte_sse42},
+    {detail::find_byte_avx2},
+    {detail::find_byte_avx512},
+#else
+    {nullptr},
+    {nullptr},
+    {nullptr},
+#endif
+};
+
+Isa select()
+{
+    const Isa cpu = cpu_isa();
+    const char* env = std::getenv("HID_DRIVER_ISA");
+    if (!env) return cpu;
+
+    Isa want;
+    if (!parse_isa(env, want)) {
+        std::fprintf(stderr, "[hid_driver] Ignoring unknown HID_DRIVER_ISA=%s\n", env);
+        return cpu;
+    }
+    if (want > cpu) {
+        std::fprintf(stderr, "[hid_driver] HID_DRIVER_ISA=%s not supported here; using %s\n",
+                     env, isa_name(cpu));
+        return cpu;
+    }
+    return want;
+}
+
+} // namespace
+
+const char* isa_name(Isa isa)
+{
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE42:  return "sse4.2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "?";
+}
+
+bool parse_isa(std::string_view s, Isa& out)
+{
+    for (int i = 0; i < kNumIsas; ++i) {
+        if (s == isa_name(static_cast<Isa>(i))) {
+            out = static_cast<Isa>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+Isa cpu_isa()
+{
+    static const Isa isa = detect();
+    return isa;
+}
+
+Isa active_isa()
+{
+    static const Isa isa = select();
+    return isa;
+}
+
+const Kernels* kernels_for(Isa isa)
+{
+    if (isa > cpu_isa()) return nullptr;
+    const Kernels& k = kTables[static_cast<int>(isa)];
+    return k.find_byte ? &k : nullptr;
+}
+
+const Kernels& kernels()
+{
+    static const Kernels& k = kTables[static_cast<int>(active_isa())];
+    return k;
+}
+
+} // namespace Simd
@@ -0,0 +1,78 @@
+#ifndef SIMD_H
+#define SIMD_H
+/*
+ * simd.h
+ * Runtime CPU-feature dispatch for the driver's vectorised kernels.
+ *
+ * Each kernel is built once per ISA tier: a portable scalar version in
+ * simd.cpp and SSE4.2 / AVX2 / AVX-512 versions in simd_<isa>.cpp, the only
+ * translation units compiled with the matching -m flags (see the Makefile).
+ * On first use the best tier the CPU and OS support is picked with cpuid and
+ * xgetbv, optionally capped by $HID_DRIVER_ISA (scalar, sse4.2, avx2,
+ * avx512) to reproduce an older node, and every later call goes straight
+ * through the chosen function table.
+ *
+ *     const char* nl = Simd::find_byte(buf, len, '\n');   // == buf + len if none
+ *
+ * Kernels never read outside the aligned blocks that contain [p, p + n),
+ * so they are safe right up to an unmapped page.  Benchmarks and tests call
+ * every built tier directly through kernels_for().
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Simd {
+
+enum class Isa : uint8_t {
+    Scalar,
+    SSE42,
+    AVX2,
+    AVX512,     // AVX-512F + BW
+};
+
+constexpr int kNumIsas = 4;
+
+/** Returns the first byte equal to @p c in [p, p + n), or p + n if none. */
+using FindByteFn = const char* (*)(const char* p, size_t n, char c);
+
+struct Kernels {
+    FindByteFn find_byte;
+};
+
+const char* isa_name(Isa isa);
+
+/** Parse "scalar" / "sse4.2" / "avx2" / "avx512"; returns false if unknown. */
+bool parse_isa(std::string_view s, Isa& out);
+
+/** Best tier this CPU and OS support (cpuid + xgetbv), detected once. */
+Isa cpu_isa();
+
+/** Tier in use: cpu_isa() capped by $HID_DRIVER_ISA, fixed at first use. */
+Isa active_isa();
+
+/** Kernels for @p isa, or nullptr if it was not built or the CPU lacks it. */
+const Kernels* kernels_for(Isa isa);
+
+/** Kernels for active_isa(). */
+const Kernels& kernels();
+
+inline const char* find_byte(const char* p, size_t n, char c)
+{
+    return kernels().find_byte(p, n, c);
+}
+
+namespace detail {
+
+// Per-ISA entry points: scalar in simd.cpp, the others in simd_<isa>.cpp (x86 only).
+const char* find_byte_scalar(const char* p, size_t n, char c);
+const char* find_byte_sse42(const char* p, size_t n, char c);
+const char* find_byte_avx2(const char* p, size_t n, char c);
+const char* find_byte_avx512(const char* p, size_t n, char c);
+
+} // namespace detail
+
+} // namespace Simd
+
+#endif // SIMD_H
@@ -0,0 +1,44 @@
+/*
+ * simd_avx2.cpp
+ * AVX2 kernels.  The only translation unit built with -mavx2; nothing
+ * here runs unless Simd::cpu_isa() reported AVX2 (see simd.h).
+ *
+ * find_byte scans whole 32-byte aligned blocks: an aligned load cannot
+ * cross a page boundary, so reading the block that holds the first or last
+ * byte is safe even when its neighbour page is unmapped.  Matches before p
+ * are masked off and matches at or past p + n are clamped to p + n.
+ */
+
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+namespace Simd {
+namespace detail {
+
+const char* find_byte_avx2(const char* p, size_t n, char c)
+{
+    if (n == 0) return p;
+    const char*   end    = p + n;
+    const __m256i needle = _mm256_set1_epi8(c);
+    const size_t  off    = reinterpret_cast<uintptr_t>(p) & 31;
+    const char*   blk    = p - off;
+
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                        _mm256_load_si256(reinterpret_cast<const __m256i*>(blk)), needle)));
+    mask &= ~0u << off;
+    while (mask == 0) {
+        blk += 32;
+        if (blk >= end) return end;
+        mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                   _mm256_load_si256(reinterpret_cast<const __m256i*>(blk)), needle)));
+    }
+    const char* hit = blk + __builtin_ctz(mask);
+    return hit < end ? hit : end;
+}
+
+} // namespace detail
+} // namespace Simd
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * simd_avx512.cpp
+ * AVX-512 kernels.  The only translation unit built with -mavx512f -mavx512bw; nothing
+ * here runs unless Simd::cpu_isa() reported AVX-512 (see simd.h).
+ *
+ * find_byte scans whole 64-byte aligned blocks: an aligned load cannot
+ * cross a page boundary, so reading the block that holds the first or last
+ * byte is safe even when its neighbour page is unmapped.  Matches before p
+ * are masked off and matches at or past p + n are clamped to p + n.
+ */
+
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+namespace Simd {
+namespace detail {
+
+const char* find_byte_avx512(const char* p, size_t n, char c)
+{
+    if (n == 0) return p;
+    const char*   end    = p + n;
+    const __m512i needle = _mm512_set1_epi8(c);
+    const size_t  off    = reinterpret_cast<uintptr_t>(p) & 63;
+    const char*   blk    = p - off;
+
+    uint64_t mask = _mm512_cmpeq_epi8_mask(_mm512_load_si512(blk), needle);
+    mask &= ~uint64_t{0} << off;
+    while (mask == 0) {
+        blk += 64;
+        if (blk >= end) return end;
+        mask = _mm512_cmpeq_epi8_mask(_mm512_load_si512(blk), needle);
+    }
+    const char* hit = blk + __builtin_ctzll(mask);
+    return hit < end ? hit : end;
+}
+
+} // namespace detail
+} // namespace Simd
+
+#endif
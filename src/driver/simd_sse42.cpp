@@ -0,0 +1,44 @@
+/*
+ * simd_sse42.cpp
+ * SSE4.2 kernels.  The only translation unit built with -msse4.2; nothing
+ * here runs unless Simd::cpu_isa() reported SSE4.2 (see simd.h).
+ *
+ * find_byte scans whole 16-byte aligned blocks: an aligned load cannot
+ * cross a page boundary, so reading the block that holds the first or last
+ * byte is safe even when its neighbour page is unmapped.  Matches before p
+ * are masked off and matches at or past p + n are clamped to p + n.
+ */
+
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+namespace Simd {
+namespace detail {
+
+const char* find_byte_sse42(const char* p, size_t n, char c)
+{
+    if (n == 0) return p;
+    const char*   end    = p + n;
+    const __m128i needle = _mm_set1_epi8(c);
+    const size_t  off    = reinterpret_cast<uintptr_t>(p) & 15;
+    const char*   blk    = p - off;
+
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                        _mm_load_si128(reinterpret_cast<const __m128i*>(blk)), needle)));
+    mask &= 0xffffu << off;
+    while (mask == 0) {
+        blk += 16;
+        if (blk >= end) return end;
+        mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                   _mm_load_si128(reinterpret_cast<const __m128i*>(blk)), needle)));
+    }
+    const char* hit = blk + __builtin_ctz(mask);
+    return hit < end ? hit : end;
+}
+
+} // namespace detail
+} // namespace Simd
+
+#endif
@@ -7,11 +7,16 @@
  */
 
 #include "virtual_hid.h"
+#include "async_log.h"
+#include "keymap.h"
+#include "metrics.h"
 
-#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
-#include <stdexcept>
 #include <iostream>
 
 #include <linux/uinput.h>
@@ -21,15 +26,51 @@ namespace VirtualHID {
 
 // ---- helpers ---------------------------------------------------------------
 
+static EmitHook g_emit_hook = nullptr;
+
+void set_emit_hook(EmitHook hook)
+{
+    g_emit_hook = hook;
+}
+
 static void emit(int fd, uint16_t type, uint16_t code, int32_t value)
 {
+    if (g_emit_hook) g_emit_hook(fd, type, code, value);
     struct input_event ev{};
     ev.type  = type;
     ev.code  = code;
     ev.value = value;
     if (write(fd, &ev, sizeof(ev)) < 0) {
-        std::cerr << "[VirtualHID] emit failed: " << strerror(errno) << '\n';
+        HID_LOG(AsyncLog::Level::Error, "[VirtualHID] emit failed: {}", AsyncLog::Errno{errno});
+        Metrics::inc(Metrics::kEmitErrors);
+    }
+}
+
+/** emit() of an event device @p D advertises (checked at compile time). */
+template <const DeviceDesc& D, uint16_t Type, uint16_t Code>
+static void emit(int fd, int32_t value)
+{
+    static_assert(D.supports(Type, Code), "event not in the device descriptor");
+    emit(fd, Type, Code, value);
+}
+
+std::string event_node(int uinput_fd)
+{
+    char sysname[64] = {};
+    if (uinput_fd < 0 || ioctl(uinput_fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) return "";
+
+    const std::string dir = std::string("/sys/devices/virtual/input/") + sysname;
+    std::string node;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (struct dirent* de = readdir(d)) {
+            if (std::strncmp(de->d_name, "event", 5) == 0) {
+                node = std::string("/dev/input/") + de->d_name;
+                break;
+            }
+        }
+        closedir(d);
     }
+    return node;
 }
 
 static void syn(int fd)
@@ -37,20 +78,39 @@ static void syn(int fd)
     emit(fd, EV_SYN, SYN_REPORT, 0);
 }
 
-static int open_uinput()
+// ---- Batched frames ----------------------------------------------------------
+
+void EventBatch::add(uint16_t type, uint16_t code, int32_t value)
 {
-    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
-    if (fd < 0) {
-        // Fallback path used on some distros
-        fd = open("/dev/input/uinput", O_WRONLY | O_NONBLOCK);
+    if (count == kCapacity) flush();
+    input_event& ev = events[count++];
+    ev = input_event{};
+    ev.type  = type;
+    ev.code  = code;
+    ev.value = value;
+}
+
+void EventBatch::syn()
+{
+    add(EV_SYN, SYN_REPORT, 0);
+}
+
+void EventBatch::flush()
+{
+    const int n = count;
+    count = 0;
+    if (n == 0 || fd < 0) return;
+    if (g_emit_hook) {
+        for (int i = 0; i < n; ++i) g_emit_hook(fd, events[i].type, events[i].code, events[i].value);
     }
-    if (fd < 0) {
-        throw std::runtime_error(
-            std::string("[VirtualHID] Cannot open /dev/uinput: ") + strerror(errno) +
-            ". Ensure the uinput kernel module is loaded (modprobe uinput) and "
-            "that your user is in the 'input' group or run with appropriate permissions.");
+    const ssize_t want    = static_cast<ssize_t>(n * sizeof(input_event));
+    const ssize_t written = write(fd, events, static_cast<size_t>(want));
+    if (written != want) {
+        const int lost = written < 0 ? n : n - static_cast<int>(written / sizeof(input_event));
+        HID_LOG(AsyncLog::Level::Error, "[VirtualHID] batch of {} events: {} lost ({})", n, lost,
+                AsyncLog::Errno{written < 0 ? errno : EIO});
+        Metrics::inc(Metrics::kEmitErrors, static_cast<uint64_t>(lost));
     }
-    return fd;
 }
 
 // ---- Mouse -----------------------------------------------------------------
@@ -59,60 +119,8 @@ bool mouse_open(MouseState& ms, int screen_w, int screen_h)
 {
     ms.screen_w = screen_w;
     ms.screen_h = screen_h;
-
-    try { ms.fd = open_uinput(); }
-    catch (const std::exception& e) {
-        std::cerr << e.what() << '\n';
-        return false;
-    }
-
-    // Enable event types
-    ioctl(ms.fd, UI_SET_EVBIT,  EV_KEY);
-    ioctl(ms.fd, UI_SET_EVBIT,  EV_ABS);
-    ioctl(ms.fd, UI_SET_EVBIT,  EV_REL);
-
-    // Mouse buttons
-    ioctl(ms.fd, UI_SET_KEYBIT, BTN_LEFT);
-    ioctl(ms.fd, UI_SET_KEYBIT, BTN_RIGHT);
-    ioctl(ms.fd, UI_SET_KEYBIT, BTN_MIDDLE);
-
-    // Absolute axes for cursor position
-    ioctl(ms.fd, UI_SET_ABSBIT, ABS_X);
-    ioctl(ms.fd, UI_SET_ABSBIT, ABS_Y);
-
-    // Scroll wheel (relative)
-    ioctl(ms.fd, UI_SET_RELBIT, REL_WHEEL);
-
-    struct uinput_user_dev uidev{};
-    snprintf(uidev.name, UINPUT_MAX_NAME_SIZE, "GestureLink Virtual Mouse");
-    uidev.id.bustype = BUS_VIRTUAL;
-    uidev.id.vendor  = 0x1357;
-    uidev.id.product = 0x0001;
-    uidev.id.version = 1;
-
-    uidev.absmin[ABS_X]  = 0;
-    uidev.absmax[ABS_X]  = screen_w - 1;
-    uidev.absfuzz[ABS_X] = 0;
-    uidev.absflat[ABS_X] = 0;
-
-    uidev.absmin[ABS_Y]  = 0;
-    uidev.absmax[ABS_Y]  = screen_h - 1;
-    uidev.absfuzz[ABS_Y] = 0;
-    uidev.absflat[ABS_Y] = 0;
-
-    if (write(ms.fd, &uidev, sizeof(uidev)) < 0) {
-        std::cerr << "[VirtualHID] mouse write uidev failed\n";
-        close(ms.fd);
-        ms.fd = -1;
-        return false;
-    }
-
-    if (ioctl(ms.fd, UI_DEV_CREATE) < 0) {
-        std::cerr << "[VirtualHID] UI_DEV_CREATE (mouse) failed: " << strerror(errno) << '\n';
-        close(ms.fd);
-        ms.fd = -1;
-        return false;
-    }
+    ms.fd = open_device<kMouseDevice>(screen_w, screen_h);
+    if (ms.fd < 0) return false;
 
     std::cout << "[VirtualHID] Virtual mouse created ("
               << screen_w << 'x' << screen_h << ")\n";
@@ -126,8 +134,8 @@ void mouse_move_abs(const MouseState& ms, int x, int y)
     x = std::max(0, std::min(x, ms.screen_w - 1));
     y = std::max(0, std::min(y, ms.screen_h - 1));
 
-    emit(ms.fd, EV_ABS, ABS_X, x);
-    emit(ms.fd, EV_ABS, ABS_Y, y);
+    emit<kMouseDevice, EV_ABS, ABS_X>(ms.fd, x);
+    emit<kMouseDevice, EV_ABS, ABS_Y>(ms.fd, y);
     syn(ms.fd);
 }
 
@@ -143,10 +151,74 @@ void mouse_click(const MouseState& ms, uint16_t button)
 void mouse_scroll(const MouseState& ms, int delta)
 {
     if (ms.fd < 0) return;
-    emit(ms.fd, EV_REL, REL_WHEEL, delta);
+    emit<kMouseDevice, EV_REL, REL_WHEEL>(ms.fd, delta);
     syn(ms.fd);
 }
 
+void mouse_sample(MouseState& ms, int x, int y, int64_t now_ns)
+{
+    x = std::max(0, std::min(x, ms.screen_w - 1));
+    y = std::max(0, std::min(y, ms.screen_h - 1));
+    // A hand taking over a coast starts a new stroke: the coast position is not its own.
+    const bool fresh  = ms.x < 0 || ms.coasting;
+    const int64_t dt  = now_ns - ms.sample_ns;
+    ms.coasting = false;
+    if (fresh || dt <= 0 || dt > kFlickMaxAgeNs) {
+        ms.vx = ms.vy = 0;
+    } else {
+        ms.vx += ((x - ms.x) * 1e9 / static_cast<double>(dt) - ms.vx) * kFlickSmoothing;
+        ms.vy += ((y - ms.y) * 1e9 / static_cast<double>(dt) - ms.vy) * kFlickSmoothing;
+    }
+    ms.x         = x;
+    ms.y         = y;
+    ms.sample_ns = now_ns;
+}
+
+bool mouse_release(MouseState& ms, int64_t now_ns)
+{
+    const bool flick = ms.friction > 0 && ms.x >= 0 && now_ns - ms.sample_ns <= kFlickMaxAgeNs &&
+                       std::hypot(ms.vx, ms.vy) >= kFlickMinSpeed;
+    ms.coasting = flick;
+    ms.coast_ns = now_ns;
+    if (!flick) ms.vx = ms.vy = 0;
+    return flick;
+}
+
+bool mouse_inertia_tick(MouseState& ms, int64_t now_ns)
+{
+    if (!ms.coasting) return false;
+    const double dt = static_cast<double>(now_ns - ms.coast_ns) / 1e9;
+    if (dt <= 0) return true;
+    ms.coast_ns = now_ns;
+
+    // Exact for v' = -friction * v over the step, so the path does not depend on tick_ns.
+    const double decay = std::exp(-ms.friction * dt);
+    const double reach = (1.0 - decay) / ms.friction;
+    const int    from_x = static_cast<int>(std::lround(ms.x));
+    const int    from_y = static_cast<int>(std::lround(ms.y));
+    ms.x  += ms.vx * reach;
+    ms.y  += ms.vy * reach;
+    ms.vx *= decay;
+    ms.vy *= decay;
+
+    // A screen edge stops that axis, as it would stop a thrown cursor.
+    const double max_x = ms.screen_w - 1, max_y = ms.screen_h - 1;
+    if (ms.x < 0 || ms.x > max_x) { ms.x = std::max(0.0, std::min(ms.x, max_x)); ms.vx = 0; }
+    if (ms.y < 0 || ms.y > max_y) { ms.y = std::max(0.0, std::min(ms.y, max_y)); ms.vy = 0; }
+
+    const int x = static_cast<int>(std::lround(ms.x));
+    const int y = static_cast<int>(std::lround(ms.y));
+    if (x != from_x || y != from_y) mouse_move_abs(ms, x, y);
+    ms.coasting = std::hypot(ms.vx, ms.vy) >= kFlickStopSpeed;
+    return ms.coasting;
+}
+
+void mouse_stop(MouseState& ms)
+{
+    ms.coasting = false;
+    ms.vx = ms.vy = 0;
+}
+
 void mouse_close(MouseState& ms)
 {
     if (ms.fd < 0) return;
@@ -156,67 +228,100 @@ void mouse_close(MouseState& ms)
     std::cout << "[VirtualHID] Virtual mouse destroyed\n";
 }
 
-// ---- Gamepad ---------------------------------------------------------------
+// ---- Pointers --------------------------------------------------------------
 
-bool gamepad_open(GamepadState& gs)
+static bool pointer_open(Pointer& p, int index, int screen_w, int screen_h)
 {
-    try { gs.fd = open_uinput(); }
-    catch (const std::exception& e) {
-        std::cerr << e.what() << '\n';
-        return false;
+    char name[UINPUT_MAX_NAME_SIZE];
+    snprintf(name, sizeof(name), "%s %d", kPointerDevice.name, index);
+    p.fd = open_device<kPointerDevice>(screen_w, screen_h, name);
+    return p.fd >= 0;
+}
+
+bool pointers_open(PointerSet& ps, int screen_w, int screen_h)
+{
+    const int count = std::max(0, std::min(ps.count, kMaxPointers));
+    ps = PointerSet{};
+    ps.count    = count;
+    ps.screen_w = screen_w;
+    ps.screen_h = screen_h;
+    for (int i = 0; i < count; ++i) {
+        if (!pointer_open(ps.p[i], i, screen_w, screen_h)) {
+            pointers_close(ps);
+            return false;
+        }
     }
+    std::cout << "[VirtualHID] " << count << " virtual pointer(s) created (" << screen_w << 'x' << screen_h
+              << ")\n";
+    return true;
+}
 
-    ioctl(gs.fd, UI_SET_EVBIT,  EV_KEY);
-    ioctl(gs.fd, UI_SET_EVBIT,  EV_ABS);
-
-    // Face buttons + shoulder buttons + meta buttons
-    for (uint16_t btn : {
-            static_cast<uint16_t>(GamepadBtn::A),
-            static_cast<uint16_t>(GamepadBtn::B),
-            static_cast<uint16_t>(GamepadBtn::X),
-            static_cast<uint16_t>(GamepadBtn::Y),
-            static_cast<uint16_t>(GamepadBtn::LB),
-            static_cast<uint16_t>(GamepadBtn::RB),
-            static_cast<uint16_t>(GamepadBtn::SELECT),
-            static_cast<uint16_t>(GamepadBtn::START)
-        }) {
-        ioctl(gs.fd, UI_SET_KEYBIT, btn);
-    }
-
-    // Left stick axes
-    ioctl(gs.fd, UI_SET_ABSBIT, ABS_X);
-    ioctl(gs.fd, UI_SET_ABSBIT, ABS_Y);
-
-    struct uinput_user_dev uidev{};
-    snprintf(uidev.name, UINPUT_MAX_NAME_SIZE, "GestureLink Virtual Gamepad");
-    uidev.id.bustype = BUS_VIRTUAL;
-    uidev.id.vendor  = 0x1357;
-    uidev.id.product = 0x0002;
-    uidev.id.version = 1;
-
-    uidev.absmin[ABS_X]  = -32767;
-    uidev.absmax[ABS_X]  =  32767;
-    uidev.absfuzz[ABS_X] = 16;
-    uidev.absflat[ABS_X] = 128;
-
-    uidev.absmin[ABS_Y]  = -32767;
-    uidev.absmax[ABS_Y]  =  32767;
-    uidev.absfuzz[ABS_Y] = 16;
-    uidev.absflat[ABS_Y] = 128;
-
-    if (write(gs.fd, &uidev, sizeof(uidev)) < 0) {
-        std::cerr << "[VirtualHID] gamepad write uidev failed\n";
-        close(gs.fd);
-        gs.fd = -1;
-        return false;
+int pointers_frame(PointerSet& ps, const PointerUpdate* updates, int n)
+{
+    static_assert(sizeof(kPointerButtons) / sizeof(kPointerButtons[0]) <= 8 * sizeof(Pointer::buttons),
+                  "one bit per pointer button");
+
+    // Fold the updates first, so several updates to one pointer make one frame.
+    Pointer want[kMaxPointers];
+    std::copy(ps.p, ps.p + ps.count, want);
+    for (int i = 0; i < n; ++i) {
+        const PointerUpdate& u = updates[i];
+        Pointer& w = want[u.id];
+        if (u.button == 0) {
+            w.x = std::max(0, std::min(u.x, ps.screen_w - 1));
+            w.y = std::max(0, std::min(u.y, ps.screen_h - 1));
+            continue;
+        }
+        for (size_t b = 0; b < sizeof(kPointerButtons) / sizeof(kPointerButtons[0]); ++b) {
+            if (kPointerButtons[b] != u.button) continue;
+            w.buttons = static_cast<uint8_t>(u.pressed ? w.buttons | 1u << b : w.buttons & ~(1u << b));
+        }
     }
 
-    if (ioctl(gs.fd, UI_DEV_CREATE) < 0) {
-        std::cerr << "[VirtualHID] UI_DEV_CREATE (gamepad) failed: " << strerror(errno) << '\n';
-        close(gs.fd);
-        gs.fd = -1;
-        return false;
+    // One batch for every pointer: each frame is flushed to its own device.
+    EventBatch batch(-1);
+    int written = 0;
+    for (int i = 0; i < ps.count; ++i) {
+        Pointer& p = ps.p[i];
+        const Pointer& w = want[i];
+        if (w.x != p.x) add<kPointerDevice, EV_ABS, ABS_X>(batch, w.x);
+        if (w.y != p.y) add<kPointerDevice, EV_ABS, ABS_Y>(batch, w.y);
+        const unsigned changed = w.buttons ^ p.buttons;
+        for (size_t b = 0; changed && b < sizeof(kPointerButtons) / sizeof(kPointerButtons[0]); ++b) {
+            if (changed >> b & 1u) batch.add(EV_KEY, kPointerButtons[b], w.buttons >> b & 1u);
+        }
+        p.x       = w.x;
+        p.y       = w.y;
+        p.buttons = w.buttons;
+        if (batch.count == 0) continue;
+        batch.fd = p.fd;
+        batch.syn();
+        batch.flush();
+        ++written;
     }
+    return written;
+}
+
+void pointers_close(PointerSet& ps)
+{
+    int closed = 0;
+    for (Pointer& p : ps.p) {
+        if (p.fd < 0) continue;
+        ioctl(p.fd, UI_DEV_DESTROY);
+        close(p.fd);
+        p.fd = -1;
+        ++closed;
+    }
+    if (closed) std::cout << "[VirtualHID] " << closed << " virtual pointer(s) destroyed\n";
+}
+
+// ---- Gamepad ---------------------------------------------------------------
+
+bool gamepad_open(GamepadState& gs)
+{
+    // Read-write (kGamepadDevice takes force feedback): FF requests come back on the same fd.
+    gs.fd = open_device<kGamepadDevice>();
+    if (gs.fd < 0) return false;
 
     std::cout << "[VirtualHID] Virtual gamepad created\n";
     return true;
@@ -233,11 +338,184 @@ void gamepad_stick(const GamepadState& gs, int x, int y)
 {
     if (gs.fd < 0) return;
     auto clamp = [](int v) { return std::max(-32767, std::min(v, 32767)); };
-    emit(gs.fd, EV_ABS, ABS_X, clamp(x));
-    emit(gs.fd, EV_ABS, ABS_Y, clamp(y));
+    emit<kGamepadDevice, EV_ABS, ABS_X>(gs.fd, clamp(x));
+    emit<kGamepadDevice, EV_ABS, ABS_Y>(gs.fd, clamp(y));
     syn(gs.fd);
 }
 
+// ---- Turbo -------------------------------------------------------------------
+
+/** Whether @p t is held at @p t_ns; stores the ideal time of the edge after that. */
+static bool turbo_phase(const TurboButton& t, int64_t t_ns, int64_t& next_ns)
+{
+    const int64_t begin = t.start_ns + (t_ns - t.start_ns) / t.period_ns * t.period_ns;
+    const bool down = t_ns - begin < t.on_ns;
+    next_ns = begin + (down ? t.on_ns : t.period_ns);
+    return down;
+}
+
+/** The earliest next edge over every autofiring button (0 if none). */
+static int64_t turbo_next(const GamepadState& gs)
+{
+    int64_t next = 0;
+    for (const TurboButton& t : gs.turbo) {
+        if (t.period_ns != 0 && (next == 0 || t.next_ns < next)) next = t.next_ns;
+    }
+    return next;
+}
+
+bool gamepad_turbo(GamepadState& gs, GamepadBtn btn, int hz, int duty_pct, int64_t now_ns)
+{
+    TurboButton* slot = nullptr;
+    for (TurboButton& t : gs.turbo) {
+        if (t.period_ns != 0 && t.btn == btn) slot = &t;
+    }
+    EventBatch b(gs.fd);
+    if (hz == 0) {
+        if (!slot) return true;
+        if (slot->down) {
+            b.add(EV_KEY, static_cast<uint16_t>(btn), 0);
+            b.syn();
+        }
+        *slot = TurboButton{};
+        --gs.turbo_count;
+        gs.turbo_next_ns = turbo_next(gs);
+        return true;
+    }
+    if (hz < 1 || hz > kMaxTurboHz || duty_pct < 1 || duty_pct > 99) return false;
+    const int64_t period_ns = 1000000000 / hz;
+    const int64_t on_ns     = period_ns * duty_pct / 100;
+    if (on_ns < kMinTurboPhaseNs || period_ns - on_ns < kMinTurboPhaseNs) return false;
+    if (!slot) {
+        for (TurboButton& t : gs.turbo) {
+            if (t.period_ns == 0) {
+                slot = &t;
+                break;
+            }
+        }
+        if (!slot) return false;
+        ++gs.turbo_count;
+        slot->btn  = btn;
+        slot->down = false;
+    }
+    slot->period_ns = period_ns;
+    slot->on_ns     = on_ns;
+    slot->start_ns  = now_ns;
+    slot->next_ns   = now_ns + slot->on_ns;
+    if (!slot->down) {
+        b.add(EV_KEY, static_cast<uint16_t>(btn), 1);
+        b.syn();
+        slot->down = true;
+    }
+    gs.turbo_next_ns = turbo_next(gs);
+    return true;
+}
+
+int64_t gamepad_turbo_tick(GamepadState& gs, int64_t now_ns)
+{
+    EventBatch b(gs.fd);
+    for (TurboButton& t : gs.turbo) {
+        if (t.period_ns == 0 || t.next_ns > now_ns + kTurboCoalesceNs) continue;
+        const int64_t due  = t.next_ns;
+        const bool    down = turbo_phase(t, std::max(now_ns, due), t.next_ns);
+        if (down != t.down) {
+            b.add(EV_KEY, static_cast<uint16_t>(t.btn), down ? 1 : 0);
+            t.down = down;
+            Metrics::observe_turbo_edge_ns(static_cast<uint64_t>(now_ns > due ? now_ns - due : due - now_ns));
+        }
+    }
+    if (b.count > 0) b.syn();
+    return gs.turbo_next_ns = turbo_next(gs);
+}
+
+/** Append effect @p id's current state (gain applied) to @p out if there is room. */
+static void report(const GamepadState& gs, FfEvent* out, int max, int& n, int id)
+{
+    if (n >= max) return;
+    const FfEffect& e = gs.ff[id];
+    auto gain = [&](uint16_t m) { return static_cast<uint16_t>(uint32_t{m} * gs.ff_gain / 0xffff); };
+    out[n++] = FfEvent{id, e.playing, gain(e.strong), gain(e.weak), e.length_ms};
+}
+
+/** One request the kernel queued: a handshake to complete or an EV_FF to apply. */
+static void ff_request(GamepadState& gs, const input_event& ev, FfEvent* out, int max, int& n)
+{
+    if (ev.type == EV_UINPUT && ev.code == UI_FF_UPLOAD) {
+        // The game's EVIOCSFF is blocked until UI_END_FF_UPLOAD.
+        uinput_ff_upload up{};
+        up.request_id = static_cast<uint32_t>(ev.value);
+        if (ioctl(gs.fd, UI_BEGIN_FF_UPLOAD, &up) < 0) {
+            HID_LOG(AsyncLog::Level::Error, "[VirtualHID] UI_BEGIN_FF_UPLOAD failed: {}",
+                    AsyncLog::Errno{errno});
+            return;
+        }
+        const int id = up.effect.id;
+        if (id < 0 || id >= kMaxFfEffects || up.effect.type != FF_RUMBLE) {
+            up.retval = -EINVAL;
+        } else {
+            FfEffect& e = gs.ff[id];
+            e.used      = true;
+            e.strong    = up.effect.u.rumble.strong_magnitude;
+            e.weak      = up.effect.u.rumble.weak_magnitude;
+            e.length_ms = up.effect.replay.length;
+            Metrics::inc(Metrics::kFfUploads);
+            if (e.playing) report(gs, out, max, n, id);   // updated while playing
+        }
+        if (ioctl(gs.fd, UI_END_FF_UPLOAD, &up) < 0) {
+            HID_LOG(AsyncLog::Level::Error, "[VirtualHID] UI_END_FF_UPLOAD failed: {}",
+                    AsyncLog::Errno{errno});
+        }
+    } else if (ev.type == EV_UINPUT && ev.code == UI_FF_ERASE) {
+        uinput_ff_erase er{};
+        er.request_id = static_cast<uint32_t>(ev.value);
+        if (ioctl(gs.fd, UI_BEGIN_FF_ERASE, &er) < 0) {
+            HID_LOG(AsyncLog::Level::Error, "[VirtualHID] UI_BEGIN_FF_ERASE failed: {}",
+                    AsyncLog::Errno{errno});
+            return;
+        }
+        const int id = static_cast<int>(er.effect_id);
+        if (id >= 0 && id < kMaxFfEffects) {
+            if (gs.ff[id].playing) {
+                gs.ff[id].playing = false;
+                report(gs, out, max, n, id);
+            }
+            gs.ff[id] = FfEffect{};
+            Metrics::inc(Metrics::kFfErases);
+        }
+        er.retval = 0;
+        if (ioctl(gs.fd, UI_END_FF_ERASE, &er) < 0) {
+            HID_LOG(AsyncLog::Level::Error, "[VirtualHID] UI_END_FF_ERASE failed: {}",
+                    AsyncLog::Errno{errno});
+        }
+    } else if (ev.type == EV_FF && ev.code == FF_GAIN) {
+        gs.ff_gain = static_cast<uint16_t>(std::max(0, std::min(ev.value, 0xffff)));
+        for (int id = 0; id < kMaxFfEffects; ++id) {
+            if (gs.ff[id].playing) report(gs, out, max, n, id);
+        }
+    } else if (ev.type == EV_FF && ev.code < kMaxFfEffects && gs.ff[ev.code].used) {
+        // value = repeat count; 0 stops
+        FfEffect& e = gs.ff[ev.code];
+        const bool play = ev.value > 0;
+        if (play || e.playing) {
+            e.playing = play;
+            report(gs, out, max, n, ev.code);
+        }
+    }
+}
+
+int gamepad_service(GamepadState& gs, FfEvent* out, int max)
+{
+    int n = 0;
+    input_event evs[16];
+    ssize_t r;
+    while (gs.fd >= 0 && n < max && (r = read(gs.fd, evs, sizeof(evs))) > 0) {   // until EAGAIN
+        for (ssize_t i = 0; i < r / static_cast<ssize_t>(sizeof(input_event)); ++i) {
+            ff_request(gs, evs[i], out, max, n);
+        }
+    }
+    return n;
+}
+
 void gamepad_close(GamepadState& gs)
 {
     if (gs.fd < 0) return;
@@ -247,4 +525,428 @@ void gamepad_close(GamepadState& gs)
     std::cout << "[VirtualHID] Virtual gamepad destroyed\n";
 }
 
+// ---- Keyboard ----------------------------------------------------------------
+
+bool keyboard_open(KeyboardState& ks)
+{
+    ks.fd = open_device<kKeyboardDevice>();
+    if (ks.fd < 0) return false;
+
+    std::cout << "[VirtualHID] Virtual keyboard created\n";
+    return true;
+}
+
+// Worst case per typed character: shift change + press + SYN, release + SYN.
+static constexpr int kMaxCharEvents = 5;
+static_assert(KeyboardState::kQueueCapacity >= 2 * (kMaxTypeLen * kMaxCharEvents + 2),
+              "the queue holds two TYPEs of kMaxTypeLen");
+
+/** Room for @p n more queued events, moving what is left to the front. */
+static bool queue_room(KeyboardState& ks, int n)
+{
+    if (ks.head > 0) {
+        std::memmove(ks.queue, ks.queue + ks.head, static_cast<size_t>(ks.tail - ks.head) * sizeof(KeyEvent));
+        ks.tail -= ks.head;
+        ks.head = 0;
+    }
+    return KeyboardState::kQueueCapacity - ks.tail >= n;
+}
+
+static void queue_key(KeyboardState& ks, uint16_t code, bool pressed)
+{
+    ks.queue[ks.tail++] = {code, static_cast<uint16_t>(pressed ? 1 : 0)};
+}
+
+static void queue_syn(KeyboardState& ks)
+{
+    ks.queue[ks.tail++] = {KEY_RESERVED, 0};
+}
+
+/**
+ * Write queued frames: one EventBatch, or every batch back to back when
+ * @p all.  Frames are never split across writes.
+ */
+static void write_queue(KeyboardState& ks, bool all)
+{
+    EventBatch b(ks.fd);
+    while (ks.head < ks.tail) {
+        int end = ks.head;
+        while (ks.queue[end].code != KEY_RESERVED) ++end;          // every frame ends in a SYN
+        if (b.room() < end + 1 - ks.head) {
+            if (!all) break;
+            b.flush();
+        }
+        for (; ks.head < end; ++ks.head) b.add(EV_KEY, ks.queue[ks.head].code, ks.queue[ks.head].value);
+        b.syn();
+        ++ks.head;
+    }
+    if (ks.head == ks.tail) ks.head = ks.tail = 0;
+    ks.typing = ks.tail > 0;
+}
+
+bool keyboard_key(KeyboardState& ks, uint16_t code, bool pressed)
+{
+    if (ks.fd < 0) return true;
+    if (ks.typing) {
+        if (!queue_room(ks, 2)) return false;
+        queue_key(ks, code, pressed);
+        queue_syn(ks);
+        return true;
+    }
+    EventBatch b(ks.fd);
+    b.add(EV_KEY, code, pressed ? 1 : 0);
+    b.syn();
+    return true;
+}
+
+bool keyboard_chord(KeyboardState& ks, const uint16_t* codes, int n)
+{
+    if (ks.fd < 0) return true;
+    if (ks.typing) {
+        if (!queue_room(ks, 2 * (n + 1))) return false;
+        for (int i = 0; i < n; ++i)  queue_key(ks, codes[i], true);
+        queue_syn(ks);
+        for (int i = n - 1; i >= 0; --i) queue_key(ks, codes[i], false);
+        queue_syn(ks);
+        return true;
+    }
+    EventBatch b(ks.fd);                                   // 2 * (kMaxChord + 1) events fit
+    for (int i = 0; i < n; ++i)  b.add(EV_KEY, codes[i], 1);
+    b.syn();
+    for (int i = n - 1; i >= 0; --i) b.add(EV_KEY, codes[i], 0);
+    b.syn();
+    return true;
+}
+
+bool keyboard_type(KeyboardState& ks, std::string_view text, size_t& unmapped)
+{
+    unmapped = 0;
+    // Every character takes at least one byte, so this bounds what text queues.
+    if (text.size() > kMaxTypeLen ||
+        !queue_room(ks, static_cast<int>(text.size()) * kMaxCharEvents + 2)) {
+        return false;
+    }
+
+    const bool busy = ks.typing;
+    bool shift = false;
+    while (!text.empty()) {
+        Keymap::Stroke k;
+        if (!Keymap::next_stroke(text, k)) {
+            ++unmapped;
+            continue;
+        }
+        if (k.shift != shift) {
+            static_assert(kKeyboardDevice.supports(EV_KEY, KEY_LEFTSHIFT));
+            queue_key(ks, KEY_LEFTSHIFT, k.shift);
+            shift = k.shift;
+        }
+        queue_key(ks, k.code, true);
+        queue_syn(ks);
+        queue_key(ks, k.code, false);
+        queue_syn(ks);
+    }
+    if (shift) {
+        queue_key(ks, KEY_LEFTSHIFT, false);
+        queue_syn(ks);
+    }
+    // Behind earlier text the timer already armed writes it in turn.
+    if (!busy) write_queue(ks, ks.gap_ns <= 0 || ks.fd < 0);
+    return true;
+}
+
+bool keyboard_type_tick(KeyboardState& ks)
+{
+    write_queue(ks, ks.gap_ns <= 0 || ks.fd < 0);
+    return ks.typing;
+}
+
+void keyboard_close(KeyboardState& ks)
+{
+    ks.head = ks.tail = 0;
+    ks.typing = false;
+    if (ks.fd < 0) return;
+    ioctl(ks.fd, UI_DEV_DESTROY);
+    close(ks.fd);
+    ks.fd = -1;
+    std::cout << "[VirtualHID] Virtual keyboard destroyed\n";
+}
+
+// ---- Touchscreen -------------------------------------------------------------
+
+bool touch_open(TouchState& ts, int screen_w, int screen_h)
+{
+    ts = TouchState{};
+    ts.screen_w = screen_w;
+    ts.screen_h = screen_h;
+    ts.fd = open_device<kTouchDevice>(screen_w, screen_h);
+    if (ts.fd < 0) return false;
+
+    std::cout << "[VirtualHID] Virtual touchscreen created ("
+              << screen_w << 'x' << screen_h << ", " << kMaxTouchSlots << " slots)\n";
+    return true;
+}
+
+int touch_frame(TouchState& ts, const TouchUpdate* updates, int n)
+{
+    // Worst case: every slot changes (4 events each) plus emulation and SYN, in one batch.
+    static_assert(kMaxTouchSlots * 4 + 4 <= EventBatch::kCapacity, "a touch frame must fit one batch");
+
+    EventBatch b(ts.fd);
+    auto select = [&](int slot) {
+        if (ts.cur_slot == slot) return;
+        add<kTouchDevice, EV_ABS, ABS_MT_SLOT>(b, slot);
+        ts.cur_slot = slot;
+    };
+
+    int before = 0;
+    for (const TouchSlot& s : ts.slots) before += s.tracking_id >= 0;
+
+    for (int i = 0; i < n; ++i) {
+        const TouchUpdate& u = updates[i];
+        TouchSlot& s = ts.slots[u.slot];
+        if (u.up) {
+            if (s.tracking_id < 0) continue;
+            select(u.slot);
+            add<kTouchDevice, EV_ABS, ABS_MT_TRACKING_ID>(b, -1);
+            s.tracking_id = -1;
+            continue;
+        }
+        const int x = std::max(0, std::min(u.x, ts.screen_w - 1));
+        const int y = std::max(0, std::min(u.y, ts.screen_h - 1));
+        if (s.tracking_id < 0) {
+            select(u.slot);
+            s.tracking_id = ts.next_id;
+            ts.next_id    = (ts.next_id + 1) & 0xffff;
+            add<kTouchDevice, EV_ABS, ABS_MT_TRACKING_ID>(b, s.tracking_id);
+            add<kTouchDevice, EV_ABS, ABS_MT_POSITION_X>(b, x);
+            add<kTouchDevice, EV_ABS, ABS_MT_POSITION_Y>(b, y);
+        } else if (x != s.x || y != s.y) {
+            select(u.slot);
+            if (x != s.x) add<kTouchDevice, EV_ABS, ABS_MT_POSITION_X>(b, x);
+            if (y != s.y) add<kTouchDevice, EV_ABS, ABS_MT_POSITION_Y>(b, y);
+        }
+        s.x = x;
+        s.y = y;
+    }
+
+    // Single-touch emulation follows one contact until it lifts, then the lowest slot.
+    int after = 0;
+    for (const TouchSlot& s : ts.slots) after += s.tracking_id >= 0;
+    if (ts.emu_slot < 0 || ts.slots[ts.emu_slot].tracking_id < 0) {
+        ts.emu_slot = -1;
+        for (int i = 0; i < kMaxTouchSlots && ts.emu_slot < 0; ++i) {
+            if (ts.slots[i].tracking_id >= 0) ts.emu_slot = i;
+        }
+    }
+    if ((before > 0) != (after > 0)) add<kTouchDevice, EV_KEY, BTN_TOUCH>(b, after > 0);
+    if (ts.emu_slot >= 0) {
+        const TouchSlot& e = ts.slots[ts.emu_slot];
+        if (e.x != ts.emu_x) add<kTouchDevice, EV_ABS, ABS_X>(b, ts.emu_x = e.x);
+        if (e.y != ts.emu_y) add<kTouchDevice, EV_ABS, ABS_Y>(b, ts.emu_y = e.y);
+    }
+
+    if (b.count > 0) b.syn();
+    return after;
+}
+
+void touch_close(TouchState& ts)
+{
+    if (ts.fd < 0) return;
+    ioctl(ts.fd, UI_DEV_DESTROY);
+    close(ts.fd);
+    ts.fd = -1;
+    std::cout << "[VirtualHID] Virtual touchscreen destroyed\n";
+}
+
+// ---- Pen tablet --------------------------------------------------------------
+
+bool pen_open(PenState& ps, int screen_w, int screen_h)
+{
+    ps = PenState{};
+    ps.screen_w = screen_w;
+    ps.screen_h = screen_h;
+    ps.fd = open_device<kPenDevice>(screen_w, screen_h);
+    if (ps.fd < 0) return false;
+
+    std::cout << "[VirtualHID] Virtual pen tablet created ("
+              << screen_w << 'x' << screen_h << ", 1/" << kPenSubpixel << " px)\n";
+    return true;
+}
+
+static void pen_move(EventBatch& b, PenState& ps, int x, int y)
+{
+    ps.abs.set<ABS_X>(b, x);
+    ps.abs.set<ABS_Y>(b, y);
+}
+
+void pen_frame(PenState& ps, const PenSample& s, int64_t now_ns)
+{
+    const int x  = std::max(0, std::min(s.x, ps.screen_w * kPenSubpixel - 1));
+    const int y  = std::max(0, std::min(s.y, ps.screen_h * kPenSubpixel - 1));
+    const int p  = std::max(0, std::min(s.pressure, kPenMaxPressure));
+    const int tx = std::max(-kPenMaxTilt, std::min(s.tilt_x, kPenMaxTilt));
+    const int ty = std::max(-kPenMaxTilt, std::min(s.tilt_y, kPenMaxTilt));
+    const bool touch = p >= (ps.touching ? kPenContactOff : kPenContactOn);
+
+    const int64_t interval = now_ns - ps.last_sample_ns;
+    ps.last_sample_ns = now_ns;
+
+    EventBatch b(ps.fd);
+    const bool jump = !ps.in_range || (touch && !ps.touching) || ps.tick_ns <= 0 ||
+                      interval <= 0 || interval > kPenMaxGlideNs;
+    if (!ps.in_range) {
+        add<kPenDevice, EV_KEY, BTN_TOOL_PEN>(b, 1);
+        ps.in_range = true;
+    }
+    if (jump) {
+        ps.gliding = false;
+        pen_move(b, ps, x, y);
+    } else {
+        ps.gliding  = true;
+        ps.from_x   = ps.abs.get<ABS_X>();
+        ps.from_y   = ps.abs.get<ABS_Y>();
+        ps.to_x     = x;
+        ps.to_y     = y;
+        ps.glide_t0 = now_ns;
+        ps.glide_ns = interval;
+    }
+    ps.abs.set<ABS_TILT_X>(b, tx);
+    ps.abs.set<ABS_TILT_Y>(b, ty);
+
+    ps.abs.set<ABS_PRESSURE>(b, touch ? p : 0);
+    if (touch != ps.touching) {
+        add<kPenDevice, EV_KEY, BTN_TOUCH>(b, touch);
+        ps.touching = touch;
+    }
+    if (b.count > 0) b.syn();
+}
+
+bool pen_tick(PenState& ps, int64_t now_ns)
+{
+    if (!ps.gliding) return false;
+    const int64_t t = now_ns - ps.glide_t0;
+    int x = ps.to_x;
+    int y = ps.to_y;
+    if (t < ps.glide_ns) {
+        x = ps.from_x + static_cast<int>(int64_t{ps.to_x - ps.from_x} * t / ps.glide_ns);
+        y = ps.from_y + static_cast<int>(int64_t{ps.to_y - ps.from_y} * t / ps.glide_ns);
+    } else {
+        ps.gliding = false;
+    }
+    EventBatch b(ps.fd);
+    pen_move(b, ps, x, y);
+    if (b.count > 0) b.syn();
+    return ps.gliding;
+}
+
+void pen_out(PenState& ps)
+{
+    ps.gliding = false;
+    if (!ps.in_range) return;
+    EventBatch b(ps.fd);
+    ps.abs.set<ABS_PRESSURE>(b, 0);
+    if (ps.touching) add<kPenDevice, EV_KEY, BTN_TOUCH>(b, 0);
+    add<kPenDevice, EV_KEY, BTN_TOOL_PEN>(b, 0);
+    b.syn();
+    ps.touching = false;
+    ps.in_range = false;
+}
+
+void pen_close(PenState& ps)
+{
+    if (ps.fd < 0) return;
+    ioctl(ps.fd, UI_DEV_DESTROY);
+    close(ps.fd);
+    ps.fd = -1;
+    std::cout << "[VirtualHID] Virtual pen tablet destroyed\n";
+}
+
+// ---- Motion sensor -----------------------------------------------------------
+
+bool gyro_open(GyroState& gs)
+{
+    gs = GyroState{};
+    gs.fd = open_device<kGyroDevice>();
+    if (gs.fd < 0) return false;
+
+    std::cout << "[VirtualHID] Virtual motion sensor created (+-" << kGyroMaxDps << " deg/s)\n";
+    return true;
+}
+
+// from[] / to[] index the rates like gs.rate.value: RX, RY, RZ
+static_assert(AbsCache<kGyroDevice>::kSlots == 3 && AbsCache<kGyroDevice>::slot<ABS_RZ>() == 2);
+
+/** One frame: the rates that changed, then MSC_TIMESTAMP (us since the stream began). */
+static void gyro_write(GyroState& gs, const int rate[3], int64_t now_ns)
+{
+    EventBatch b(gs.fd);
+    gs.rate.set<ABS_RX>(b, rate[0]);
+    gs.rate.set<ABS_RY>(b, rate[1]);
+    gs.rate.set<ABS_RZ>(b, rate[2]);
+    add<kGyroDevice, EV_MSC, MSC_TIMESTAMP>(b, static_cast<int32_t>(static_cast<uint32_t>((now_ns - gs.stream_t0) / 1000)));
+    b.syn();
+}
+
+void gyro_sample(GyroState& gs, const int rate[3], int64_t now_ns)
+{
+    constexpr int kMax = kGyroMaxDps * kGyroResPerDps;
+    int to[3];
+    for (int i = 0; i < 3; ++i) to[i] = std::max(-kMax, std::min(rate[i], kMax));
+
+    const int64_t interval = now_ns - gs.last_sample_ns;
+    gs.last_sample_ns = now_ns;
+    if (!gs.streaming) gs.stream_t0 = now_ns;
+    const bool jump = !gs.streaming || gs.tick_ns <= 0 || interval <= 0 || interval > kGyroMaxGlideNs;
+    gs.streaming = true;
+    if (jump) {
+        gs.glide_ns = 0;
+        std::copy(to, to + 3, gs.from);
+        std::copy(to, to + 3, gs.to);
+        gyro_write(gs, to, now_ns);
+        return;
+    }
+    std::copy(gs.rate.value, gs.rate.value + 3, gs.from);
+    std::copy(to, to + 3, gs.to);
+    gs.glide_t0 = now_ns;
+    gs.glide_ns = interval;
+}
+
+bool gyro_tick(GyroState& gs, int64_t now_ns)
+{
+    if (!gs.streaming) return false;
+    if (now_ns - gs.last_sample_ns > kGyroStaleNs) {
+        gyro_stop(gs, now_ns);
+        return false;
+    }
+    int rate[3];
+    const int64_t t = std::max<int64_t>(now_ns - gs.glide_t0, 0);   // a report due before the sample arrived
+    for (int i = 0; i < 3; ++i) {
+        rate[i] = t < gs.glide_ns ? gs.from[i] + static_cast<int>(int64_t{gs.to[i] - gs.from[i]} * t / gs.glide_ns)
+                                  : gs.to[i];
+    }
+    gyro_write(gs, rate, now_ns);
+    return true;
+}
+
+void gyro_stop(GyroState& gs, int64_t now_ns)
+{
+    const bool moving = gs.rate.value[0] != 0 || gs.rate.value[1] != 0 || gs.rate.value[2] != 0;
+    gs.streaming = false;
+    gs.glide_ns  = 0;
+    std::fill(gs.from, gs.from + 3, 0);
+    std::fill(gs.to, gs.to + 3, 0);
+    if (!moving) return;
+    const int zero[3] = {};
+    gyro_write(gs, zero, now_ns);
+}
+
+void gyro_close(GyroState& gs)
+{
+    if (gs.fd < 0) return;
+    ioctl(gs.fd, UI_DEV_DESTROY);
+    close(gs.fd);
+    gs.fd = -1;
+    std::cout << "[VirtualHID] Virtual motion sensor destroyed\n";
+}
+
 } // namespace VirtualHID
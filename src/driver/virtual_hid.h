@@ -3,20 +3,145 @@
 /*
  * virtual_hid.h
  * Kernel-level virtual HID interface using Linux uinput.
- * Creates virtual mouse and gamepad devices accessible system-wide.
+ * Creates virtual mouse, pointer, gamepad, keyboard, touchscreen, pen tablet
+ * and motion sensor devices accessible system-wide.  What each device can
+ * report is its DeviceDesc (device_descriptor.h), next to its state below.
  */
 
+#include "device_descriptor.h"
+
+#include <linux/input.h>
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 namespace VirtualHID {
 
+// ---------- Observation ----------------------------------------------------
+
+/**
+ * Optional observer invoked for every input_event written to a device
+ * (including SYN_REPORT).  Must be cheap and must not block; used by the
+ * driver's flight recorder.  nullptr disables observation.
+ */
+using EmitHook = void (*)(int fd, uint16_t type, uint16_t code, int32_t value);
+void set_emit_hook(EmitHook hook);
+
+/**
+ * Path of the evdev node ("/dev/input/eventN") the kernel created for an
+ * open uinput device, via UI_GET_SYSNAME and sysfs.  The node may appear a
+ * moment after UI_DEV_CREATE; returns "" if it is not (yet) known.
+ */
+std::string event_node(int uinput_fd);
+
+
+// ---------- Batched frames -------------------------------------------------
+
+/**
+ * Events of one or more frames, written to a device with a single write(2).
+ * kCapacity is one evdev client buffer for a keyboard (64 events): a larger
+ * write could overrun a reader before it wakes and cost a SYN_DROPPED.
+ * Producers end each frame with syn() and flush() before a frame that no
+ * longer fits in room().  Every event still passes through the emit hook.
+ */
+struct EventBatch {
+    static constexpr int kCapacity = 64;
+
+    explicit EventBatch(int fd_) : fd(fd_) {}
+    ~EventBatch() { flush(); }
+
+    void add(uint16_t type, uint16_t code, int32_t value);
+    void syn();
+    int  room() const { return kCapacity - count; }
+
+    /** Write everything added so far; a failed or short write counts as emit errors. */
+    void flush();
+
+    int         fd;
+    int         count = 0;
+    input_event events[kCapacity];
+};
+
+/**
+ * Pause between consecutive keyboard batches of a long TYPE, so a reader has
+ * time to drain its 64-event buffer before the next batch lands (see
+ * KeyboardState::gap_ns).
+ */
+constexpr int kDefaultBatchGapUs = 500;
+
+/** b.add(Type, Code, value) that only builds if device @p D advertises Type / Code. */
+template <const DeviceDesc& D, uint16_t Type, uint16_t Code>
+inline void add(EventBatch& b, int32_t value)
+{
+    static_assert(D.supports(Type, Code), "event not in the device descriptor");
+    b.add(Type, Code, value);
+}
+
+/**
+ * The last value sent on every axis of device @p D, one slot per axis in
+ * code order (DeviceDesc::abs_slot), for writers that only send what
+ * changed.  Slots resolve at compile time; naming an axis D lacks does not
+ * build.
+ */
+template <const DeviceDesc& D>
+struct AbsCache {
+    static constexpr int kSlots = D.abs_count();
+
+    int32_t value[kSlots] = {};
+
+    template <uint16_t Code>
+    static constexpr int slot()
+    {
+        static_assert(D.abs_slot(Code) >= 0, "axis not in the device descriptor");
+        return D.abs_slot(Code);
+    }
+
+    template <uint16_t Code>
+    int32_t get() const { return value[slot<Code>()]; }
+
+    /** Add axis @p Code = @p v to @p b unless that is what was last sent. */
+    template <uint16_t Code>
+    void set(EventBatch& b, int32_t v)
+    {
+        int32_t& last = value[slot<Code>()];
+        if (v != last) b.add(EV_ABS, Code, last = v);
+    }
+};
+
+
 // ---------- Mouse ----------------------------------------------------------
 
+/**
+ * Flick inertia: a release faster than kFlickMinSpeed keeps the cursor
+ * moving, slowing by exp(-friction * t), until it drops below
+ * kFlickStopSpeed or reaches a screen edge.  The velocity is estimated from
+ * the samples; a release more than kFlickMaxAgeNs after the last one (the
+ * hand had stopped) does not coast.
+ */
+constexpr double  kFlickMinSpeed    = 400.0;       // px/s
+constexpr double  kFlickStopSpeed   = 20.0;        // px/s
+constexpr int64_t kFlickMaxAgeNs    = 100000000;
+constexpr double  kFlickSmoothing   = 0.5;         // EWM alpha of the sample velocity
+
+inline constexpr DeviceDesc kMouseDevice =
+    DeviceDesc("mouse", "GestureLink Virtual Mouse", 0x0001)
+        .key(BTN_LEFT).key(BTN_RIGHT).key(BTN_MIDDLE)
+        .abs({ABS_X, 0, 1, Extent::kScreenW})
+        .abs({ABS_Y, 0, 1, Extent::kScreenH})
+        .rel(REL_WHEEL);
+
 struct MouseState {
     int   fd          = -1;
     int   screen_w    = 1920;
     int   screen_h    = 1080;
+    // Inertia (mouse_sample / mouse_release / mouse_inertia_tick)
+    double  friction  = 0;         // velocity decay, 1/s; 0 = inertia off
+    int64_t tick_ns   = 4000000;   // integration step while coasting
+    bool    coasting  = false;
+    double  x = -1, y = -1;        // last position sent; -1 = none yet
+    double  vx = 0, vy = 0;        // px/s
+    int64_t sample_ns = 0;         // last mouse_sample
+    int64_t coast_ns  = 0;         // last integration step
 };
 
 /**
@@ -41,10 +166,97 @@ void mouse_click(const MouseState& ms, uint16_t button);
  */
 void mouse_scroll(const MouseState& ms, int delta);
 
+/**
+ * Track an absolute position the producer moved to at @p now_ns, for the
+ * release velocity.  Stops any coast and starts a new stroke.  Does not
+ * emit: mouse_move_abs does.
+ */
+void mouse_sample(MouseState& ms, int x, int y, int64_t now_ns);
+
+/**
+ * The producer let go of the cursor at @p now_ns: start coasting if inertia
+ * is on and the last samples were a flick.
+ * @return true if coasting; call mouse_inertia_tick every tick_ns.
+ */
+bool mouse_release(MouseState& ms, int64_t now_ns);
+
+/**
+ * Integrate the coast to @p now_ns and emit the position if it moved a
+ * pixel.  @return true while still coasting.
+ */
+bool mouse_inertia_tick(MouseState& ms, int64_t now_ns);
+
+/** Stop coasting immediately (new hand input). */
+void mouse_stop(MouseState& ms);
+
 /** Destroy the virtual mouse device and close the fd. */
 void mouse_close(MouseState& ms);
 
 
+// ---------- Pointers -------------------------------------------------------
+
+/**
+ * Independent absolute pointers, one device each, so that compositors with
+ * multi-pointer support (e.g. X11 MPX master devices) can give every hand
+ * its own cursor.  The mouse above stays the shared system cursor.
+ */
+constexpr int kMaxPointers = 4;
+
+/** Buttons a pointer has; bit i of Pointer::buttons is kPointerButtons[i]. */
+constexpr uint16_t kPointerButtons[] = {BTN_LEFT, BTN_RIGHT, BTN_MIDDLE};
+
+/** Each pointer; opened with its index appended to the name. */
+inline constexpr DeviceDesc kPointerDevice =
+    DeviceDesc("pointer", "GestureLink Virtual Pointer", 0x0006)
+        .key(kPointerButtons[0]).key(kPointerButtons[1]).key(kPointerButtons[2])
+        .abs({ABS_X, 0, 1, Extent::kScreenW})
+        .abs({ABS_Y, 0, 1, Extent::kScreenH});
+
+/** Move (button == 0) or button change for one pointer. */
+struct PointerUpdate {
+    int      id;
+    int      x = 0, y = 0;
+    uint16_t button  = 0;          // one of kPointerButtons
+    bool     pressed = false;
+};
+
+/** Up to a move and every button per pointer in one POINTER line. */
+constexpr int kMaxPointerUpdates = kMaxPointers * 4;
+
+/** One pointer device and the last state sent on it. */
+struct Pointer {
+    int     fd      = -1;
+    int     x = -1, y = -1;        // -1 = never moved
+    uint8_t buttons = 0;
+};
+
+struct PointerSet {
+    int     count    = 0;          // pointers in use (opened by pointers_open)
+    int     screen_w = 1920;
+    int     screen_h = 1080;
+    Pointer p[kMaxPointers];
+};
+
+/**
+ * Open @p ps.count (<= kMaxPointers) absolute pointer devices, named
+ * "GestureLink Virtual Pointer <i>".  On failure the ones already open are
+ * closed.  @return true on success.
+ */
+bool pointers_open(PointerSet& ps, int screen_w = 1920, int screen_h = 1080);
+
+/**
+ * Apply @p n <= kMaxPointerUpdates updates (ids below ps.count, checked by
+ * the caller).  Updates are first folded into each pointer's wanted state,
+ * then every pointer that changed gets one frame (position, then buttons)
+ * through a single shared EventBatch; unchanged pointers are not written.
+ * @return the number of pointers written.
+ */
+int pointers_frame(PointerSet& ps, const PointerUpdate* updates, int n);
+
+/** Destroy every pointer device and close the fds. */
+void pointers_close(PointerSet& ps);
+
+
 // ---------- Gamepad --------------------------------------------------------
 
 /** Gamepad button bit-flags (matching evdev BTN_* constants). */
@@ -59,16 +271,100 @@ enum class GamepadBtn : uint16_t {
     START  = 0x139,   // BTN_START
 };
 
+/** Rumble effect slots a game can upload (uinput ff_effects_max). */
+constexpr int kMaxFfEffects = 16;
+
+/** Xbox-style layout: face, shoulder and meta buttons, the left stick, rumble. */
+inline constexpr DeviceDesc kGamepadDevice =
+    DeviceDesc("gamepad", "GestureLink Virtual Gamepad", 0x0002)
+        .key(static_cast<uint16_t>(GamepadBtn::A)).key(static_cast<uint16_t>(GamepadBtn::B))
+        .key(static_cast<uint16_t>(GamepadBtn::X)).key(static_cast<uint16_t>(GamepadBtn::Y))
+        .key(static_cast<uint16_t>(GamepadBtn::LB)).key(static_cast<uint16_t>(GamepadBtn::RB))
+        .key(static_cast<uint16_t>(GamepadBtn::SELECT)).key(static_cast<uint16_t>(GamepadBtn::START))
+        .abs({ABS_X, -32767, 32767, Extent::kFixed, 16, 128})
+        .abs({ABS_Y, -32767, 32767, Extent::kFixed, 16, 128})
+        .ff(FF_RUMBLE, kMaxFfEffects)
+        .ff(FF_GAIN, kMaxFfEffects);
+
+/** An uploaded FF_RUMBLE effect; magnitudes 0..0xffff. */
+struct FfEffect {
+    bool     used      = false;
+    bool     playing   = false;
+    uint16_t strong    = 0;
+    uint16_t weak      = 0;
+    uint16_t length_ms = 0;        // 0 = until stopped
+};
+
+/** A rumble change for the back-channel: effect @p id starts (or changes) or stops. */
+struct FfEvent {
+    int      id;
+    bool     play;
+    uint16_t strong, weak;         // gain applied
+    uint16_t length_ms;
+};
+
+/** Buttons that can autofire at once, and the fastest rate (games poll once per frame). */
+constexpr int kMaxTurbo   = 8;
+constexpr int kMaxTurboHz = 60;
+
+/**
+ * Edges due within this long of a tick go out in the tick's frame, so
+ * buttons whose edges (nearly) coincide share one write(2).  One TimerWheel
+ * tick: the timer cannot fire any closer to an edge than that anyway.
+ */
+constexpr int64_t kTurboCoalesceNs = 1000000;
+
+/**
+ * Shortest press or release phase gamepad_turbo accepts.  Either edge of a
+ * phase may go out up to kTurboCoalesceNs early, so a shorter phase could
+ * put a press and its release (or a release and the next press) in
+ * back-to-back frames a game never samples apart.
+ */
+constexpr int64_t kMinTurboPhaseNs = 2 * kTurboCoalesceNs;
+
+/**
+ * An autofiring button: pressed for on_ns at the start of every period,
+ * counted from start_ns, so late ticks never accumulate into drift.
+ */
+struct TurboButton {
+    GamepadBtn btn       = GamepadBtn::A;
+    int64_t    period_ns = 0;          // 0 = slot free
+    int64_t    on_ns     = 0;
+    int64_t    start_ns  = 0;
+    int64_t    next_ns   = 0;          // ideal time of the next edge
+    bool       down      = false;
+};
+
+/**
+ * The gamepad and its force-feedback state.  Games upload, play and erase
+ * rumble effects through the evdev node; the kernel queues those requests
+ * on fd, and gamepad_service() answers them.
+ */
 struct GamepadState {
-    int fd = -1;
+    int         fd = -1;
+    uint16_t    ff_gain = 0xffff;     // FF_GAIN
+    FfEffect    ff[kMaxFfEffects];
+    TurboButton turbo[kMaxTurbo];
+    int         turbo_count = 0;      // slots in use
+    int64_t     turbo_next_ns = 0;    // earliest next edge, 0 = nothing autofires
 };
 
 /**
- * Open /dev/uinput and register a virtual gamepad (Xbox-style layout).
+ * Open /dev/uinput (read-write, non-blocking) and register a virtual
+ * gamepad (Xbox-style layout) with FF_RUMBLE and FF_GAIN.
  * @return true on success.
  */
 bool gamepad_open(GamepadState& gs);
 
+/**
+ * Read what the kernel queued on the gamepad's fd (call when it polls
+ * readable): complete UI_FF_UPLOAD / UI_FF_ERASE handshakes, which the
+ * game's ioctl is blocked on, and apply EV_FF play / stop / gain.  Never
+ * blocks.  Up to @p max resulting changes are stored in @p out.
+ * @return the number stored.
+ */
+int gamepad_service(GamepadState& gs, FfEvent* out, int max);
+
 /**
  * Press or release a gamepad button.
  * @param pressed  true = press, false = release
@@ -80,9 +376,345 @@ void gamepad_button(const GamepadState& gs, GamepadBtn btn, bool pressed);
  */
 void gamepad_stick(const GamepadState& gs, int x, int y);
 
+/**
+ * Autofire @p btn at @p hz (1..kMaxTurboHz), held for @p duty_pct (1..99)
+ * percent of each period.  The first press is written at once; a button
+ * that is already autofiring restarts at the new rate.  @p hz 0 stops it
+ * and releases the button.  Updates turbo_next_ns.
+ * @return false if the arguments are out of range, leave the press or the
+ *         release shorter than kMinTurboPhaseNs, or every slot is in use.
+ */
+bool gamepad_turbo(GamepadState& gs, GamepadBtn btn, int hz, int duty_pct, int64_t now_ns);
+
+/**
+ * Write every turbo edge due by @p now_ns (+ kTurboCoalesceNs) as one frame.
+ * A tick late by whole periods jumps to the current phase instead of
+ * replaying the missed edges.
+ * @return the new turbo_next_ns.
+ */
+int64_t gamepad_turbo_tick(GamepadState& gs, int64_t now_ns);
+
 /** Destroy the virtual gamepad device and close the fd. */
 void gamepad_close(GamepadState& gs);
 
+
+// ---------- Keyboard -------------------------------------------------------
+
+/** Every standard key; Keymap's names are checked against it at compile time. */
+inline constexpr DeviceDesc kKeyboardDevice =
+    DeviceDesc("keyboard", "GestureLink Virtual Keyboard", 0x0003).keys_range(KEY_ESC, KEY_MICMUTE);
+
+/** Longest KEY_CHORD accepted (modifiers + key). */
+constexpr int kMaxChord = 8;
+
+/** Longest TYPE text accepted, in bytes; longer text is refused whole. */
+constexpr size_t kMaxTypeLen = 512;
+
+/** One queued key event; code 0 (KEY_RESERVED, never sent) stands for SYN_REPORT. */
+struct KeyEvent {
+    uint16_t code;
+    uint16_t value;
+};
+
+/**
+ * The keyboard and the frames still to write.  Text past the first batch
+ * of a TYPE waits in the queue and goes out one batch per
+ * keyboard_type_tick(), gap_ns apart on the driver's timer wheel; key and
+ * chord frames that arrive meanwhile queue behind it, so order is kept.
+ */
+struct KeyboardState {
+    static constexpr int kQueueCapacity = 6144;   // two kMaxTypeLen TYPEs, worst case
+
+    int      fd      = -1;
+    int64_t  gap_ns  = int64_t{kDefaultBatchGapUs} * 1000;   // 0 = write every batch at once
+    bool     typing  = false;      // frames queued for keyboard_type_tick()
+    int      head    = 0;
+    int      tail    = 0;
+    KeyEvent queue[kQueueCapacity];
+};
+
+/**
+ * Open /dev/uinput and register a virtual keyboard with every standard key
+ * (KEY_ESC through KEY_MICMUTE).
+ * @return true on success.
+ */
+bool keyboard_open(KeyboardState& ks);
+
+/**
+ * Press or release one key (KEY_* code): one frame, queued behind any text
+ * still being typed.
+ * @return false if the queue is full (nothing sent).
+ */
+bool keyboard_key(KeyboardState& ks, uint16_t code, bool pressed);
+
+/**
+ * Press @p codes in order in one frame, then release them in reverse order
+ * in a second; both frames go out in one write(2), or queue behind text
+ * still being typed.
+ * @return false if the queue is full (nothing sent).
+ */
+bool keyboard_chord(KeyboardState& ks, const uint16_t* codes, int n);
+
+/**
+ * Type @p text (see Keymap::next_stroke for escapes) as a press frame and a
+ * release frame per character, holding LEFTSHIFT across runs of shifted
+ * characters.  Frames are batched into EventBatch-sized writes of about 15
+ * characters.  The first batch is written now unless earlier text is still
+ * queued; the rest is left to keyboard_type_tick() (all of it is written
+ * now when gap_ns is 0).  Never sleeps.
+ * @p unmapped is set to the number of characters with no key on the layout
+ * (skipped).
+ * @return false, typing nothing, if @p text is longer than kMaxTypeLen or
+ * does not fit in the queue.
+ */
+bool keyboard_type(KeyboardState& ks, std::string_view text, size_t& unmapped);
+
+/**
+ * Write the next batch of queued frames; call gap_ns after the last write
+ * while ks.typing.
+ * @return ks.typing: whether frames remain.
+ */
+bool keyboard_type_tick(KeyboardState& ks);
+
+/** Destroy the virtual keyboard device and close the fd. */
+void keyboard_close(KeyboardState& ks);
+
+
+// ---------- Touchscreen ----------------------------------------------------
+
+/** Contact slots of the type-B multitouch protocol (ten fingers). */
+constexpr int kMaxTouchSlots = 10;
+
+inline constexpr DeviceDesc kTouchDevice =
+    DeviceDesc("touchscreen", "GestureLink Virtual Touchscreen", 0x0004)
+        .prop(INPUT_PROP_DIRECT)
+        .key(BTN_TOUCH)
+        .abs({ABS_X, 0, 1, Extent::kScreenW})
+        .abs({ABS_Y, 0, 1, Extent::kScreenH})
+        .abs({ABS_MT_SLOT, 0, kMaxTouchSlots - 1})
+        .abs({ABS_MT_POSITION_X, 0, 1, Extent::kScreenW})
+        .abs({ABS_MT_POSITION_Y, 0, 1, Extent::kScreenH})
+        .abs({ABS_MT_TRACKING_ID, 0, 0xffff});
+
+struct TouchSlot {
+    int tracking_id = -1;     // -1 = no contact
+    int x = 0;
+    int y = 0;
+};
+
+/**
+ * The touchscreen and the last state sent for every slot.  touch_frame()
+ * diffs against it, so only what changed goes out.
+ */
+struct TouchState {
+    int       fd          = -1;
+    int       screen_w    = 1920;
+    int       screen_h    = 1080;
+    TouchSlot slots[kMaxTouchSlots];
+    int       cur_slot    = 0;     // last ABS_MT_SLOT sent
+    int       next_id     = 0;     // tracking id for the next new contact
+    int       emu_slot    = -1;    // contact driving single-touch ABS_X / ABS_Y
+    int       emu_x       = -1;    // last ABS_X / ABS_Y sent
+    int       emu_y       = -1;
+};
+
+/** One contact change: down / moved to (x, y), or lifted. */
+struct TouchUpdate {
+    int  slot;
+    bool up;
+    int  x, y;
+};
+
+/**
+ * Open /dev/uinput and register a direct-touch (INPUT_PROP_DIRECT) type-B
+ * multitouch screen with kMaxTouchSlots slots, plus BTN_TOUCH / ABS_X /
+ * ABS_Y single-touch emulation for legacy readers.
+ * @return true on success.
+ */
+bool touch_open(TouchState& ts, int screen_w = 1920, int screen_h = 1080);
+
+/**
+ * Apply @p n <= kMaxTouchSlots updates (slots in range, checked by the
+ * caller) as one frame and one write(2).  Only slots whose contact or position changed are
+ * emitted, ABS_MT_SLOT only when the slot differs from the last one sent;
+ * an update that changes nothing emits nothing, not even SYN_REPORT.
+ * @return the number of active contacts afterwards.
+ */
+int touch_frame(TouchState& ts, const TouchUpdate* updates, int n);
+
+/** Destroy the virtual touchscreen device and close the fd. */
+void touch_close(TouchState& ts);
+
+
+// ---------- Pen tablet -----------------------------------------------------
+
+/** Pen position units per screen pixel (ABS_X / ABS_Y resolution). */
+constexpr int kPenSubpixel = 16;
+
+constexpr int kPenMaxPressure = 4095;
+constexpr int kPenMaxTilt     = 90;      // degrees either side of vertical
+
+/**
+ * Contact hysteresis on the reported pressure: the pen touches down at
+ * kPenContactOn and lifts only below kPenContactOff, so depth noise around
+ * one threshold cannot chatter BTN_TOUCH.
+ */
+constexpr int kPenContactOn  = 410;      // ~10 %
+constexpr int kPenContactOff = 205;      // ~5 %
+
+/** Longest producer interval a position glide spans; longer gaps jump. */
+constexpr int64_t kPenMaxGlideNs = 50000000;
+
+/**
+ * Position resolution assumes a 96 dpi screen (tablet readers such as
+ * libinput require one, hence UI_ABS_SETUP); tilt is in degrees, i.e. 57
+ * units per radian.
+ */
+inline constexpr DeviceDesc kPenDevice =
+    DeviceDesc("pen", "GestureLink Virtual Pen", 0x0005)
+        .prop(INPUT_PROP_DIRECT)
+        .key(BTN_TOOL_PEN).key(BTN_TOUCH)
+        .abs({ABS_X, 0, kPenSubpixel, Extent::kScreenW, 0, 0, kPenSubpixel * 96 * 10 / 254})
+        .abs({ABS_Y, 0, kPenSubpixel, Extent::kScreenH, 0, 0, kPenSubpixel * 96 * 10 / 254})
+        .abs({ABS_PRESSURE, 0, kPenMaxPressure})
+        .abs({ABS_TILT_X, -kPenMaxTilt, kPenMaxTilt, Extent::kFixed, 0, 0, 57})
+        .abs({ABS_TILT_Y, -kPenMaxTilt, kPenMaxTilt, Extent::kFixed, 0, 0, 57});
+
+/** One producer sample: position in kPenSubpixel units, pressure, tilt in degrees. */
+struct PenSample {
+    int x, y;
+    int pressure;
+    int tilt_x, tilt_y;
+};
+
+/**
+ * The pen and the last state sent.  With tick_ns > 0, position moves from
+ * the last sent point to each new sample over one producer interval, one
+ * frame per pen_tick(); proximity, contact, pressure and tilt always go out
+ * with the sample.
+ */
+struct PenState {
+    int     fd        = -1;
+    int     screen_w  = 1920;
+    int     screen_h  = 1080;
+    int64_t tick_ns   = 0;         // glide step; 0 = positions jump to each sample
+    bool    in_range  = false;     // BTN_TOOL_PEN
+    bool    touching  = false;     // BTN_TOUCH
+    AbsCache<kPenDevice> abs;      // last position (subpixel), pressure and tilt sent
+    // Glide towards the latest sample
+    bool    gliding   = false;
+    int     from_x = 0, from_y = 0, to_x = 0, to_y = 0;
+    int64_t glide_t0  = 0;
+    int64_t glide_ns  = 0;
+    int64_t last_sample_ns = 0;
+};
+
+/**
+ * Open /dev/uinput and register the screen-mapped pen tablet (kPenDevice):
+ * BTN_TOOL_PEN / BTN_TOUCH, ABS_X / ABS_Y in kPenSubpixel units,
+ * ABS_PRESSURE and ABS_TILT_X / ABS_TILT_Y.
+ * @return true on success.
+ */
+bool pen_open(PenState& ps, int screen_w = 1920, int screen_h = 1080);
+
+/**
+ * Apply one sample taken at @p now_ns as one frame: the pen enters
+ * proximity if it was out, touches or lifts per the contact hysteresis,
+ * and reports pressure (0 while hovering) and tilt if they changed.
+ * Position jumps on entering proximity and on touch-down, otherwise it
+ * glides (see PenState).  Values are clamped to the device ranges.
+ */
+void pen_frame(PenState& ps, const PenSample& s, int64_t now_ns);
+
+/**
+ * Emit the glide position for @p now_ns if it moved.
+ * @return true while the glide has further to go.
+ */
+bool pen_tick(PenState& ps, int64_t now_ns);
+
+/** Lift (if touching) and leave proximity: one frame. */
+void pen_out(PenState& ps);
+
+/** Destroy the virtual pen tablet and close the fd. */
+void pen_close(PenState& ps);
+
+
+// ---------- Motion sensor --------------------------------------------------
+
+/** ABS_RX / ABS_RY / ABS_RZ units per degree per second (the axis resolution). */
+constexpr int kGyroResPerDps = 16;
+constexpr int kGyroMaxDps    = 2000;
+
+/** Longest producer interval a rate glide spans; longer gaps jump. */
+constexpr int64_t kGyroMaxGlideNs = 100000000;
+
+/** Without a sample for this long the rates drop to zero and streaming stops. */
+constexpr int64_t kGyroStaleNs = 250000000;
+
+/**
+ * Rates only, the way evdev exposes a controller's IMU.  No fuzz: the
+ * kernel would otherwise swallow small rate changes.
+ */
+inline constexpr DeviceDesc kGyroDevice =
+    DeviceDesc("gyro", "GestureLink Virtual Motion Sensors", 0x0007)
+        .prop(INPUT_PROP_ACCELEROMETER)
+        .abs({ABS_RX, -kGyroMaxDps * kGyroResPerDps, kGyroMaxDps * kGyroResPerDps, Extent::kFixed, 0, 0,
+              kGyroResPerDps})
+        .abs({ABS_RY, -kGyroMaxDps * kGyroResPerDps, kGyroMaxDps * kGyroResPerDps, Extent::kFixed, 0, 0,
+              kGyroResPerDps})
+        .abs({ABS_RZ, -kGyroMaxDps * kGyroResPerDps, kGyroMaxDps * kGyroResPerDps, Extent::kFixed, 0, 0,
+              kGyroResPerDps})
+        .msc(MSC_TIMESTAMP);
+
+/**
+ * The motion sensor and the last rates sent.  Producer samples (one per
+ * camera frame) are upsampled: with tick_ns > 0 the rates glide from the
+ * last value sent to each new sample over one producer interval, and every
+ * gyro_tick() writes a frame stamped with MSC_TIMESTAMP whether or not a
+ * rate changed, the way a real IMU reports at a fixed rate.
+ */
+struct GyroState {
+    int     fd        = -1;
+    int64_t tick_ns   = 0;         // report period; 0 = one frame per sample
+    bool    streaming = false;     // a sample arrived and GYRO OFF / staleness has not ended it
+    AbsCache<kGyroDevice> rate;    // last ABS_RX / ABS_RY / ABS_RZ sent
+    int     from[3]   = {};
+    int     to[3]     = {};
+    int64_t glide_t0  = 0;
+    int64_t glide_ns  = 0;
+    int64_t last_sample_ns = 0;
+    int64_t stream_t0 = 0;         // MSC_TIMESTAMP origin
+};
+
+/**
+ * Open /dev/uinput and register the motion sensor (kGyroDevice): ABS_RX /
+ * ABS_RY / ABS_RZ angular rates of +-kGyroMaxDps at kGyroResPerDps, and
+ * MSC_TIMESTAMP.
+ * @return true on success.
+ */
+bool gyro_open(GyroState& gs);
+
+/**
+ * Apply one producer sample of angular rates (kGyroResPerDps units, clamped)
+ * taken at @p now_ns.  The first sample of a stream, every sample with
+ * tick_ns == 0 and samples after a gap longer than kGyroMaxGlideNs are
+ * written at once; the rest glide (see GyroState).
+ */
+void gyro_sample(GyroState& gs, const int rate[3], int64_t now_ns);
+
+/**
+ * Write the rates for @p now_ns as one timestamped frame, or zero them and
+ * stop once the last sample is older than kGyroStaleNs.
+ * @return true while streaming.
+ */
+bool gyro_tick(GyroState& gs, int64_t now_ns);
+
+/** Zero the rates (one frame if any was non-zero) and stop streaming. */
+void gyro_stop(GyroState& gs, int64_t now_ns);
+
+/** Destroy the virtual motion sensor and close the fd. */
+void gyro_close(GyroState& gs);
+
 } // namespace VirtualHID
 
 #endif // VIRTUAL_HID_H
@@ -0,0 +1,96 @@
+"""
+feedback.py
+The driver → producer back-channel: rumble effects games play on the
+virtual gamepad, as hid_driver writes them to $HID_DRIVER_FEEDBACK_FD
+(see src/driver/hid_driver.cpp):
+
+    FF PLAY <id> <strong> <weak> <length_ms>    magnitudes 0..65535, gain applied
+    FF STOP <id>
+
+RumbleState keeps the effects that are playing and expires finite ones
+after their length, so whatever renders them (the HUD, a haptic wristband)
+only asks for the current intensity:
+
+    read_fd, write_fd = os.pipe()           # write_fd is inherited by hid_driver
+    rumble = RumbleState()
+    FeedbackReader(read_fd, rumble).start()
+    strong, weak = rumble.intensity()       # 0 … 1 each
+
+Time comes from an injectable clock (src/clock.py).
+"""
+
+from __future__ import annotations
+
+import os
+import threading
+import time
+from dataclasses import dataclass
+from typing import Callable, Dict, Optional, Tuple
+
+FF_MAX_MAGNITUDE = 0xFFFF
+
+
+@dataclass
+class Effect:
+    strong: float           # 0 … 1
+    weak: float
+    until: Optional[float]  # clock time it ends, None = until stopped
+
+
+class RumbleState:
+    """Active rumble effects by id; thread-safe (the reader thread applies)."""
+
+    def __init__(self, clock: Callable[[], float] = time.monotonic) -> None:
+        self._clock   = clock
+        self._lock    = threading.Lock()
+        self._effects: Dict[int, Effect] = {}
+
+    def apply(self, line: str) -> bool:
+        """Apply one back-channel line; False if it is not one."""
+        parts = line.split()
+        try:
+            if len(parts) == 6 and parts[:2] == ["FF", "PLAY"]:
+                eid, strong, weak, length_ms = (int(p) for p in parts[2:])
+                until = self._clock() + length_ms / 1000.0 if length_ms > 0 else None
+                effect = Effect(strong / FF_MAX_MAGNITUDE, weak / FF_MAX_MAGNITUDE, until)
+                with self._lock:
+                    self._effects[eid] = effect
+                return True
+            if len(parts) == 3 and parts[:2] == ["FF", "STOP"]:
+                with self._lock:
+                    self._effects.pop(int(parts[2]), None)
+                return True
+        except ValueError:
+            pass
+        return False
+
+    def intensity(self) -> Tuple[float, float]:
+        """(strong, weak) motor level now: the maximum over live effects."""
+        now = self._clock()
+        with self._lock:
+            for eid in [e for e, fx in self._effects.items() if fx.until is not None and fx.until <= now]:
+                del self._effects[eid]
+            live = list(self._effects.values())
+        return (max((fx.strong for fx in live), default=0.0),
+                max((fx.weak for fx in live), default=0.0))
+
+    def active(self) -> int:
+        """Number of effects playing now."""
+        self.intensity()
+        with self._lock:
+            return len(self._effects)
+
+
+class FeedbackReader(threading.Thread):
+    """Applies every line read from @fd to a RumbleState until EOF."""
+
+    def __init__(self, fd: int, state: RumbleState) -> None:
+        super().__init__(name="FeedbackReader", daemon=True)
+        self.fd    = fd
+        self.state = state
+        self.lines = 0
+
+    def run(self) -> None:
+        with os.fdopen(self.fd, "rb") as f:
+            for raw in f:
+                self.lines += self.state.apply(raw.decode(errors="replace"))
@@ -0,0 +1,151 @@
+"""
+idle.py
+Low-power idle mode: when no hand has been seen for a while, the detector
+drops the camera to a low rate and resolution, main.py pauses the preview
+and HUD, and the driver is told to put its timers to sleep (POWER IDLE).
+The first frame with a hand wakes everything up again.
+
+    idle = IdleController(idle_after_s=10.0)
+    change = idle.observe(hand_seen)        # None, IDLE or ACTIVE
+    if change == IDLE:
+        ...                                 # reconfigure capture, notify driver
+
+The controller only decides and measures; the detector and main.py act on
+its transitions.  It reads time from an injectable clock (src/clock.py) and
+CPU/wake-up counters from an injectable ``usage`` callable so the state
+machine can be tested without a camera or real time passing.
+
+Wake latency is measured from the grab of the low-rate frame in which a hand
+was detected to the first full-rate result.  A hand that appears just after
+a grab waits up to one idle frame period before it is even sampled, so the
+bound reported alongside the measurement is ``1 / idle_fps`` plus it.
+"""
+
+from __future__ import annotations
+
+import time
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Callable, List, Optional, Tuple
+
+ACTIVE = "active"
+IDLE   = "idle"
+
+IDLE_FPS  = 5.0
+IDLE_SIZE = (320, 240)
+
+
+def process_usage() -> Tuple[float, int]:
+    """(CPU seconds, voluntary context switches) of this process, all threads."""
+    switches = 0
+    try:
+        for task in Path("/proc/self/task").iterdir():
+            for line in (task / "status").read_text().splitlines():
+                if line.startswith("voluntary_ctxt_switches:"):
+                    switches += int(line.split()[1])
+    except (OSError, ValueError):
+        pass
+    return time.process_time(), switches
+
+
+@dataclass
+class IdlePeriod:
+    """One stretch of idle time and what it cost."""
+    seconds:       float
+    cpu_percent:   float
+    wakeups_per_s: float
+    wake_latency:  Optional[float] = None   # seconds, once the first full-rate result is out
+    bound:         Optional[float] = None   # idle frame period + wake_latency
+
+    def summary(self) -> str:
+        text = (f"Idle for {self.seconds:.1f} s: {self.cpu_percent:.1f}% CPU, "
+                f"{self.wakeups_per_s:.1f} wakeups/s")
+        if self.wake_latency is not None:
+            text += (f"; woke in {self.wake_latency * 1e3:.0f} ms "
+                     f"(bound {self.bound * 1e3:.0f} ms)")
+        return text
+
+
+class IdleController:
+    """ACTIVE ⇄ IDLE state machine driven by per-frame hand detections."""
+
+    def __init__(self, idle_after_s: float = 10.0, idle_fps: float = IDLE_FPS,
+                 idle_size: Tuple[int, int] = IDLE_SIZE,
+                 clock: Callable[[], float] = time.monotonic,
+                 usage: Callable[[], Tuple[float, int]] = process_usage) -> None:
+        if idle_fps <= 0:
+            raise ValueError("idle_fps must be positive")
+        self.idle_after_s = idle_after_s
+        self.idle_fps     = idle_fps
+        self.idle_size    = idle_size
+        self._clock       = clock
+        self._usage       = usage
+
+        self.state        = ACTIVE
+        self.periods: List[IdlePeriod] = []
+        self._last_hand   = clock()
+        self._idle_since  = 0.0
+        self._idle_usage  = (0.0, 0)
+        self._waking_from: Optional[float] = None
+
+    def now(self) -> float:
+        return self._clock()
+
+    @property
+    def enabled(self) -> bool:
+        return self.idle_after_s > 0
+
+    @property
+    def idle(self) -> bool:
+        return self.state == IDLE
+
+    @property
+    def frame_period(self) -> float:
+        """Minimum time between idle frames."""
+        return 1.0 / self.idle_fps
+
+    def observe(self, hand_seen: bool, grabbed_at: Optional[float] = None) -> Optional[str]:
+        """
+        Feed one processed frame.  @grabbed_at is when the frame was captured
+        (defaults to now).  Returns the new state on a transition, else None.
+        """
+        now = self._clock()
+        if hand_seen:
+            self._last_hand = now
+            if self.state == IDLE:
+                self._leave_idle(now, now if grabbed_at is None else grabbed_at)
+                return ACTIVE
+        elif self.state == ACTIVE and self.enabled and now - self._last_hand >= self.idle_after_s:
+            self.state       = IDLE
+            self._idle_since = now
+            self._idle_usage = self._usage()
+            return IDLE
+        return None
+
+    def result_published(self) -> Optional[IdlePeriod]:
+        """
+        Call after each full-rate result; completes the wake-latency
+        measurement of the idle period just left and returns it (once).
+        """
+        if self._waking_from is None:
+            return None
+        period = self.periods[-1]
+        period.wake_latency = self._clock() - self._waking_from
+        period.bound        = self.frame_period + period.wake_latency
+        self._waking_from   = None
+        return period
+
+    def in_progress(self) -> Optional[IdlePeriod]:
+        """Cost of the current idle stretch so far (None while active)."""
+        return self._measure(self._clock()) if self.state == IDLE else None
+
+    def _measure(self, now: float) -> IdlePeriod:
+        cpu0, sw0 = self._idle_usage
+        cpu1, sw1 = self._usage()
+        secs = max(now - self._idle_since, 1e-9)
+        return IdlePeriod(secs, 100.0 * (cpu1 - cpu0) / secs, (sw1 - sw0) / secs)
+
+    def _leave_idle(self, now: float, grabbed_at: float) -> None:
+        self.periods.append(self._measure(now))
+        self.state        = ACTIVE
+        self._waking_from = grabbed_at
@@ -0,0 +1,330 @@
+"""
+metrics.py
+Pipeline counters, gauges and histograms exported in Prometheus text format
+(version 0.0.4) over loopback HTTP or a Unix socket.
+
+Counters and histograms are sharded per thread: every recording thread
+updates a private dict that only it writes, so the hot path never takes a
+lock.  A scrape copies each shard (dict.copy() is atomic under the GIL)
+and sums them.  Gauges are either set directly or computed by a callback
+at scrape time (e.g. queue depths).
+
+    from src import metrics
+    FRAMES = metrics.counter("gesturelink_frames_total", "Frames processed.")
+    FRAMES.inc()
+    metrics.serve("unix:/run/user/1000/gesturelink.metrics")   # or "9465"
+
+The driver exports its own metrics (see src/driver/metrics.h).
+"""
+
+from __future__ import annotations
+
+import math
+import os
+import socket
+import socketserver
+import stat
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Sequence, Tuple
+
+LabelKey = Tuple[Tuple[str, str], ...]
+
+CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8"
+
+DEFAULT_LATENCY_BUCKETS = (0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0)
+
+
+def _key(labels: Dict[str, object]) -> LabelKey:
+    return tuple(sorted((k, str(v)) for k, v in labels.items()))
+
+
+def _fmt_labels(key: LabelKey, extra: Sequence[Tuple[str, str]] = ()) -> str:
+    items = list(key) + list(extra)
+    if not items:
+        return ""
+    body = ",".join(
+        '{}="{}"'.format(k, v.replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n"))
+        for k, v in items
+    )
+    return "{" + body + "}"
+
+
+def _fmt_value(v: float) -> str:
+    if math.isinf(v):
+        return "+Inf" if v > 0 else "-Inf"
+    return repr(float(v)) if not float(v).is_integer() else str(int(v))
+
+
+# ---- Sharding ----------------------------------------------------------------
+
+class _Sharded:
+    """Per-thread dict shards; each thread writes only its own."""
+
+    def __init__(self) -> None:
+        self._local  = threading.local()
+        self._shards: List[dict] = []
+        self._lock   = threading.Lock()      # taken once per thread, not per update
+
+    def _shard(self) -> dict:
+        try:
+            return self._local.shard
+        except AttributeError:
+            shard: dict = {}
+            with self._lock:
+                self._shards.append(shard)
+            self._local.shard = shard
+            return shard
+
+    def _snapshots(self) -> List[dict]:
+        with self._lock:
+            shards = list(self._shards)
+        return [s.copy() for s in shards]
+
+
+# ---- Metric types ------------------------------------------------------------
+
+class Counter(_Sharded):
+    kind = "counter"
+
+    def __init__(self, name: str, help: str) -> None:
+        super().__init__()
+        self.name, self.help = name, help
+
+    def inc(self, n: float = 1, **labels: object) -> None:
+        shard = self._shard()
+        k = _key(labels)
+        shard[k] = shard.get(k, 0) + n
+
+    def value(self, **labels: object) -> float:
+        k = _key(labels)
+        return sum(s.get(k, 0) for s in self._snapshots())
+
+    def samples(self) -> List[str]:
+        totals: Dict[LabelKey, float] = {}
+        for s in self._snapshots():
+            for k, v in s.items():
+                totals[k] = totals.get(k, 0) + v
+        return [f"{self.name}{_fmt_labels(k)} {_fmt_value(v)}" for k, v in sorted(totals.items())]
+
+
+class Histogram(_Sharded):
+    kind = "histogram"
+
+    def __init__(self, name: str, help: str,
+                 buckets: Sequence[float] = DEFAULT_LATENCY_BUCKETS) -> None:
+        super().__init__()
+        self.name, self.help = name, help
+        self.buckets = tuple(sorted(buckets))
+
+    def observe(self, value: float, **labels: object) -> None:
+        shard = self._shard()
+        k = _key(labels)
+        cell = shard.get(k)
+        if cell is None:
+            cell = shard[k] = [0] * (len(self.buckets) + 1) + [0.0]   # counts…, +Inf, sum
+        i = 0
+        while i < len(self.buckets) and value > self.buckets[i]:
+            i += 1
+        cell[i] += 1
+        cell[-1] += value
+
+    def samples(self) -> List[str]:
+        totals: Dict[LabelKey, List[float]] = {}
+        for s in self._snapshots():
+            for k, cell in s.items():
+                cell = list(cell)
+                acc = totals.setdefault(k, [0] * len(cell))
+                for i, v in enumerate(cell):
+                    acc[i] += v
+        out = []
+        for k, cell in sorted(totals.items()):
+            cumulative = 0
+            for i, le in enumerate(list(self.buckets) + [math.inf]):
+                cumulative += cell[i]
+                le_str = "+Inf" if math.isinf(le) else repr(float(le))
+                out.append(f"{self.name}_bucket{_fmt_labels(k, [('le', le_str)])} {int(cumulative)}")
+            out.append(f"{self.name}_sum{_fmt_labels(k)} {_fmt_value(cell[-1])}")
+            out.append(f"{self.name}_count{_fmt_labels(k)} {int(cumulative)}")
+        return out
+
+
+class Gauge:
+    kind = "gauge"
+
+    def __init__(self, name: str, help: str) -> None:
+        self.name, self.help = name, help
+        self._values:    Dict[LabelKey, float] = {}
+        self._callbacks: Dict[LabelKey, Callable[[], float]] = {}
+
+    def set(self, value: float, **labels: object) -> None:
+        self._values[_key(labels)] = value
+
+    def set_function(self, fn: Callable[[], float], **labels: object) -> None:
+        """Evaluate @fn at every scrape (e.g. ``queue.qsize``)."""
+        self._callbacks[_key(labels)] = fn
+
+    def samples(self) -> List[str]:
+        values = dict(self._values)
+        for k, fn in list(self._callbacks.items()):
+            try:
+                values[k] = float(fn())
+            except Exception:   # a broken callback must not break the scrape
+                continue
+        return [f"{self.name}{_fmt_labels(k)} {_fmt_value(v)}" for k, v in sorted(values.items())]
+
+
+class ThreadCpu:
+    """utime/stime of every thread in this process, named after threading.Thread."""
+    kind = "counter"
+
+    def __init__(self, name: str = "gesturelink_thread_cpu_seconds_total") -> None:
+        self.name = name
+        self.help = "CPU time consumed per thread."
+
+    def samples(self) -> List[str]:
+        names = {t.native_id: t.name for t in threading.enumerate() if t.native_id}
+        tick  = os.sysconf("SC_CLK_TCK")
+        out   = []
+        try:
+            tids = sorted(os.listdir("/proc/self/task"), key=int)
+        except OSError:
+            return out
+        for tid in tids:
+            try:
+                stat = Path(f"/proc/self/task/{tid}/stat").read_text()
+            except OSError:
+                continue
+            comm   = stat[stat.index("(") + 1:stat.rindex(")")]
+            fields = stat[stat.rindex(")") + 2:].split()
+            utime, stime = int(fields[11]), int(fields[12])
+            thread = names.get(int(tid), comm)
+            for mode, ticks in (("user", utime), ("system", stime)):
+                labels = _fmt_labels((("tid", tid), ("thread", thread), ("mode", mode)))
+                out.append(f"{self.name}{labels} {ticks / tick:.2f}")
+        return out
+
+
+# ---- Registry ----------------------------------------------------------------
+
+class Registry:
+    def __init__(self) -> None:
+        self._metrics: List[object] = []
+        self._lock = threading.Lock()
+
+    def register(self, metric):
+        with self._lock:
+            self._metrics.append(metric)
+        return metric
+
+    def render(self) -> str:
+        with self._lock:
+            metrics = list(self._metrics)
+        lines = []
+        for m in metrics:
+            lines.append(f"# HELP {m.name} {m.help}")
+            lines.append(f"# TYPE {m.name} {m.kind}")
+            lines.extend(m.samples())
+        return "\n".join(lines) + "\n"
+
+
+REGISTRY = Registry()
+REGISTRY.register(ThreadCpu())
+
+
+def counter(name: str, help: str, registry: Registry = REGISTRY) -> Counter:
+    return registry.register(Counter(name, help))
+
+
+def gauge(name: str, help: str, registry: Registry = REGISTRY) -> Gauge:
+    return registry.register(Gauge(name, help))
+
+
+def histogram(name: str, help: str, buckets: Sequence[float] = DEFAULT_LATENCY_BUCKETS,
+              registry: Registry = REGISTRY) -> Histogram:
+    return registry.register(Histogram(name, help, buckets))
+
+
+# ---- Exporter ----------------------------------------------------------------
+
+def _handler(registry: Registry):
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self) -> None:   # noqa: N802
+            if self.path not in ("/", "/metrics"):
+                self.send_error(404, "try GET /metrics")
+                return
+            body = registry.render().encode()
+            self.send_response(200)
+            self.send_header("Content-Type", CONTENT_TYPE)
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, *args) -> None:   # keep stderr for the pipeline
+            pass
+
+        def address_string(self) -> str:
+            return "unix" if isinstance(self.client_address, str) else super().address_string()
+
+    return Handler
+
+
+class _UnixHTTPServer(socketserver.ThreadingMixIn, socketserver.UnixStreamServer):
+    daemon_threads = True
+
+    def server_bind(self) -> None:
+        socketserver.UnixStreamServer.server_bind(self)
+        self.server_name, self.server_port = "localhost", 0
+
+
+class Exporter:
+    """Serves a registry until close(); created by serve()."""
+
+    def __init__(self, server: socketserver.BaseServer, unix_path: Optional[str]) -> None:
+        self.server    = server
+        self.unix_path = unix_path
+        self.address   = unix_path if unix_path else server.server_address
+        self._thread   = threading.Thread(target=server.serve_forever, name="MetricsExporter",
+                                          kwargs={"poll_interval": 0.2}, daemon=True)
+        self._thread.start()
+
+    def close(self) -> None:
+        self.server.shutdown()
+        self.server.server_close()
+        self._thread.join(timeout=2)
+        if self.unix_path:
+            try:
+                os.unlink(self.unix_path)
+            except OSError:
+                pass
+
+
+def serve(endpoint: str, registry: Registry = REGISTRY) -> Exporter:
+    """
+    Start exporting @registry.  @endpoint is ``unix:/path`` or a loopback
+    ``[127.x.x.x:]port`` (port 0 picks a free one; see Exporter.address).
+    Raises ValueError for non-loopback addresses and OSError if binding fails
+    (FileExistsError if the unix: path exists and is not a socket).
+    """
+    handler = _handler(registry)
+    if endpoint.startswith("unix:"):
+        path = endpoint[len("unix:"):]
+        try:
+            mode = os.lstat(path).st_mode
+        except FileNotFoundError:
+            mode = None
+        if mode is not None:
+            # Replace a stale socket, but never delete anything else a typo names
+            if not stat.S_ISSOCK(mode):
+                raise FileExistsError(f"metrics endpoint {path!r} exists and is not a socket")
+            os.unlink(path)
+        return Exporter(_UnixHTTPServer(path, handler), path)
+
+    host, _, port = endpoint.rpartition(":")
+    host = host or "127.0.0.1"
+    if not socket.inet_aton(host)[0] == 127:
+        raise ValueError(f"metrics endpoint must be loopback or unix:, got {endpoint!r}")
+    server = ThreadingHTTPServer((host, int(port)), handler)
+    server.daemon_threads = True
+    return Exporter(server, None)
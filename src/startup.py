@@ -0,0 +1,157 @@
+"""
+startup.py
+Startup timeline: which initialisation phase ran when, on which thread, and
+how long it took from launch to "ready" and to the first command.
+
+    timeline = StartupTimeline()
+    with timeline.phase("camera_open"):
+        cap = cv2.VideoCapture(...)
+    timeline.mark("first_command")
+    print(timeline.report())
+
+Times are seconds since the process was exec'd (start time from
+/proc/self/stat), so interpreter start-up and module imports before main()
+are part of the picture.  run_concurrently() runs independent phases on
+their own threads for main.py's --warm-start mode.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Callable, Dict, Iterator, List, Optional
+
+
+def process_age() -> float:
+    """Seconds since this process was exec'd (0.0 if /proc is unavailable)."""
+    try:
+        stat = Path("/proc/self/stat").read_text()
+        start_ticks = int(stat[stat.rindex(")") + 2:].split()[19])
+        age = time.clock_gettime(time.CLOCK_BOOTTIME) - start_ticks / os.sysconf("SC_CLK_TCK")
+        return max(0.0, age)
+    except (OSError, ValueError, IndexError, AttributeError):
+        return 0.0
+
+
+@dataclass
+class Phase:
+    name:   str
+    start:  float           # seconds since launch
+    end:    float
+    thread: str
+    detail: str = ""
+
+    @property
+    def duration(self) -> float:
+        return self.end - self.start
+
+
+class StartupTimeline:
+    """Thread-safe record of startup phases and one-off milestones."""
+
+    def __init__(self, clock: Callable[[], float] = time.monotonic,
+                 age: Optional[float] = None) -> None:
+        self._clock  = clock
+        self._origin = clock() - (process_age() if age is None else age)
+        self._lock   = threading.Lock()
+        self.phases: List[Phase] = []
+        self.marks:  Dict[str, float] = {}
+
+    def now(self) -> float:
+        """Seconds since launch."""
+        return self._clock() - self._origin
+
+    @contextmanager
+    def phase(self, name: str, detail: str = "") -> Iterator[None]:
+        start = self.now()
+        try:
+            yield
+        finally:
+            self.add(name, start, self.now(), detail=detail)
+
+    def add(self, name: str, start: float, end: float, thread: Optional[str] = None,
+            detail: str = "") -> None:
+        """Record a phase measured elsewhere (e.g. by the driver process)."""
+        p = Phase(name, start, end, thread or threading.current_thread().name, detail)
+        with self._lock:
+            self.phases.append(p)
+
+    def mark(self, name: str) -> bool:
+        """Record a milestone the first time it happens; returns True then."""
+        with self._lock:
+            if name in self.marks:
+                return False
+            self.marks[name] = self.now()
+            return True
+
+    # ---- Reporting ----------------------------------------------------------
+
+    def report(self, width: int = 40) -> str:
+        with self._lock:
+            phases = sorted(self.phases, key=lambda p: p.start)
+            marks  = sorted(self.marks.items(), key=lambda kv: kv[1])
+        span  = max([p.end for p in phases] + [t for _, t in marks] + [1e-3])
+        scale = width / span
+        lines = [f"{'phase':<22}{'thread':<18}{'start ms':>9}{'dur ms':>9}  timeline"]
+        for p in phases:
+            a   = int(p.start * scale)
+            bar = " " * a + "█" * max(1, int(p.end * scale) - a)
+            lines.append(f"{p.name:<22}{p.thread[:17]:<18}{p.start * 1e3:>9.1f}"
+                         f"{p.duration * 1e3:>9.1f}  {bar:<{width}}"
+                         + (f"  {p.detail}" if p.detail else ""))
+        for name, t in marks:
+            lines.append(f"{'→ ' + name:<22}{'':<18}{t * 1e3:>9.1f}{'':>9}  "
+                         f"{' ' * min(width - 1, int(t * scale))}▲")
+        return "\n".join(lines)
+
+    def to_dict(self) -> dict:
+        with self._lock:
+            return {
+                "phases": [{"name": p.name, "thread": p.thread, "detail": p.detail,
+                            "start_ms": round(p.start * 1e3, 3),
+                            "duration_ms": round(p.duration * 1e3, 3)}
+                           for p in sorted(self.phases, key=lambda p: p.start)],
+                "marks_ms": {k: round(v * 1e3, 3) for k, v in self.marks.items()},
+            }
+
+    def write(self, path: Path) -> Path:
+        path = Path(path)
+        path.parent.mkdir(parents=True, exist_ok=True)
+        path.write_text(json.dumps(self.to_dict(), indent=1))
+        return path
+
+
+def run_concurrently(tasks: Dict[str, Callable[[], object]],
+                     timeline: Optional[StartupTimeline] = None) -> Dict[str, object]:
+    """
+    Run independent initialisation @tasks on one thread each and wait for
+    all of them.  Each task is recorded as a timeline phase; the first
+    exception is re-raised after every task has finished.
+    """
+    out:    Dict[str, object] = {}
+    errors: List[BaseException] = []
+
+    def _run(name: str, fn: Callable[[], object]) -> None:
+        try:
+            if timeline is not None:
+                with timeline.phase(name):
+                    out[name] = fn()
+            else:
+                out[name] = fn()
+        except BaseException as e:        # re-raised on the caller's thread
+            errors.append(e)
+
+    threads = [threading.Thread(target=_run, args=(name, fn), name=f"Warm-{name}", daemon=True)
+               for name, fn in tasks.items()]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    if errors:
+        raise errors[0]
+    return out
@@ -1,5 +1,6 @@
 """GestureLink vision package."""
 from .gesture_detector import GestureDetector, HandResult, Landmark
 from .gesture_mapper import GestureMapper
+from .pen_mapper import PenMapper
 
-__all__ = ["GestureDetector", "HandResult", "Landmark", "GestureMapper"]
+__all__ = ["GestureDetector", "HandResult", "Landmark", "GestureMapper", "PenMapper"]
@@ -1,7 +1,18 @@
 """
 gesture_detector.py
 Real-time hand landmark detection using the MediaPipe Tasks HandLandmarker API
-(mediapipe >= 0.10).  Runs in a dedicated thread, publishing results via a queue.
+(mediapipe >= 0.10).  Runs in a dedicated thread, publishing one HandFrame per
+processed camera frame via a queue, so every hand seen together is mapped
+together and a frame without a hand explicitly reports the hand as lost.
+
+Start-up is split into phases (load_landmarker, open_camera, warm_up) that
+the thread runs in order on first start(); main.py's --warm-start calls them
+concurrently beforehand instead.  Each phase is recorded on an optional
+StartupTimeline.
+
+With an IdleController (src/idle.py) attached, the loop drops the camera to
+the idle rate and resolution once no hand has been seen for a while and
+restores it on the first frame that has one.
 """
 
 from __future__ import annotations
@@ -9,12 +20,16 @@ from __future__ import annotations
 import queue
 import threading
 import time
+from contextlib import nullcontext
 from dataclasses import dataclass, field
 from pathlib import Path
 from typing import List, Optional, Tuple
 
 import cv2
 
+from ..idle import ACTIVE, IDLE, IdleController
+from ..startup import StartupTimeline
+
 # ---------------------------------------------------------------------------
 # MediaPipe landmark indices (fixed across all API versions)
 # ---------------------------------------------------------------------------
@@ -115,10 +130,21 @@ class HandResult:
         return lm.x, lm.y
 
 
+@dataclass
+class HandFrame:
+    """Every hand detected in one camera frame, published as a single item.
+
+    No hands means the frame was processed and none was seen.
+    """
+    frame_id: int
+    hands: List[HandResult]
+    timestamp_ms: float = field(default_factory=lambda: time.monotonic() * 1000)
+
+
 class GestureDetector:
     """
     Captures frames from a camera, detects hand landmarks,
-    and puts HandResult objects into an output queue.
+    and puts one HandFrame per processed frame into an output queue.
     """
 
     def __init__(
@@ -130,6 +156,8 @@ class GestureDetector:
         output_queue: Optional[queue.Queue] = None,
         frame_width: int = 640,
         frame_height: int = 480,
+        timeline: Optional[StartupTimeline] = None,
+        idle: Optional[IdleController] = None,
     ) -> None:
         self.camera_index = camera_index
         self.max_hands = max_hands
@@ -146,6 +174,16 @@ class GestureDetector:
         self._latest_frame: Optional[cv2.typing.MatLike] = None
         self._frame_lock = threading.Lock()
 
+        # Start-up phases (see load_landmarker / open_camera / warm_up)
+        self.timeline    = timeline
+        self._landmarker = None
+        self._mp_image   = None          # (Image, ImageFormat) from mediapipe
+        self._cap: Optional[cv2.VideoCapture] = None
+        self._last_ts_ms = 0
+        self._frame_id   = 0
+
+        self.idle = idle
+
     # ------------------------------------------------------------------ public
 
     def start(self) -> None:
@@ -169,18 +207,20 @@ class GestureDetector:
         with self._frame_lock:
             return self._latest_frame
 
-    # ----------------------------------------------------------------- private
-
-    def _run(self) -> None:
+    def load_landmarker(self) -> None:
+        """Import MediaPipe and create the HandLandmarker (model load)."""
+        if self._landmarker is not None:
+            return
         # Lazy imports – only needed at runtime, not during unit tests
-        from mediapipe.tasks.python.core.base_options import BaseOptions
-        from mediapipe.tasks.python.vision.hand_landmarker import (
-            HandLandmarker, HandLandmarkerOptions,
-        )
-        from mediapipe.tasks.python.vision.core.vision_task_running_mode import (
-            VisionTaskRunningMode,
-        )
-        from mediapipe.tasks.python.vision.core.image import Image as MpImage, ImageFormat
+        with self._phase("mediapipe_import"):
+            from mediapipe.tasks.python.core.base_options import BaseOptions
+            from mediapipe.tasks.python.vision.hand_landmarker import (
+                HandLandmarker, HandLandmarkerOptions,
+            )
+            from mediapipe.tasks.python.vision.core.vision_task_running_mode import (
+                VisionTaskRunningMode,
+            )
+            from mediapipe.tasks.python.vision.core.image import Image as MpImage, ImageFormat
 
         # Resolve model path relative to this file (repo_root/models/)
         _repo_root = Path(__file__).parent.parent.parent
@@ -202,23 +242,86 @@ class GestureDetector:
             min_hand_presence_confidence=self.det_conf,
             min_tracking_confidence=self.trk_conf,
         )
+        with self._phase("model_load"):
+            self._landmarker = HandLandmarker.create_from_options(options)
+        self._mp_image = (MpImage, ImageFormat)
+
+    def open_camera(self) -> None:
+        """Open and configure the camera and wait for its first frame."""
+        if self._cap is not None:
+            return
+        with self._phase("camera_open"):
+            # Use V4L2 directly – the GStreamer backend often fails after
+            # an unclean shutdown or on Fedora with missing plugins.
+            cap = cv2.VideoCapture(self.camera_index, cv2.CAP_V4L2)
+            if not cap.isOpened():
+                # Fallback: let OpenCV auto-detect backend
+                cap = cv2.VideoCapture(self.camera_index)
+            if not cap.isOpened():
+                raise RuntimeError(f"Cannot open camera index {self.camera_index}")
+
+            self._configure_capture(cap, self.frame_w, self.frame_h, 60)
+        with self._phase("camera_first_frame"):
+            cap.read()                   # sensors often take 100s of ms to stream
+        self._cap = cap
+
+    def warm_up(self) -> None:
+        """Run one dummy inference so the first real frame is not the slow one."""
+        import numpy as np
+        self.load_landmarker()
+        MpImage, ImageFormat = self._mp_image
+        blank = np.zeros((self.frame_h, self.frame_w, 3), dtype=np.uint8)
+        with self._phase("warmup_inference"):
+            self._landmarker.detect_for_video(
+                MpImage(image_format=ImageFormat.SRGB, data=blank), self._next_ts_ms())
+
+    @property
+    def prepared(self) -> bool:
+        return self._landmarker is not None and self._cap is not None
+
+    # ----------------------------------------------------------------- private
+
+    def _phase(self, name: str):
+        return self.timeline.phase(name) if self.timeline is not None else nullcontext()
+
+    @staticmethod
+    def _configure_capture(cap: cv2.VideoCapture, width: int, height: int, fps: float) -> None:
+        cap.set(cv2.CAP_PROP_FRAME_WIDTH,  width)
+        cap.set(cv2.CAP_PROP_FRAME_HEIGHT, height)
+        cap.set(cv2.CAP_PROP_FPS, fps)
+
+    def _apply_idle_change(self, cap: cv2.VideoCapture, change: Optional[str]) -> None:
+        if change == IDLE:
+            self._configure_capture(cap, *self.idle.idle_size, self.idle.idle_fps)
+        elif change == ACTIVE:
+            self._configure_capture(cap, self.frame_w, self.frame_h, 60)
+
+    def _next_ts_ms(self) -> int:
+        # VIDEO mode needs strictly increasing timestamps across warm-up and run
+        self._last_ts_ms = max(self._last_ts_ms + 1, int(time.monotonic() * 1000))
+        return self._last_ts_ms
+
+    def _publish(self, frame: HandFrame) -> None:
+        # Drop the oldest frame rather than block the camera loop
+        try:
+            self.out_q.put_nowait(frame)
+        except queue.Full:
+            try:
+                self.out_q.get_nowait()
+            except queue.Empty:
+                pass
+            self.out_q.put_nowait(frame)
+
+    def _run(self) -> None:
+        self.load_landmarker()
+        self.open_camera()
+        MpImage, ImageFormat = self._mp_image
+        cap, landmarker = self._cap, self._landmarker
+        idle = self.idle
 
-        # Use V4L2 directly – the GStreamer backend often fails after
-        # an unclean shutdown or on Fedora with missing plugins.
-        cap = cv2.VideoCapture(self.camera_index, cv2.CAP_V4L2)
-        if not cap.isOpened():
-            # Fallback: let OpenCV auto-detect backend
-            cap = cv2.VideoCapture(self.camera_index)
-        if not cap.isOpened():
-            raise RuntimeError(f"Cannot open camera index {self.camera_index}")
-
-        cap.set(cv2.CAP_PROP_FRAME_WIDTH,  self.frame_w)
-        cap.set(cv2.CAP_PROP_FRAME_HEIGHT, self.frame_h)
-        cap.set(cv2.CAP_PROP_FPS, 60)
-
-        with HandLandmarker.create_from_options(options) as landmarker:
-            frame_idx = 0
+        try:
             while not self._stop_event.is_set():
+                grabbed = idle.now() if idle is not None else 0.0
                 ok, frame = cap.read()
                 if not ok:
                     continue
@@ -229,12 +332,17 @@ class GestureDetector:
 
                 # Create MediaPipe image
                 mp_image = MpImage(image_format=ImageFormat.SRGB, data=rgb)
-                timestamp_ms = int(time.monotonic() * 1000) + frame_idx
-                frame_idx += 1
+                detection = landmarker.detect_for_video(mp_image, self._next_ts_ms())
+                self._frame_id += 1
+                if self.timeline is not None:
+                    self.timeline.mark("first_frame_processed")
 
-                detection = landmarker.detect_for_video(mp_image, timestamp_ms)
+                # Decide before publishing so consumers see ACTIVE with the hand
+                hand_seen = bool(detection.hand_landmarks)
+                change    = idle.observe(hand_seen, grabbed) if idle is not None else None
 
-                if detection.hand_landmarks:
+                hands: List[HandResult] = []
+                if hand_seen:
                     for hand_lm_list, hand_info_list in zip(
                         detection.hand_landmarks,
                         detection.handedness,
@@ -261,24 +369,31 @@ class GestureDetector:
                             hand_info_list[0].category_name
                             if hand_info_list else "Right"
                         )
-                        result = HandResult(
+                        hands.append(HandResult(
                             landmarks=lm_list,
                             handedness=handedness,
-                        )
+                        ))
 
-                        try:
-                            self.out_q.put_nowait(result)
-                        except queue.Full:
-                            try:
-                                self.out_q.get_nowait()
-                            except queue.Empty:
-                                pass
-                            self.out_q.put_nowait(result)
+                # Published even without a hand: an empty frame is how consumers
+                # learn the hand left, rather than from a slow queue.
+                self._publish(HandFrame(self._frame_id, hands))
 
                 with self._frame_lock:
                     self._latest_frame = frame.copy()
 
-        cap.release()
+                if idle is None:
+                    continue
+                if change is not None:
+                    self._apply_idle_change(cap, change)
+                elif hand_seen:
+                    idle.result_published()
+                if idle.idle:
+                    # Cameras that ignore CAP_PROP_FPS are throttled here instead
+                    self._stop_event.wait(max(0.0, idle.frame_period - (idle.now() - grabbed)))
+        finally:
+            landmarker.close()
+            cap.release()
+            self._landmarker, self._cap = None, None
 
 
 # Minimal hand connection pairs for drawing (subset of the 21-point skeleton)
@@ -12,21 +12,30 @@ hand poses during transitions.
 Supported Gestures  (highest → lowest priority)
 ------------------------------------------------
   Pinch            – thumb+index tips close  → left click
-  Fist             – 0 fingers extended      → GAMEPAD_BTN A (hold)
+  Fist             – 0 fingers extended      → GAMEPAD_BTN A (hold), or
+                                               GAMEPAD_TURBO A (autofire)
   V-sign           – index+middle only       → right click
   Three fingers    – index+middle+ring only  → GAMEPAD_STICK
   Open palm        – all 5 extended          → GAMEPAD_BTN START (one-shot)
   Thumb scroll     – thumb+index extended    → scroll up/down
   Pointer          – index extended           → mouse move
   Idle             – anything else            → (no output)
+
+When the cursor stops following the hand (a gesture that does not track
+it, or the hand is lost) MOUSE_RELEASE is sent once, so the driver can let
+a flicked cursor coast (HID_DRIVER_INERTIA_FRICTION).
+
+With ``turbo_hz`` set, a held fist autofires A at that rate instead of
+holding it: the driver times the presses (GAMEPAD_TURBO), so they do not
+depend on the camera frame rate.  Losing the hand stops the autofire.
 """
 
 from __future__ import annotations
 
 import math
 import time
-from dataclasses import dataclass, field
-from typing import List, Optional
+from dataclasses import dataclass
+from typing import Callable, List, Optional
 
 from .gesture_detector import HandResult, LM
 
@@ -41,6 +50,7 @@ SCREEN_SMOOTHING       = 0.40    # EWM alpha  (higher = more responsive, more ji
 STICK_SMOOTHING        = 0.35    # EWM alpha for gamepad stick
 STICK_DEADZONE         = 0.08    # normalised dead-zone radius around centre
 CONFIRM_FRAMES         = 3       # consecutive frames before a gesture activates
+TURBO_DUTY_PCT         = 50      # share of each autofire period A is held
 
 
 # ---- Gesture identifiers (used for frame-count confirmation) ------------------
@@ -67,17 +77,19 @@ class _MappingState:
     stick_y: float = 0.0
     # Pinch hysteresis
     pinching: bool = False
+    # Cursor follows the hand (pointer, pinch, V-sign); MOUSE_RELEASE when it stops
+    tracking: bool = False
     # Gamepad hold states
     fist_held: bool = False
     # Gesture confirmation counter
     pending_gesture: str = _G_IDLE
     pending_count: int = 0
     active_gesture: str  = _G_IDLE
-    # Cooldown timestamps (far in the past so first event fires immediately)
-    last_click_t: float  = field(default_factory=lambda: time.monotonic() - 10.0)
-    last_rclick_t: float = field(default_factory=lambda: time.monotonic() - 10.0)
-    last_scroll_t: float = field(default_factory=lambda: time.monotonic() - 10.0)
-    last_start_t: float  = field(default_factory=lambda: time.monotonic() - 10.0)
+    # Cooldown timestamps (-inf so the first event fires immediately on any clock)
+    last_click_t: float  = -math.inf
+    last_rclick_t: float = -math.inf
+    last_scroll_t: float = -math.inf
+    last_start_t: float  = -math.inf
 
 
 def _classify(hand: HandResult) -> str:
@@ -131,11 +143,17 @@ class GestureMapper:
     detected gesture runs.  A gesture must win ``CONFIRM_FRAMES``
     consecutive classification rounds before its action fires, preventing
     spurious triggers during hand transitions.
+
+    Cooldowns are measured on ``clock`` (seconds, monotonic); pass a
+    ``src.clock.SimulatedClock`` for deterministic tests.
     """
 
-    def __init__(self, screen_w: int = 1920, screen_h: int = 1080) -> None:
+    def __init__(self, screen_w: int = 1920, screen_h: int = 1080,
+                 clock: Callable[[], float] = time.monotonic, turbo_hz: int = 0) -> None:
         self.screen_w = screen_w
         self.screen_h = screen_h
+        self.turbo_hz = turbo_hz
+        self._clock = clock
         self._state = _MappingState()
 
     def map(self, hand: HandResult) -> List[str]:
@@ -144,7 +162,7 @@ class GestureMapper:
         driver command strings.
         """
         commands: List[str] = []
-        now = time.monotonic()
+        now = self._clock()
         s   = self._state
 
         # ── 1. Classify this frame ───────────────────────────────────────
@@ -165,12 +183,17 @@ class GestureMapper:
 
         # ── 3. Release held state when gesture changes ───────────────────
         if active != _G_FIST and s.fist_held:
-            commands.append("GAMEPAD_BTN A 0")
+            commands.append("GAMEPAD_TURBO A 0" if self.turbo_hz else "GAMEPAD_BTN A 0")
             s.fist_held = False
 
         if active != _G_PINCH and s.pinching:
             s.pinching = False
 
+        tracking = active in (_G_POINTER, _G_PINCH, _G_V_SIGN)
+        if s.tracking and not tracking:
+            commands.append("MOUSE_RELEASE")
+        s.tracking = tracking
+
         # ── 4. Execute the active gesture ────────────────────────────────
 
         # --- Pointer (mouse move) ----------------------------------------
@@ -189,7 +212,8 @@ class GestureMapper:
         # --- Fist (gamepad A hold) ---------------------------------------
         elif active == _G_FIST:
             if not s.fist_held:
-                commands.append("GAMEPAD_BTN A 1")
+                commands.append(f"GAMEPAD_TURBO A {self.turbo_hz} {TURBO_DUTY_PCT}" if self.turbo_hz
+                                else "GAMEPAD_BTN A 1")
                 s.fist_held = True
 
         # --- V-sign (right click, one-shot per cooldown) -----------------
@@ -219,6 +243,18 @@ class GestureMapper:
 
         return commands
 
+    def lost(self) -> List[str]:
+        """Commands for a frame without a hand: let go of the cursor once, stop autofire."""
+        s = self._state
+        commands: List[str] = []
+        if s.tracking:
+            s.tracking = False
+            commands.append("MOUSE_RELEASE")
+        if s.fist_held and self.turbo_hz:
+            s.fist_held = False
+            commands.append("GAMEPAD_TURBO A 0")
+        return commands
+
     # ── Helpers ──────────────────────────────────────────────────────────────
 
     def _do_pointer(self, hand: HandResult) -> List[str]:
@@ -0,0 +1,133 @@
+"""
+gyro_mapper.py
+Maps hand orientation changes to GYRO commands for hid_driver's virtual
+motion sensor (``main.py --gyro``), for games with gyro aiming.
+
+The palm is the controller body:
+  Orientation  – a right-handed frame built from the wrist and the index,
+                 middle and pinky knuckles (across the palm, up the palm,
+                 out of the palm), in camera space: x right, y up, z towards
+                 the camera, with y rescaled from image rows to x units
+  Rate         – the rotation between two frames' orientations (log map of
+                 R_cur · R_prevᵀ) divided by the time between them, in deg/s
+                 about the camera axes: rx pitch, ry yaw, rz roll
+
+Camera frames arrive at 30–60 Hz; consumers expect gyro reports at 250 Hz
+or more, so the driver upsamples: it glides between the rates sent here and
+reports at its own tick (HID_DRIVER_GYRO_TICK_US, 500 Hz by default) with an
+MSC_TIMESTAMP on every report.  Rates are smoothed and small ones dropped
+so a resting hand does not drift the aim; the sensor stops (GYRO OFF)
+when the hand is lost.
+"""
+
+from __future__ import annotations
+
+import math
+from typing import List, Optional, Tuple
+
+from .gesture_detector import HandResult, LM
+
+
+# ---- Tunable thresholds -------------------------------------------------------
+
+GYRO_SMOOTHING = 0.60    # EWM alpha for the rates; the driver's glide smooths the rest
+GYRO_DEADBAND  = 3.0     # deg/s; smaller rates are landmark jitter on a still hand
+GYRO_MAX_GAP   = 0.20    # s; a longer gap between frames restarts the estimate
+GYRO_MAX_DPS   = 2000    # VirtualHID::kGyroMaxDps
+FRAME_ASPECT   = 480 / 640   # GestureDetector frame height / width
+
+Vec = Tuple[float, float, float]
+Mat = Tuple[Vec, Vec, Vec]       # rows
+
+
+def _sub(a: Vec, b: Vec) -> Vec:
+    return (a[0] - b[0], a[1] - b[1], a[2] - b[2])
+
+
+def _unit(v: Vec) -> Vec:
+    n = math.sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) or 1e-12
+    return (v[0] / n, v[1] / n, v[2] / n)
+
+
+def _cross(a: Vec, b: Vec) -> Vec:
+    return (a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0])
+
+
+def hand_orientation(hand: HandResult, aspect: float = FRAME_ASPECT) -> Mat:
+    """
+    Rotation matrix of the palm in camera space, as rows (x, y, z) whose
+    columns are the palm axes: across (index → pinky knuckle), up (wrist →
+    middle knuckle) and the palm normal.
+    """
+    def cam(idx: int) -> Vec:
+        p = hand.lm(idx)
+        return (p.x, -p.y * aspect, -p.z)
+
+    wrist = cam(LM.WRIST)
+    up    = _unit(_sub(cam(LM.MIDDLE_FINGER_MCP), wrist))
+    side  = _sub(cam(LM.PINKY_MCP), cam(LM.INDEX_FINGER_MCP))
+    d     = side[0] * up[0] + side[1] * up[1] + side[2] * up[2]
+    across = _unit((side[0] - d * up[0], side[1] - d * up[1], side[2] - d * up[2]))
+    normal = _cross(across, up)
+    return ((across[0], up[0], normal[0]),
+            (across[1], up[1], normal[1]),
+            (across[2], up[2], normal[2]))
+
+
+def angular_velocity(r_prev: Mat, r_cur: Mat, dt: float) -> Vec:
+    """Rate (deg/s about camera x, y, z) that turns @r_prev into @r_cur in @dt s."""
+    # d = r_cur · r_prevᵀ, the rotation between the two frames in camera
+    # space; only its trace and antisymmetric part are needed.
+    def dot(i: int, j: int) -> float:
+        a, b = r_cur[i], r_prev[j]
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+    vee = (dot(2, 1) - dot(1, 2), dot(0, 2) - dot(2, 0), dot(1, 0) - dot(0, 1))
+    cos_a = max(-1.0, min((dot(0, 0) + dot(1, 1) + dot(2, 2) - 1.0) / 2.0, 1.0))
+    angle = math.acos(cos_a)
+    s = math.sin(angle)
+    k = angle / (2.0 * s) if s > 1e-6 else 0.5        # small angles: vee / 2
+    scale = math.degrees(k) / dt
+    return (vee[0] * scale, vee[1] * scale, vee[2] * scale)
+
+
+class GyroMapper:
+    """
+    Consumes HandResult objects and emits GYRO command strings; same
+    interface as GestureMapper, plus lost() for frames without a hand.
+    Used alongside another mapper, whose commands it does not touch.
+    """
+
+    def __init__(self, aspect: float = FRAME_ASPECT) -> None:
+        self.aspect = aspect
+        self._prev: Optional[Mat] = None
+        self._prev_ms = 0.0
+        self._rate: List[float] = [0.0, 0.0, 0.0]
+        self._streaming = False
+
+    def map(self, hand: HandResult) -> List[str]:
+        r = hand_orientation(hand, self.aspect)
+        dt = (hand.timestamp_ms - self._prev_ms) / 1000.0
+        prev, self._prev, self._prev_ms = self._prev, r, hand.timestamp_ms
+        if prev is None or not 0.0 < dt <= GYRO_MAX_GAP:
+            # One orientation is no rate: wait for the next frame.
+            self._rate = [0.0, 0.0, 0.0]
+            return []
+
+        w = angular_velocity(prev, r, dt)
+        out = []
+        for i in range(3):
+            self._rate[i] += (w[i] - self._rate[i]) * GYRO_SMOOTHING
+            v = self._rate[i] if abs(self._rate[i]) >= GYRO_DEADBAND else 0.0
+            out.append(max(-GYRO_MAX_DPS, min(v, GYRO_MAX_DPS)))
+        self._streaming = True
+        return [f"GYRO {out[0]:.1f} {out[1]:.1f} {out[2]:.1f}"]
+
+    def lost(self) -> List[str]:
+        """Commands for a frame without a hand: stop the sensor once."""
+        self._prev = None
+        if not self._streaming:
+            return []
+        self._streaming = False
+        return ["GYRO OFF"]
+
@@ -6,13 +6,14 @@ Draws a translucent panel on the camera frame showing:
   • Active HID commands being sent
   • Per-finger extension state (visual indicators)
   • Frames-per-second counter
+  • Rumble a game is playing on the virtual gamepad (strong / weak motor)
 """
 
 from __future__ import annotations
 
 import collections
 import time
-from typing import List, Optional
+from typing import List, Optional, Tuple
 
 import cv2
 import numpy as np
@@ -57,6 +58,10 @@ def classify_gesture(hand: Optional[HandResult], cmds: List[str]) -> str:
             return "Fist  (Btn A Press)"
         if "GAMEPAD_BTN A 0" in c:
             return "Fist Released"
+        if c.startswith("PEN "):
+            return "Pen  (Out)" if c == "PEN OUT" else f"Pen  (Pressure {c.split()[3]})"
+        if c.startswith("POINTER ") and " DOWN " in c:
+            return "Pinch  (Pointer Press)"
 
     # No special command → infer from finger state
     ext = [hand.finger_extended(i) for i in range(5)]
@@ -95,6 +100,7 @@ class HudOverlay:
         self._fps_ts: collections.deque[float] = collections.deque(maxlen=60)
         self._gesture_name: str = "Waiting…"
         self._finger_state: list[bool] = [False] * 5
+        self._rumble: Tuple[float, float] = (0.0, 0.0)
 
     # ── Public API ───────────────────────────────────────────────────────────
 
@@ -102,10 +108,12 @@ class HudOverlay:
         self,
         hand: Optional[HandResult],
         cmds: List[str],
+        rumble: Tuple[float, float] = (0.0, 0.0),
     ) -> None:
         """Feed new frame data (call once per loop iteration)."""
         now = time.monotonic()
         self._fps_ts.append(now)
+        self._rumble = rumble
 
         # Gesture label
         self._gesture_name = classify_gesture(hand, cmds)
@@ -167,6 +175,16 @@ class HudOverlay:
         fps_text = f"FPS: {fps_val:.0f}"
         cv2.putText(frame, fps_text, (15, h - 15), _FONT, 0.55, _CYAN, 1, cv2.LINE_AA)
 
+        # ── Rumble meter (bottom-right, only while a game rumbles) ──────
+        if any(self._rumble):
+            rx, ry = w - 170, h - 62
+            self._draw_panel(frame, rx, ry, 160, 52, alpha=0.65)
+            for i, (label, level) in enumerate(zip(("S", "W"), self._rumble)):
+                by = ry + 12 + i * 20
+                cv2.putText(frame, label, (rx + 8, by + 9), _FONT, 0.4, _GREY, 1, cv2.LINE_AA)
+                cv2.rectangle(frame, (rx + 24, by), (rx + 150, by + 10), _GREY, 1)
+                cv2.rectangle(frame, (rx + 24, by), (rx + 24 + int(126 * level), by + 10), _YELLOW, -1)
+
         return frame
 
     # ── Internals ────────────────────────────────────────────────────────────
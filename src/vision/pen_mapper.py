@@ -0,0 +1,104 @@
+"""
+pen_mapper.py
+Maps HandResult objects to PEN commands for hid_driver's virtual pen tablet
+(``main.py --pen``), for drawing applications.
+
+The index fingertip is the pen nib:
+  Position  – index tip, smoothed, in fractional screen pixels (the driver
+              resolves 1/16 px and glides between samples at its tick rate)
+  Pressure  – how far the tip is pushed ahead of the index knuckle towards
+              the camera (Landmark.z), PEN_DEPTH_HOVER … PEN_DEPTH_FULL → 0 … 4095
+  Tilt      – direction from the tip back to the PIP joint, in degrees from
+              pointing straight at the camera, clamped to ±PEN_TILT_MAX
+
+Hover vs contact is decided in the driver with hysteresis on the pressure
+(kPenContactOn / kPenContactOff in virtual_hid.h), so every producer gets
+the same touch behaviour; this mapper only reports pressure.  The pen is in
+proximity while the index finger is extended and leaves it (PEN OUT) when
+the finger curls or the hand is lost.
+"""
+
+from __future__ import annotations
+
+import math
+from dataclasses import dataclass
+from typing import List
+
+from .gesture_detector import HandResult, LM
+
+
+# ---- Tunable thresholds -------------------------------------------------------
+
+PEN_SMOOTHING          = 0.50    # EWM alpha for position
+PEN_PRESSURE_SMOOTHING = 0.80    # EWM alpha for pressure; light: the driver hysteresis
+                                 # handles contact noise, smoothing only adds latency
+PEN_DEPTH_HOVER        = 0.02    # tip-ahead-of-knuckle depth where pressure starts
+PEN_DEPTH_FULL         = 0.10    # depth for full pressure
+PEN_TILT_MAX           = 60      # degrees
+PEN_MAX_PRESSURE       = 4095    # VirtualHID::kPenMaxPressure
+
+
+@dataclass
+class _PenState:
+    x: float = 0.5
+    y: float = 0.5
+    pressure: float = 0.0
+    in_range: bool = False
+
+
+def pen_pressure(hand: HandResult) -> float:
+    """Normalised pressure (0 … 1) from the index tip's depth ahead of its knuckle."""
+    depth = hand.lm(LM.INDEX_FINGER_MCP).z - hand.lm(LM.INDEX_FINGER_TIP).z
+    p = (depth - PEN_DEPTH_HOVER) / (PEN_DEPTH_FULL - PEN_DEPTH_HOVER)
+    return max(0.0, min(p, 1.0))
+
+
+def pen_tilt(hand: HandResult) -> tuple:
+    """(tilt_x, tilt_y) in whole degrees: where the finger's top leans from the nib."""
+    tip = hand.lm(LM.INDEX_FINGER_TIP)
+    pip = hand.lm(LM.INDEX_FINGER_PIP)
+    toward = max(pip.z - tip.z, 1e-6)          # along the camera axis
+    tx = math.degrees(math.atan2(pip.x - tip.x, toward))
+    ty = math.degrees(math.atan2(pip.y - tip.y, toward))
+    clamp = lambda a: max(-PEN_TILT_MAX, min(round(a), PEN_TILT_MAX))  # noqa: E731
+    return clamp(tx), clamp(ty)
+
+
+class PenMapper:
+    """
+    Consumes HandResult objects and emits PEN command strings; same
+    interface as GestureMapper, plus lost() for frames without a hand.
+    """
+
+    def __init__(self, screen_w: int = 1920, screen_h: int = 1080) -> None:
+        self.screen_w = screen_w
+        self.screen_h = screen_h
+        self._state = _PenState()
+
+    def map(self, hand: HandResult) -> List[str]:
+        s = self._state
+        if not hand.finger_extended(1):
+            return self.lost()
+
+        ix, iy = hand.index_tip_position()
+        p = pen_pressure(hand)
+        if not s.in_range:
+            # Entering proximity: start from the real position, not the last one.
+            s.x, s.y, s.pressure = ix, iy, p
+            s.in_range = True
+        else:
+            s.x        += (ix - s.x) * PEN_SMOOTHING
+            s.y        += (iy - s.y) * PEN_SMOOTHING
+            s.pressure += (p - s.pressure) * PEN_PRESSURE_SMOOTHING
+
+        px = max(0.0, min(s.x * self.screen_w, self.screen_w - 0.01))
+        py = max(0.0, min(s.y * self.screen_h, self.screen_h - 0.01))
+        tx, ty = pen_tilt(hand)
+        return [f"PEN {px:.2f} {py:.2f} {round(s.pressure * PEN_MAX_PRESSURE)} {tx} {ty}"]
+
+    def lost(self) -> List[str]:
+        """Commands for a frame without a usable hand: leave proximity once."""
+        if not self._state.in_range:
+            return []
+        self._state.in_range = False
+        return ["PEN OUT"]
@@ -0,0 +1,105 @@
+"""
+pointer_mapper.py
+Maps HandResult objects to POINTER commands for hid_driver's independent
+virtual pointers (``main.py --pointers``): two-hand cursor control, one
+cursor per hand.
+
+  Pointer id  – by handedness: the left hand drives pointer 0, the right
+                hand pointer 1 (HID_DRIVER_POINTERS must be at least 2)
+  Position    – index tip, smoothed, in screen pixels
+  Left button – pinch (thumb tip to index tip), with the same hysteresis
+                as GestureMapper's click
+
+Both hands of a camera frame go into one POINTER line (map_frame), so the
+driver parses once and writes one frame per pointer that changed.  A hand
+that leaves the frame while pinching releases its button.
+"""
+
+from __future__ import annotations
+
+from dataclasses import dataclass
+from typing import Dict, Iterable, List
+
+from .gesture_detector import HandResult
+from .gesture_mapper import PINCH_CLOSE_THRESHOLD, PINCH_OPEN_THRESHOLD
+
+
+# ---- Tunable thresholds -------------------------------------------------------
+
+POINTER_SMOOTHING = 0.50         # EWM alpha for position
+POINTER_IDS       = {"Left": 0, "Right": 1}
+
+
+@dataclass
+class _PointerState:
+    x: float = 0.5
+    y: float = 0.5
+    tracking: bool = False
+    pressed: bool = False
+
+
+class PointerMapper:
+    """
+    Consumes the HandResults of one camera frame and emits one POINTER
+    command string; map() and lost() give GestureMapper's interface.
+    """
+
+    def __init__(self, screen_w: int = 1920, screen_h: int = 1080) -> None:
+        self.screen_w = screen_w
+        self.screen_h = screen_h
+        self._state: Dict[int, _PointerState] = {pid: _PointerState() for pid in POINTER_IDS.values()}
+
+    def map(self, hand: HandResult) -> List[str]:
+        return self.map_frame([hand])
+
+    def map_frame(self, hands: Iterable[HandResult]) -> List[str]:
+        """One POINTER line for every hand seen in a frame (none if nothing changed)."""
+        items: List[str] = []
+        seen = set()
+        for hand in hands:
+            pid = POINTER_IDS.get(hand.handedness)
+            if pid is None or pid in seen:
+                continue
+            seen.add(pid)
+            items += self._update(pid, hand)
+        for pid in self._state:
+            if pid not in seen:
+                items += self._release(pid)
+        return ["POINTER " + " ".join(items)] if items else []
+
+    def lost(self) -> List[str]:
+        """Commands for a frame without a hand: release whatever is held."""
+        return self.map_frame([])
+
+    # ------------------------------------------------------------------ helpers
+
+    def _update(self, pid: int, hand: HandResult) -> List[str]:
+        s = self._state[pid]
+        ix, iy = hand.index_tip_position()
+        if not s.tracking:
+            # A hand coming back starts from where it is, not where it left.
+            s.x, s.y, s.tracking = ix, iy, True
+        else:
+            s.x += (ix - s.x) * POINTER_SMOOTHING
+            s.y += (iy - s.y) * POINTER_SMOOTHING
+
+        px = max(0, min(round(s.x * self.screen_w), self.screen_w - 1))
+        py = max(0, min(round(s.y * self.screen_h), self.screen_h - 1))
+        items = [f"{pid} {px} {py}"]
+
+        d = hand.pinch_distance()
+        if not s.pressed and d < PINCH_CLOSE_THRESHOLD:
+            s.pressed = True
+            items.append(f"{pid} DOWN LEFT")
+        elif s.pressed and d > PINCH_OPEN_THRESHOLD:
+            s.pressed = False
+            items.append(f"{pid} UP LEFT")
+        return items
+
+    def _release(self, pid: int) -> List[str]:
+        s = self._state[pid]
+        s.tracking = False
+        if not s.pressed:
+            return []
+        s.pressed = False
+        return [f"{pid} UP LEFT"]
@@ -1,9 +1,18 @@
 """
 conftest.py
-Shared pytest fixtures for the GestureLink test suite.
+Shared pytest fixtures for the GestureLink test suite: synthetic hands, and
+hid_driver built once per session and run end to end against its null sink
+with a flight recorder dump to read the written events back.
 """
 
+import os
+import re
+import shutil
+import signal
+import subprocess
 import sys
+import time
+from collections import namedtuple
 from pathlib import Path
 
 # Ensure the repo root is on sys.path so src packages are importable
@@ -13,6 +22,9 @@ import pytest
 from src.vision.gesture_detector import HandResult, Landmark
 from src.vision.gesture_mapper import GestureMapper
 
+DRIVER_DIR = Path(__file__).parent.parent / "src" / "driver"
+DRIVER_OUT = DRIVER_DIR / "build" / "default"          # the driver Makefile's OUT
+
 
 # ---------------------------------------------------------------------------
 # Helpers to build synthetic HandResult objects
@@ -52,6 +64,130 @@ PINKY_TIP      = 20
 PINKY_PIP      = 18
 
 
+def pointing(x: float = 0.5) -> HandResult:
+    """Index extended at @x, other fingers curled."""
+    return make_hand({
+        INDEX_TIP: (x, 0.3, 0.0), INDEX_PIP: (x, 0.45, 0.0), INDEX_MCP: (x, 0.55, 0.0),
+        MIDDLE_TIP: (0.5, 0.7, 0.0), MIDDLE_PIP: (0.5, 0.6, 0.0), MIDDLE_MCP: (0.5, 0.55, 0.0),
+        RING_TIP: (0.5, 0.7, 0.0), RING_PIP: (0.5, 0.6, 0.0), RING_MCP: (0.5, 0.55, 0.0),
+        PINKY_TIP: (0.5, 0.7, 0.0), PINKY_PIP: (0.5, 0.6, 0.0), PINKY_MCP: (0.5, 0.55, 0.0),
+    })
+
+
+def fist() -> HandResult:
+    """Every finger curled."""
+    return make_hand({
+        INDEX_TIP: (0.5, 0.7, 0.0), INDEX_PIP: (0.5, 0.6, 0.0), INDEX_MCP: (0.5, 0.55, 0.0),
+        MIDDLE_TIP: (0.5, 0.7, 0.0), MIDDLE_PIP: (0.5, 0.6, 0.0), MIDDLE_MCP: (0.5, 0.55, 0.0),
+        RING_TIP: (0.5, 0.7, 0.0), RING_PIP: (0.5, 0.6, 0.0), RING_MCP: (0.5, 0.55, 0.0),
+        PINKY_TIP: (0.5, 0.7, 0.0), PINKY_PIP: (0.5, 0.6, 0.0), PINKY_MCP: (0.5, 0.55, 0.0),
+    })
+
+
+def map_all(mapper, hands) -> list:
+    """Every command @mapper emits for @hands, one frame each."""
+    return [c for h in hands for c in mapper.map(h)]
+
+
 @pytest.fixture()
 def default_mapper() -> GestureMapper:
     return GestureMapper(screen_w=1920, screen_h=1080)
+
+
+# ---------------------------------------------------------------------------
+# hid_driver end to end
+# ---------------------------------------------------------------------------
+
+# One input_event from a flight recorder dump: "#E <t_ns> <n> <fd> <type> <code> <value>"
+FlightEvent = namedtuple("FlightEvent", "t_ns fd type code value")
+_EVENT_RE = re.compile(r"^#E (\d+) \d+ (\d+) (\d+) (\d+) (-?\d+)$", re.M)
+
+
+class NullDriver:
+    """A running hid_driver writing its frames to /dev/null (see null_driver)."""
+
+    def __init__(self, binary: Path, flight: Path, env: dict, pass_fds=()) -> None:
+        self.flight = flight
+        self.last = None                     # last line sent
+        self.proc = subprocess.Popen(
+            [str(binary)], stdin=subprocess.PIPE, stderr=subprocess.PIPE, pass_fds=pass_fds,
+            env={"HID_DRIVER_SINK": "null", "HID_DRIVER_FLIGHT_LOG": str(flight), **env})
+        # Until Ready, SIGUSR2 would still kill it rather than dump
+        self._startup = []
+        for raw in self.proc.stderr:
+            self._startup.append(raw.decode(errors="replace"))
+            if "Ready." in self._startup[-1]:
+                break
+
+    def send(self, *lines: str) -> None:
+        """Write protocol lines (newlines added) and flush."""
+        self.proc.stdin.write("".join(f"{line}\n" for line in lines).encode())
+        self.proc.stdin.flush()
+        self.last = lines[-1] if lines else self.last
+
+    def _dump(self, deadline: float) -> str:
+        # Written from the signal handler: wait until it appears and stops growing
+        self.flight.unlink(missing_ok=True)
+        os.kill(self.proc.pid, signal.SIGUSR2)
+        size = -1
+        while time.monotonic() < deadline:
+            time.sleep(0.02)
+            now = self.flight.stat().st_size if self.flight.exists() else -1
+            if now > 0 and now == size:
+                break
+            size = now
+        return self.flight.read_text() if self.flight.exists() else ""
+
+    def finish(self) -> str:
+        """
+        Dump the flight recorder (SIGUSR2) once it holds the last line sent,
+        QUIT, and return stderr; asserts a clean exit.
+        """
+        deadline = time.monotonic() + 5.0
+        while self.last is not None and time.monotonic() < deadline:
+            if self.last in self._dump(deadline).splitlines():
+                break
+        if self.last is None:
+            self._dump(deadline)
+        self.proc.stdin.write(b"QUIT\n")
+        self.proc.stdin.close()
+        err = "".join(self._startup) + self.proc.stderr.read().decode()
+        assert self.proc.wait(timeout=5) == 0, err
+        return err
+
+    def events(self, type: int = None, code: int = None) -> list:
+        """FlightEvents from the dump, optionally only those of @type / @code."""
+        out = [FlightEvent(*map(int, m)) for m in _EVENT_RE.findall(self.flight.read_text())]
+        return [e for e in out if (type is None or e.type == type) and (code is None or e.code == code)]
+
+
+@pytest.fixture(scope="session")
+def driver_bin() -> Path:
+    """hid_driver, built once per session; skips without make and g++."""
+    if shutil.which("make") is None or shutil.which("g++") is None:
+        pytest.skip("needs make and g++ to build hid_driver")
+    build = subprocess.run(["make", "-s", "-C", str(DRIVER_DIR), "hid_driver"],
+                           capture_output=True, text=True)
+    assert build.returncode == 0, build.stderr
+    return DRIVER_OUT / "hid_driver"
+
+
+@pytest.fixture()
+def null_driver(driver_bin, tmp_path):
+    """
+    Starts hid_driver on the null sink: ``null_driver(HID_DRIVER_X="1")``
+    returns a NullDriver whose flight recorder dumps to tmp_path.  Drivers
+    a test leaves running are killed afterwards.
+    """
+    started = []
+
+    def start(pass_fds=(), **env) -> NullDriver:
+        drv = NullDriver(driver_bin, tmp_path / f"driver{len(started)}.flight", env, pass_fds)
+        started.append(drv)
+        return drv
+
+    yield start
+    for drv in started:
+        if drv.proc.poll() is None:
+            drv.proc.kill()
+            drv.proc.wait()
@@ -0,0 +1,47 @@
+#ifndef GESTURELINK_TEST_CHECK_H
+#define GESTURELINK_TEST_CHECK_H
+/*
+ * check.h
+ * Minimal assertion helpers for the native driver tests.
+ *
+ * Each test binary is a plain executable: CHECK() reports failures and
+ * keeps going, check_exit() turns the tally into the process exit code.
+ * Exit code 77 means "skipped" (e.g. no /dev/uinput); the pytest wrapper in
+ * tests/test_driver_native.py maps it to pytest.skip.
+ */
+
+#include <cstdio>
+
+namespace Check {
+
+inline int& failures()
+{
+    static int n = 0;
+    return n;
+}
+
+constexpr int kSkipExitCode = 77;
+
+inline int check_exit(const char* suite)
+{
+    if (failures() == 0) {
+        std::printf("[%s] all checks passed\n", suite);
+        return 0;
+    }
+    std::printf("[%s] %d check(s) FAILED\n", suite, failures());
+    return 1;
+}
+
+} // namespace Check
+
+#define CHECK(cond, ...)                                                     \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            ++Check::failures();                                             \
+            std::printf("%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond); \
+            std::printf(__VA_ARGS__);                                        \
+            std::printf("\n");                                               \
+        }                                                                    \
+    } while (0)
+
+#endif // GESTURELINK_TEST_CHECK_H
@@ -0,0 +1,171 @@
+/*
+ * test_async_log.cpp
+ * Functional tests for the asynchronous hot-path logger (async_log.h).
+ *
+ * The drain thread writes into a pipe that the test reads back after
+ * AsyncLog::stop(), which flushes everything still queued.  The idle check
+ * counts the drain thread's context switches in /proc.
+ */
+
+#include "async_log.h"
+#include "check.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+static std::string read_all(int fd)
+{
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) out.append(buf, static_cast<size_t>(n));
+    return out;
+}
+
+static int count_lines(const std::string& s, std::string_view needle)
+{
+    int n = 0;
+    for (size_t pos = 0; (pos = s.find(needle, pos)) != std::string::npos; pos += needle.size()) ++n;
+    return n;
+}
+
+static uint64_t mono_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/** Voluntary context switches of the "hid_log" drain thread, or -1 if not found. */
+static long drain_switches()
+{
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return -1;
+    long switches = -1;
+    while (const dirent* e = readdir(dir)) {
+        const std::string task = std::string("/proc/self/task/") + e->d_name;
+        std::ifstream comm(task + "/comm");
+        std::string name;
+        if (!std::getline(comm, name) || name != "hid_log") continue;
+        std::ifstream status(task + "/status");
+        for (std::string line; std::getline(status, line);) {
+            if (line.rfind("voluntary_ctxt_switches:", 0) == 0) switches = std::stol(line.substr(24));
+        }
+    }
+    closedir(dir);
+    return switches;
+}
+
+static void log_unknown(std::string_view cmd)
+{
+    HID_LOG(AsyncLog::Level::Warn, "[hid_driver] Unknown command: {}", cmd);
+}
+
+int main()
+{
+    int p[2];
+    if (pipe(p) < 0) {
+        std::printf("pipe() failed: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    fcntl(p[0], F_SETFL, O_NONBLOCK);
+
+    AsyncLog::set_output_fd(p[1]);
+    AsyncLog::set_rate_limit(5);
+    AsyncLog::start();
+
+    // ---- 1. Formatting of every argument kind -------------------------------
+    const std::string owned = "owned";
+    HID_LOG(AsyncLog::Level::Info, "args {} {} {} {} done",
+            -42, 7u, std::string_view("view"), owned);
+    HID_LOG(AsyncLog::Level::Error, "err {}", AsyncLog::Errno{ENOENT});
+    HID_LOG(AsyncLog::Level::Info, "literal {} {}", "cstr", 0.5);
+
+    // ---- 2. Level filter ----------------------------------------------------
+    HID_LOG(AsyncLog::Level::Debug, "debug-hidden");
+    AsyncLog::set_level(AsyncLog::Level::Debug);
+    HID_LOG(AsyncLog::Level::Debug, "debug-shown");
+    AsyncLog::set_level(AsyncLog::Level::Info);
+
+    // ---- 3. Per-site rate limit (5/s) ---------------------------------------
+    for (int i = 0; i < 200; ++i) log_unknown("SPAM");
+
+    // ---- 4. Strings longer than kMaxStringArg are truncated, not overrun -----
+    const std::string long_cmd(100, 'L');
+    HID_LOG(AsyncLog::Level::Warn, "long {}|", long_cmd);
+
+    AsyncLog::stop();
+    const std::string text = read_all(p[0]);
+
+    CHECK(text.find("args -42 7 view owned done\n") != std::string::npos, "output:\n%s", text.c_str());
+    CHECK(text.find("err No such file or directory\n") != std::string::npos, "output:\n%s", text.c_str());
+    CHECK(text.find("literal cstr 0.5\n") != std::string::npos, "output:\n%s", text.c_str());
+    CHECK(text.find("debug-hidden") == std::string::npos, "debug record below level was logged");
+    CHECK(text.find("debug-shown") != std::string::npos, "debug record missing after set_level");
+
+    // A second boundary during the loop can open one extra window.
+    const int spam = count_lines(text, "Unknown command: SPAM");
+    CHECK(spam >= 5 && spam <= 10, "%d rate-limited lines, expected 5..10", spam);
+    CHECK(text.find("long " + std::string(AsyncLog::kMaxStringArg, 'L') + "|\n") != std::string::npos,
+          "long string not truncated to %zu bytes", AsyncLog::kMaxStringArg);
+
+    // ---- 5. JSON output -----------------------------------------------------
+    AsyncLog::set_json(true);
+    AsyncLog::start();
+    HID_LOG(AsyncLog::Level::Warn, "quote \" and {}", std::string_view("back\\slash"));
+    AsyncLog::stop();
+    const std::string json = read_all(p[0]);
+    CHECK(json.rfind("{\"t_ns\":", 0) == 0, "json output:\n%s", json.c_str());
+    CHECK(json.find("\"level\":\"warn\"") != std::string::npos, "json output:\n%s", json.c_str());
+    CHECK(json.find("\"site\":\"test_async_log.cpp:") != std::string::npos, "json output:\n%s", json.c_str());
+    CHECK(json.find("\"msg\":\"quote \\\" and back\\\\slash\"}") != std::string::npos,
+          "json output:\n%s", json.c_str());
+    AsyncLog::set_json(false);
+
+    // ---- 6. An idle drain thread parks until a record arrives ---------------
+    // With a one-minute fallback the thread only wakes when a record is
+    // submitted (or stop() is called), not on a polling interval.
+    AsyncLog::set_drain_interval_ms(60000);
+    AsyncLog::start();
+    usleep(50000);                                           // let it park
+    const long parked = drain_switches();
+    usleep(300000);
+    const long idle_wakes = drain_switches() - parked;
+    CHECK(parked >= 0 && idle_wakes <= 1, "drain thread woke %ld times in 300 ms idle", idle_wakes);
+    const uint64_t t0 = mono_ns();
+    HID_LOG(AsyncLog::Level::Warn, "wake {}", 1);
+    std::string woke;
+    while (woke.find("wake 1\n") == std::string::npos && mono_ns() - t0 < 2000000000ull) {
+        woke += read_all(p[0]);
+        usleep(1000);
+    }
+    const double wake_ms = static_cast<double>(mono_ns() - t0) / 1e6;
+    CHECK(woke.find("wake 1\n") != std::string::npos && wake_ms < 500, "record written after %.1f ms", wake_ms);
+    AsyncLog::stop();
+    const double stop_ms = static_cast<double>(mono_ns() - t0) / 1e6 - wake_ms;
+    CHECK(stop_ms < 500, "stop() took %.1f ms with a parked drain thread", stop_ms);
+    std::printf("[test_async_log] idle drain: %ld wake-ups in 300 ms, record out in %.2f ms\n", idle_wakes,
+                wake_ms);
+    AsyncLog::set_drain_interval_ms(1000);
+
+    // ---- 7. A full ring drops instead of blocking ---------------------------
+    // No drain thread is running now, so the ring fills and further records
+    // are counted as dropped.
+    AsyncLog::set_rate_limit(1000000);
+    const uint64_t dropped_before = AsyncLog::dropped();
+    for (size_t i = 0; i < AsyncLog::kRingCapacity + 100; ++i) {
+        HID_LOG(AsyncLog::Level::Warn, "fill {}", i);
+    }
+    CHECK(AsyncLog::dropped() - dropped_before >= 100, "%llu dropped, expected >= 100",
+          static_cast<unsigned long long>(AsyncLog::dropped() - dropped_before));
+
+    close(p[0]);
+    close(p[1]);
+    return Check::check_exit("test_async_log");
+}
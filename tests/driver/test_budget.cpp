@@ -0,0 +1,247 @@
+/*
+ * test_budget.cpp
+ * Allocation and syscall budget regression tests for the driver dispatch path.
+ *
+ * A fixed command stream is pushed through HidDriver::dispatch() with every
+ * virtual device pointed at a SOCK_SEQPACKET socketpair.  Seqpacket sockets
+ * preserve write() boundaries, so draining the peer end counts exactly how
+ * many write(2) calls each command produced and how many input_events they
+ * carried.  A global operator new hook counts heap allocations.
+ *
+ * Budgets
+ * -------
+ *   - zero heap allocations per command once warmed up
+ *   - at most kBudget[i].max_writes write(2) calls per command (one frame)
+ *
+ * Raising a budget is a deliberate decision: update the table below in the
+ * same change that makes the driver slower and say why.
+ */
+
+#include "command_dispatch.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// ---- Counting allocator ------------------------------------------------------
+
+static std::atomic<long> g_allocs{0};
+
+void* operator new(std::size_t n)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n ? n : 1);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return operator new(n, t); }
+void operator delete(void* p) noexcept                 { std::free(p); }
+void operator delete[](void* p) noexcept               { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept    { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept  { std::free(p); }
+
+// ---- Syscall-counting sink ---------------------------------------------------
+
+struct Sink {
+    int dev  = -1;   // handed to the driver as the device fd
+    int peer = -1;   // drained by the test
+
+    bool open()
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) return false;
+        dev  = sv[0];
+        peer = sv[1];
+        return true;
+    }
+
+    /** Drain pending packets; returns (writes, events) since last drain. */
+    void drain(int& writes, int& events)
+    {
+        writes = events = 0;
+        input_event buf[128];
+        for (;;) {
+            ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n < 0) break;                                    // EAGAIN: empty
+            ++writes;
+            events += static_cast<int>(n / static_cast<ssize_t>(sizeof(input_event)));
+        }
+    }
+
+    void close_all()
+    {
+        if (dev >= 0)  ::close(dev);
+        if (peer >= 0) ::close(peer);
+        dev = peer = -1;
+    }
+};
+
+// ---- Budget table ------------------------------------------------------------
+
+struct Budget {
+    const char* line;
+    int         max_writes;   // write(2) calls allowed for this frame
+    int         events;       // exact input_events expected (incl. SYN)
+};
+
+static const Budget kBudget[] = {
+    {"MOUSE_MOVE 960 540",        3, 3},
+    {"MOUSE_MOVE 0 1079",         3, 3},
+    {"MOUSE_LEFT",                4, 4},
+    {"MOUSE_RIGHT",               4, 4},
+    {"MOUSE_SCROLL 3",            2, 2},
+    {"MOUSE_SCROLL -3",           2, 2},
+    {"MOUSE_RELEASE",             0, 0},   // inertia off: nothing to coast
+    {"GAMEPAD_BTN A 1",           2, 2},
+    {"GAMEPAD_BTN A 0",           2, 2},
+    {"GAMEPAD_BTN START 1",       2, 2},
+    {"GAMEPAD_STICK -32767 1200", 3, 3},
+    {"GAMEPAD_TURBO X 15 50",     1, 2},   // first press at once, one frame
+    {"GAMEPAD_TURBO X 20 25",     0, 0},   // retune: already held
+    {"GAMEPAD_TURBO X 0",         1, 2},   // stop releases it
+    {"KEY_DOWN LEFTCTRL",         1, 2},
+    {"KEY_UP LEFTCTRL",           1, 2},
+    {"KEY_CHORD CTRL+SHIFT+TAB",  1, 8},   // press frame + release frame, one batch
+    {"TYPE Hi",                   1, 10},
+    // 43 characters, 4 events each, in 64-event batches: the first now, the
+    // rest from the keyboard's timer (run_frame ticks it like the loop would)
+    {"TYPE the quick brown fox jumps over the lazy dog", 3, 172},
+    {"TOUCH 0 500 300 1 900 300", 1, 11},  // two contacts down, one frame
+    {"TOUCH 0 520 300 1 880 300", 1, 6},   // pinch: only X changes
+    {"TOUCH 0 520 300 1 880 300", 0, 0},   // nothing changed: nothing written
+    {"TOUCH 0 UP 1 UP",           1, 6},
+    {"PEN 100.5 200.25 0 10 -5",  1, 4},   // into proximity: tool, X, Y
+    {"PEN 100.5 200.25 600 10 -5", 1, 3},  // touch down: pressure + BTN_TOUCH
+    {"PEN 110.75 204 650 10 -5",  1, 4},   // stroke: X, Y, pressure
+    {"PEN OUT",                   1, 4},
+    {"POINTER 0 100 100 1 900 500", 2, 5},  // one write per pointer that changed
+    {"POINTER 0 DOWN LEFT 1 DOWN RIGHT", 2, 4},
+    {"POINTER 0 120 110 0 UP LEFT 1 880 500", 2, 6},
+    {"POINTER 1 UP RIGHT",        1, 2},
+    {"POINTER 1 880 500",         0, 0},
+    {"GYRO 90 -45.5 0",           1, 4},   // RX, RY, MSC_TIMESTAMP
+    {"GYRO 100 -40 10",           0, 0},   // glides: the timer writes it
+    {"GYRO OFF",                  1, 4},   // zeroes what was written
+    {"MACRO combo",               2, 4},   // the frames due at 0, one per device
+    {"MACRO combo",               4, 8},   // restart: release, then press again
+    {"MACRO_STOP combo",          2, 4},   // releases what it holds
+    {"POWER IDLE",                0, 0},   // power state only, no events
+    {"POWER ACTIVE",              0, 0},
+    {"# comment",                 0, 0},
+    {"MOUSE_MOVE 10",             0, 0},   // malformed: ignored
+    {"KEY_CHORD CTRL+",           0, 0},   // empty last key
+    {"MOUSE_WARP 1 2",            0, 0},   // unknown: AsyncLog only, no write
+    {"GAMEPAD_BTN Z 1",           0, 0},
+    {"GAMEPAD_TURBO A 90 50",     0, 0},   // above kMaxTurboHz
+    {"GAMEPAD_TURBO A 60 95",     0, 0},   // release shorter than kMinTurboPhaseNs
+    {"MACRO nope",                0, 0},
+    {"GYRO 1 2",                  0, 0},
+    {"POINTER 2 1 1",             0, 0},   // no such pointer: nothing applied
+    {"POINTER 0 DOWN THUMB",      0, 0},
+};
+
+int main()
+{
+    Sink mouse_sink, pad_sink, key_sink, touch_sink, pen_sink, gyro_sink, ptr_sinks[2];
+    if (!mouse_sink.open() || !pad_sink.open() || !key_sink.open() || !touch_sink.open() ||
+        !pen_sink.open() || !gyro_sink.open() || !ptr_sinks[0].open() || !ptr_sinks[1].open()) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+
+    HidDriver::Devices dev;
+    dev.mouse.fd   = mouse_sink.dev;
+    dev.gamepad.fd  = pad_sink.dev;
+    dev.keyboard.fd = key_sink.dev;
+    dev.touch.fd    = touch_sink.dev;
+    dev.pen.fd      = pen_sink.dev;
+    dev.gyro.fd     = gyro_sink.dev;
+    dev.gyro.tick_ns = 2000000;         // upsampled: samples glide
+    dev.pointers.count = 2;
+    for (int i = 0; i < 2; ++i) dev.pointers.p[i].fd = ptr_sinks[i].dev;
+
+    Macro::Set macros;
+    std::string error;
+    if (!HidDriver::compile_macros("[combo]\n0 GAMEPAD_BTN A 1\n0 KEY_DOWN CTRL\n"
+                                   "500 GAMEPAD_BTN A 0\n500 KEY_UP CTRL\n", macros, error)) {
+        std::printf("compile_macros: %s\n", error.c_str());
+        return 1;
+    }
+    dev.macros.set = &macros;
+    dev.macros.fd[Macro::kGamepad]  = dev.gamepad.fd;
+    dev.macros.fd[Macro::kKeyboard] = dev.keyboard.fd;
+
+    // Lines arrive from the stdin loop as std::string; mirror that.
+    std::string line;
+    line.reserve(256);
+
+    auto run_frame = [&](const Budget& b, int& writes, int& events) {
+        line.assign(b.line);
+        HidDriver::dispatch(dev, line);
+        while (dev.keyboard.typing) VirtualHID::keyboard_type_tick(dev.keyboard);
+        int mw, me, pw, pe, kw, ke, tw, te, nw, ne, gw, ge;
+        mouse_sink.drain(mw, me);
+        pad_sink.drain(pw, pe);
+        key_sink.drain(kw, ke);
+        touch_sink.drain(tw, te);
+        pen_sink.drain(nw, ne);
+        gyro_sink.drain(gw, ge);
+        writes = mw + pw + kw + tw + nw + gw;
+        events = me + pe + ke + te + ne + ge;
+        for (Sink& s : ptr_sinks) {
+            int sw, se;
+            s.drain(sw, se);
+            writes += sw;
+            events += se;
+        }
+    };
+
+    // Warm-up: first use of iostreams, lazy statics, etc. may allocate.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const Budget& b : kBudget) { int w, e; run_frame(b, w, e); }
+    }
+
+    // ---- 1. Per-frame syscall budget and event framing --------------------
+    for (const Budget& b : kBudget) {
+        int writes, events;
+        run_frame(b, writes, events);
+        CHECK(writes <= b.max_writes, "'%s': %d writes, budget %d", b.line, writes, b.max_writes);
+        CHECK(events == b.events, "'%s': %d events, expected %d", b.line, events, b.events);
+    }
+
+    // ---- 2. Zero steady-state allocations ---------------------------------
+    const long before = g_allocs.load();
+    long total_writes = 0, budget_writes = 0;
+    for (int pass = 0; pass < 1000; ++pass) {
+        for (const Budget& b : kBudget) {
+            int writes, events;
+            run_frame(b, writes, events);
+            total_writes  += writes;
+            budget_writes += b.max_writes;
+        }
+    }
+    const long allocs = g_allocs.load() - before;
+    CHECK(allocs == 0, "%ld heap allocations in steady state", allocs);
+    CHECK(total_writes <= budget_writes, "%ld writes over stream, budget %ld",
+          total_writes, budget_writes);
+
+    mouse_sink.close_all();
+    pad_sink.close_all();
+    key_sink.close_all();
+    touch_sink.close_all();
+    pen_sink.close_all();
+    gyro_sink.close_all();
+    for (Sink& s : ptr_sinks) s.close_all();
+    return Check::check_exit("test_budget");
+}
@@ -0,0 +1,184 @@
+/*
+ * test_descriptor.cpp
+ * Device descriptors: the capability checks and axis slots the build relies
+ * on, every device's generated setup program against the capabilities the
+ * hand-written setup registered, the uinput_user_dev filled for a screen,
+ * and AbsCache writing only axes that changed.  Events a device lacks are
+ * rejected by the compiler (VirtualHID::add / AbsCache::slot), so only the
+ * accepting side can be tested here.
+ */
+
+#include "virtual_hid.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace VirtualHID;
+
+// ---- Compile time ------------------------------------------------------------
+
+static_assert(kMouseDevice.supports(EV_REL, REL_WHEEL) && !kPointerDevice.supports(EV_REL, REL_WHEEL));
+static_assert(kGamepadDevice.supports(EV_FF, FF_RUMBLE) && kGamepadDevice.ff_effects_max == kMaxFfEffects);
+static_assert(kKeyboardDevice.supports(EV_KEY, KEY_ESC) && kKeyboardDevice.supports(EV_KEY, KEY_MICMUTE) &&
+              !kKeyboardDevice.supports(EV_KEY, BTN_LEFT));
+static_assert(kTouchDevice.supports(EV_ABS, ABS_MT_TRACKING_ID) && !kTouchDevice.supports(EV_ABS, ABS_PRESSURE));
+static_assert(kGyroDevice.supports(EV_MSC, MSC_TIMESTAMP) && kGyroDevice.supports(EV_SYN, SYN_REPORT) &&
+              !kGyroDevice.supports(EV_KEY, BTN_TOUCH));
+static_assert(AbsCache<kPenDevice>::kSlots == 5 && AbsCache<kPenDevice>::slot<ABS_X>() == 0 &&
+              AbsCache<kPenDevice>::slot<ABS_PRESSURE>() == 2 && AbsCache<kPenDevice>::slot<ABS_TILT_Y>() == 4);
+static_assert(kPenDevice.needs_abs_setup() && kGyroDevice.needs_abs_setup() && !kTouchDevice.needs_abs_setup());
+static_assert(setup_program<kKeyboardDevice>.size() == 1 + (KEY_MICMUTE - KEY_ESC + 1));
+
+namespace {
+
+using Op = std::pair<unsigned long, uint16_t>;
+
+/** What the hand-written *_open() functions set up before descriptors. */
+struct Expected {
+    const char*     name;
+    std::vector<Op> ops;
+};
+
+template <const DeviceDesc& D>
+std::vector<Op> program()
+{
+    std::vector<Op> ops;
+    for (const SetupOp& op : setup_program<D>) ops.emplace_back(op.request, op.arg);
+    return ops;
+}
+
+uint16_t pad(GamepadBtn b) { return static_cast<uint16_t>(b); }
+
+bool same_set(std::vector<Op> a, std::vector<Op> b)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+int recv_events(int peer)
+{
+    input_event buf[16];
+    const ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+    return n < 0 ? 0 : static_cast<int>(n / static_cast<ssize_t>(sizeof(input_event)));
+}
+
+} // namespace
+
+int main()
+{
+    // ---- 1. Setup programs match the capabilities registered by hand ----------------
+    std::vector<Op> keyboard = {{UI_SET_EVBIT, EV_KEY}};
+    for (int code = KEY_ESC; code <= KEY_MICMUTE; ++code) keyboard.emplace_back(UI_SET_KEYBIT, code);
+    const std::pair<Expected, std::vector<Op>> devices[] = {
+        {{"mouse", {{UI_SET_EVBIT, EV_KEY}, {UI_SET_EVBIT, EV_ABS}, {UI_SET_EVBIT, EV_REL},
+                    {UI_SET_KEYBIT, BTN_LEFT}, {UI_SET_KEYBIT, BTN_RIGHT}, {UI_SET_KEYBIT, BTN_MIDDLE},
+                    {UI_SET_ABSBIT, ABS_X}, {UI_SET_ABSBIT, ABS_Y}, {UI_SET_RELBIT, REL_WHEEL}}},
+         program<kMouseDevice>()},
+        {{"pointer", {{UI_SET_EVBIT, EV_KEY}, {UI_SET_EVBIT, EV_ABS}, {UI_SET_KEYBIT, BTN_LEFT},
+                      {UI_SET_KEYBIT, BTN_RIGHT}, {UI_SET_KEYBIT, BTN_MIDDLE}, {UI_SET_ABSBIT, ABS_X},
+                      {UI_SET_ABSBIT, ABS_Y}}},
+         program<kPointerDevice>()},
+        {{"gamepad", {{UI_SET_EVBIT, EV_KEY}, {UI_SET_EVBIT, EV_ABS}, {UI_SET_EVBIT, EV_FF},
+                      {UI_SET_FFBIT, FF_RUMBLE}, {UI_SET_FFBIT, FF_GAIN},
+                      {UI_SET_KEYBIT, pad(GamepadBtn::A)}, {UI_SET_KEYBIT, pad(GamepadBtn::B)},
+                      {UI_SET_KEYBIT, pad(GamepadBtn::X)}, {UI_SET_KEYBIT, pad(GamepadBtn::Y)},
+                      {UI_SET_KEYBIT, pad(GamepadBtn::LB)}, {UI_SET_KEYBIT, pad(GamepadBtn::RB)},
+                      {UI_SET_KEYBIT, pad(GamepadBtn::SELECT)}, {UI_SET_KEYBIT, pad(GamepadBtn::START)},
+                      {UI_SET_ABSBIT, ABS_X}, {UI_SET_ABSBIT, ABS_Y}}},
+         program<kGamepadDevice>()},
+        {{"keyboard", keyboard}, program<kKeyboardDevice>()},
+        {{"touchscreen", {{UI_SET_PROPBIT, INPUT_PROP_DIRECT}, {UI_SET_EVBIT, EV_KEY}, {UI_SET_EVBIT, EV_ABS},
+                          {UI_SET_KEYBIT, BTN_TOUCH}, {UI_SET_ABSBIT, ABS_X}, {UI_SET_ABSBIT, ABS_Y},
+                          {UI_SET_ABSBIT, ABS_MT_SLOT}, {UI_SET_ABSBIT, ABS_MT_TRACKING_ID},
+                          {UI_SET_ABSBIT, ABS_MT_POSITION_X}, {UI_SET_ABSBIT, ABS_MT_POSITION_Y}}},
+         program<kTouchDevice>()},
+        // Axes with a resolution go through UI_ABS_SETUP, which sets their bits
+        {{"pen", {{UI_SET_PROPBIT, INPUT_PROP_DIRECT}, {UI_SET_EVBIT, EV_KEY}, {UI_SET_EVBIT, EV_ABS},
+                  {UI_SET_KEYBIT, BTN_TOOL_PEN}, {UI_SET_KEYBIT, BTN_TOUCH}}},
+         program<kPenDevice>()},
+        {{"gyro", {{UI_SET_PROPBIT, INPUT_PROP_ACCELEROMETER}, {UI_SET_EVBIT, EV_ABS}, {UI_SET_EVBIT, EV_MSC},
+                   {UI_SET_MSCBIT, MSC_TIMESTAMP}}},
+         program<kGyroDevice>()},
+    };
+    for (const auto& [want, got] : devices) {
+        CHECK(same_set(want.ops, got), "%s: setup program differs (%zu ops, expected %zu)", want.name, got.size(),
+              want.ops.size());
+    }
+    // Properties and event types come before the codes that need them
+    const auto mouse = program<kMouseDevice>();
+    CHECK(mouse[0] == Op(UI_SET_EVBIT, EV_KEY) && mouse[1] == Op(UI_SET_EVBIT, EV_REL) &&
+          mouse[2] == Op(UI_SET_EVBIT, EV_ABS), "mouse program order");
+    CHECK(program<kPenDevice>()[0] == Op(UI_SET_PROPBIT, INPUT_PROP_DIRECT), "pen program order");
+
+    // ---- 2. uinput_user_dev for a screen -------------------------------------------
+    uinput_user_dev u;
+    fill_user_dev(kMouseDevice, 1920, 1080, nullptr, u);
+    CHECK(std::strcmp(u.name, "GestureLink Virtual Mouse") == 0 && u.id.bustype == BUS_VIRTUAL &&
+          u.id.vendor == 0x1357 && u.id.product == 0x0001 && u.id.version == 1, "mouse ids");
+    CHECK(u.absmin[ABS_X] == 0 && u.absmax[ABS_X] == 1919 && u.absmax[ABS_Y] == 1079 && u.absmax[ABS_Z] == 0,
+          "mouse ranges");
+    fill_user_dev(kGamepadDevice, 1920, 1080, nullptr, u);
+    CHECK(u.absmin[ABS_Y] == -32767 && u.absmax[ABS_Y] == 32767 && u.absfuzz[ABS_Y] == 16 &&
+          u.absflat[ABS_Y] == 128 && u.ff_effects_max == kMaxFfEffects, "gamepad stick / effects");
+    fill_user_dev(kTouchDevice, 800, 600, nullptr, u);
+    CHECK(u.absmax[ABS_MT_POSITION_X] == 799 && u.absmax[ABS_MT_POSITION_Y] == 599 &&
+          u.absmax[ABS_MT_SLOT] == kMaxTouchSlots - 1 && u.absmax[ABS_MT_TRACKING_ID] == 0xffff, "touch ranges");
+    fill_user_dev(kPointerDevice, 1920, 1080, "GestureLink Virtual Pointer 1", u);
+    CHECK(std::strcmp(u.name, "GestureLink Virtual Pointer 1") == 0 && u.id.product == 0x0006, "pointer name");
+    fill_user_dev(kPenDevice, 1920, 1080, nullptr, u);
+    CHECK(u.absmax[ABS_X] == 1920 * kPenSubpixel - 1 && u.absmin[ABS_TILT_X] == -kPenMaxTilt &&
+          kPenDevice.abs_info[ABS_X].res == kPenSubpixel * 96 * 10 / 254 && kPenDevice.abs_info[ABS_TILT_Y].res == 57,
+          "pen ranges / resolution");
+
+    // ---- 3. AbsCache writes only what changed ----------------------------------------
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    AbsCache<kPenDevice> cache;
+    {
+        EventBatch b(sv[0]);
+        cache.set<ABS_X>(b, 100);
+        cache.set<ABS_Y>(b, 0);                   // the cache starts at 0: nothing to send
+        cache.set<ABS_PRESSURE>(b, 900);
+        add<kPenDevice, EV_KEY, BTN_TOUCH>(b, 1);
+        b.syn();
+    }
+    CHECK(recv_events(sv[1]) == 4, "first frame: X, pressure, BTN_TOUCH, SYN");
+    {
+        EventBatch b(sv[0]);
+        cache.set<ABS_X>(b, 100);
+        cache.set<ABS_PRESSURE>(b, 901);
+        cache.set<ABS_TILT_Y>(b, -5);
+        if (b.count > 0) b.syn();
+    }
+    CHECK(recv_events(sv[1]) == 3, "second frame: pressure, tilt, SYN");
+    CHECK(cache.get<ABS_X>() == 100 && cache.get<ABS_PRESSURE>() == 901 && cache.value[4] == -5, "cached values");
+
+    // Setup syscalls per device: open, the program, axes (one write, or one
+    // UI_ABS_SETUP each plus UI_DEV_SETUP) and UI_DEV_CREATE
+    auto syscalls = [](const DeviceDesc& d, size_t ops) {
+        return 1 + ops + (d.needs_abs_setup() ? d.abs_count() + 1 : 1) + 1;
+    };
+    std::printf("[test_descriptor] setup syscalls: mouse %zu, gamepad %zu, keyboard %zu, touch %zu, pen %zu, "
+                "gyro %zu\n",
+                syscalls(kMouseDevice, setup_program<kMouseDevice>.size()),
+                syscalls(kGamepadDevice, setup_program<kGamepadDevice>.size()),
+                syscalls(kKeyboardDevice, setup_program<kKeyboardDevice>.size()),
+                syscalls(kTouchDevice, setup_program<kTouchDevice>.size()),
+                syscalls(kPenDevice, setup_program<kPenDevice>.size()),
+                syscalls(kGyroDevice, setup_program<kGyroDevice>.size()));
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_descriptor");
+}
@@ -0,0 +1,356 @@
+/*
+ * test_event_loop.cpp
+ * Timer wheel and stdin loop tests (event_loop.h), including the watched fd.
+ *
+ * Timer tests run against a SimulatedClock, so the 24-hour session below
+ * takes a couple of seconds: the clock jumps straight to the next deadline
+ * (or by poll-sized random steps) instead of sleeping.
+ */
+
+#include "event_loop.h"
+#include "check.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using EventLoop::SimulatedClock;
+using EventLoop::TimerWheel;
+
+static constexpr int64_t kMs = 1000000;
+static constexpr int64_t kS  = 1000 * kMs;
+
+// ---- Helpers -----------------------------------------------------------------
+
+struct Fired {
+    std::vector<int64_t> deadlines;   // what each timer asked for
+    std::vector<int64_t> at;          // clock when it actually ran
+};
+
+struct OneShot {
+    Fired*  log;
+    int64_t deadline;
+};
+
+static void on_oneshot(void* ctx, int64_t now)
+{
+    auto* t = static_cast<OneShot*>(ctx);
+    t->log->deadlines.push_back(t->deadline);
+    t->log->at.push_back(now);
+}
+
+/** Re-arms itself at deadline + period (absolute, so it never drifts). */
+struct Periodic {
+    TimerWheel* wheel;
+    int64_t     period;
+    int64_t     deadline;
+    int64_t     fires     = 0;
+    int64_t     max_late  = 0;
+    int64_t     early     = 0;
+};
+
+static void on_periodic(void* ctx, int64_t now)
+{
+    auto* p = static_cast<Periodic*>(ctx);
+    ++p->fires;
+    if (now < p->deadline) ++p->early;
+    if (now - p->deadline > p->max_late) p->max_late = now - p->deadline;
+    p->deadline += p->period;
+    p->wheel->schedule_at(p->deadline, on_periodic, p);
+}
+
+// ---- Tests -------------------------------------------------------------------
+
+static void test_order_and_cancel()
+{
+    SimulatedClock clock(5 * kS);
+    TimerWheel     wheel(clock);
+    Fired          log;
+    OneShot a{&log, 5 * kS + 30 * kMs}, b{&log, 5 * kS + 10 * kMs}, c{&log, 5 * kS + 20 * kMs};
+    OneShot d{&log, 5 * kS + 15 * kMs};
+
+    wheel.schedule_at(a.deadline, on_oneshot, &a);
+    wheel.schedule_at(b.deadline, on_oneshot, &b);
+    wheel.schedule_at(c.deadline, on_oneshot, &c);
+    const EventLoop::TimerId dead = wheel.schedule_at(d.deadline, on_oneshot, &d);
+    CHECK(wheel.active() == 4, "active=%zu", wheel.active());
+    CHECK(wheel.next_deadline() == b.deadline, "next=%lld", (long long)wheel.next_deadline());
+
+    CHECK(wheel.cancel(dead), "cancel pending timer");
+    CHECK(!wheel.cancel(dead), "double cancel must fail");
+
+    clock.advance(9 * kMs);
+    CHECK(wheel.advance() == 0, "nothing is due yet");
+
+    clock.advance(100 * kMs);                        // one late wake-up covers all three
+    CHECK(wheel.advance() == 3, "three timers due");
+    CHECK(log.deadlines.size() == 3 &&
+          log.deadlines[0] == b.deadline && log.deadlines[1] == c.deadline &&
+          log.deadlines[2] == a.deadline, "timers must fire in deadline order");
+    CHECK(wheel.active() == 0, "active=%zu", wheel.active());
+    CHECK(wheel.next_deadline() == INT64_MAX, "idle wheel has no deadline");
+}
+
+static void test_far_future_and_past()
+{
+    SimulatedClock clock(0);
+    TimerWheel     wheel(clock);
+    Fired          log;
+    OneShot far{&log, 10 * kS + 3 * kMs};            // many revolutions out
+    OneShot past{&log, -5 * kMs};                    // already overdue
+
+    const EventLoop::TimerId far_id = wheel.schedule_at(far.deadline, on_oneshot, &far);
+    CHECK(wheel.next_deadline() == far.deadline, "far next=%lld", (long long)wheel.next_deadline());
+
+    // Step in 1 ms increments to 10 s: the far timer shares a slot with every
+    // 256th tick and must not fire on any of them.
+    for (int64_t t = kMs; t < far.deadline; t += kMs) {
+        clock.set(t);
+        wheel.advance();
+    }
+    CHECK(log.at.empty(), "far timer fired %zu time(s) early", log.at.size());
+
+    wheel.schedule_at(past.deadline, on_oneshot, &past);
+    CHECK(wheel.next_deadline() == past.deadline, "overdue timer is next");
+    clock.set(far.deadline);
+    CHECK(wheel.advance() == 2, "overdue + far timers fire");
+    CHECK(log.deadlines.size() == 2 && log.deadlines[0] == past.deadline, "overdue fires first");
+    CHECK(!wheel.cancel(far_id), "cancelling a fired timer must fail");
+
+    // A recycled pool slot must not be cancellable through the stale id.
+    OneShot again{&log, far.deadline + kS};
+    wheel.schedule_at(again.deadline, on_oneshot, &again);
+    CHECK(!wheel.cancel(far_id), "stale id cancelled a recycled timer");
+    CHECK(wheel.active() == 1, "active=%zu", wheel.active());
+}
+
+static void test_pool_exhaustion()
+{
+    SimulatedClock clock(0);
+    TimerWheel     wheel(clock);
+    Fired          log;
+    OneShot        t{&log, kS};
+    size_t n = 0;
+    while (wheel.schedule_at(t.deadline, on_oneshot, &t) != EventLoop::kNoTimer) ++n;
+    CHECK(n == TimerWheel::kMaxTimers, "pool held %zu timers", n);
+    clock.set(kS);
+    CHECK(wheel.advance() == n, "all pooled timers fire");
+    CHECK(wheel.schedule_at(2 * kS, on_oneshot, &t) != EventLoop::kNoTimer, "pool is reusable");
+}
+
+/**
+ * 24 simulated hours of driver-like timer traffic: a 60 Hz frame timer, a
+ * 1 Hz housekeeping timer, and a stream of short one-shots (cooldowns,
+ * turbo/inertia ticks), some of which are cancelled before they fire.
+ */
+static void test_simulated_day()
+{
+    constexpr int64_t kDay    = 24 * 3600 * kS;
+    constexpr int64_t kFrame  = kS / 60;
+
+    SimulatedClock clock(0);
+    TimerWheel     wheel(clock);
+    Periodic frame{&wheel, kFrame, kFrame};
+    Periodic house{&wheel, kS, kS};
+    wheel.schedule_at(frame.deadline, on_periodic, &frame);
+    wheel.schedule_at(house.deadline, on_periodic, &house);
+    const size_t baseline = wheel.active();
+
+    std::mt19937_64 rng(85);
+    std::uniform_int_distribution<int64_t> delay(1 * kMs, 2 * kS);
+    std::uniform_int_distribution<int64_t> step(0, 40 * kMs);     // poll(2)-sized wake-ups
+
+    struct Shot { int64_t deadline = 0; int64_t fired_at = -1; bool armed = false; EventLoop::TimerId id = 0; };
+    static Shot shots[16];
+    int64_t scheduled = 0, fired = 0, cancelled = 0, early = 0, missed = 0, worst_late = 0;
+
+    while (clock.now_ns() < kDay) {
+        // Alternate exact jumps to the next deadline (idle) and random
+        // poll-sized steps (busy) so both paths are covered.
+        if ((clock.now_ns() / kS) % 2 == 0) clock.set(wheel.next_deadline());
+        else                                clock.advance(step(rng));
+        const int64_t now = clock.now_ns();
+        wheel.advance();
+
+        for (Shot& s : shots) {
+            if (s.armed && s.deadline <= now) ++missed;          // due but not fired
+            if (s.fired_at < 0) continue;
+            ++fired;
+            if (s.fired_at < s.deadline) ++early;
+            if (s.fired_at - s.deadline > worst_late) worst_late = s.fired_at - s.deadline;
+            s.fired_at = -1;
+        }
+        // Keep up to 16 one-shots in flight and cancel some of them.
+        for (Shot& s : shots) {
+            if (s.armed && rng() % 1000 == 0) {
+                CHECK(wheel.cancel(s.id), "cancel armed one-shot");
+                s.armed = false;
+                ++cancelled;
+            }
+            if (!s.armed && rng() % 8 == 0) {
+                s.deadline = now + delay(rng);
+                s.id = wheel.schedule_at(s.deadline, [](void* ctx, int64_t t) {
+                    auto* shot = static_cast<Shot*>(ctx);
+                    shot->armed    = false;
+                    shot->fired_at = t;
+                }, &s);
+                s.armed = s.id != EventLoop::kNoTimer;
+                ++scheduled;
+            }
+        }
+    }
+
+    size_t still_armed = 0;
+    for (Shot& s : shots) if (s.armed) ++still_armed;
+
+    std::printf("[test_event_loop] 24h simulated: frames=%lld housekeeping=%lld "
+                "oneshots scheduled=%lld fired=%lld cancelled=%lld worst_late=%.1f ms\n",
+                (long long)frame.fires, (long long)house.fires, (long long)scheduled,
+                (long long)fired, (long long)cancelled, worst_late / 1e6);
+
+    const int64_t end = clock.now_ns();
+    CHECK(frame.fires == end / kFrame, "frame timer fired %lld, expected %lld (drift)",
+          (long long)frame.fires, (long long)(end / kFrame));
+    CHECK(house.fires == end / kS, "housekeeping fired %lld, expected %lld",
+          (long long)house.fires, (long long)(end / kS));
+    CHECK(frame.early == 0 && house.early == 0, "periodic timers fired early");
+    CHECK(frame.max_late <= 40 * kMs, "frame timer late by %lld ns", (long long)frame.max_late);
+    CHECK(early == 0, "%lld one-shot(s) fired early", (long long)early);
+    CHECK(missed == 0, "%lld one-shot(s) still pending after their deadline", (long long)missed);
+    CHECK(worst_late <= 40 * kMs, "one-shot late by %lld ns", (long long)worst_late);
+    CHECK(scheduled > 100000, "only %lld one-shots scheduled", (long long)scheduled);
+    CHECK(fired + cancelled + static_cast<int64_t>(still_armed) == scheduled,
+          "one-shots lost: scheduled=%lld fired=%lld cancelled=%lld armed=%zu",
+          (long long)scheduled, (long long)fired, (long long)cancelled, still_armed);
+    // No leak: only the two periodic timers and the still-armed one-shots remain.
+    CHECK(wheel.active() == baseline + still_armed, "active=%zu expected=%zu",
+          wheel.active(), baseline + still_armed);
+}
+
+// ---- stdin loop --------------------------------------------------------------
+
+struct LoopCtx {
+    std::vector<std::string> lines;
+    int timer_fires = 0;
+};
+
+static void test_run_lines_and_timers()
+{
+    int p[2];
+    CHECK(pipe(p) == 0, "pipe");
+    const std::string long_line(5000, 'x');
+    const std::string input = "MOUSE_MOVE 1 2\nMOUSE_LEFT\n" + long_line + "\nMOUSE_RIGHT\nQUIT\nNEVER\n";
+    CHECK(write(p[1], input.data(), input.size()) == static_cast<ssize_t>(input.size()), "write");
+    close(p[1]);
+
+    LoopCtx ctx;
+    TimerWheel wheel(EventLoop::monotonic_clock());
+    wheel.schedule_in(0, [](void* c, int64_t) { ++static_cast<LoopCtx*>(c)->timer_fires; }, &ctx);
+
+    EventLoop::LoopHooks hooks;
+    hooks.ctx     = &ctx;
+    hooks.on_line = [](void* c, std::string_view line) {
+        static_cast<LoopCtx*>(c)->lines.emplace_back(line);
+        return line != "QUIT";
+    };
+    std::atomic<bool> running{true};
+    EventLoop::run(p[0], wheel, hooks, running);
+    close(p[0]);
+
+    CHECK(ctx.lines.size() == 4, "lines=%zu", ctx.lines.size());
+    CHECK(ctx.lines.size() == 4 && ctx.lines[0] == "MOUSE_MOVE 1 2" && ctx.lines[1] == "MOUSE_LEFT" &&
+          ctx.lines[2] == "MOUSE_RIGHT" && ctx.lines[3] == "QUIT",
+          "over-long line must be dropped and QUIT must stop the loop");
+
+    // EOF with a pending timer: the loop returns, the timer has fired once.
+    int q[2];
+    CHECK(pipe(q) == 0, "pipe");
+    close(q[1]);
+    EventLoop::run(q[0], wheel, hooks, running);
+    close(q[0]);
+    CHECK(ctx.timer_fires <= 1, "timer fired %d times", ctx.timer_fires);
+
+    // EOF after a command without a newline (printf 'MOUSE_LEFT' | hid_driver):
+    // it still runs; the tail of an over-long line does not.
+    const std::string tails[] = {"MOUSE_MOVE 3 4\nMOUSE_LEFT", long_line};
+    for (const std::string& tail : tails) {
+        int r[2];
+        CHECK(pipe(r) == 0, "pipe");
+        CHECK(write(r[1], tail.data(), tail.size()) == static_cast<ssize_t>(tail.size()), "write");
+        close(r[1]);
+        ctx.lines.clear();
+        EventLoop::run(r[0], wheel, hooks, running);
+        close(r[0]);
+        if (tail == long_line) {
+            CHECK(ctx.lines.empty(), "over-long unterminated line delivered (%zu lines)", ctx.lines.size());
+        } else {
+            CHECK(ctx.lines.size() == 2 && ctx.lines[0] == "MOUSE_MOVE 3 4" && ctx.lines[1] == "MOUSE_LEFT",
+                  "unterminated last line: %zu lines", ctx.lines.size());
+        }
+    }
+}
+
+struct WatchCtx {
+    std::vector<std::string> order;    // "line:<text>" / "watch:<bytes>"
+    int readable = 0;
+};
+
+static void test_run_watch_fd()
+{
+    int in[2], w[2];
+    CHECK(pipe(in) == 0 && socketpair(AF_UNIX, SOCK_STREAM, 0, w) == 0, "pipe/socketpair");
+    // Input and a watched request land before the same wake-up: the line goes first.
+    CHECK(write(w[1], "ff", 2) == 2 && write(in[1], "A\n", 2) == 2, "write");
+
+    WatchCtx ctx;
+    TimerWheel wheel(EventLoop::monotonic_clock());
+    EventLoop::LoopHooks hooks;
+    hooks.ctx         = &ctx;
+    hooks.watch_fd    = w[0];
+    hooks.on_line     = [](void* c, std::string_view line) {
+        static_cast<WatchCtx*>(c)->order.push_back("line:" + std::string(line));
+        return line != "QUIT";
+    };
+    hooks.on_readable = [](void* c, int fd) {
+        char buf[16];
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        auto* ctx = static_cast<WatchCtx*>(c);
+        ++ctx->readable;
+        if (n > 0) ctx->order.push_back("watch:" + std::string(buf, static_cast<size_t>(n)));
+    };
+    std::atomic<bool> running{true};
+    std::thread loop([&] { EventLoop::run(in[0], wheel, hooks, running); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(write(w[1], "xy", 2) == 2, "write");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    close(w[1]);                                 // hang-up: dropped, not spun on
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(write(in[1], "B\nQUIT\n", 7) == 7, "write");
+    loop.join();
+
+    const std::vector<std::string> want = {"line:A", "watch:ff", "watch:xy", "line:B", "line:QUIT"};
+    CHECK(ctx.order == want, "order: %zu entries, first '%s'", ctx.order.size(),
+          ctx.order.empty() ? "" : ctx.order[0].c_str());
+    CHECK(ctx.readable <= 3, "watch fd polled %d times after hang-up", ctx.readable);
+    close(in[0]);
+    close(in[1]);
+    close(w[0]);
+}
+
+int main()
+{
+    test_order_and_cancel();
+    test_far_future_and_past();
+    test_pool_exhaustion();
+    test_simulated_day();
+    test_run_lines_and_timers();
+    test_run_watch_fd();
+    return Check::check_exit("test_event_loop");
+}
@@ -0,0 +1,137 @@
+/*
+ * test_ff.cpp
+ * Gamepad force feedback: EV_FF play / stop / gain applied to uploaded
+ * rumble effects, the back-channel lines they become, and requests the
+ * driver cannot answer.  The kernel side is a SOCK_SEQPACKET socketpair
+ * peer writing what uinput would queue; the UI_FF_UPLOAD / UI_FF_ERASE
+ * handshakes themselves need /dev/uinput and are covered by
+ * test_uinput_loopback.cpp.
+ */
+
+#include "command_dispatch.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <string>
+#include <vector>
+
+using VirtualHID::FfEvent;
+
+namespace {
+
+void send_ev(int peer, uint16_t type, uint16_t code, int32_t value)
+{
+    input_event ev{};
+    ev.type  = type;
+    ev.code  = code;
+    ev.value = value;
+    CHECK(send(peer, &ev, sizeof(ev), 0) == static_cast<ssize_t>(sizeof(ev)), "send");
+}
+
+/** Service once and return the back-channel lines it produced. */
+std::vector<std::string> service(VirtualHID::GamepadState& gs)
+{
+    FfEvent changes[VirtualHID::kMaxFfEffects];
+    const int n = VirtualHID::gamepad_service(gs, changes, VirtualHID::kMaxFfEffects);
+    std::vector<std::string> lines;
+    char line[64];
+    for (int i = 0; i < n; ++i) {
+        const size_t len = HidDriver::format_feedback(changes[i], line, sizeof(line));
+        lines.emplace_back(line, len);
+    }
+    return lines;
+}
+
+void check_lines(const char* what, const std::vector<std::string>& got,
+                 const std::vector<std::string>& want)
+{
+    CHECK(got.size() == want.size(), "%s: %zu lines, expected %zu", what, got.size(), want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i) {
+        CHECK(got[i] == want[i], "%s[%zu]: got '%s' expected '%s'", what, i, got[i].c_str(),
+              want[i].c_str());
+    }
+}
+
+void upload(VirtualHID::GamepadState& gs, int id, uint16_t strong, uint16_t weak, uint16_t length_ms)
+{
+    gs.ff[id].used      = true;
+    gs.ff[id].strong    = strong;
+    gs.ff[id].weak      = weak;
+    gs.ff[id].length_ms = length_ms;
+}
+
+} // namespace
+
+int main()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    fcntl(sv[0], F_SETFL, O_NONBLOCK);
+    VirtualHID::GamepadState gs;
+    gs.fd = sv[0];
+
+    // ---- 1. Nothing queued: never blocks ------------------------------------------
+    check_lines("idle", service(gs), {});
+
+    // ---- 2. Play, update while playing, stop -----------------------------------------
+    upload(gs, 0, 0xffff, 0x4000, 200);
+    upload(gs, 3, 0x1000, 0, 0);
+    send_ev(sv[1], EV_FF, 0, 1);
+    check_lines("play", service(gs), {"FF PLAY 0 65535 16384 200\n"});
+    send_ev(sv[1], EV_FF, 3, 2);
+    send_ev(sv[1], EV_FF, 0, 0);
+    check_lines("play 3, stop 0", service(gs), {"FF PLAY 3 4096 0 0\n", "FF STOP 0\n"});
+    CHECK(gs.ff[3].playing && !gs.ff[0].playing, "playing flags");
+    send_ev(sv[1], EV_FF, 0, 0);
+    check_lines("stop twice", service(gs), {});
+
+    // ---- 3. Gain scales what is forwarded, and re-reports what is playing -----------
+    send_ev(sv[1], EV_FF, FF_GAIN, 0x8000);
+    check_lines("gain", service(gs), {"FF PLAY 3 2048 0 0\n"});
+    send_ev(sv[1], EV_FF, 0, 1);
+    check_lines("play at half gain", service(gs), {"FF PLAY 0 32768 8192 200\n"});
+    send_ev(sv[1], EV_FF, FF_GAIN, 0xffff);
+    send_ev(sv[1], EV_FF, 0, 0);
+    send_ev(sv[1], EV_FF, 3, 0);
+    std::vector<std::string> got;
+    for (int i = 0; i < 3; ++i) {
+        for (std::string& l : service(gs)) got.push_back(std::move(l));
+    }
+    check_lines("full gain, stop all", got,
+                {"FF PLAY 0 65535 16384 200\n", "FF PLAY 3 4096 0 0\n", "FF STOP 0\n", "FF STOP 3\n"});
+
+    // ---- 4. Effects that were never uploaded, or out of range, are ignored ----------
+    send_ev(sv[1], EV_FF, 5, 1);
+    send_ev(sv[1], EV_FF, VirtualHID::kMaxFfEffects, 1);
+    send_ev(sv[1], EV_KEY, BTN_SOUTH, 1);
+    for (int i = 0; i < 3; ++i) check_lines("unknown effect", service(gs), {});
+
+    // ---- 5. Handshake on an fd that is not uinput: logged, nothing applied ----------
+    const uint64_t uploads = Metrics::counter_value(Metrics::kFfUploads);
+    send_ev(sv[1], EV_UINPUT, UI_FF_UPLOAD, 1);
+    send_ev(sv[1], EV_UINPUT, UI_FF_ERASE, 2);
+    for (int i = 0; i < 2; ++i) check_lines("failed handshake", service(gs), {});
+    CHECK(Metrics::counter_value(Metrics::kFfUploads) == uploads, "upload counted without a handshake");
+    CHECK(gs.ff[0].used && gs.ff[3].used, "erase applied without a handshake");
+
+    // ---- 6. Back-channel formatting -------------------------------------------------
+    char small[8];
+    CHECK(HidDriver::format_feedback(FfEvent{1, true, 65535, 65535, 65535}, small, sizeof(small)) == 0,
+          "truncated line must not be sent");
+    char line[64];
+    CHECK(HidDriver::format_feedback(FfEvent{15, false, 1, 2, 3}, line, sizeof(line)) == 11 &&
+          std::string(line) == "FF STOP 15\n", "stop line '%s'", line);
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_ff");
+}
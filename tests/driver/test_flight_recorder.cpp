@@ -0,0 +1,98 @@
+/*
+ * test_flight_recorder.cpp
+ * Flight recorder dumps: commands round-trip as replayable lines, commands
+ * longer than kMaxCommandLen dump as #T metadata (length and prefix) that
+ * replay skips, and the ring keeps only the newest kCapacity records.
+ */
+
+#include "flight_recorder.h"
+#include "check.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> dump_lines(const std::string& path)
+{
+    CHECK(FlightRecorder::dump("test"), "dump to %s", path.c_str());
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(line);
+    return lines;
+}
+
+/** The lines hid_driver would run when the dump is replayed into it. */
+std::vector<std::string> replayed(const std::vector<std::string>& lines)
+{
+    std::vector<std::string> out;
+    for (const std::string& l : lines) {
+        if (!l.empty() && l[0] != '#') out.push_back(l);
+    }
+    return out;
+}
+
+void record(const std::string& line) { FlightRecorder::record_command(line.data(), line.size()); }
+
+} // namespace
+
+int main()
+{
+    char path[] = "/tmp/test_flight_recorder-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        std::printf("mkstemp failed\n");
+        return Check::kSkipExitCode;
+    }
+    close(fd);
+    FlightRecorder::set_dump_path(path);
+
+    // ---- 1. Short and full-length commands replay as received ---------------------
+    std::string touch = "TOUCH";
+    for (int slot = 0; slot < 10; ++slot) touch += (slot ? " | " : " ") + std::to_string(slot) + " 1919 1079";
+    CHECK(touch.size() <= FlightRecorder::kMaxCommandLen, "a ten-contact TOUCH (%zu bytes) fits", touch.size());
+    const std::string exact(FlightRecorder::kMaxCommandLen, 'x');
+    record("MOUSE_MOVE 960 540");
+    record(touch);
+    record(exact);
+    FlightRecorder::record_event(3, 1, 272, 1);
+    auto lines = dump_lines(path);
+    CHECK(lines.size() == 8 && lines[0].rfind("# gesturelink flight recorder v1", 0) == 0, "%zu lines",
+          lines.size());
+    CHECK((replayed(lines) == std::vector<std::string>{"MOUSE_MOVE 960 540", touch, exact}), "replayed commands");
+    const std::string event = " 3 3 1 272 1";                  // seq, fd, type, code, value
+    CHECK(lines.back().rfind("#E ", 0) == 0 && lines.back().substr(lines.back().size() - event.size()) == event,
+          "event record: %s", lines.back().c_str());
+
+    // ---- 2. Longer commands are marked, not replayed ------------------------------
+    const std::string type = "TYPE " + std::string(300, 'a');
+    record(type);
+    record("MOUSE_LEFT");
+    lines = dump_lines(path);
+    CHECK((replayed(lines) == std::vector<std::string>{"MOUSE_MOVE 960 540", touch, exact, "MOUSE_LEFT"}),
+          "truncated command skipped on replay");
+    const std::string& t = lines[lines.size() - 3];
+    std::istringstream meta(t);
+    std::string kind, prefix;
+    unsigned long long t_ns = 0, seq = 0, len = 0;
+    meta >> kind >> t_ns >> seq >> len >> prefix;
+    CHECK(kind == "#T" && t_ns > 0 && seq == 4 && len == type.size(), "#T header: %s", t.substr(0, 40).c_str());
+    CHECK(t.size() > FlightRecorder::kMaxCommandLen &&
+          t.substr(t.size() - FlightRecorder::kMaxCommandLen) == type.substr(0, FlightRecorder::kMaxCommandLen),
+          "#T keeps the first kMaxCommandLen bytes");
+
+    // ---- 3. The ring keeps the newest kCapacity records ---------------------------
+    for (size_t i = 0; i < FlightRecorder::kCapacity + 10; ++i) record("MOUSE_SCROLL " + std::to_string(i));
+    const auto cmds = replayed(dump_lines(path));
+    CHECK(cmds.size() == FlightRecorder::kCapacity && cmds.front() == "MOUSE_SCROLL 10" &&
+          cmds.back() == "MOUSE_SCROLL " + std::to_string(FlightRecorder::kCapacity + 9),
+          "ring window: %zu commands, first %s", cmds.size(), cmds.empty() ? "-" : cmds.front().c_str());
+
+    unlink(path);
+    return Check::check_exit("test_flight_recorder");
+}
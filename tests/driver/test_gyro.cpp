@@ -0,0 +1,186 @@
+/*
+ * test_gyro.cpp
+ * Motion sensor on a SimulatedClock: the first sample written at once,
+ * 30 Hz samples upsampled to 500 Hz frames that glide between them with
+ * MSC_TIMESTAMP on every frame, staleness and GYRO OFF zeroing the rates,
+ * clamping, one frame per sample with the tick off, and malformed GYRO
+ * lines.  The sensor writes to a SOCK_SEQPACKET socketpair.
+ */
+
+#include "command_dispatch.h"
+#include "event_loop.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+using HidDriver::DispatchResult;
+
+namespace {
+
+constexpr int64_t kMsNs   = 1000000;
+constexpr int64_t kTickNs = 2 * kMsNs;
+constexpr int     kRes    = VirtualHID::kGyroResPerDps;
+
+/** One frame read back: its rates (carried over when unchanged) and MSC_TIMESTAMP. */
+struct Frame {
+    int     rate[3];
+    int64_t stamp_us;
+    bool    has_stamp;
+};
+
+int g_rate[3] = {};
+
+int drain(int peer, std::vector<Frame>& out)
+{
+    input_event buf[16];
+    int n = 0;
+    for (;;) {
+        const ssize_t len = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) break;
+        Frame f{{}, 0, false};
+        for (ssize_t i = 0; i < len / static_cast<ssize_t>(sizeof(input_event)); ++i) {
+            const input_event& e = buf[i];
+            if (e.type == EV_ABS && e.code >= ABS_RX && e.code <= ABS_RZ) g_rate[e.code - ABS_RX] = e.value;
+            if (e.type == EV_MSC && e.code == MSC_TIMESTAMP) {
+                f.stamp_us  = static_cast<uint32_t>(e.value);
+                f.has_stamp = true;
+            }
+        }
+        std::copy(g_rate, g_rate + 3, f.rate);
+        out.push_back(f);
+        ++n;
+    }
+    return n;
+}
+
+/** Tick as hid_driver does, phase-locked: @p due, due + kTickNs, ... up to @p end_ns. */
+int64_t run(HidDriver::Devices& dev, EventLoop::SimulatedClock& clock, int64_t due, int64_t end_ns, int peer,
+            std::vector<Frame>& out)
+{
+    for (; due <= end_ns; due += kTickNs) {
+        clock.set(due);
+        const bool more = VirtualHID::gyro_tick(dev.gyro, due);
+        drain(peer, out);
+        if (!more) break;
+    }
+    clock.set(end_ns);
+    return due;
+}
+
+} // namespace
+
+int main()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    EventLoop::SimulatedClock clock(1000000000);
+    HidDriver::Devices dev;
+    dev.clock        = &clock;
+    dev.gyro.fd      = sv[0];
+    dev.gyro.tick_ns = kTickNs;
+    std::vector<Frame> frames;
+
+    // ---- 1. The first sample goes out at once, fractional deg/s -------------------
+    const int64_t t0 = clock.now_ns();
+    CHECK(HidDriver::dispatch(dev, "GYRO 90 -45.5 0.03125") == DispatchResult::Handled, "GYRO");
+    CHECK(drain(sv[1], frames) == 1 && frames[0].rate[0] == 90 * kRes && frames[0].rate[1] == -728 &&
+          frames[0].rate[2] == 1 && frames[0].has_stamp && frames[0].stamp_us == 0,
+          "first frame: %d %d %d", frames.empty() ? 0 : frames[0].rate[0], frames.empty() ? 0 : frames[0].rate[1],
+          frames.empty() ? 0 : frames[0].rate[2]);
+    CHECK(dev.gyro.streaming, "not streaming");
+
+    // ---- 2. 30 Hz samples become 500 Hz frames gliding between them ------------------
+    // The next sample lands one camera frame later; the glide towards it
+    // spans that interval, so the frames in between ramp linearly.
+    constexpr int64_t kFrameNs = 33333333;
+    frames.clear();
+    int64_t due = run(dev, clock, t0 + kTickNs, t0 + kFrameNs, sv[1], frames);
+    CHECK(frames.size() == 16, "%zu frames before the second sample", frames.size());
+    bool held = true;
+    for (const Frame& f : frames) held &= f.rate[0] == 90 * kRes && f.has_stamp;
+    CHECK(held, "rates moved without a new sample");
+
+    HidDriver::dispatch(dev, "GYRO 190 -45.5 0");                  // +100 deg/s on RX
+    const int64_t t1 = clock.now_ns();
+    frames.clear();
+    due = run(dev, clock, due, t1 + 2 * kFrameNs, sv[1], frames);
+    bool ramp = frames.size() > 20, stamps = true;
+    int64_t last_stamp = -1;
+    for (const Frame& f : frames) {
+        stamps &= f.has_stamp && f.stamp_us > last_stamp;
+        last_stamp = f.stamp_us;
+    }
+    for (size_t i = 0; ramp && i < frames.size(); ++i) {
+        const int64_t t = t0 + frames[i].stamp_us * 1000 - t1;
+        const int want = t < kFrameNs ? static_cast<int>(90 * kRes + int64_t{100 * kRes} * t / kFrameNs) : 190 * kRes;
+        ramp = std::abs(frames[i].rate[0] - want) <= 1;
+    }
+    CHECK(ramp, "RX does not ramp from 90 to 190 deg/s over one sample interval");
+    CHECK(stamps && frames.size() > 1 && frames[1].stamp_us - frames[0].stamp_us == kTickNs / 1000,
+          "MSC_TIMESTAMP not advancing by the tick");
+    const double hz = (frames.size() - 1) * 1e6 / static_cast<double>(frames.back().stamp_us - frames[0].stamp_us);
+    CHECK(hz > 499 && hz < 501, "report rate %.1f Hz", hz);
+
+    // ---- 3. Staleness: no sample for kGyroStaleNs zeroes the rates and stops ----------
+    frames.clear();
+    run(dev, clock, due, t1 + VirtualHID::kGyroStaleNs + 10 * kMsNs, sv[1], frames);
+    CHECK(!frames.empty() && frames.back().rate[0] == 0 && frames.back().rate[1] == 0 && !dev.gyro.streaming,
+          "stale stream not zeroed");
+    CHECK(!VirtualHID::gyro_tick(dev.gyro, clock.now_ns()), "ticking after stopping");
+
+    // ---- 4. A restarted stream stamps from zero again; GYRO OFF zeroes once -----------
+    frames.clear();
+    HidDriver::dispatch(dev, "GYRO 0 0 -30");
+    CHECK(drain(sv[1], frames) == 1 && frames[0].stamp_us == 0 && frames[0].rate[2] == -30 * kRes,
+          "restart frame");
+    clock.advance(5 * kMsNs);
+    HidDriver::dispatch(dev, "GYRO OFF");
+    CHECK(drain(sv[1], frames) == 1 && frames.back().rate[2] == 0 && !dev.gyro.streaming, "GYRO OFF");
+    HidDriver::dispatch(dev, "GYRO OFF");
+    CHECK(drain(sv[1], frames) == 0, "second GYRO OFF wrote a frame");
+
+    // ---- 5. Clamping, long gaps and the tick switched off ---------------------------
+    frames.clear();
+    HidDriver::dispatch(dev, "GYRO 5000 -5000 0");
+    drain(sv[1], frames);
+    constexpr int kMax = VirtualHID::kGyroMaxDps * kRes;
+    CHECK(frames.size() == 1 && frames[0].rate[0] == kMax && frames[0].rate[1] == -kMax, "not clamped");
+    clock.advance(VirtualHID::kGyroMaxGlideNs + kMsNs);
+    HidDriver::dispatch(dev, "GYRO 10 10 10");
+    CHECK(drain(sv[1], frames) == 1 && frames.back().rate[0] == 10 * kRes, "a long gap should jump");
+    HidDriver::dispatch(dev, "GYRO OFF");
+    drain(sv[1], frames);
+    dev.gyro.tick_ns = 0;
+    for (const char* line : {"GYRO 1 2 3", "GYRO 4 5 6", "GYRO 7 8 9"}) {
+        clock.advance(kFrameNs);
+        HidDriver::dispatch(dev, line);
+    }
+    frames.clear();
+    CHECK(drain(sv[1], frames) == 3 && frames.back().rate[2] == 9 * kRes, "tick off: one frame per sample");
+    HidDriver::dispatch(dev, "GYRO OFF");
+    drain(sv[1], frames);
+
+    // ---- 6. Malformed lines ----------------------------------------------------------
+    const uint64_t malformed = Metrics::counter_value(Metrics::kCmdMalformed);
+    const char* const bad[] = {"GYRO", "GYRO 1", "GYRO 1 2", "GYRO x 1 2", "GYRO 1 2 -", "GYRO STOP"};
+    for (const char* line : bad) {
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Ignored, "'%s' accepted", line);
+    }
+    CHECK(Metrics::counter_value(Metrics::kCmdMalformed) - malformed == sizeof(bad) / sizeof(bad[0]),
+          "malformed counter");
+    frames.clear();
+    CHECK(drain(sv[1], frames) == 0 && !dev.gyro.streaming, "bad lines wrote or started something");
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_gyro");
+}
@@ -0,0 +1,164 @@
+/*
+ * test_inertia.cpp
+ * Flick inertia on a SimulatedClock: the release velocity, friction decay
+ * independent of the tick, releases that must not coast, screen edges, and
+ * new input cancelling a coast before its next tick.  The mouse writes to a
+ * SOCK_SEQPACKET socketpair.
+ */
+
+#include "command_dispatch.h"
+#include "event_loop.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using HidDriver::DispatchResult;
+
+namespace {
+
+constexpr int64_t kFrameNs = 33333333;      // ~30 fps producer
+constexpr int64_t kTickNs  = 4000000;
+
+/** ABS_X values written since the last drain. */
+std::vector<int> drain_x(int peer)
+{
+    std::vector<int> xs;
+    input_event buf[64];
+    for (;;) {
+        const ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) break;
+        for (ssize_t i = 0; i < n / static_cast<ssize_t>(sizeof(input_event)); ++i) {
+            if (buf[i].type == EV_ABS && buf[i].code == ABS_X) xs.push_back(buf[i].value);
+        }
+    }
+    return xs;
+}
+
+/** MOUSE_MOVE every frame, @p step px to the right from @p x0. */
+void stroke(HidDriver::Devices& dev, EventLoop::SimulatedClock& clock, int x0, int step, int frames)
+{
+    for (int i = 0; i < frames; ++i) {
+        clock.advance(kFrameNs);
+        HidDriver::dispatch(dev, "MOUSE_MOVE " + std::to_string(x0 + i * step) + " 500");
+    }
+}
+
+/**
+ * Tick until the coast ends, draining as it goes (a socketpair queues only
+ * a few hundred packets); @return the ABS_X values written.
+ */
+std::vector<int> coast(HidDriver::Devices& dev, int peer, EventLoop::SimulatedClock& clock, int64_t tick_ns,
+                       int* ticks = nullptr)
+{
+    std::vector<int> xs;
+    int n = 0;
+    bool more;
+    do {
+        clock.advance(tick_ns);
+        more = VirtualHID::mouse_inertia_tick(dev.mouse, clock.now_ns());
+        for (int x : drain_x(peer)) xs.push_back(x);
+    } while (more && ++n < 100000);
+    if (ticks) *ticks = n + 1;
+    return xs;
+}
+
+} // namespace
+
+int main()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    EventLoop::SimulatedClock clock(1000000000);
+    HidDriver::Devices dev;
+    dev.clock          = &clock;
+    dev.mouse.fd       = sv[0];
+    dev.mouse.screen_w = 1920;
+    dev.mouse.screen_h = 1080;
+
+    // ---- 1. Inertia off: a release changes nothing ------------------------------------
+    stroke(dev, clock, 100, 30, 6);
+    CHECK(HidDriver::dispatch(dev, "MOUSE_RELEASE") == DispatchResult::Handled, "MOUSE_RELEASE");
+    CHECK(!dev.mouse.coasting, "coasting with inertia off");
+    drain_x(sv[1]);
+
+    // ---- 2. A flick coasts and slows to a stop ---------------------------------------
+    // 30 px per frame = 900 px/s; friction 4/s then covers (v - 20) / 4 px more.
+    dev.mouse.friction = 4.0;
+    stroke(dev, clock, 100, 30, 6);
+    const double v = dev.mouse.vx;
+    CHECK(std::fabs(v - 900.0) < 30.0 && dev.mouse.vy == 0, "release velocity %.1f px/s", v);
+    HidDriver::dispatch(dev, "MOUSE_RELEASE");
+    CHECK(dev.mouse.coasting, "flick did not coast");
+    drain_x(sv[1]);
+    int ticks = 0;
+    const std::vector<int> xs = coast(dev, sv[1], clock, kTickNs, &ticks);
+    const int reach = static_cast<int>(std::lround((v - VirtualHID::kFlickStopSpeed) / 4.0));
+    CHECK(!xs.empty() && std::abs(xs.back() - (250 + reach)) <= 2, "coast ended at %d, expected %d",
+          xs.empty() ? -1 : xs.back(), 250 + reach);
+    bool slowing = true;
+    for (size_t i = 2; i < xs.size(); ++i) slowing &= xs[i] - xs[i - 1] <= xs[i - 1] - xs[i - 2] + 1;
+    CHECK(slowing, "coast did not slow down");
+    std::printf("[test_inertia] %.0f px/s flick: %zu moves over %d ticks (%.0f ms), %d px\n", v, xs.size(),
+                ticks, ticks * kTickNs / 1e6, xs.empty() ? 0 : xs.back() - 250);
+
+    // ---- 3. The path does not depend on the tick --------------------------------------
+    stroke(dev, clock, 100, 30, 6);
+    HidDriver::dispatch(dev, "MOUSE_RELEASE");
+    drain_x(sv[1]);
+    const std::vector<int> coarse = coast(dev, sv[1], clock, 4 * kTickNs);
+    CHECK(!coarse.empty() && std::abs(coarse.back() - xs.back()) <= 2,
+          "16 ms ticks end at %d, 4 ms ticks at %d", coarse.empty() ? -1 : coarse.back(), xs.back());
+
+    // ---- 4. Releases that must not coast ----------------------------------------------
+    stroke(dev, clock, 600, 10, 6);                          // 300 px/s: below kFlickMinSpeed
+    HidDriver::dispatch(dev, "MOUSE_RELEASE");
+    CHECK(!dev.mouse.coasting, "slow release coasted");
+    stroke(dev, clock, 600, 30, 6);
+    clock.advance(VirtualHID::kFlickMaxAgeNs + 1);          // the hand stopped before letting go
+    HidDriver::dispatch(dev, "MOUSE_RELEASE");
+    CHECK(!dev.mouse.coasting, "stale release coasted");
+    stroke(dev, clock, 600, 30, 1);                          // a single sample has no velocity
+    HidDriver::dispatch(dev, "MOUSE_RELEASE");
+    CHECK(!dev.mouse.coasting, "release after a pause coasted");
+
+    // ---- 5. Any new input cancels before the next tick; POWER does not ---------------
+    const char* const cancels[] = {"MOUSE_MOVE 900 500", "MOUSE_LEFT", "GAMEPAD_BTN A 1", "KEY_DOWN A",
+                                   "MOUSE_WARP 1 1"};
+    for (const char* line : cancels) {
+        stroke(dev, clock, 600, 30, 6);
+        HidDriver::dispatch(dev, "MOUSE_RELEASE");
+        drain_x(sv[1]);
+        clock.advance(kTickNs);
+        VirtualHID::mouse_inertia_tick(dev.mouse, clock.now_ns());
+        HidDriver::dispatch(dev, "POWER IDLE");
+        CHECK(dev.mouse.coasting, "POWER stopped the coast");
+        HidDriver::dispatch(dev, "POWER ACTIVE");
+        HidDriver::dispatch(dev, line);
+        CHECK(!dev.mouse.coasting, "'%s' did not cancel", line);
+        drain_x(sv[1]);
+        clock.advance(kTickNs);
+        CHECK(!VirtualHID::mouse_inertia_tick(dev.mouse, clock.now_ns()) && drain_x(sv[1]).empty(),
+              "'%s': a tick moved the cursor after the cancel", line);
+    }
+
+    // ---- 6. A screen edge stops the coast there --------------------------------------
+    stroke(dev, clock, 1700, 60, 4);                         // 1800 px/s towards x = 1919
+    HidDriver::dispatch(dev, "MOUSE_RELEASE");
+    drain_x(sv[1]);
+    const std::vector<int> edge = coast(dev, sv[1], clock, kTickNs);
+    CHECK(!edge.empty() && edge.back() == 1919 && !dev.mouse.coasting, "edge: ended at %d",
+          edge.empty() ? -1 : edge.back());
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_inertia");
+}
@@ -0,0 +1,259 @@
+/*
+ * test_keyboard.cpp
+ * Keyboard commands: key names, the US layout table, and the exact frames
+ * and write(2) batching of KEY_DOWN / KEY_UP / KEY_CHORD / TYPE.
+ *
+ * The keyboard fd is one end of a SOCK_SEQPACKET socketpair (as in
+ * test_budget.cpp), so every write(2) arrives as one packet.  Typed text is
+ * decoded back from the event stream with the inverse of the layout table
+ * and must match the input exactly.  Batches after the first of a long
+ * TYPE are written by keyboard_type_tick(), which the test calls in place
+ * of the driver's timer wheel.
+ */
+
+#include "command_dispatch.h"
+#include "keymap.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using HidDriver::DispatchResult;
+
+namespace {
+
+struct Ev { uint16_t type, code; int32_t value; };
+
+/** Packets (one per write(2)) received on the test end of the socketpair. */
+std::vector<std::vector<input_event>> drain(int peer)
+{
+    std::vector<std::vector<input_event>> writes;
+    input_event buf[256];
+    for (;;) {
+        const ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) break;
+        writes.emplace_back(buf, buf + n / static_cast<ssize_t>(sizeof(input_event)));
+    }
+    return writes;
+}
+
+std::vector<input_event> flatten(const std::vector<std::vector<input_event>>& writes)
+{
+    std::vector<input_event> all;
+    for (const auto& w : writes) all.insert(all.end(), w.begin(), w.end());
+    return all;
+}
+
+void check_events(const char* what, const std::vector<input_event>& got, const std::vector<Ev>& want)
+{
+    CHECK(got.size() == want.size(), "%s: %zu events, expected %zu", what, got.size(), want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i) {
+        CHECK(got[i].type == want[i].type && got[i].code == want[i].code && got[i].value == want[i].value,
+              "%s[%zu]: got (%u,%u,%d) expected (%u,%u,%d)", what, i,
+              got[i].type, got[i].code, got[i].value, want[i].type, want[i].code, want[i].value);
+    }
+}
+
+/** Replay a TYPE event stream through the inverse layout, like a US keymap would. */
+std::string decode(const std::vector<input_event>& events)
+{
+    std::map<std::pair<uint16_t, bool>, char> inverse;
+    for (int c = 1; c < 128; ++c) {
+        const char ch = static_cast<char>(c);
+        std::string_view one(&ch, 1);
+        Keymap::Stroke k;
+        if (Keymap::next_stroke(one, k)) inverse[{k.code, k.shift}] = ch;
+    }
+    std::string out;
+    bool shift = false;
+    for (const input_event& ev : events) {
+        if (ev.type != EV_KEY) continue;
+        if (ev.code == KEY_LEFTSHIFT) { shift = ev.value != 0; continue; }
+        if (ev.value != 1) continue;
+        const auto it = inverse.find({ev.code, shift});
+        out += it == inverse.end() ? '?' : it->second;
+    }
+    return out;
+}
+
+} // namespace
+
+int main()
+{
+    // ---- 1. Key names ---------------------------------------------------------
+    uint16_t code = 0;
+    CHECK(Keymap::key_code("CTRL", code) && code == KEY_LEFTCTRL, "CTRL alias");
+    CHECK(Keymap::key_code("SUPER", code) && code == KEY_LEFTMETA, "SUPER alias");
+    CHECK(Keymap::key_code("KEY_TAB", code) && code == KEY_TAB, "KEY_ prefix");
+    CHECK(Keymap::key_code("F12", code) && code == KEY_F12, "F12");
+    CHECK(Keymap::key_code("7", code) && code == KEY_7, "digit");
+    CHECK(!Keymap::key_code("ctrl", code), "names are case-sensitive");
+    CHECK(!Keymap::key_code("", code) && !Keymap::key_code("HYPER", code), "unknown names");
+
+    // ---- 2. Layout table ------------------------------------------------------
+    for (int c = 32; c < 127; ++c) {
+        const char ch = static_cast<char>(c);
+        std::string_view one(&ch, 1);
+        Keymap::Stroke k;
+        CHECK(Keymap::next_stroke(one, k) && one.empty(), "printable '%c' has no key", ch);
+    }
+    struct Case { const char* text; uint16_t code; bool shift; size_t consumed; };
+    const Case cases[] = {
+        {"a", KEY_A, false, 1},        {"A", KEY_A, true, 1},
+        {"?", KEY_SLASH, true, 1},     {"\"", KEY_APOSTROPHE, true, 1},
+        {"\\n", KEY_ENTER, false, 2},  {"\\t", KEY_TAB, false, 2},
+        {"\\\\", KEY_BACKSLASH, false, 2}, {"\\x", KEY_BACKSLASH, false, 1},
+    };
+    for (const Case& c : cases) {
+        std::string_view t = c.text;
+        Keymap::Stroke k{};
+        CHECK(Keymap::next_stroke(t, k) && k.code == c.code && k.shift == c.shift,
+              "'%s' -> (%u,%d)", c.text, k.code, k.shift);
+        CHECK(std::strlen(c.text) - t.size() == c.consumed, "'%s' consumed %zu", c.text,
+              std::strlen(c.text) - t.size());
+    }
+    for (const char* s : {"\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\x01"}) {
+        std::string_view t = s;
+        Keymap::Stroke k;
+        CHECK(!Keymap::next_stroke(t, k) && t.empty(), "unmapped code point %zu bytes", std::strlen(s));
+    }
+
+    // ---- 3. Frames and batching through dispatch -------------------------------
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    HidDriver::Devices dev;
+    dev.keyboard.fd = sv[0];
+
+    CHECK(HidDriver::dispatch(dev, "KEY_DOWN LEFTALT") == DispatchResult::Handled, "KEY_DOWN");
+    auto w = drain(sv[1]);
+    CHECK(w.size() == 1, "KEY_DOWN: %zu writes", w.size());
+    check_events("KEY_DOWN", flatten(w), {{EV_KEY, KEY_LEFTALT, 1}, {EV_SYN, SYN_REPORT, 0}});
+    HidDriver::dispatch(dev, "KEY_UP LEFTALT");
+    check_events("KEY_UP", flatten(drain(sv[1])), {{EV_KEY, KEY_LEFTALT, 0}, {EV_SYN, SYN_REPORT, 0}});
+
+    CHECK(HidDriver::dispatch(dev, "KEY_CHORD CTRL+SHIFT+TAB") == DispatchResult::Handled, "chord");
+    w = drain(sv[1]);
+    CHECK(w.size() == 1, "KEY_CHORD: %zu writes, expected one batch", w.size());
+    check_events("KEY_CHORD", flatten(w), {
+        {EV_KEY, KEY_LEFTCTRL, 1}, {EV_KEY, KEY_LEFTSHIFT, 1}, {EV_KEY, KEY_TAB, 1}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_TAB, 0}, {EV_KEY, KEY_LEFTSHIFT, 0}, {EV_KEY, KEY_LEFTCTRL, 0}, {EV_SYN, SYN_REPORT, 0},
+    });
+
+    HidDriver::dispatch(dev, "TYPE Hi!");
+    w = drain(sv[1]);
+    CHECK(w.size() == 1, "TYPE Hi!: %zu writes", w.size());
+    check_events("TYPE Hi!", flatten(w), {
+        {EV_KEY, KEY_LEFTSHIFT, 1}, {EV_KEY, KEY_H, 1}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_H, 0}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_LEFTSHIFT, 0}, {EV_KEY, KEY_I, 1}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_I, 0}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_LEFTSHIFT, 1}, {EV_KEY, KEY_1, 1}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_1, 0}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_LEFTSHIFT, 0}, {EV_SYN, SYN_REPORT, 0},
+    });
+
+    // Every printable character, twice, plus escapes: long enough to span batches.
+    std::string text;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int c = 32; c < 127; ++c) text += static_cast<char>(c) == '\\' ? std::string("\\\\")
+                                                                           : std::string(1, static_cast<char>(c));
+        text += "\\n\\t";
+    }
+    // The dispatch writes one batch and queues the rest; a KEY_DOWN meanwhile
+    // queues behind the text.  Each tick (the driver's timer) writes one batch.
+    HidDriver::dispatch(dev, "TYPE " + text);
+    w = drain(sv[1]);
+    CHECK(w.size() == 1 && dev.keyboard.typing, "TYPE dispatch: %zu writes, typing=%d", w.size(),
+          dev.keyboard.typing);
+    CHECK(HidDriver::dispatch(dev, "KEY_DOWN LEFTALT") == DispatchResult::Handled && drain(sv[1]).empty(),
+          "KEY_DOWN while typing must queue behind the text");
+    int ticks = 0;
+    while (dev.keyboard.typing && ticks < 100) {
+        VirtualHID::keyboard_type_tick(dev.keyboard);
+        const auto batch = drain(sv[1]);
+        CHECK(batch.size() == 1, "tick %d: %zu writes", ticks, batch.size());
+        w.insert(w.end(), batch.begin(), batch.end());
+        ++ticks;
+    }
+    std::vector<input_event> all = flatten(w);
+    CHECK(all.size() >= 2 && all[all.size() - 2].code == KEY_LEFTALT && all[all.size() - 2].value == 1,
+          "KEY_DOWN not after the text");
+    all.resize(all.size() - 2);
+    HidDriver::dispatch(dev, "KEY_UP LEFTALT");
+    drain(sv[1]);
+    size_t largest = 0;
+    bool   split   = false;
+    for (const auto& packet : w) {
+        largest = std::max(largest, packet.size());
+        split  |= packet.empty() || packet.back().type != EV_SYN;
+    }
+    std::string want;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int c = 32; c < 127; ++c) want += static_cast<char>(c);
+        want += "\n\t";
+    }
+    CHECK(decode(all) == want, "round trip:\n  got  '%s'\n  want '%s'", decode(all).c_str(), want.c_str());
+    CHECK(w.size() > 1 && largest <= VirtualHID::EventBatch::kCapacity,
+          "%zu writes, largest %zu events", w.size(), largest);
+    CHECK(!split, "a frame was split across writes");
+    CHECK(all.size() <= w.size() * VirtualHID::EventBatch::kCapacity &&
+          w.size() <= all.size() / (VirtualHID::EventBatch::kCapacity - 5) + 1,
+          "%zu events in %zu writes: batches under-filled", all.size(), w.size());
+
+    // ---- 4. Errors and unmapped text --------------------------------------------
+    const uint64_t unmapped = Metrics::counter_value(Metrics::kKeysUnmapped);
+    CHECK(HidDriver::dispatch(dev, "TYPE caf\xc3\xa9!") == DispatchResult::Handled, "TYPE with é");
+    CHECK(Metrics::counter_value(Metrics::kKeysUnmapped) == unmapped + 1, "é not counted as unmapped");
+    CHECK(decode(flatten(drain(sv[1]))) == "caf!", "unmapped character not skipped");
+
+    CHECK(HidDriver::dispatch(dev, "KEY_DOWN HYPER") == DispatchResult::Unknown, "unknown key");
+    CHECK(HidDriver::dispatch(dev, "KEY_CHORD CTRL+NOPE") == DispatchResult::Unknown, "unknown chord key");
+    CHECK(HidDriver::dispatch(dev, "KEY_DOWN") == DispatchResult::Ignored, "KEY_DOWN without key");
+    CHECK(HidDriver::dispatch(dev, "KEY_CHORD") == DispatchResult::Ignored, "empty chord");
+    for (const char* line : {"KEY_CHORD CTRL+", "KEY_CHORD +A", "KEY_CHORD CTRL++A", "KEY_CHORD +"}) {
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Ignored, "'%s' accepted", line);
+    }
+    CHECK(HidDriver::dispatch(dev, "KEY_CHORD A+B+C+D+E+F+G+H+I") == DispatchResult::Ignored,
+          "chord over kMaxChord");
+    CHECK(HidDriver::dispatch(dev, "TYPE") == DispatchResult::Ignored, "TYPE without text");
+    CHECK(HidDriver::dispatch(dev, "TYPE " + std::string(VirtualHID::kMaxTypeLen + 1, 'a')) ==
+          DispatchResult::Ignored && !dev.keyboard.typing, "TYPE over kMaxTypeLen must be refused whole");
+    CHECK(drain(sv[1]).empty(), "rejected commands wrote events");
+
+    // A full queue refuses further keyboard commands rather than reorder them.
+    const std::string half(VirtualHID::kMaxTypeLen, 'A');
+    CHECK(HidDriver::dispatch(dev, "TYPE " + half) == DispatchResult::Handled &&
+          HidDriver::dispatch(dev, "TYPE " + half) == DispatchResult::Handled &&
+          HidDriver::dispatch(dev, "TYPE " + half) == DispatchResult::Ignored, "third long TYPE must not fit");
+    auto queued = drain(sv[1]);
+    while (dev.keyboard.typing) {
+        VirtualHID::keyboard_type_tick(dev.keyboard);
+        const auto batch = drain(sv[1]);
+        queued.insert(queued.end(), batch.begin(), batch.end());
+    }
+    CHECK(decode(flatten(queued)) == half + half, "queued TYPEs in order");
+
+    // gap_ns 0: every batch in the dispatch itself
+    dev.keyboard.gap_ns = 0;
+    HidDriver::dispatch(dev, "TYPE " + text);
+    CHECK(!dev.keyboard.typing && decode(flatten(drain(sv[1]))) == want, "gap_ns 0: all batches at once");
+    dev.keyboard.gap_ns = int64_t{VirtualHID::kDefaultBatchGapUs} * 1000;
+
+    HidDriver::dispatch(dev, "TYPE   two");                       // one separator, the rest is text
+    CHECK(decode(flatten(drain(sv[1]))) == "  two", "leading spaces of TYPE text");
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_keyboard");
+}
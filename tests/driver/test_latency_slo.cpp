@@ -0,0 +1,212 @@
+/*
+ * test_latency_slo.cpp
+ * Tail-latency SLO test for the driver path under CPU contention.
+ *
+ * The main thread writes protocol lines into a pipe at a fixed rate and
+ * stamps each line's send time; a consumer thread reads them exactly like
+ * hid_driver's stdin loop (buffered getline) and dispatches to devices
+ * backed by /dev/null, stamping the time the last write(2) of the frame
+ * returned.  While this runs, CPU-hog threads spin on the same core as the
+ * producer and consumer.
+ *
+ * Scenarios: "realistic" (240 cmd/s, ~4 mapper frames per camera frame)
+ * and "worst" (5000 cmd/s).  p50 / p99 / p99.9 of pipe-write→emit latency
+ * are compared with the SLO table below; every latency sample is written to
+ * $GESTURELINK_RESULTS_DIR/latency_slo_driver.json (default ./results) in
+ * the bench_results.h schema so runs can be compared with bench/compare.py.
+ *
+ * SLOs can be overridden per run, e.g. GESTURELINK_SLO_DRIVER_P999_US=8000.
+ */
+
+#include "bench_results.h"
+#include "command_dispatch.h"
+#include "check.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Slo {
+    const char* env;
+    double      default_us;
+};
+
+const Slo kSloP99  = {"GESTURELINK_SLO_DRIVER_P99_US",  2000.0};
+const Slo kSloP999 = {"GESTURELINK_SLO_DRIVER_P999_US", 15000.0};   // README: sub-15 ms
+
+double slo_us(const Slo& s)
+{
+    const char* v = std::getenv(s.env);
+    return v ? std::atof(v) : s.default_us;
+}
+
+int64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t{ts.tv_sec} * 1000000000 + ts.tv_nsec;
+}
+
+void pin_to_cpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+int first_allowed_cpu()
+{
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &set)) return c;
+    }
+    return 0;
+}
+
+struct Result {
+    const char*         name;
+    int                 rate_hz;
+    std::vector<double> lat_us;
+    size_t              samples;
+    double              p50_us, p99_us, p999_us, max_us;
+};
+
+double percentile(std::vector<double> v, double q)
+{
+    if (v.empty()) return 0.0;
+    const size_t idx = std::min(v.size() - 1, static_cast<size_t>(q * static_cast<double>(v.size())));
+    std::nth_element(v.begin(), v.begin() + static_cast<long>(idx), v.end());
+    return v[idx];
+}
+
+Result run_scenario(const char* name, int rate_hz, int seconds, int cpu, int hogs)
+{
+    const size_t n = static_cast<size_t>(rate_hz) * static_cast<size_t>(seconds);
+    std::vector<int64_t> t_send(n, 0), t_emit(n, 0);
+
+    int p[2];
+    if (pipe(p) < 0) return {name, rate_hz, {}, 0, 0, 0, 0, 0};
+
+    std::atomic<bool> hog_run{true};
+    std::vector<std::thread> hog_threads;
+    for (int i = 0; i < hogs; ++i) {
+        hog_threads.emplace_back([&, cpu] {
+            pin_to_cpu(cpu);
+            volatile uint64_t x = 0;
+            while (hog_run.load(std::memory_order_relaxed)) x = x + 1;
+        });
+    }
+
+    std::thread consumer([&, cpu] {
+        pin_to_cpu(cpu);
+        HidDriver::Devices dev;
+        dev.mouse.fd   = open("/dev/null", O_WRONLY);
+        dev.gamepad.fd = open("/dev/null", O_WRONLY);
+        FILE* in = fdopen(p[0], "r");
+        char*  buf = nullptr;
+        size_t cap = 0;
+        size_t seq = 0;
+        ssize_t len;
+        while (seq < n && (len = getline(&buf, &cap, in)) > 0) {
+            if (buf[len - 1] == '\n') --len;
+            HidDriver::dispatch(dev, std::string_view(buf, static_cast<size_t>(len)));
+            t_emit[seq++] = now_ns();
+        }
+        free(buf);
+        fclose(in);
+        close(dev.mouse.fd);
+        close(dev.gamepad.fd);
+    });
+
+    pin_to_cpu(cpu);
+    const int64_t period = 1000000000LL / rate_hz;
+    int64_t next = now_ns();
+    char line[64];
+    for (size_t i = 0; i < n; ++i) {
+        next += period;
+        struct timespec ts{static_cast<time_t>(next / 1000000000), static_cast<long>(next % 1000000000)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+
+        int len = (i % 8 == 7)
+            ? std::snprintf(line, sizeof(line), "GAMEPAD_STICK %d %d\n", static_cast<int>(i % 60000) - 30000, 1200)
+            : std::snprintf(line, sizeof(line), "MOUSE_MOVE %zu %zu\n", i % 1920, i % 1080);
+        t_send[i] = now_ns();
+        if (write(p[1], line, static_cast<size_t>(len)) != len) break;
+    }
+    close(p[1]);
+    consumer.join();
+    hog_run = false;
+    for (auto& t : hog_threads) t.join();
+
+    std::vector<double> lat;
+    lat.reserve(n);
+    double max_us = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (t_emit[i] == 0 || t_send[i] == 0) continue;
+        const double us = static_cast<double>(t_emit[i] - t_send[i]) / 1000.0;
+        lat.push_back(us);
+        max_us = std::max(max_us, us);
+    }
+    Result r{name, rate_hz, {}, lat.size(), 0, 0, 0, max_us};
+    r.p50_us  = percentile(lat, 0.50);
+    r.p99_us  = percentile(lat, 0.99);
+    r.p999_us = percentile(lat, 0.999);
+    r.lat_us  = std::move(lat);
+    return r;
+}
+
+void write_json(const std::vector<Result>& results, int hogs, double p99_slo, double p999_slo)
+{
+    std::vector<BenchResults::Benchmark> benches;
+    for (const Result& r : results) {
+        BenchResults::Benchmark b;
+        b.name    = std::string("pipe_write_to_emit/") + r.name;
+        b.unit    = "us";
+        b.samples = r.lat_us;
+        b.metrics = {
+            {"rate_hz", r.rate_hz}, {"hog_threads", hogs},
+            {"p50_us", r.p50_us}, {"p99_us", r.p99_us}, {"p999_us", r.p999_us},
+            {"max_us", r.max_us}, {"slo_p99_us", p99_slo}, {"slo_p999_us", p999_slo},
+        };
+        benches.push_back(std::move(b));
+    }
+    const std::string path = BenchResults::write("latency_slo_driver", benches);
+    if (!path.empty()) std::printf("results written to %s\n", path.c_str());
+}
+
+} // namespace
+
+int main()
+{
+    const int cpu  = first_allowed_cpu();
+    const int hogs = 2;
+    const double p99_slo  = slo_us(kSloP99);
+    const double p999_slo = slo_us(kSloP999);
+
+    std::vector<Result> results;
+    results.push_back(run_scenario("realistic", 240,  4, cpu, hogs));
+    results.push_back(run_scenario("worst",     5000, 2, cpu, hogs));
+
+    for (const Result& r : results) {
+        std::printf("%-10s %5d Hz  n=%-6zu p50=%8.1fus  p99=%8.1fus  p99.9=%8.1fus  max=%8.1fus\n",
+                    r.name, r.rate_hz, r.samples, r.p50_us, r.p99_us, r.p999_us, r.max_us);
+        CHECK(r.samples > 0, "%s: no samples collected", r.name);
+        CHECK(r.p99_us <= p99_slo, "%s: p99 %.1fus exceeds SLO %.1fus", r.name, r.p99_us, p99_slo);
+        CHECK(r.p999_us <= p999_slo, "%s: p99.9 %.1fus exceeds SLO %.1fus", r.name, r.p999_us, p999_slo);
+    }
+
+    write_json(results, hogs, p99_slo, p999_slo);
+    return Check::check_exit("test_latency_slo");
+}
@@ -0,0 +1,270 @@
+/*
+ * test_macro.cpp
+ * Macros: compiling a macro file into flat event runs, rejecting bad lines
+ * by line number, and playback on a SimulatedClock — frames at their
+ * defined times, several macros at once, restarts, late ticks, MACRO_STOP
+ * releasing what a macro holds, and malformed MACRO lines.  The gamepad
+ * and keyboard write to SOCK_SEQPACKET socketpairs.
+ */
+
+#include "command_dispatch.h"
+#include "event_loop.h"
+#include "macro.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using HidDriver::DispatchResult;
+
+namespace {
+
+constexpr int64_t kSecNs = 1000000000;
+constexpr int64_t kMsNs  = 1000000;
+
+constexpr const char* kMacros =
+    "# fighting-game combos\n"
+    "[hadouken]\n"
+    "0    GAMEPAD_STICK 0 32767\n"
+    "40   GAMEPAD_STICK 23170 23170\n"
+    "80   GAMEPAD_STICK 40000 0\n"      // clamped to 32767
+    "80   GAMEPAD_BTN A 1\n"
+    "130  GAMEPAD_BTN A 0\n"
+    "130  GAMEPAD_STICK 0 0\n"
+    "\n"
+    "[save]\n"
+    "16.5 KEY_UP S\n"                   // listed first, played second
+    "0    KEY_DOWN CTRL\n"
+    "0    KEY_DOWN S\n"
+    "33   KEY_UP CTRL\n"
+    "[hold]\n"
+    "0    GAMEPAD_BTN LB 1\n"
+    "0    KEY_DOWN SHIFT\n"
+    "500  GAMEPAD_BTN LB 0\n"
+    "500  KEY_UP SHIFT\n";
+
+/** One write read back from a device: when, and what it carried. */
+struct Frame {
+    int64_t                  t_ns;
+    std::vector<input_event> events;
+};
+
+void drain(int peer, int64_t t_ns, std::vector<Frame>& out)
+{
+    input_event buf[64];
+    for (;;) {
+        const ssize_t len = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) break;
+        out.push_back({t_ns, std::vector<input_event>(buf, buf + len / sizeof(input_event))});
+    }
+}
+
+/** Tick the way hid_driver arms its timer (kSlackNs / 2 early) until nothing is running. */
+void run(HidDriver::Devices& dev, EventLoop::SimulatedClock& clock, int pad, int kbd,
+         std::vector<Frame>& pad_out, std::vector<Frame>& kbd_out)
+{
+    while (dev.macros.next_ns != 0) {
+        const int64_t at = dev.macros.next_ns - Macro::kSlackNs / 2;
+        if (at > clock.now_ns()) clock.set(at);
+        Macro::tick(dev.macros, clock.now_ns());
+        drain(pad, clock.now_ns(), pad_out);
+        drain(kbd, clock.now_ns(), kbd_out);
+    }
+}
+
+bool has(const Frame& f, uint16_t type, uint16_t code, int32_t value)
+{
+    for (const input_event& e : f.events) {
+        if (e.type == type && e.code == code && e.value == value) return true;
+    }
+    return false;
+}
+
+/** The line number compile_macros() blames for @p text, or 0 if it compiles. */
+int error_line(const std::string& text)
+{
+    Macro::Set set;
+    std::string error;
+    if (HidDriver::compile_macros(text, set, error)) return 0;
+    return std::atoi(error.c_str() + 5);                      // "line <n>: ..."
+}
+
+} // namespace
+
+int main()
+{
+    int pad[2], kbd[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, pad) < 0 || socketpair(AF_UNIX, SOCK_SEQPACKET, 0, kbd) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+
+    // ---- 1. Compiling: one flat array, a SYN per time and device -------------------
+    Macro::Set set;
+    std::string error;
+    CHECK(HidDriver::compile_macros(kMacros, set, error), "compile: %s", error.c_str());
+    CHECK(set.defs.size() == 3, "%zu macros", set.defs.size());
+    const Macro::Def* had = set.find("hadouken");
+    const Macro::Def* save = set.find("save");
+    CHECK(had && save && set.find("hold") && !set.find("nope"), "find()");
+    // hadouken: 2+SYN, 2+SYN, 3+SYN, 3+SYN = 14 events; save: 2+SYN, 1+SYN, 1+SYN.
+    CHECK(had->first == 0 && had->count == 14 && had->length_ns == 130 * kMsNs,
+          "hadouken: first %u count %u", had->first, had->count);
+    CHECK(save->first == 14 && save->count == 7 && save->length_ns == 33 * kMsNs,
+          "save: first %u count %u", save->first, save->count);
+    const Macro::Event& clamped = set.events[had->first + 6];
+    CHECK(clamped.code == ABS_X && clamped.value == 32767 && clamped.t_ns == 80 * kMsNs, "stick not clamped");
+    const Macro::Event& key_up = set.events[save->first + 3];
+    CHECK(key_up.code == KEY_S && key_up.value == 0 && key_up.t_ns == 16500000, "steps not sorted by time");
+    // hold: gamepad and keyboard at the same time are separate frames.
+    const Macro::Def* hold = set.find("hold");
+    CHECK(hold->count == 8 && set.events[hold->first + 1].type == EV_SYN &&
+          set.events[hold->first + 1].target == Macro::kGamepad, "hold: %u events", hold->count);
+
+    // ---- 2. Bad lines are reported by number and leave nothing behind ---------------
+    struct Bad { const char* text; int line; };
+    const Bad bad[] = {
+        {"0 KEY_DOWN A\n", 1},                                   // before any [name]
+        {"[a]\n0 KEY_DOWN A\n[a]\n0 KEY_UP A\n", 3},             // defined twice
+        {"[a]\n[b]\n0 KEY_DOWN A\n", 1},                         // no steps
+        {"[a]\n# c\nx KEY_DOWN A\n", 3},                         // bad time
+        {"[a]\n-5 KEY_DOWN A\n", 2},                             // negative time
+        {"[a]\n0 KEY_DOWN NOPE\n", 2},                           // unknown key
+        {"[a]\n0 GAMEPAD_BTN Z 1\n", 2},                         // unknown button
+        {"[a]\n0 GAMEPAD_BTN A\n", 2},                           // missing state
+        {"[a]\n0 GAMEPAD_STICK 1\n", 2},                         // missing y
+        {"[a]\n0 MOUSE_LEFT\n", 2},                              // not allowed in a macro
+        {"[a]\n0 KEY_DOWN A B\n", 2},                            // trailing text
+        {"[a] x\n0 KEY_DOWN A\n", 1},                            // junk after the name
+        {"[]\n", 1},                                             // empty name
+    };
+    for (const Bad& b : bad) {
+        CHECK(error_line(b.text) == b.line, "'%s': blamed line %d, expected %d", b.text, error_line(b.text),
+              b.line);
+    }
+    Macro::Set broken = set;
+    CHECK(!HidDriver::compile_macros("[a]\n0 KEY_DOWN NOPE\n", broken, error) && broken.defs.empty() &&
+          error.find("NOPE") != std::string::npos, "failed compile: %s", error.c_str());
+    CHECK(HidDriver::compile_macros("# nothing\n\n", broken, error) && broken.defs.empty(), "empty file");
+
+    // ---- 3. Playback: every frame within half a tick of its defined time -----------
+    EventLoop::SimulatedClock clock(kSecNs);
+    HidDriver::Devices dev;
+    dev.clock       = &clock;
+    dev.gamepad.fd  = pad[0];
+    dev.keyboard.fd = kbd[0];
+    dev.macros.fd[Macro::kGamepad]  = pad[0];
+    dev.macros.fd[Macro::kKeyboard] = kbd[0];
+    dev.macros.set  = &set;
+    std::vector<Frame> pad_out, kbd_out;
+
+    const int64_t t0 = clock.now_ns();
+    CHECK(HidDriver::dispatch(dev, "MACRO hadouken") == DispatchResult::Handled, "MACRO hadouken");
+    drain(pad[1], t0, pad_out);
+    CHECK(pad_out.size() == 1 && has(pad_out[0], EV_ABS, ABS_Y, 32767), "first frame goes out with the command");
+    CHECK(dev.macros.active == 1 && dev.macros.next_ns == t0 + 40 * kMsNs, "next frame at +40 ms");
+    run(dev, clock, pad[1], kbd[1], pad_out, kbd_out);
+    const int64_t ideal[] = {0, 40, 80, 130};
+    CHECK(pad_out.size() == 4, "%zu frames, expected 4", pad_out.size());
+    bool on_time = pad_out.size() == 4;
+    for (size_t i = 0; on_time && i < 4; ++i) {
+        on_time = std::llabs(pad_out[i].t_ns - (t0 + ideal[i] * kMsNs)) <= Macro::kSlackNs / 2 &&
+                  pad_out[i].events.back().type == EV_SYN;
+    }
+    CHECK(on_time, "frames off their defined times");
+    CHECK(pad_out.size() == 4 && has(pad_out[2], EV_KEY, BTN_SOUTH, 1) && has(pad_out[2], EV_ABS, ABS_X, 32767) &&
+          has(pad_out[3], EV_KEY, BTN_SOUTH, 0) && has(pad_out[3], EV_ABS, ABS_Y, 0), "frame contents");
+    CHECK(dev.macros.active == 0 && dev.macros.next_ns == 0, "macro still running after its last frame");
+
+    // ---- 4. Two macros at once, on two devices ---------------------------------------
+    pad_out.clear();
+    kbd_out.clear();
+    const int64_t t1 = clock.now_ns();
+    HidDriver::dispatch(dev, "MACRO save");
+    clock.advance(10 * kMsNs);
+    HidDriver::dispatch(dev, "MACRO hadouken");
+    CHECK(dev.macros.active == 2, "%d running", dev.macros.active);
+    drain(pad[1], clock.now_ns(), pad_out);
+    drain(kbd[1], t1, kbd_out);
+    run(dev, clock, pad[1], kbd[1], pad_out, kbd_out);
+    CHECK(pad_out.size() == 4 && kbd_out.size() == 3, "%zu pad, %zu keyboard frames", pad_out.size(), kbd_out.size());
+    CHECK(kbd_out.size() == 3 && has(kbd_out[0], EV_KEY, KEY_LEFTCTRL, 1) && has(kbd_out[0], EV_KEY, KEY_S, 1) &&
+          has(kbd_out[1], EV_KEY, KEY_S, 0) && std::llabs(kbd_out[1].t_ns - (t1 + 16500000)) <= Macro::kSlackNs / 2 &&
+          has(kbd_out[2], EV_KEY, KEY_LEFTCTRL, 0), "save frames");
+
+    // ---- 5. A late tick writes every frame it missed, in order ------------------------
+    pad_out.clear();
+    const int64_t t2 = clock.now_ns();
+    HidDriver::dispatch(dev, "MACRO hadouken");
+    clock.set(t2 + 100 * kMsNs);
+    Macro::tick(dev.macros, clock.now_ns());
+    drain(pad[1], clock.now_ns(), pad_out);
+    CHECK(pad_out.size() == 2 && pad_out[1].events.size() == 7 && has(pad_out[1], EV_ABS, ABS_X, 23170) &&
+          has(pad_out[1], EV_KEY, BTN_SOUTH, 1), "late tick: %zu writes", pad_out.size());
+    run(dev, clock, pad[1], kbd[1], pad_out, kbd_out);
+
+    // ---- 6. MACRO_STOP releases what the macro holds; MACRO restarts -------------------
+    pad_out.clear();
+    kbd_out.clear();
+    HidDriver::dispatch(dev, "MACRO hold");
+    HidDriver::dispatch(dev, "MACRO save");
+    clock.advance(10 * kMsNs);
+    HidDriver::dispatch(dev, "MACRO hold");                       // restart: releases, then presses again
+    drain(pad[1], clock.now_ns(), pad_out);
+    drain(kbd[1], clock.now_ns(), kbd_out);
+    CHECK(dev.macros.active == 2 && pad_out.size() == 3 && has(pad_out[1], EV_KEY, BTN_TL, 0) &&
+          has(pad_out[2], EV_KEY, BTN_TL, 1), "restart: %zu pad writes", pad_out.size());
+    pad_out.clear();
+    kbd_out.clear();
+    CHECK(HidDriver::dispatch(dev, "MACRO_STOP hold") == DispatchResult::Handled, "MACRO_STOP hold");
+    drain(pad[1], clock.now_ns(), pad_out);
+    drain(kbd[1], clock.now_ns(), kbd_out);
+    CHECK(pad_out.size() == 1 && has(pad_out[0], EV_KEY, BTN_TL, 0) && kbd_out.size() == 1 &&
+          has(kbd_out[0], EV_KEY, KEY_LEFTSHIFT, 0), "stop did not release LB and SHIFT");
+    CHECK(dev.macros.active == 1 && dev.macros.next_ns == clock.now_ns() - 10 * kMsNs + 16500000,
+          "save should still run");
+    kbd_out.clear();
+    HidDriver::dispatch(dev, "MACRO_STOP");
+    drain(kbd[1], clock.now_ns(), kbd_out);
+    CHECK(dev.macros.active == 0 && dev.macros.next_ns == 0 && kbd_out.size() == 1 &&
+          has(kbd_out[0], EV_KEY, KEY_LEFTCTRL, 0) && has(kbd_out[0], EV_KEY, KEY_S, 0),
+          "MACRO_STOP with no name");
+    CHECK(HidDriver::dispatch(dev, "MACRO_STOP") == DispatchResult::Handled, "stop with nothing running");
+
+    // ---- 7. A restart keeps its slot; a fifth macro and bad lines are refused ---------
+    const uint64_t unknown = Metrics::counter_value(Metrics::kCmdUnknown);
+    const uint64_t malformed = Metrics::counter_value(Metrics::kCmdMalformed);
+    Macro::Set busy;
+    CHECK(HidDriver::compile_macros("[a]\n0 KEY_DOWN A\n100 KEY_UP A\n[b]\n0 KEY_DOWN B\n100 KEY_UP B\n"
+                                    "[c]\n0 KEY_DOWN C\n100 KEY_UP C\n[d]\n0 KEY_DOWN D\n100 KEY_UP D\n"
+                                    "[e]\n0 KEY_DOWN E\n100 KEY_UP E\n", busy, error), "%s", error.c_str());
+    dev.macros.set = &busy;
+    for (const char* line : {"MACRO a", "MACRO a", "MACRO a"}) HidDriver::dispatch(dev, line);
+    CHECK(dev.macros.active == 1, "a restart took another slot: %d running", dev.macros.active);
+    for (const char* line : {"MACRO b", "MACRO c", "MACRO d"}) HidDriver::dispatch(dev, line);
+    CHECK(dev.macros.active == Macro::kMaxPlaying, "%d running", dev.macros.active);
+    CHECK(HidDriver::dispatch(dev, "MACRO e") == DispatchResult::Ignored, "fifth macro started");
+    HidDriver::dispatch(dev, "MACRO_STOP");
+    drain(kbd[1], clock.now_ns(), kbd_out);
+    dev.macros.set = &set;
+    CHECK(HidDriver::dispatch(dev, "MACRO nope") == DispatchResult::Unknown, "unknown macro");
+    CHECK(HidDriver::dispatch(dev, "MACRO") == DispatchResult::Ignored, "MACRO without a name");
+    CHECK(Metrics::counter_value(Metrics::kCmdUnknown) - unknown == 1 &&
+          Metrics::counter_value(Metrics::kCmdMalformed) - malformed == 1,
+          "counters: a busy MACRO is well-formed, only the nameless one counts as malformed");
+    HidDriver::Devices none;
+    none.clock = &clock;
+    CHECK(HidDriver::dispatch(none, "MACRO hadouken") == DispatchResult::Unknown, "no macro file loaded");
+
+    close(pad[0]);
+    close(pad[1]);
+    close(kbd[0]);
+    close(kbd[1]);
+    return Check::check_exit("test_macro");
+}
@@ -0,0 +1,171 @@
+/*
+ * test_metrics.cpp
+ * Tests for the driver metrics shards and the Prometheus exporter.
+ */
+
+#include "command_dispatch.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string scrape(const std::string& path, const char* request)
+{
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return "";
+    }
+    send(fd, request, std::strlen(request), 0);
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) out.append(buf, static_cast<size_t>(n));
+    close(fd);
+    return out;
+}
+
+static bool has_line(const std::string& text, const std::string& line)
+{
+    return text.find("\n" + line + "\n") != std::string::npos;
+}
+
+int main()
+{
+    // ---- 1. Sharded counters sum correctly across threads ------------------
+    constexpr int kThreads = 4, kPerThread = 100000;
+    const uint64_t before = Metrics::counter_value(Metrics::kEventsEmitted);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < kPerThread; ++i) Metrics::inc(Metrics::kEventsEmitted);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    const uint64_t got = Metrics::counter_value(Metrics::kEventsEmitted) - before;
+    CHECK(got == uint64_t{kThreads} * kPerThread, "sharded sum %llu, expected %d",
+          static_cast<unsigned long long>(got), kThreads * kPerThread);
+
+    // ---- 2. Dispatch feeds command counters and device gauges ---------------
+    HidDriver::Devices dev;                                    // fds closed: no writes
+    HidDriver::dispatch(dev, "MOUSE_MOVE 640 360");
+    HidDriver::dispatch(dev, "MOUSE_MOVE 641 361");
+    HidDriver::dispatch(dev, "GAMEPAD_STICK -100 200");
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO A 15 50");
+    HidDriver::dispatch(dev, "NOT_A_COMMAND");
+    HidDriver::dispatch(dev, "MOUSE_SCROLL");                 // malformed
+    HidDriver::dispatch(dev, "POWER IDLE");
+    HidDriver::dispatch(dev, "POWER SLEEP");                  // malformed
+    HidDriver::dispatch(dev, "KEY_CHORD CTRL+TAB");
+    HidDriver::dispatch(dev, "TYPE na\xc3\xafve");             // one character off the layout
+    HidDriver::dispatch(dev, "TOUCH 0 10 10 1 20 20 2 30 30");
+    HidDriver::dispatch(dev, "TOUCH 1 UP");
+    HidDriver::dispatch(dev, "PEN 10.5 10 900 0 0");
+    dev.pointers.count = 2;
+    HidDriver::dispatch(dev, "POINTER 0 10 10 1 DOWN LEFT");
+    HidDriver::dispatch(dev, "GYRO 10 0 0");
+    HidDriver::dispatch(dev, "GYRO OFF");
+    Metrics::inc(Metrics::kFfUploads);
+    Metrics::set_gauge(Metrics::kFfPlaying, 1);
+    Metrics::observe_dispatch_ns(1500);                        // 1.5 us  -> le=2e-06
+    Metrics::observe_dispatch_ns(75000000);                    // 75 ms   -> +Inf only
+    Metrics::observe_turbo_edge_ns(300000);                    // 0.3 ms  -> le=0.0005
+    Metrics::observe_macro_drift_ns(4000);                     // 4 us    -> le=5e-06
+
+    const std::string text = Metrics::render();
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"MOUSE_MOVE\"} 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"GAMEPAD_STICK\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"GAMEPAD_TURBO\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_turbo_buttons 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"unknown\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"malformed\"} 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"POWER\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_power_idle 1") && dev.idle, "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"KEY_CHORD\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"TYPE\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_events_dropped_total{reason=\"unmapped_char\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_device_open{device=\"keyboard\"} 0"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"TOUCH\"} 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_touch_contacts 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"PEN\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_device_axis{device=\"pen\",axis=\"pressure\"} 900"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"POINTER\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_device_open{device=\"pointers\"} 0"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_commands_total{command=\"GYRO\"} 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_device_open{device=\"gyro\"} 0"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_ff_requests_total{request=\"upload\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_ff_playing 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_device_axis{device=\"mouse\",axis=\"x\"} 641"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_device_axis{device=\"gamepad\",axis=\"x\"} -100"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_dispatch_latency_seconds_bucket{le=\"1e-06\"} 0"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_dispatch_latency_seconds_bucket{le=\"2e-06\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_dispatch_latency_seconds_bucket{le=\"0.05\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_dispatch_latency_seconds_bucket{le=\"+Inf\"} 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_dispatch_latency_seconds_count 2"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_turbo_edge_error_seconds_bucket{le=\"0.0002\"} 0"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_turbo_edge_error_seconds_bucket{le=\"0.0005\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_turbo_edge_error_seconds_count 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_macro_drift_seconds_bucket{le=\"5e-06\"} 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_macro_drift_seconds_count 1"), "%s", text.c_str());
+    CHECK(has_line(text, "hid_driver_macros_running 0"), "%s", text.c_str());
+    CHECK(text.find("# TYPE hid_driver_dispatch_latency_seconds histogram\n") != std::string::npos,
+          "missing TYPE line");
+    CHECK(text.find("hid_driver_thread_cpu_seconds_total{tid=") != std::string::npos,
+          "no per-thread CPU samples");
+
+    // ---- 3. Exporter over a Unix socket -------------------------------------
+    const std::string path = "/tmp/test_metrics-" + std::to_string(getpid()) + ".sock";
+    if (!Metrics::serve("unix:" + path)) {
+        std::printf("cannot bind %s\n", path.c_str());
+        return Check::kSkipExitCode;
+    }
+    const std::string ok = scrape(path, "GET /metrics HTTP/1.0\r\n\r\n");
+    CHECK(ok.rfind("HTTP/1.0 200 OK\r\n", 0) == 0, "response:\n%s", ok.c_str());
+    CHECK(ok.find("text/plain; version=0.0.4") != std::string::npos, "content type missing");
+    CHECK(ok.find("hid_driver_commands_total{command=\"MOUSE_MOVE\"} 2\n") != std::string::npos,
+          "scrape body missing counters");
+    CHECK(ok.find("thread=\"hid_metrics\"") != std::string::npos, "exporter thread not named");
+
+    const std::string query = scrape(path, "GET /metrics?x=1 HTTP/1.0\r\n\r\n");
+    CHECK(query.rfind("HTTP/1.0 200 OK\r\n", 0) == 0, "response:\n%s", query.c_str());
+    for (const char* bad : {"GET /nope HTTP/1.0\r\n\r\n", "GET /metricsfoo HTTP/1.0\r\n\r\n",
+                            "GET /metrics/x HTTP/1.0\r\n\r\n"}) {
+        const std::string nf = scrape(path, bad);
+        CHECK(nf.rfind("HTTP/1.0 404", 0) == 0, "%.20s response:\n%s", bad, nf.c_str());
+    }
+
+    Metrics::stop();
+    CHECK(access(path.c_str(), F_OK) != 0, "socket %s not removed on stop", path.c_str());
+
+    // A stale socket (left by a crash) is replaced; any other file is left alone
+    const int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    CHECK(stale >= 0 && bind(stale, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "stale socket");
+    close(stale);
+    CHECK(Metrics::serve("unix:" + path), "could not rebind over a stale socket");
+    Metrics::stop();
+    const std::string file = "/tmp/test_metrics-" + std::to_string(getpid()) + ".txt";
+    FILE* f = std::fopen(file.c_str(), "w");
+    CHECK(f && std::fputs("keep\n", f) >= 0, "create %s", file.c_str());
+    if (f) std::fclose(f);
+    CHECK(!Metrics::serve("unix:" + file), "bound over a regular file");
+    CHECK(access(file.c_str(), F_OK) == 0, "serve() deleted regular file %s", file.c_str());
+    unlink(file.c_str());
+
+    // ---- 4. Non-loopback TCP is refused -------------------------------------
+    CHECK(!Metrics::serve("0.0.0.0:0"), "bound a non-loopback address");
+
+    return Check::check_exit("test_metrics");
+}
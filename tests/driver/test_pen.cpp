@@ -0,0 +1,210 @@
+/*
+ * test_pen.cpp
+ * Pen tablet: exact frames of PEN / PEN OUT, subpixel parsing, the contact
+ * hysteresis under pressure noise, and position glides on a SimulatedClock,
+ * over a SOCK_SEQPACKET socketpair (one packet per write(2), as in
+ * test_budget.cpp).
+ */
+
+#include "command_dispatch.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <random>
+#include <string>
+#include <vector>
+
+using HidDriver::DispatchResult;
+using VirtualHID::kPenSubpixel;
+
+namespace {
+
+struct Ev { uint16_t type, code; int32_t value; };
+
+std::vector<std::vector<input_event>> drain(int peer)
+{
+    std::vector<std::vector<input_event>> writes;
+    input_event buf[64];
+    for (;;) {
+        const ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) break;
+        writes.emplace_back(buf, buf + n / static_cast<ssize_t>(sizeof(input_event)));
+    }
+    return writes;
+}
+
+/** Exactly one write carrying exactly @p want (no write at all if @p want is empty). */
+void check_frame(const char* what, int peer, const std::vector<Ev>& want)
+{
+    const auto w = drain(peer);
+    CHECK(w.size() == (want.empty() ? 0u : 1u), "%s: %zu writes", what, w.size());
+    const std::vector<input_event> got = w.empty() ? std::vector<input_event>{} : w[0];
+    CHECK(got.size() == want.size(), "%s: %zu events, expected %zu", what, got.size(), want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i) {
+        CHECK(got[i].type == want[i].type && got[i].code == want[i].code && got[i].value == want[i].value,
+              "%s[%zu]: got (%u,%u,%d) expected (%u,%u,%d)", what, i,
+              got[i].type, got[i].code, got[i].value, want[i].type, want[i].code, want[i].value);
+    }
+}
+
+std::string pen(const char* xy, int pressure, int tx = 0, int ty = 0)
+{
+    return std::string("PEN ") + xy + " " + std::to_string(pressure) + " " + std::to_string(tx) + " " +
+           std::to_string(ty);
+}
+
+/** BTN_TOUCH transitions in a stream of writes. */
+int touch_transitions(const std::vector<std::vector<input_event>>& writes)
+{
+    int n = 0;
+    for (const auto& packet : writes) {
+        for (const input_event& ev : packet) n += ev.type == EV_KEY && ev.code == BTN_TOUCH;
+    }
+    return n;
+}
+
+} // namespace
+
+int main()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    EventLoop::SimulatedClock clock(1000000000);
+    HidDriver::Devices dev;
+    dev.clock        = &clock;
+    dev.pen.fd       = sv[0];
+    dev.pen.screen_w = 1920;
+    dev.pen.screen_h = 1080;
+
+    // ---- 1. Proximity, contact and tilt: exact frames --------------------------------
+    CHECK(HidDriver::dispatch(dev, pen("100.5 200.25", 0)) == DispatchResult::Handled, "hover");
+    check_frame("enter", sv[1], {
+        {EV_KEY, BTN_TOOL_PEN, 1}, {EV_ABS, ABS_X, 1608}, {EV_ABS, ABS_Y, 3204}, {EV_SYN, SYN_REPORT, 0},
+    });
+    HidDriver::dispatch(dev, pen("100.5 200.25", VirtualHID::kPenContactOn - 1));
+    check_frame("below contact", sv[1], {});
+    HidDriver::dispatch(dev, pen("100.5 200.25", 500));
+    check_frame("touch down", sv[1], {
+        {EV_ABS, ABS_PRESSURE, 500}, {EV_KEY, BTN_TOUCH, 1}, {EV_SYN, SYN_REPORT, 0},
+    });
+    CHECK(Metrics::counter_value(Metrics::kCmdPen) >= 3, "PEN not counted");
+    HidDriver::dispatch(dev, pen("100.5 200.25", VirtualHID::kPenContactOff));
+    check_frame("still touching", sv[1], {
+        {EV_ABS, ABS_PRESSURE, VirtualHID::kPenContactOff}, {EV_SYN, SYN_REPORT, 0},
+    });
+    HidDriver::dispatch(dev, pen("100.5 200.25", VirtualHID::kPenContactOff - 1, 30, -100));
+    check_frame("lift + tilt", sv[1], {
+        {EV_ABS, ABS_TILT_X, 30}, {EV_ABS, ABS_TILT_Y, -VirtualHID::kPenMaxTilt},
+        {EV_ABS, ABS_PRESSURE, 0}, {EV_KEY, BTN_TOUCH, 0}, {EV_SYN, SYN_REPORT, 0},
+    });
+    HidDriver::dispatch(dev, pen("100.5 200.25", 4095, 30, -90));
+    drain(sv[1]);
+    CHECK(HidDriver::dispatch(dev, "PEN OUT") == DispatchResult::Handled, "PEN OUT");
+    check_frame("out", sv[1], {
+        {EV_ABS, ABS_PRESSURE, 0}, {EV_KEY, BTN_TOUCH, 0}, {EV_KEY, BTN_TOOL_PEN, 0}, {EV_SYN, SYN_REPORT, 0},
+    });
+    HidDriver::dispatch(dev, "PEN OUT");
+    check_frame("out twice", sv[1], {});
+
+    // ---- 2. Subpixel parsing and clamping -------------------------------------------
+    struct Xy { const char* xy; int x, y; };
+    const Xy coords[] = {
+        {"0.03125 +7", 1, 7 * kPenSubpixel},                      // 0.5 unit rounds up
+        {"12 .5", 12 * kPenSubpixel, kPenSubpixel / 2},
+        {"1919.99 1079.999999", 1920 * kPenSubpixel - 1, 1080 * kPenSubpixel - 1},
+        {"-4.5 3.", 0, 3 * kPenSubpixel},
+    };
+    for (const Xy& c : coords) {
+        HidDriver::dispatch(dev, pen(c.xy, 0));
+        const int x = dev.pen.abs.get<ABS_X>(), y = dev.pen.abs.get<ABS_Y>();
+        CHECK(x == c.x && y == c.y, "'%s' -> (%d,%d), expected (%d,%d)", c.xy, x, y, c.x, c.y);
+    }
+    const char* const bad[] = {
+        "PEN", "PEN 1 2 3", "PEN 1 2 3 4", "PEN 1.2.3 4 5 6 7", "PEN x 1 1 1 1", "PEN - 1 1 1 1",
+        "PEN . 1 1 1 1", "PEN 1e3 1 1 1 1", "PEN 1 1 1.5 0 0", "PEN 99999999999 1 1 1 1",
+    };
+    drain(sv[1]);
+    for (const char* line : bad) {
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Ignored, "'%s' accepted", line);
+    }
+    CHECK(drain(sv[1]).empty(), "malformed PEN wrote events");
+
+    // ---- 3. Hysteresis: noise around either threshold never chatters ----------------
+    std::mt19937 rng(93);
+    auto noisy = [&](int centre) { return centre - 100 + static_cast<int>(rng() % 201); };
+    HidDriver::dispatch(dev, pen("500 500", 1000));
+    drain(sv[1]);
+    int naive = 0, changes = 0;
+    bool naive_touch = true;
+    for (int i = 0; i < 1000; ++i) {
+        const int p = noisy(VirtualHID::kPenContactOn);
+        naive += (p >= VirtualHID::kPenContactOn) != naive_touch;
+        naive_touch = p >= VirtualHID::kPenContactOn;
+        HidDriver::dispatch(dev, pen("500 500", p));
+        changes += touch_transitions(drain(sv[1]));
+    }
+    CHECK(changes == 0 && dev.pen.touching, "pen lifted on noise above kPenContactOff");
+    HidDriver::dispatch(dev, pen("500 500", 0));
+    drain(sv[1]);
+    for (int i = 0; i < 1000; ++i) {
+        HidDriver::dispatch(dev, pen("500 500", noisy(VirtualHID::kPenContactOff)));
+        changes += touch_transitions(drain(sv[1]));
+    }
+    CHECK(changes == 0 && !dev.pen.touching, "pen touched on noise below kPenContactOn");
+    std::printf("[test_pen] pressure noise at the contact threshold: %d BTN_TOUCH changes with one "
+                "threshold, 0 with hysteresis\n", naive);
+
+    // ---- 4. Glide: one producer interval, one frame per tick ----------------------
+    const int64_t tick = 4000000, interval = 40000000;
+    dev.pen.tick_ns = tick;
+    HidDriver::dispatch(dev, "PEN OUT");
+    HidDriver::dispatch(dev, pen("100 100", 0));
+    drain(sv[1]);
+    clock.advance(interval);
+    HidDriver::dispatch(dev, pen("140 100", 0));
+    check_frame("glide starts", sv[1], {});
+    CHECK(dev.pen.gliding, "no glide");
+    int frames = 0, last_x = dev.pen.abs.get<ABS_X>();
+    bool monotonic = true, more = true;
+    while (more) {
+        clock.advance(tick);
+        more = VirtualHID::pen_tick(dev.pen, clock.now_ns());
+        for (const auto& packet : drain(sv[1])) {
+            ++frames;
+            monotonic &= packet.size() == 2 && packet[0].code == ABS_X && packet[0].value > last_x;
+            last_x = packet[0].value;
+        }
+    }
+    CHECK(frames == interval / tick, "%d glide frames, expected %lld", frames,
+          static_cast<long long>(interval / tick));
+    CHECK(monotonic && last_x == 140 * kPenSubpixel, "glide ended at %d", last_x);
+
+    // Touch-down mid-glide jumps to the sample so the stroke starts under the nib.
+    HidDriver::dispatch(dev, pen("180 100", 0));
+    clock.advance(tick);
+    VirtualHID::pen_tick(dev.pen, clock.now_ns());
+    drain(sv[1]);
+    clock.advance(tick);
+    HidDriver::dispatch(dev, pen("200 120", 800));
+    check_frame("touch down mid-glide", sv[1], {
+        {EV_ABS, ABS_X, 200 * kPenSubpixel}, {EV_ABS, ABS_Y, 120 * kPenSubpixel},
+        {EV_ABS, ABS_PRESSURE, 800}, {EV_KEY, BTN_TOUCH, 1}, {EV_SYN, SYN_REPORT, 0},
+    });
+    CHECK(!dev.pen.gliding && !VirtualHID::pen_tick(dev.pen, clock.now_ns()), "glide survived touch-down");
+
+    // A gap longer than kPenMaxGlideNs jumps.
+    clock.advance(VirtualHID::kPenMaxGlideNs + 1);
+    HidDriver::dispatch(dev, pen("300 120", 800));
+    CHECK(!dev.pen.gliding && dev.pen.abs.get<ABS_X>() == 300 * kPenSubpixel, "long gap glided");
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_pen");
+}
@@ -0,0 +1,139 @@
+/*
+ * test_pointers.cpp
+ * Independent pointers: exact frames of POINTER on each device, several
+ * updates to one pointer coalesced into one frame, unchanged pointers left
+ * alone, per-pointer button state, and lines that must change nothing.
+ * Every pointer writes to its own SOCK_SEQPACKET socketpair (one packet per
+ * write(2), as in test_touch.cpp).
+ */
+
+#include "command_dispatch.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <vector>
+
+using HidDriver::DispatchResult;
+
+namespace {
+
+constexpr int kPointers = 3;
+
+struct Ev { uint16_t type, code; int32_t value; };
+
+std::vector<std::vector<input_event>> drain(int peer)
+{
+    std::vector<std::vector<input_event>> writes;
+    input_event buf[64];
+    for (;;) {
+        const ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) break;
+        writes.emplace_back(buf, buf + n / static_cast<ssize_t>(sizeof(input_event)));
+    }
+    return writes;
+}
+
+/** Exactly one write carrying exactly @p want (none if @p want is empty). */
+void check_frame(const char* what, int id, int peer, const std::vector<Ev>& want)
+{
+    const auto w = drain(peer);
+    CHECK(w.size() == (want.empty() ? 0u : 1u), "%s: pointer %d: %zu writes", what, id, w.size());
+    const std::vector<input_event> got = w.empty() ? std::vector<input_event>{} : w[0];
+    CHECK(got.size() == want.size(), "%s: pointer %d: %zu events, expected %zu", what, id, got.size(),
+          want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i) {
+        CHECK(got[i].type == want[i].type && got[i].code == want[i].code && got[i].value == want[i].value,
+              "%s: pointer %d [%zu]: got (%u,%u,%d) expected (%u,%u,%d)", what, id, i,
+              got[i].type, got[i].code, got[i].value, want[i].type, want[i].code, want[i].value);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    int peers[kPointers];
+    HidDriver::Devices dev;
+    for (int i = 0; i < kPointers; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+            std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+            return Check::kSkipExitCode;
+        }
+        dev.pointers.p[i].fd = sv[0];
+        peers[i] = sv[1];
+    }
+    dev.pointers.count    = kPointers;
+    dev.pointers.screen_w = 1920;
+    dev.pointers.screen_h = 1080;
+
+    // ---- 1. Each pointer gets its own frame; untouched pointers stay silent --------
+    CHECK(HidDriver::dispatch(dev, "POINTER 0 100 200 1 1500 600") == DispatchResult::Handled, "move");
+    check_frame("first move", 0, peers[0],
+                {{EV_ABS, ABS_X, 100}, {EV_ABS, ABS_Y, 200}, {EV_SYN, SYN_REPORT, 0}});
+    check_frame("first move", 1, peers[1],
+                {{EV_ABS, ABS_X, 1500}, {EV_ABS, ABS_Y, 600}, {EV_SYN, SYN_REPORT, 0}});
+    check_frame("first move", 2, peers[2], {});
+
+    // One axis changed on pointer 1; pointer 0 repeated unchanged.
+    HidDriver::dispatch(dev, "POINTER 0 100 200 1 1510 600");
+    check_frame("one axis", 0, peers[0], {});
+    check_frame("one axis", 1, peers[1], {{EV_ABS, ABS_X, 1510}, {EV_SYN, SYN_REPORT, 0}});
+
+    // ---- 2. Buttons are per pointer ------------------------------------------------
+    HidDriver::dispatch(dev, "POINTER 0 DOWN LEFT 1 DOWN RIGHT");
+    check_frame("press", 0, peers[0], {{EV_KEY, BTN_LEFT, 1}, {EV_SYN, SYN_REPORT, 0}});
+    check_frame("press", 1, peers[1], {{EV_KEY, BTN_RIGHT, 1}, {EV_SYN, SYN_REPORT, 0}});
+    HidDriver::dispatch(dev, "POINTER 0 DOWN LEFT");
+    check_frame("press again", 0, peers[0], {});
+
+    // Drag on 0 while 1 releases: position before buttons in each frame.
+    HidDriver::dispatch(dev, "POINTER 0 120 210 0 DOWN MIDDLE 1 UP RIGHT");
+    check_frame("drag", 0, peers[0], {
+        {EV_ABS, ABS_X, 120}, {EV_ABS, ABS_Y, 210}, {EV_KEY, BTN_MIDDLE, 1}, {EV_SYN, SYN_REPORT, 0},
+    });
+    check_frame("drag", 1, peers[1], {{EV_KEY, BTN_RIGHT, 0}, {EV_SYN, SYN_REPORT, 0}});
+    CHECK(dev.pointers.p[0].buttons == 0b101 && dev.pointers.p[1].buttons == 0, "button state");
+
+    // ---- 3. Several updates to one pointer coalesce into one frame --------------------
+    HidDriver::dispatch(dev, "POINTER 2 10 10 2 20 20 2 DOWN LEFT 2 UP LEFT 2 30 40");
+    check_frame("coalesced", 2, peers[2],
+                {{EV_ABS, ABS_X, 30}, {EV_ABS, ABS_Y, 40}, {EV_SYN, SYN_REPORT, 0}});
+    HidDriver::dispatch(dev, "POINTER 0 UP LEFT 0 UP MIDDLE 0 DOWN LEFT");
+    check_frame("release and press", 0, peers[0], {{EV_KEY, BTN_MIDDLE, 0}, {EV_SYN, SYN_REPORT, 0}});
+
+    // ---- 4. Positions are clamped to the screen ---------------------------------------
+    HidDriver::dispatch(dev, "POINTER 1 -50 5000");
+    check_frame("clamp", 1, peers[1], {{EV_ABS, ABS_X, 0}, {EV_ABS, ABS_Y, 1079}, {EV_SYN, SYN_REPORT, 0}});
+
+    // ---- 5. Malformed lines and bad ids change nothing --------------------------------
+    const uint64_t malformed = Metrics::counter_value(Metrics::kCmdMalformed);
+    const char* const bad[] = {
+        "POINTER", "POINTER 0", "POINTER 0 1", "POINTER 3 1 1", "POINTER -1 1 1", "POINTER x 1 1",
+        "POINTER 0 DOWN", "POINTER 0 DOWN THUMB", "POINTER 0 PRESS LEFT", "POINTER 0 500 500 1 1",
+        "POINTER 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 0 1 1 "
+        "0 1 1 0 1 1 0 1 1",
+    };
+    for (const char* line : bad) {
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Ignored, "'%s' accepted", line);
+    }
+    for (int i = 0; i < kPointers; ++i) check_frame("malformed", i, peers[i], {});
+    CHECK(Metrics::counter_value(Metrics::kCmdMalformed) - malformed == sizeof(bad) / sizeof(bad[0]),
+          "malformed counter");
+    CHECK(dev.pointers.p[0].x == 120 && dev.pointers.p[0].buttons == 0b001, "state after bad lines");
+
+    // ---- 6. Pointers beyond the configured count do not exist -------------------------
+    dev.pointers.count = 1;
+    CHECK(HidDriver::dispatch(dev, "POINTER 1 5 5") == DispatchResult::Ignored, "pointer 1 after count=1");
+    dev.pointers.count = kPointers;
+
+    for (int i = 0; i < kPointers; ++i) {
+        close(dev.pointers.p[i].fd);
+        close(peers[i]);
+    }
+    return Check::check_exit("test_pointers");
+}
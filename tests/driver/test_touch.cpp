@@ -0,0 +1,200 @@
+/*
+ * test_touch.cpp
+ * Type-B multitouch: the slot cache, exact frames of TOUCH and the
+ * single-touch emulation, over a SOCK_SEQPACKET socketpair (one packet per
+ * write(2), as in test_budget.cpp).
+ *
+ * Every frame is also replayed into a model of an evdev reader (per-slot
+ * state, current slot) that must end up agreeing with the driver's cache:
+ * emitting only changes is only correct if nothing a reader needs is lost.
+ */
+
+#include "command_dispatch.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <random>
+#include <string>
+#include <vector>
+
+using HidDriver::DispatchResult;
+using VirtualHID::kMaxTouchSlots;
+
+namespace {
+
+struct Ev { uint16_t type, code; int32_t value; };
+
+std::vector<std::vector<input_event>> drain(int peer)
+{
+    std::vector<std::vector<input_event>> writes;
+    input_event buf[128];
+    for (;;) {
+        const ssize_t n = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) break;
+        writes.emplace_back(buf, buf + n / static_cast<ssize_t>(sizeof(input_event)));
+    }
+    return writes;
+}
+
+/** Exactly one write carrying exactly @p want. */
+void check_frame(const char* what, int peer, const std::vector<Ev>& want)
+{
+    const auto w = drain(peer);
+    CHECK(w.size() == (want.empty() ? 0u : 1u), "%s: %zu writes", what, w.size());
+    const std::vector<input_event> got = w.empty() ? std::vector<input_event>{} : w[0];
+    CHECK(got.size() == want.size(), "%s: %zu events, expected %zu", what, got.size(), want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i) {
+        CHECK(got[i].type == want[i].type && got[i].code == want[i].code && got[i].value == want[i].value,
+              "%s[%zu]: got (%u,%u,%d) expected (%u,%u,%d)", what, i,
+              got[i].type, got[i].code, got[i].value, want[i].type, want[i].code, want[i].value);
+    }
+}
+
+/** What an evdev client knows after reading the stream. */
+struct Reader {
+    VirtualHID::TouchSlot slots[kMaxTouchSlots];
+    int  slot = 0;
+    bool touching = false;
+
+    void feed(const std::vector<input_event>& events)
+    {
+        for (const input_event& ev : events) {
+            if (ev.type == EV_KEY && ev.code == BTN_TOUCH) touching = ev.value != 0;
+            if (ev.type != EV_ABS) continue;
+            switch (ev.code) {
+                case ABS_MT_SLOT:        slot = ev.value;                  break;
+                case ABS_MT_TRACKING_ID: slots[slot].tracking_id = ev.value; break;
+                case ABS_MT_POSITION_X:  slots[slot].x = ev.value;         break;
+                case ABS_MT_POSITION_Y:  slots[slot].y = ev.value;         break;
+            }
+        }
+    }
+};
+
+} // namespace
+
+int main()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    HidDriver::Devices dev;
+    dev.touch.fd       = sv[0];
+    dev.touch.screen_w = 1920;
+    dev.touch.screen_h = 1080;
+
+    // ---- 1. Contacts down, moved, lifted: exact frames ---------------------------
+    CHECK(HidDriver::dispatch(dev, "TOUCH 0 100 200 1 300 400") == DispatchResult::Handled, "two down");
+    check_frame("two down", sv[1], {
+        {EV_ABS, ABS_MT_TRACKING_ID, 0}, {EV_ABS, ABS_MT_POSITION_X, 100}, {EV_ABS, ABS_MT_POSITION_Y, 200},
+        {EV_ABS, ABS_MT_SLOT, 1},
+        {EV_ABS, ABS_MT_TRACKING_ID, 1}, {EV_ABS, ABS_MT_POSITION_X, 300}, {EV_ABS, ABS_MT_POSITION_Y, 400},
+        {EV_KEY, BTN_TOUCH, 1}, {EV_ABS, ABS_X, 100}, {EV_ABS, ABS_Y, 200}, {EV_SYN, SYN_REPORT, 0},
+    });
+
+    // Slot 0 unchanged, slot 1 moves in x only: slot 1 is still current, no ABS_MT_SLOT.
+    HidDriver::dispatch(dev, "TOUCH 0 100 200 1 310 400");
+    check_frame("one axis", sv[1], {{EV_ABS, ABS_MT_POSITION_X, 310}, {EV_SYN, SYN_REPORT, 0}});
+
+    HidDriver::dispatch(dev, "TOUCH 0 100 200 1 310 400");
+    check_frame("no change", sv[1], {});
+
+    // Pinch: both move; emulation follows slot 0.
+    HidDriver::dispatch(dev, "TOUCH 0 120 210 1 290 390");
+    check_frame("pinch", sv[1], {
+        {EV_ABS, ABS_MT_SLOT, 0}, {EV_ABS, ABS_MT_POSITION_X, 120}, {EV_ABS, ABS_MT_POSITION_Y, 210},
+        {EV_ABS, ABS_MT_SLOT, 1}, {EV_ABS, ABS_MT_POSITION_X, 290}, {EV_ABS, ABS_MT_POSITION_Y, 390},
+        {EV_ABS, ABS_X, 120}, {EV_ABS, ABS_Y, 210}, {EV_SYN, SYN_REPORT, 0},
+    });
+
+    // Lift slot 0: emulation hands over to slot 1; a lift of a free slot is a no-op.
+    HidDriver::dispatch(dev, "TOUCH 0 UP 5 UP");
+    check_frame("lift 0", sv[1], {
+        {EV_ABS, ABS_MT_SLOT, 0}, {EV_ABS, ABS_MT_TRACKING_ID, -1},
+        {EV_ABS, ABS_X, 290}, {EV_ABS, ABS_Y, 390}, {EV_SYN, SYN_REPORT, 0},
+    });
+    HidDriver::dispatch(dev, "TOUCH 1 UP");
+    check_frame("lift 1", sv[1], {
+        {EV_ABS, ABS_MT_SLOT, 1}, {EV_ABS, ABS_MT_TRACKING_ID, -1},
+        {EV_KEY, BTN_TOUCH, 0}, {EV_SYN, SYN_REPORT, 0},
+    });
+
+    // A new contact gets a new tracking id; positions are clamped to the screen.
+    HidDriver::dispatch(dev, "TOUCH 1 -50 5000");
+    check_frame("new id, clamped", sv[1], {
+        {EV_ABS, ABS_MT_TRACKING_ID, 2}, {EV_ABS, ABS_MT_POSITION_X, 0}, {EV_ABS, ABS_MT_POSITION_Y, 1079},
+        {EV_KEY, BTN_TOUCH, 1}, {EV_ABS, ABS_X, 0}, {EV_ABS, ABS_Y, 1079}, {EV_SYN, SYN_REPORT, 0},
+    });
+    HidDriver::dispatch(dev, "TOUCH 1 UP");
+    drain(sv[1]);
+
+    // ---- 2. Malformed commands change nothing --------------------------------------
+    const char* const bad[] = {
+        "TOUCH", "TOUCH 0 10", "TOUCH 10 1 1", "TOUCH -1 1 1", "TOUCH 0 1 1 1 DOWN",
+        "TOUCH 0 1 1 1 2 2 2 3 3 3 4 4 4 5 5 5 6 6 6 7 7 7 8 8 8 9 9 9 0 UP",   // 11 items
+    };
+    for (const char* line : bad) {
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Ignored, "'%s' accepted", line);
+    }
+    CHECK(drain(sv[1]).empty(), "malformed TOUCH wrote events");
+    for (const VirtualHID::TouchSlot& s : dev.touch.slots) {
+        CHECK(s.tracking_id == -1, "malformed TOUCH changed slot state");
+    }
+
+    // ---- 3. All ten fingers in one frame, one write ---------------------------------
+    std::string ten = "TOUCH";
+    for (int i = 0; i < kMaxTouchSlots; ++i) ten += " " + std::to_string(i) + " " +
+                                                    std::to_string(100 * i) + " " + std::to_string(50 * i);
+    HidDriver::dispatch(dev, ten);
+    auto w = drain(sv[1]);
+    CHECK(w.size() == 1 && w[0].back().type == EV_SYN, "ten contacts: %zu writes", w.size());
+    CHECK(Metrics::counter_value(Metrics::kCmdTouch) > 0, "TOUCH not counted");
+
+    // ---- 4. Random streams: an evdev reader's view matches the cache ---------------
+    Reader reader;
+    for (const auto& packet : w) reader.feed(packet);
+    std::mt19937 rng(92);
+    size_t events = 0, frames = 0;
+    for (int i = 0; i < 5000; ++i) {
+        std::string line = "TOUCH";
+        const int items = 1 + static_cast<int>(rng() % kMaxTouchSlots);
+        for (int k = 0; k < items; ++k) {
+            const int slot = static_cast<int>(rng() % kMaxTouchSlots);
+            line += " " + std::to_string(slot);
+            line += rng() % 6 == 0 ? std::string(" UP")
+                                   : " " + std::to_string(rng() % 2000) + " " + std::to_string(rng() % 1100);
+        }
+        HidDriver::dispatch(dev, line);
+        for (const auto& packet : drain(sv[1])) {
+            CHECK(packet.back().type == EV_SYN, "frame split across writes");
+            reader.feed(packet);
+            events += packet.size();
+            ++frames;
+        }
+    }
+    bool any = false;
+    for (int s = 0; s < kMaxTouchSlots; ++s) {
+        const VirtualHID::TouchSlot& want = dev.touch.slots[s];
+        const VirtualHID::TouchSlot& got  = reader.slots[s];
+        any |= want.tracking_id >= 0;
+        CHECK(got.tracking_id == want.tracking_id, "slot %d: reader id %d, driver %d", s,
+              got.tracking_id, want.tracking_id);
+        if (want.tracking_id >= 0) {
+            CHECK(got.x == want.x && got.y == want.y, "slot %d: reader (%d,%d), driver (%d,%d)", s,
+                  got.x, got.y, want.x, want.y);
+        }
+    }
+    CHECK(reader.touching == any, "BTN_TOUCH %d with contacts %d", reader.touching, any);
+    std::printf("[test_touch] random stream: 5000 commands, %zu frames, %.1f events/frame\n",
+                frames, frames ? static_cast<double>(events) / static_cast<double>(frames) : 0.0);
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_touch");
+}
@@ -0,0 +1,218 @@
+/*
+ * test_turbo.cpp
+ * Gamepad turbo on a SimulatedClock: edges at their ideal times, achieved
+ * rate and duty over a second, several buttons sharing frames, late ticks
+ * that skip instead of replaying, stopping, the shortest phases staying
+ * frames apart, and malformed GAMEPAD_TURBO lines (including phases below
+ * kMinTurboPhaseNs).  The gamepad writes to a SOCK_SEQPACKET socketpair.
+ */
+
+#include "command_dispatch.h"
+#include "event_loop.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+using HidDriver::DispatchResult;
+
+namespace {
+
+constexpr int64_t kSecNs = 1000000000;
+
+struct Edge { int64_t t_ns; uint16_t code; int value; int write; };
+
+/** One frame per write: the EV_KEY changes it carries, stamped @p t_ns. */
+int drain(int peer, int64_t t_ns, std::vector<Edge>& out, int& writes)
+{
+    input_event buf[64];
+    int n = 0;
+    for (;;) {
+        const ssize_t len = recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) break;
+        ++writes;
+        for (ssize_t i = 0; i < len / static_cast<ssize_t>(sizeof(input_event)); ++i) {
+            if (buf[i].type == EV_KEY) out.push_back({t_ns, buf[i].code, buf[i].value, writes});
+        }
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * Tick the way hid_driver arms its timer: @p early_ns (by default
+ * kTurboCoalesceNs / 2) before each next edge, until @p end_ns.
+ * @return the edges written.
+ */
+std::vector<Edge> run(HidDriver::Devices& dev, int peer, EventLoop::SimulatedClock& clock, int64_t end_ns,
+                      int* writes = nullptr, int64_t early_ns = VirtualHID::kTurboCoalesceNs / 2)
+{
+    std::vector<Edge> edges;
+    int w = 0;
+    while (dev.gamepad.turbo_next_ns != 0) {
+        const int64_t at = dev.gamepad.turbo_next_ns - early_ns;
+        if (at > end_ns) break;
+        if (at > clock.now_ns()) clock.set(at);
+        VirtualHID::gamepad_turbo_tick(dev.gamepad, clock.now_ns());
+        drain(peer, clock.now_ns(), edges, w);
+    }
+    clock.set(end_ns);
+    if (writes) *writes = w;
+    return edges;
+}
+
+int count(const std::vector<Edge>& edges, uint16_t code, int value)
+{
+    int n = 0;
+    for (const Edge& e : edges) n += e.code == code && e.value == value;
+    return n;
+}
+
+} // namespace
+
+int main()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        std::printf("socketpair(AF_UNIX, SOCK_SEQPACKET) unavailable: %d\n", errno);
+        return Check::kSkipExitCode;
+    }
+    EventLoop::SimulatedClock clock(kSecNs);
+    HidDriver::Devices dev;
+    dev.clock      = &clock;
+    dev.gamepad.fd = sv[0];
+    std::vector<Edge> edges;
+    int writes = 0;
+
+    // ---- 1. The first press goes out with the command ----------------------------
+    const int64_t t0 = clock.now_ns();
+    CHECK(HidDriver::dispatch(dev, "GAMEPAD_TURBO A 15 50") == DispatchResult::Handled, "GAMEPAD_TURBO");
+    CHECK(drain(sv[1], t0, edges, writes) == 1 && edges.size() == 1 && edges[0].value == 1,
+          "first press: %zu edges", edges.size());
+    CHECK(dev.gamepad.turbo_count == 1 && dev.gamepad.turbo_next_ns == t0 + kSecNs / 15 / 2,
+          "next edge at %lld", static_cast<long long>(dev.gamepad.turbo_next_ns - t0));
+
+    // ---- 2. 15 Hz at 50 % for a second: every edge within half a tick --------------
+    // Up to just before the 16th press: 14 more presses, 15 releases.
+    edges = run(dev, sv[1], clock, t0 + kSecNs - 2000000);
+    CHECK(count(edges, BTN_SOUTH, 1) == 14 && count(edges, BTN_SOUTH, 0) == 15,
+          "%d presses, %d releases in 1 s", count(edges, BTN_SOUTH, 1) + 1, count(edges, BTN_SOUTH, 0));
+    const int64_t period = kSecNs / 15;
+    bool on_time = true, alternates = true;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const int k = static_cast<int>(i) + 1;                     // edge k after the first press
+        const int64_t ideal = t0 + k / 2 * period + (k % 2 ? period / 2 : 0);
+        on_time &= std::llabs(edges[i].t_ns - ideal) <= VirtualHID::kTurboCoalesceNs / 2;
+        alternates &= edges[i].value == (k % 2 ? 0 : 1);
+    }
+    CHECK(on_time && alternates, "edges off their ideal times or out of order");
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO A 0");
+    edges.clear();
+    drain(sv[1], clock.now_ns(), edges, writes);
+    CHECK(dev.gamepad.turbo_count == 0 && dev.gamepad.turbo_next_ns == 0, "turbo still running");
+
+    // ---- 3. Duty cycle: 20 Hz held 25 % of each period -----------------------------
+    const int64_t t1 = clock.now_ns();
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO B 20 25");
+    edges.clear();
+    drain(sv[1], t1, edges, writes);
+    std::vector<Edge> more = run(dev, sv[1], clock, t1 + kSecNs - 2000000);
+    edges.insert(edges.end(), more.begin(), more.end());
+    int64_t held = 0;
+    for (size_t i = 0; i + 1 < edges.size(); i += 2) held += edges[i + 1].t_ns - edges[i].t_ns;
+    CHECK(count(edges, BTN_EAST, 1) == 20 && std::llabs(held - kSecNs / 4) < 20 * 600000,
+          "20 Hz / 25 %%: %d presses, held %.1f ms", count(edges, BTN_EAST, 1), held / 1e6);
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO B 0");
+    drain(sv[1], clock.now_ns(), edges, writes);
+
+    // ---- 4. Buttons sharing edges share frames --------------------------------------
+    // X at 10 Hz and Y at 20 Hz from the same instant, LB 0.4 ms later: every
+    // X edge coincides with a Y edge, and LB's are within kTurboCoalesceNs.
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO X 10 50");
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO Y 20 50");
+    clock.advance(400000);
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO LB 10 50");
+    drain(sv[1], clock.now_ns(), edges, writes);
+    edges = run(dev, sv[1], clock, clock.now_ns() + kSecNs, &writes);
+    const int xy_edges = count(edges, BTN_NORTH, 0) + count(edges, BTN_NORTH, 1);
+    CHECK(xy_edges == 20 && count(edges, BTN_WEST, 1) + count(edges, BTN_WEST, 0) == 40,
+          "X %d edges, Y %d edges", xy_edges, count(edges, BTN_WEST, 1) + count(edges, BTN_WEST, 0));
+    CHECK(writes == 40, "%d writes for 80 edges of three buttons, expected 40 (one per Y edge)", writes);
+    bool shared = true;
+    for (const Edge& e : edges) {
+        if (e.code != BTN_NORTH) continue;
+        int with = 0;
+        for (const Edge& o : edges) with += o.write == e.write && o.code != BTN_NORTH;
+        shared &= with == 2;
+    }
+    CHECK(shared, "X edges not in the same frame as Y and LB");
+
+    // ---- 5. A late tick jumps to the current phase ----------------------------------
+    for (const char* line : {"GAMEPAD_TURBO X 0", "GAMEPAD_TURBO Y 0", "GAMEPAD_TURBO LB 0"}) {
+        HidDriver::dispatch(dev, line);
+    }
+    drain(sv[1], clock.now_ns(), edges, writes);
+    const int64_t t2 = clock.now_ns();
+    HidDriver::dispatch(dev, "GAMEPAD_TURBO A 10 50");
+    drain(sv[1], t2, edges, writes);
+    clock.set(t2 + 2 * kSecNs / 10 + kSecNs / 40);                 // 2.25 periods: pressed again
+    VirtualHID::gamepad_turbo_tick(dev.gamepad, clock.now_ns());
+    edges.clear();
+    CHECK(drain(sv[1], clock.now_ns(), edges, writes) == 0 && dev.gamepad.turbo[0].down,
+          "late tick replayed %zu missed edges", edges.size());
+    CHECK(dev.gamepad.turbo_next_ns == t2 + 2 * kSecNs / 10 + kSecNs / 20, "next edge after a late tick");
+
+    // ---- 6. GAMEPAD_BTN takes a button back from turbo ------------------------------
+    HidDriver::dispatch(dev, "GAMEPAD_BTN A 0");
+    edges.clear();
+    drain(sv[1], clock.now_ns(), edges, writes);
+    CHECK(dev.gamepad.turbo_count == 0 && !edges.empty() && edges.back().value == 0, "GAMEPAD_BTN kept turbo");
+
+    // ---- 7. The shortest accepted phases stay frames apart --------------------------
+    // 60 Hz at 13 % and 88 % leave a press or release just over kMinTurboPhaseNs.
+    // Ticking a whole kTurboCoalesceNs early, the worst hid_driver arms, must
+    // still write every edge of A in its own frame, a tick after the last.
+    for (const char* line : {"GAMEPAD_TURBO A 60 13", "GAMEPAD_TURBO A 60 88"}) {
+        const int64_t t3 = clock.now_ns();
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Handled, "'%s' rejected", line);
+        edges.clear();
+        drain(sv[1], t3, edges, writes);
+        more = run(dev, sv[1], clock, t3 + kSecNs / 4 - 2000000, nullptr, VirtualHID::kTurboCoalesceNs);
+        edges.insert(edges.end(), more.begin(), more.end());
+        bool apart = count(edges, BTN_SOUTH, 1) == 15;
+        for (size_t i = 1; i < edges.size(); ++i) {
+            apart &= edges[i].write != edges[i - 1].write && edges[i].value != edges[i - 1].value &&
+                     edges[i].t_ns - edges[i - 1].t_ns >= VirtualHID::kTurboCoalesceNs;
+        }
+        CHECK(apart, "'%s': %d presses, edges closer than a tick", line, count(edges, BTN_SOUTH, 1));
+        HidDriver::dispatch(dev, "GAMEPAD_TURBO A 0");
+        drain(sv[1], clock.now_ns(), edges, writes);
+    }
+
+    // ---- 8. Malformed lines ----------------------------------------------------------
+    const uint64_t malformed = Metrics::counter_value(Metrics::kCmdMalformed);
+    const char* const bad[] = {
+        "GAMEPAD_TURBO", "GAMEPAD_TURBO A", "GAMEPAD_TURBO A 15", "GAMEPAD_TURBO A 61 50",
+        "GAMEPAD_TURBO A 15 0", "GAMEPAD_TURBO A 15 100", "GAMEPAD_TURBO A -1 50", "GAMEPAD_TURBO A x 50",
+        "GAMEPAD_TURBO A 60 12", "GAMEPAD_TURBO A 60 89", "GAMEPAD_TURBO A 15 1", "GAMEPAD_TURBO A 15 99",
+    };
+    for (const char* line : bad) {
+        CHECK(HidDriver::dispatch(dev, line) == DispatchResult::Ignored, "'%s' accepted", line);
+    }
+    CHECK(Metrics::counter_value(Metrics::kCmdMalformed) - malformed == sizeof(bad) / sizeof(bad[0]),
+          "malformed counter");
+    CHECK(HidDriver::dispatch(dev, "GAMEPAD_TURBO Z 15 50") == DispatchResult::Unknown, "unknown button");
+    CHECK(HidDriver::dispatch(dev, "GAMEPAD_TURBO START 0") == DispatchResult::Handled, "stop when not running");
+    edges.clear();
+    CHECK(drain(sv[1], clock.now_ns(), edges, writes) == 0 && dev.gamepad.turbo_count == 0,
+          "bad lines wrote or started something");
+
+    close(sv[0]);
+    close(sv[1]);
+    return Check::check_exit("test_turbo");
+}
@@ -0,0 +1,591 @@
+/*
+ * test_uinput_loopback.cpp
+ * End-to-end uinput loopback harness: commands go through the production
+ * dispatch path into real virtual devices and are read back from the
+ * matching /dev/input/eventN nodes with evdev.
+ *
+ * Checks
+ * ------
+ *   framing   - every command type produces exactly the expected event
+ *               sequence, including SYN_REPORT framing, on the right device
+ *   paced     - MOUSE_MOVE at 250 Hz and 1000 Hz: no lost, reordered or
+ *               mis-framed frames; p99 write→readable within the SLO
+ *   flood     - back-to-back MOUSE_MOVE: no reordering or mis-framing; loss
+ *               is only tolerated if evdev reported SYN_DROPPED
+ *   touch     - a two-finger pinch on the type-B touchscreen reads back with
+ *               exactly the slot, tracking-id and position events written
+ *   pointers  - two independent pointers moved and clicked in one POINTER
+ *               line: each event node reads back only its own frame
+ *   pen       - a hover / touch / stroke / out sequence on the pen tablet, and
+ *               the axis resolution tablet readers need
+ *   ff        - a game uploads, plays, stops and erases a rumble effect on the
+ *               gamepad's event node; the handshakes are answered through
+ *               gamepad_service() and the upload round trip is reported
+ *   keyboard  - KEY_CHORD framing, and a TYPE spanning several batches read
+ *               by a reader draining as it goes: every key event arrives in
+ *               order and evdev never reports SYN_DROPPED
+ *
+ * Every frame's latency is measured from just before dispatch() to the
+ * moment its SYN_REPORT became readable on the evdev node (and, separately,
+ * to the kernel's CLOCK_MONOTONIC event timestamp).  Samples are written to
+ * $GESTURELINK_RESULTS_DIR/uinput_loopback.json (bench_results.h schema).
+ *
+ * The event nodes are grabbed (EVIOCGRAB) so the run does not move the
+ * desktop cursor.  Exits 77 (skip) when /dev/uinput or the event nodes are
+ * not accessible.  SLO override: GESTURELINK_SLO_UINPUT_P99_US.
+ */
+
+#include "bench_results.h"
+#include "command_dispatch.h"
+#include "keymap.h"
+#include "metrics.h"
+#include "check.h"
+
+#include <linux/input.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr double kDefaultP99SloUs = 2000.0;
+
+int64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t{ts.tv_sec} * 1000000000 + ts.tv_nsec;
+}
+
+int64_t event_ns(const input_event& ev)
+{
+    return int64_t{ev.input_event_sec} * 1000000000 + int64_t{ev.input_event_usec} * 1000;
+}
+
+double percentile(std::vector<double> v, double q)
+{
+    if (v.empty()) return 0.0;
+    const size_t idx = std::min(v.size() - 1, static_cast<size_t>(q * static_cast<double>(v.size())));
+    std::nth_element(v.begin(), v.begin() + static_cast<long>(idx), v.end());
+    return v[idx];
+}
+
+/** Open an evdev node (waiting for udev to create it), grabbed, monotonic clock. */
+int open_event_node(const std::string& path)
+{
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0) {
+            int clk = CLOCK_MONOTONIC;
+            ioctl(fd, EVIOCSCLOCKID, &clk);
+            ioctl(fd, EVIOCGRAB, 1);
+            return fd;
+        }
+        if (errno != ENOENT) return -1;
+        usleep(10000);
+    }
+    return -1;
+}
+
+std::string find_node(int uinput_fd)
+{
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        const std::string node = VirtualHID::event_node(uinput_fd);
+        if (!node.empty()) return node;
+        usleep(10000);
+    }
+    return "";
+}
+
+/** Read events until @p idle_ms pass without any. */
+std::vector<input_event> drain(int fd, int idle_ms)
+{
+    std::vector<input_event> out;
+    struct pollfd pfd{fd, POLLIN, 0};
+    while (poll(&pfd, 1, idle_ms) > 0) {
+        input_event buf[64];
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        out.insert(out.end(), buf, buf + n / static_cast<ssize_t>(sizeof(input_event)));
+    }
+    return out;
+}
+
+// ---- 1. Framing -----------------------------------------------------------------
+
+struct Ev { uint16_t type, code; int32_t value; };
+
+void check_sequence(const char* what, const std::vector<input_event>& got, const std::vector<Ev>& want)
+{
+    CHECK(got.size() == want.size(), "%s: %zu events, expected %zu", what, got.size(), want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i) {
+        CHECK(got[i].type == want[i].type && got[i].code == want[i].code && got[i].value == want[i].value,
+              "%s[%zu]: got (%u,%u,%d) expected (%u,%u,%d)", what, i,
+              got[i].type, got[i].code, got[i].value, want[i].type, want[i].code, want[i].value);
+    }
+}
+
+void run_framing(HidDriver::Devices& dev, int mouse_ev, int pad_ev)
+{
+    struct Case {
+        const char*     line;
+        bool            on_mouse;
+        std::vector<Ev> events;
+    };
+    const Case cases[] = {
+        {"MOUSE_MOVE 100 200", true, {{EV_ABS, ABS_X, 100}, {EV_ABS, ABS_Y, 200}, {EV_SYN, SYN_REPORT, 0}}},
+        {"MOUSE_LEFT",         true, {{EV_KEY, BTN_LEFT, 1}, {EV_SYN, SYN_REPORT, 0},
+                                      {EV_KEY, BTN_LEFT, 0}, {EV_SYN, SYN_REPORT, 0}}},
+        {"MOUSE_RIGHT",        true, {{EV_KEY, BTN_RIGHT, 1}, {EV_SYN, SYN_REPORT, 0},
+                                      {EV_KEY, BTN_RIGHT, 0}, {EV_SYN, SYN_REPORT, 0}}},
+        {"MOUSE_SCROLL -2",    true, {{EV_REL, REL_WHEEL, -2}, {EV_SYN, SYN_REPORT, 0}}},
+        {"GAMEPAD_BTN A 1",    false, {{EV_KEY, BTN_SOUTH, 1}, {EV_SYN, SYN_REPORT, 0}}},
+        {"GAMEPAD_BTN A 0",    false, {{EV_KEY, BTN_SOUTH, 0}, {EV_SYN, SYN_REPORT, 0}}},
+        {"GAMEPAD_STICK 1000 -2000", false, {{EV_ABS, ABS_X, 1000}, {EV_ABS, ABS_Y, -2000},
+                                             {EV_SYN, SYN_REPORT, 0}}},
+    };
+    for (const Case& c : cases) {
+        HidDriver::dispatch(dev, c.line);
+        const std::vector<input_event> m = drain(mouse_ev, 100);
+        const std::vector<input_event> g = drain(pad_ev, 20);
+        check_sequence(c.line, c.on_mouse ? m : g, c.events);
+        CHECK((c.on_mouse ? g : m).empty(), "%s: %zu events leaked to the other device",
+              c.line, (c.on_mouse ? g : m).size());
+    }
+}
+
+void run_touch(HidDriver::Devices& dev, int touch_ev)
+{
+    struct Case {
+        const char*     line;
+        std::vector<Ev> events;
+    };
+    const Case cases[] = {
+        {"TOUCH 0 100 200 1 300 400", {
+            {EV_ABS, ABS_MT_TRACKING_ID, 0}, {EV_ABS, ABS_MT_POSITION_X, 100}, {EV_ABS, ABS_MT_POSITION_Y, 200},
+            {EV_ABS, ABS_MT_SLOT, 1}, {EV_ABS, ABS_MT_TRACKING_ID, 1},
+            {EV_ABS, ABS_MT_POSITION_X, 300}, {EV_ABS, ABS_MT_POSITION_Y, 400},
+            {EV_KEY, BTN_TOUCH, 1}, {EV_ABS, ABS_X, 100}, {EV_ABS, ABS_Y, 200}, {EV_SYN, SYN_REPORT, 0}}},
+        {"TOUCH 0 120 210 1 280 390", {
+            {EV_ABS, ABS_MT_SLOT, 0}, {EV_ABS, ABS_MT_POSITION_X, 120}, {EV_ABS, ABS_MT_POSITION_Y, 210},
+            {EV_ABS, ABS_MT_SLOT, 1}, {EV_ABS, ABS_MT_POSITION_X, 280}, {EV_ABS, ABS_MT_POSITION_Y, 390},
+            {EV_ABS, ABS_X, 120}, {EV_ABS, ABS_Y, 210}, {EV_SYN, SYN_REPORT, 0}}},
+        {"TOUCH 0 UP 1 UP", {
+            {EV_ABS, ABS_MT_SLOT, 0}, {EV_ABS, ABS_MT_TRACKING_ID, -1},
+            {EV_ABS, ABS_MT_SLOT, 1}, {EV_ABS, ABS_MT_TRACKING_ID, -1},
+            {EV_KEY, BTN_TOUCH, 0}, {EV_SYN, SYN_REPORT, 0}}},
+    };
+    for (const Case& c : cases) {
+        HidDriver::dispatch(dev, c.line);
+        check_sequence(c.line, drain(touch_ev, 100), c.events);
+    }
+}
+
+void run_pen(HidDriver::Devices& dev, int pen_ev)
+{
+    struct input_absinfo abs{};
+    CHECK(ioctl(pen_ev, EVIOCGABS(ABS_X), &abs) == 0 && abs.resolution > 0 &&
+          abs.maximum == 1920 * VirtualHID::kPenSubpixel - 1,
+          "pen ABS_X: max %d resolution %d", abs.maximum, abs.resolution);
+
+    struct Case {
+        const char*     line;
+        std::vector<Ev> events;
+    };
+    const Case cases[] = {
+        {"PEN 100.5 200.25 0 10 -5", {
+            {EV_KEY, BTN_TOOL_PEN, 1}, {EV_ABS, ABS_X, 1608}, {EV_ABS, ABS_Y, 3204},
+            {EV_ABS, ABS_TILT_X, 10}, {EV_ABS, ABS_TILT_Y, -5}, {EV_SYN, SYN_REPORT, 0}}},
+        {"PEN 100.5 200.25 800 10 -5", {
+            {EV_ABS, ABS_PRESSURE, 800}, {EV_KEY, BTN_TOUCH, 1}, {EV_SYN, SYN_REPORT, 0}}},
+        {"PEN 101 200.25 700 10 -5", {
+            {EV_ABS, ABS_X, 1616}, {EV_ABS, ABS_PRESSURE, 700}, {EV_SYN, SYN_REPORT, 0}}},
+        {"PEN OUT", {
+            {EV_ABS, ABS_PRESSURE, 0}, {EV_KEY, BTN_TOUCH, 0}, {EV_KEY, BTN_TOOL_PEN, 0},
+            {EV_SYN, SYN_REPORT, 0}}},
+    };
+    for (const Case& c : cases) {
+        HidDriver::dispatch(dev, c.line);
+        check_sequence(c.line, drain(pen_ev, 100), c.events);
+    }
+}
+
+void run_pointers(HidDriver::Devices& dev)
+{
+    dev.pointers.count = 2;
+    if (!VirtualHID::pointers_open(dev.pointers, 1920, 1080)) {
+        CHECK(false, "pointers_open failed while the other devices opened");
+        return;
+    }
+    int ev[2];
+    for (int i = 0; i < 2; ++i) {
+        const std::string node = find_node(dev.pointers.p[i].fd);
+        ev[i] = node.empty() ? -1 : open_event_node(node);
+        CHECK(ev[i] >= 0, "pointer %d: no readable event node '%s'", i, node.c_str());
+    }
+    if (ev[0] >= 0 && ev[1] >= 0) {
+        for (int fd : ev) drain(fd, 50);
+        HidDriver::dispatch(dev, "POINTER 0 100 200 1 1500 600 1 DOWN LEFT");
+        check_sequence("pointer 0", drain(ev[0], 100),
+                       {{EV_ABS, ABS_X, 100}, {EV_ABS, ABS_Y, 200}, {EV_SYN, SYN_REPORT, 0}});
+        check_sequence("pointer 1", drain(ev[1], 100), {
+            {EV_ABS, ABS_X, 1500}, {EV_ABS, ABS_Y, 600}, {EV_KEY, BTN_LEFT, 1}, {EV_SYN, SYN_REPORT, 0}});
+        HidDriver::dispatch(dev, "POINTER 1 UP LEFT");
+        check_sequence("pointer 1 up", drain(ev[1], 100), {{EV_KEY, BTN_LEFT, 0}, {EV_SYN, SYN_REPORT, 0}});
+        CHECK(drain(ev[0], 20).empty(), "pointer 0 written while unchanged");
+    }
+    for (int fd : ev) {
+        if (fd < 0) continue;
+        ioctl(fd, EVIOCGRAB, 0);
+        close(fd);
+    }
+    VirtualHID::pointers_close(dev.pointers);
+}
+
+void run_ff(HidDriver::Devices& dev, const std::string& pad_node, int pad_ev)
+{
+    // While grabbed, writes from any other handle (the game's EV_FF) are ignored.
+    ioctl(pad_ev, EVIOCGRAB, 0);
+    const int game = open(pad_node.c_str(), O_RDWR | O_CLOEXEC);
+    CHECK(game >= 0, "open %s read-write: %s", pad_node.c_str(), std::strerror(errno));
+    if (game < 0) {
+        ioctl(pad_ev, EVIOCGRAB, 1);
+        return;
+    }
+
+    struct ff_effect eff{};
+    eff.type                      = FF_RUMBLE;
+    eff.id                        = -1;
+    eff.u.rumble.strong_magnitude = 0xc000;
+    eff.u.rumble.weak_magnitude   = 0x2000;
+    eff.replay.length             = 300;
+    int     rc_upload = -1, rc_erase = -1;
+    int64_t upload_ns = 0;
+    std::thread game_thread([&] {
+        const int64_t t0 = now_ns();
+        rc_upload = ioctl(game, EVIOCSFF, &eff);          // blocks until the driver answers
+        upload_ns = now_ns() - t0;
+        if (rc_upload < 0) return;
+        input_event play{};
+        play.type  = EV_FF;
+        play.code  = static_cast<uint16_t>(eff.id);
+        play.value = 1;
+        input_event stop = play;
+        stop.value = 0;
+        if (write(game, &play, sizeof(play)) < 0 || write(game, &stop, sizeof(stop)) < 0) return;
+        rc_erase = ioctl(game, EVIOCRMFF, eff.id);
+    });
+
+    // The driver side: what hid_driver's loop does when the gamepad fd is readable.
+    std::vector<VirtualHID::FfEvent> got;
+    const uint64_t erases = Metrics::counter_value(Metrics::kFfErases);
+    const int64_t  give_up = now_ns() + 2000000000;
+    while ((got.size() < 2 || Metrics::counter_value(Metrics::kFfErases) == erases) && now_ns() < give_up) {
+        struct pollfd pfd{dev.gamepad.fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        VirtualHID::FfEvent changes[VirtualHID::kMaxFfEffects];
+        const int n = VirtualHID::gamepad_service(dev.gamepad, changes, VirtualHID::kMaxFfEffects);
+        got.insert(got.end(), changes, changes + n);
+    }
+    game_thread.join();
+
+    CHECK(rc_upload == 0 && eff.id >= 0, "EVIOCSFF: %d (id %d)", rc_upload, eff.id);
+    CHECK(got.size() == 2, "%zu rumble changes, expected play + stop", got.size());
+    if (got.size() == 2) {
+        CHECK(got[0].id == eff.id && got[0].play && got[0].strong == 0xc000 && got[0].weak == 0x2000 &&
+              got[0].length_ms == 300, "play: id %d strong %u weak %u length %u", got[0].id,
+              got[0].strong, got[0].weak, got[0].length_ms);
+        CHECK(got[1].id == eff.id && !got[1].play, "stop: id %d", got[1].id);
+    }
+    CHECK(rc_erase == 0 && eff.id >= 0 && eff.id < VirtualHID::kMaxFfEffects && !dev.gamepad.ff[eff.id].used,
+          "EVIOCRMFF: %d", rc_erase);
+    std::printf("ff: upload round trip %.1f us (the game's EVIOCSFF, answered by gamepad_service)\n",
+                upload_ns / 1e3);
+
+    close(game);
+    ioctl(pad_ev, EVIOCGRAB, 1);
+    drain(pad_ev, 50);
+}
+
+// ---- 2. Keyboard ----------------------------------------------------------------
+
+void run_keyboard(HidDriver::Devices& dev, int key_ev)
+{
+    HidDriver::dispatch(dev, "KEY_CHORD CTRL+TAB");
+    check_sequence("KEY_CHORD CTRL+TAB", drain(key_ev, 100), {
+        {EV_KEY, KEY_LEFTCTRL, 1}, {EV_KEY, KEY_TAB, 1}, {EV_SYN, SYN_REPORT, 0},
+        {EV_KEY, KEY_TAB, 0}, {EV_KEY, KEY_LEFTCTRL, 0}, {EV_SYN, SYN_REPORT, 0},
+    });
+
+    // 150 lower-case characters: 600 events in 10 batches.
+    std::string line = "TYPE ";
+    for (int i = 0; i < 150; ++i) line += static_cast<char>('a' + i % 26);
+
+    std::vector<input_event> got;
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        struct pollfd pfd{key_ev, POLLIN, 0};
+        while (!done.load() || poll(&pfd, 1, 100) > 0) {
+            if (poll(&pfd, 1, 10) <= 0) continue;
+            input_event buf[64];
+            const ssize_t n = read(key_ev, buf, sizeof(buf));
+            if (n > 0) got.insert(got.end(), buf, buf + n / static_cast<ssize_t>(sizeof(input_event)));
+        }
+    });
+    HidDriver::dispatch(dev, line);
+    while (dev.keyboard.typing) {                    // the driver's timer wheel, gap_ns apart
+        usleep(static_cast<useconds_t>(dev.keyboard.gap_ns / 1000));
+        VirtualHID::keyboard_type_tick(dev.keyboard);
+    }
+    done = true;
+    reader.join();
+
+    size_t presses = 0, dropped = 0;
+    bool in_order = true;
+    for (const input_event& ev : got) {
+        if (ev.type == EV_SYN && ev.code == SYN_DROPPED) ++dropped;
+        if (ev.type != EV_KEY || ev.value != 1) continue;
+        uint16_t want;
+        const char name[2] = {static_cast<char>('A' + presses % 26), '\0'};
+        in_order &= Keymap::key_code(name, want) && ev.code == want;
+        ++presses;
+    }
+    std::printf("keyboard      TYPE %zu chars: %zu presses read back, syn_dropped=%zu\n",
+                line.size() - 5, presses, dropped);
+    CHECK(dropped == 0, "TYPE: %zu SYN_DROPPED with a %d us batch gap", dropped,
+          VirtualHID::kDefaultBatchGapUs);
+    CHECK(presses == line.size() - 5 && in_order, "TYPE: %zu of %zu presses, in order=%d",
+          presses, line.size() - 5, in_order);
+}
+
+// ---- 3. Paced / flood MOUSE_MOVE ------------------------------------------------
+
+struct Scenario {
+    const char* name;
+    int         rate_hz;      // 0 = flood
+    size_t      frames;
+};
+
+struct Outcome {
+    std::vector<double> readable_us;   // write → SYN readable
+    std::vector<double> stamp_us;      // write → kernel event timestamp
+    size_t received = 0, lost = 0, reordered = 0, misframed = 0, syn_dropped = 0;
+    double achieved_hz = 0.0;
+};
+
+/** Distinct, consecutively-changing coordinates so evdev never filters a frame. */
+inline int frame_x(size_t i) { return 1 + static_cast<int>(i % 1900); }
+inline int frame_y(size_t i) { return 1 + static_cast<int>(i % 1000); }
+
+Outcome run_moves(HidDriver::Devices& dev, int mouse_ev, const Scenario& sc)
+{
+    Outcome out;
+    std::vector<int64_t> t_write(sc.frames, 0), t_read(sc.frames, 0), t_stamp(sc.frames, 0);
+    std::unordered_map<int64_t, size_t> index;
+    for (size_t i = 0; i < sc.frames; ++i) index[int64_t{frame_x(i)} * 10000 + frame_y(i)] = i;
+
+    std::atomic<bool> writer_done{false};
+    std::thread reader([&] {
+        size_t next = 0;
+        int x = -1, y = -1, n_in_frame = 0;
+        bool resync = false;
+        struct pollfd pfd{mouse_ev, POLLIN, 0};
+        int64_t idle_since = 0;
+        for (;;) {
+            if (poll(&pfd, 1, 50) <= 0) {
+                if (writer_done.load()) {
+                    if (idle_since == 0) idle_since = now_ns();
+                    else if (now_ns() - idle_since > 500000000) break;
+                }
+                continue;
+            }
+            idle_since = 0;
+            input_event buf[64];
+            const ssize_t n = read(mouse_ev, buf, sizeof(buf));
+            const int64_t t = now_ns();
+            if (n <= 0) continue;
+            for (ssize_t k = 0; k < n / static_cast<ssize_t>(sizeof(input_event)); ++k) {
+                const input_event& ev = buf[k];
+                if (ev.type == EV_SYN && ev.code == SYN_DROPPED) {
+                    ++out.syn_dropped;
+                    resync = true;                       // discard up to next SYN_REPORT
+                    x = y = -1; n_in_frame = 0;
+                    continue;
+                }
+                if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+                    if (resync) { resync = false; continue; }
+                    const auto it = index.find(int64_t{x} * 10000 + y);
+                    if (n_in_frame != 2 || x < 0 || y < 0 || it == index.end()) {
+                        ++out.misframed;
+                    } else {
+                        const size_t j = it->second;
+                        ++out.received;
+                        t_read[j]  = t;
+                        t_stamp[j] = event_ns(ev);
+                        if (j < next)      ++out.reordered;
+                        else if (j > next) out.lost += j - next;
+                        next = std::max(next, j + 1);
+                    }
+                    x = y = -1; n_in_frame = 0;
+                    continue;
+                }
+                if (resync) continue;
+                ++n_in_frame;
+                if (ev.type == EV_ABS && ev.code == ABS_X)      x = ev.value;
+                else if (ev.type == EV_ABS && ev.code == ABS_Y) y = ev.value;
+                else                                            n_in_frame += 100;   // unexpected event
+            }
+        }
+        out.lost += sc.frames - std::min(next, sc.frames);
+    });
+
+    const int64_t period = sc.rate_hz > 0 ? 1000000000LL / sc.rate_hz : 0;
+    char line[48];
+    const int64_t start = now_ns();
+    int64_t next_t = start;
+    for (size_t i = 0; i < sc.frames; ++i) {
+        if (period) {
+            next_t += period;
+            struct timespec ts{static_cast<time_t>(next_t / 1000000000), static_cast<long>(next_t % 1000000000)};
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        }
+        std::snprintf(line, sizeof(line), "MOUSE_MOVE %d %d", frame_x(i), frame_y(i));
+        t_write[i] = now_ns();
+        HidDriver::dispatch(dev, line);
+    }
+    const int64_t end = now_ns();
+    writer_done = true;
+    reader.join();
+
+    out.achieved_hz = static_cast<double>(sc.frames) * 1e9 / static_cast<double>(std::max<int64_t>(1, end - start));
+    for (size_t i = 0; i < sc.frames; ++i) {
+        if (!t_read[i]) continue;
+        out.readable_us.push_back(static_cast<double>(t_read[i] - t_write[i]) / 1000.0);
+        out.stamp_us.push_back(static_cast<double>(t_stamp[i] - t_write[i]) / 1000.0);
+    }
+    return out;
+}
+
+} // namespace
+
+int main()
+{
+    HidDriver::Devices dev;
+    if (!VirtualHID::mouse_open(dev.mouse, 1920, 1080)) {
+        std::printf("uinput unavailable; skipping loopback harness\n");
+        return Check::kSkipExitCode;
+    }
+    if (!VirtualHID::gamepad_open(dev.gamepad) || !VirtualHID::keyboard_open(dev.keyboard) ||
+        !VirtualHID::touch_open(dev.touch, 1920, 1080) || !VirtualHID::pen_open(dev.pen, 1920, 1080)) {
+        VirtualHID::mouse_close(dev.mouse);
+        VirtualHID::gamepad_close(dev.gamepad);
+        VirtualHID::keyboard_close(dev.keyboard);
+        VirtualHID::touch_close(dev.touch);
+        std::printf("uinput gamepad / keyboard / touchscreen / pen unavailable; skipping loopback harness\n");
+        return Check::kSkipExitCode;
+    }
+
+    const std::string mouse_node = find_node(dev.mouse.fd);
+    const std::string pad_node   = find_node(dev.gamepad.fd);
+    const std::string key_node   = find_node(dev.keyboard.fd);
+    const std::string touch_node = find_node(dev.touch.fd);
+    const std::string pen_node   = find_node(dev.pen.fd);
+    const int mouse_ev = mouse_node.empty() ? -1 : open_event_node(mouse_node);
+    const int pad_ev   = pad_node.empty()   ? -1 : open_event_node(pad_node);
+    const int key_ev   = key_node.empty()   ? -1 : open_event_node(key_node);
+    const int touch_ev = touch_node.empty() ? -1 : open_event_node(touch_node);
+    const int pen_ev   = pen_node.empty()   ? -1 : open_event_node(pen_node);
+    if (mouse_ev < 0 || pad_ev < 0 || key_ev < 0 || touch_ev < 0 || pen_ev < 0) {
+        std::printf("cannot read back event nodes ('%s', '%s', '%s', '%s', '%s'): %s\n",
+                    mouse_node.c_str(), pad_node.c_str(), key_node.c_str(), touch_node.c_str(),
+                    pen_node.c_str(), std::strerror(errno));
+        for (int fd : {mouse_ev, pad_ev, key_ev, touch_ev, pen_ev}) if (fd >= 0) close(fd);
+        VirtualHID::mouse_close(dev.mouse);
+        VirtualHID::gamepad_close(dev.gamepad);
+        VirtualHID::keyboard_close(dev.keyboard);
+        VirtualHID::touch_close(dev.touch);
+        VirtualHID::pen_close(dev.pen);
+        return Check::kSkipExitCode;
+    }
+    std::printf("mouse %s, gamepad %s, keyboard %s, touchscreen %s, pen %s\n", mouse_node.c_str(),
+                pad_node.c_str(), key_node.c_str(), touch_node.c_str(), pen_node.c_str());
+    for (int fd : {mouse_ev, pad_ev, key_ev, touch_ev, pen_ev}) drain(fd, 50);
+
+    run_framing(dev, mouse_ev, pad_ev);
+    run_touch(dev, touch_ev);
+    run_pen(dev, pen_ev);
+    run_pointers(dev);
+    run_ff(dev, pad_node, pad_ev);
+    run_keyboard(dev, key_ev);
+
+    const char* env = std::getenv("GESTURELINK_SLO_UINPUT_P99_US");
+    const double p99_slo = env ? std::atof(env) : kDefaultP99SloUs;
+
+    const Scenario scenarios[] = {
+        {"paced_250hz",  250,  1000},
+        {"paced_1000hz", 1000, 2000},
+        {"flood",        0,    15000},   // < lcm(1900, 1000): coordinates stay unique
+    };
+    std::vector<BenchResults::Benchmark> benches;
+    for (const Scenario& sc : scenarios) {
+        const Outcome o = run_moves(dev, mouse_ev, sc);
+        const double p50 = percentile(o.readable_us, 0.50);
+        const double p99 = percentile(o.readable_us, 0.99);
+        const double max = o.readable_us.empty() ? 0.0
+                         : *std::max_element(o.readable_us.begin(), o.readable_us.end());
+        std::printf("%-13s %8.0f Hz  recv=%-6zu lost=%-4zu reord=%-3zu misframed=%-3zu syn_dropped=%-3zu "
+                    "p50=%7.1fus p99=%7.1fus max=%8.1fus  (kernel stamp p99=%7.1fus)\n",
+                    sc.name, o.achieved_hz, o.received, o.lost, o.reordered, o.misframed, o.syn_dropped,
+                    p50, p99, max, percentile(o.stamp_us, 0.99));
+
+        CHECK(o.reordered == 0, "%s: %zu reordered frames", sc.name, o.reordered);
+        CHECK(o.misframed == 0, "%s: %zu mis-framed frames", sc.name, o.misframed);
+        if (sc.rate_hz > 0) {
+            CHECK(o.lost == 0, "%s: %zu frames lost", sc.name, o.lost);
+            CHECK(o.syn_dropped == 0, "%s: %zu SYN_DROPPED", sc.name, o.syn_dropped);
+            CHECK(p99 <= p99_slo, "%s: p99 %.1fus exceeds SLO %.1fus", sc.name, p99, p99_slo);
+        } else {
+            CHECK(o.lost == 0 || o.syn_dropped > 0, "%s: %zu frames lost without SYN_DROPPED",
+                  sc.name, o.lost);
+        }
+
+        BenchResults::Benchmark b;
+        b.name    = std::string("write_to_readable/") + sc.name;
+        b.unit    = "us";
+        b.samples = o.readable_us;
+        b.metrics = {
+            {"rate_hz", sc.rate_hz}, {"achieved_hz", o.achieved_hz}, {"frames", static_cast<double>(sc.frames)},
+            {"received", static_cast<double>(o.received)}, {"lost", static_cast<double>(o.lost)},
+            {"reordered", static_cast<double>(o.reordered)}, {"syn_dropped", static_cast<double>(o.syn_dropped)},
+            {"p50_us", p50}, {"p99_us", p99}, {"max_us", max},
+            {"kernel_stamp_p99_us", percentile(o.stamp_us, 0.99)}, {"slo_p99_us", p99_slo},
+        };
+        benches.push_back(std::move(b));
+    }
+
+    const std::string path = BenchResults::write("uinput_loopback", benches);
+    if (!path.empty()) std::printf("results written to %s\n", path.c_str());
+
+    for (int fd : {mouse_ev, pad_ev, key_ev, touch_ev, pen_ev}) {
+        ioctl(fd, EVIOCGRAB, 0);
+        close(fd);
+    }
+    VirtualHID::mouse_close(dev.mouse);
+    VirtualHID::gamepad_close(dev.gamepad);
+    VirtualHID::keyboard_close(dev.keyboard);
+    VirtualHID::touch_close(dev.touch);
+    VirtualHID::pen_close(dev.pen);
+    return Check::check_exit("test_uinput_loopback");
+}
@@ -0,0 +1,183 @@
+"""
+test_clock.py
+Deterministic timing tests for the mapper using an injected SimulatedClock.
+
+Frames are spaced 1/16 s apart (exactly representable in binary floating
+point) so every cooldown boundary lands on a known frame, and idle gaps
+between gestures are skipped by advancing the clock instead of sleeping:
+the 24-hour session below runs in a few seconds.
+"""
+
+import gc
+import tracemalloc
+
+import pytest
+
+from tests.conftest import (
+    make_hand,
+    INDEX_TIP, INDEX_PIP, INDEX_MCP,
+    MIDDLE_TIP, MIDDLE_PIP, MIDDLE_MCP,
+    RING_TIP, RING_PIP, RING_MCP,
+    PINKY_TIP, PINKY_PIP, PINKY_MCP,
+    THUMB_TIP, THUMB_IP, WRIST,
+)
+from src.clock import SimulatedClock
+from src.vision.gesture_mapper import GestureMapper, CONFIRM_FRAMES, PINCH_CLOSE_THRESHOLD
+
+DT = 1 / 16
+
+_UP = lambda x: {0: (x, 0.3, 0.0), 1: (x, 0.5, 0.0), 2: (x, 0.6, 0.0)}   # tip, pip, mcp
+
+
+def _fingers(*extended):
+    idx = {1: (INDEX_TIP, INDEX_PIP, INDEX_MCP), 2: (MIDDLE_TIP, MIDDLE_PIP, MIDDLE_MCP),
+           3: (RING_TIP, RING_PIP, RING_MCP),    4: (PINKY_TIP, PINKY_PIP, PINKY_MCP)}
+    out = {}
+    for f in extended:
+        for j, lm in enumerate(idx[f]):
+            out[lm] = _UP(0.4 + 0.05 * f)[j]
+    return out
+
+
+_THUMB_OUT = {THUMB_TIP: (0.2, 0.5, 0.0), THUMB_IP: (0.4, 0.5, 0.0), WRIST: (0.5, 0.8, 0.0)}
+
+V_SIGN  = make_hand(_fingers(1, 2))
+SCROLL  = make_hand({**_fingers(1), **_THUMB_OUT})
+PALM    = make_hand({**_fingers(1, 2, 3, 4), **_THUMB_OUT})
+PINCH   = make_hand({THUMB_TIP: (0.5, 0.5, 0.0),
+                     INDEX_TIP: (0.5 + PINCH_CLOSE_THRESHOLD * 0.5, 0.5, 0.0),
+                     INDEX_PIP: (0.5, 0.55, 0.0), INDEX_MCP: (0.5, 0.60, 0.0)})
+
+
+def _hold(mapper, clock, hand, frames, dt=DT):
+    """Feed @hand for @frames frames; return [(t, cmd), ...]."""
+    out = []
+    for _ in range(frames):
+        out.extend((clock(), c) for c in mapper.map(hand))
+        clock.advance(dt)
+    return out
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. SimulatedClock
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestSimulatedClock:
+
+    def test_only_moves_when_told(self):
+        clock = SimulatedClock(100.0)
+        assert clock() == clock() == 100.0
+        assert clock.advance(0.5) == 100.5
+        clock.set(200.0)
+        assert clock() == 200.0
+
+    def test_refuses_to_go_backwards(self):
+        clock = SimulatedClock(10.0)
+        with pytest.raises(ValueError):
+            clock.advance(-1)
+        with pytest.raises(ValueError):
+            clock.set(5.0)
+
+    def test_mapper_does_not_read_real_time(self, monkeypatch):
+        """With a SimulatedClock injected, time.monotonic must never be consulted."""
+        import time
+        clock  = SimulatedClock()
+        mapper = GestureMapper(clock=clock)
+        monkeypatch.setattr(time, "monotonic", lambda: pytest.fail("time.monotonic called"))
+        _hold(mapper, clock, V_SIGN, 10)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Cooldown boundaries
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestCooldowns:
+    """
+    Frame k (0-based) is at t = k/16.  A gesture confirms on frame
+    CONFIRM_FRAMES-1 and fires then; repeats need strictly more than the
+    cooldown, i.e. 5 frames (0.3125 s) for clicks, 2 (0.125 s) for scroll
+    and 17 (1.0625 s) for START.
+    """
+
+    @pytest.mark.parametrize("hand,cmd,period", [
+        (V_SIGN, "MOUSE_RIGHT",         5),
+        (SCROLL, "MOUSE_SCROLL 3",      2),
+        (PALM,   "GAMEPAD_BTN START 1", 17),
+    ])
+    def test_repeat_period_is_exact(self, hand, cmd, period):
+        clock  = SimulatedClock(1000.0)
+        mapper = GestureMapper(clock=clock)
+        fired  = [t for t, c in _hold(mapper, clock, hand, 64) if c == cmd]
+        first  = 1000.0 + (CONFIRM_FRAMES - 1) * DT
+        assert fired == [first + k * period * DT for k in range(len(fired))]
+        assert len(fired) == (64 - CONFIRM_FRAMES) // period + 1
+
+    def test_first_event_fires_at_time_zero(self):
+        """Cooldown state must not assume the clock started long ago."""
+        clock  = SimulatedClock(0.0)
+        mapper = GestureMapper(clock=clock)
+        assert "MOUSE_RIGHT" in [c for _, c in _hold(mapper, clock, V_SIGN, CONFIRM_FRAMES)]
+
+    def test_repinch_inside_cooldown_is_suppressed(self):
+        """Release and re-pinch at 64 fps: 6 frames (0.094 s) is inside the cooldown."""
+        clock  = SimulatedClock()
+        mapper = GestureMapper(clock=clock)
+        clicks = lambda cmds: [c for _, c in cmds].count("MOUSE_LEFT")
+        assert clicks(_hold(mapper, clock, PINCH,  CONFIRM_FRAMES, dt=1 / 64)) == 1
+        _hold(mapper, clock, V_SIGN, CONFIRM_FRAMES, dt=1 / 64)
+        assert clicks(_hold(mapper, clock, PINCH,  CONFIRM_FRAMES, dt=1 / 64)) == 0
+        _hold(mapper, clock, V_SIGN, CONFIRM_FRAMES, dt=1 / 64)
+        clock.advance(0.30)
+        assert clicks(_hold(mapper, clock, PINCH,  CONFIRM_FRAMES, dt=1 / 64)) == 1
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. Simulated 24-hour session
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestSimulatedDay:
+    """
+    One gesture burst per simulated minute (2 s of frames, then 58 s with no
+    hand), rotating through right-click, scroll, pinch and START, for 24 h.
+    """
+
+    BURST_FRAMES = 32
+    ROTATION     = [(V_SIGN, "MOUSE_RIGHT", 6), (SCROLL, "MOUSE_SCROLL 3", 15),
+                    (PINCH, "MOUSE_LEFT", 1),   (PALM, "GAMEPAD_BTN START 1", 2)]
+
+    def _run(self, mapper, clock, minutes, counts, last_seen):
+        for minute in range(minutes):
+            hand, cmd, _ = self.ROTATION[minute % len(self.ROTATION)]
+            for t, c in _hold(mapper, clock, hand, self.BURST_FRAMES):
+                if c == cmd:
+                    counts[cmd] = counts.get(cmd, 0) + 1
+                    prev = last_seen.get(cmd)
+                    assert prev is None or t - prev > 0.12, f"{cmd} repeated after {t - prev}s"
+                    last_seen[cmd] = t
+            clock.advance(60.0 - self.BURST_FRAMES * DT)
+
+    def test_day_long_session(self):
+        clock  = SimulatedClock(12345.0)
+        mapper = GestureMapper(clock=clock)
+        counts, last_seen = {}, {}
+
+        tracemalloc.start()
+        try:
+            self._run(mapper, clock, 60, counts, last_seen)          # warm-up hour
+            gc.collect()
+            before = tracemalloc.take_snapshot()
+            self._run(mapper, clock, 23 * 60, counts, last_seen)
+            gc.collect()
+            after = tracemalloc.take_snapshot()
+        finally:
+            tracemalloc.stop()
+
+        assert clock() == pytest.approx(12345.0 + 24 * 3600)
+
+        per_gesture = 24 * 60 // len(self.ROTATION)
+        for _, cmd, per_burst in self.ROTATION:
+            assert counts.get(cmd, 0) == per_gesture * per_burst, cmd
+
+        growth = sum(s.size_diff for s in after.compare_to(before, "filename")
+                     if "src/vision" in s.traceback[0].filename)
+        assert growth < 4096, f"mapper allocations grew by {growth} bytes over 23 h"
@@ -0,0 +1,90 @@
+"""
+test_driver_native.py
+Builds and runs the native C++ driver tests in tests/driver/ so that a
+plain ``pytest tests/`` covers the driver as well as the vision code.
+
+Each native test is a standalone binary built by ``make -C src/driver`` into
+src/driver/build/default; exit code 0 = pass, 77 = skipped (e.g. no
+/dev/uinput), anything else fails with the binary's output attached.
+"""
+
+import json
+import os
+import shutil
+import subprocess
+from pathlib import Path
+
+import pytest
+
+from tests.conftest import DRIVER_DIR, DRIVER_OUT
+
+REPO_ROOT  = Path(__file__).parent.parent
+SKIP_EXIT_CODE = 77
+
+NATIVE_TESTS = [
+    "test_budget",      # zero-allocation + write(2)-per-frame budgets
+    "test_latency_slo", # receive→emit p99 / p99.9 under CPU contention
+    "test_async_log",   # hot-path logger: formatting, rate limit, JSON, drops
+    "test_metrics",     # sharded counters + Prometheus exporter
+    "test_uinput_loopback",  # evdev readback: framing, loss, write→readable
+    "test_event_loop",  # timer wheel on a simulated clock (24 h in seconds)
+    "test_simd",        # every ISA tier vs scalar, guard-paged
+    "test_keyboard",    # key names, layout table, chord / TYPE framing and batching
+    "test_touch",       # multitouch slot cache, changed-only frames, reader model
+    "test_pen",         # pen frames, subpixel parsing, contact hysteresis, glides
+    "test_ff",          # rumble play / stop / gain and the FF back-channel lines
+    "test_pointers",    # independent pointers: per-device frames, coalescing, buttons
+    "test_inertia",     # flick coast, friction decay, cancellation by new input
+    "test_turbo",       # gamepad autofire: edge timing, shared frames, late ticks
+    "test_macro",       # macro files: compile errors, frame timing, restarts, MACRO_STOP
+    "test_gyro",        # motion sensor: upsampling glides, MSC_TIMESTAMP, staleness
+    "test_descriptor",  # device descriptors: setup programs, axis ranges, AbsCache
+    "test_flight_recorder",  # dumps: replayable commands, #T for over-long lines, ring window
+]
+
+pytestmark = pytest.mark.skipif(
+    shutil.which("make") is None or shutil.which("g++") is None,
+    reason="native driver tests need make and g++",
+)
+
+
+@pytest.mark.parametrize("name", NATIVE_TESTS)
+def test_native(name):
+    build = subprocess.run(
+        ["make", "-s", "-C", str(DRIVER_DIR), name],
+        capture_output=True, text=True,
+    )
+    assert build.returncode == 0, f"build of {name} failed:\n{build.stderr}"
+
+    env = dict(os.environ)
+    env.setdefault("GESTURELINK_RESULTS_DIR", str(REPO_ROOT / "results"))
+    run = subprocess.run(
+        [str(DRIVER_OUT / name)], capture_output=True, text=True, timeout=120, env=env,
+    )
+    if run.returncode == SKIP_EXIT_CODE:
+        pytest.skip(run.stdout.strip() or f"{name} skipped")
+    assert run.returncode == 0, f"{name} failed:\n{run.stdout}\n{run.stderr}"
+
+
+@pytest.mark.parametrize("profile", ["constant", "bursty", "randomwalk"])
+def test_loadgen_null_sink(profile, tmp_path):
+    """hid_loadgen's scheduler reaches its target rate without uinput (--null)."""
+    build = subprocess.run(
+        ["make", "-s", "-C", str(DRIVER_DIR), "hid_loadgen"],
+        capture_output=True, text=True,
+    )
+    assert build.returncode == 0, f"build of hid_loadgen failed:\n{build.stderr}"
+
+    out = tmp_path / "loadgen.json"
+    run = subprocess.run(
+        [str(DRIVER_OUT / "hid_loadgen"), "--null", "--mice", "3", "--gamepads", "2",
+         "--profile", profile, "--rate", "200", "--duration", "1", "--threads", "2",
+         "--json", str(out)],
+        capture_output=True, text=True, timeout=30,
+    )
+    assert run.returncode == 0, run.stderr
+    doc = json.loads(out.read_text())
+    rate = next(b for b in doc["benchmarks"] if b["name"].startswith("achieved_rate/"))
+    assert rate["metrics"]["target_hz"] == 1000
+    assert rate["samples"][0] >= 0.8 * rate["metrics"]["target_hz"], run.stdout
+    assert rate["metrics"]["failed_writes"] == 0
@@ -0,0 +1,90 @@
+"""
+test_feedback.py
+Force-feedback back-channel: RumbleState on a SimulatedClock, FeedbackReader
+over a pipe, and hid_driver accepting (or refusing) HID_DRIVER_FEEDBACK_FD.
+The rumble handshake itself needs /dev/uinput (test_uinput_loopback.cpp).
+"""
+
+import os
+import time
+
+import pytest
+
+from src.clock import SimulatedClock
+from src.feedback import FeedbackReader, RumbleState
+
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Rumble state
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestRumbleState:
+
+    def test_play_update_and_stop(self):
+        r = RumbleState(clock=SimulatedClock())
+        assert r.intensity() == (0.0, 0.0)
+        assert r.apply("FF PLAY 0 65535 16384 0")
+        assert r.intensity() == pytest.approx((1.0, 0.25), abs=1e-4)
+        assert r.apply("FF PLAY 0 32768 0 0")                  # updated while playing
+        assert r.intensity() == pytest.approx((0.5, 0.0), abs=1e-4)
+        assert r.apply("FF STOP 0")
+        assert r.intensity() == (0.0, 0.0) and r.active() == 0
+
+    def test_strongest_effect_wins_per_motor(self):
+        r = RumbleState(clock=SimulatedClock())
+        r.apply("FF PLAY 1 65535 0 0")
+        r.apply("FF PLAY 2 0 65535 0")
+        assert r.intensity() == pytest.approx((1.0, 1.0)) and r.active() == 2
+        r.apply("FF STOP 1")
+        assert r.intensity() == pytest.approx((0.0, 1.0))
+
+    def test_finite_effects_expire_after_their_length(self):
+        clock = SimulatedClock(10.0)
+        r = RumbleState(clock=clock)
+        r.apply("FF PLAY 3 65535 65535 250")
+        clock.advance(0.249)
+        assert r.active() == 1
+        clock.advance(0.001)
+        assert r.intensity() == (0.0, 0.0) and r.active() == 0
+
+    @pytest.mark.parametrize("line", ["", "FF", "FF PLAY 1 2 3", "FF PLAY x 1 2 3",
+                                      "FF STOP", "FF PAUSE 1", "MOUSE_MOVE 1 2"])
+    def test_rejects_other_lines(self, line):
+        assert not RumbleState().apply(line)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Reader
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_reader_applies_lines_until_eof():
+    read_fd, write_fd = os.pipe()
+    state  = RumbleState()
+    reader = FeedbackReader(read_fd, state)
+    reader.start()
+    os.write(write_fd, b"FF PLAY 0 65535 0 0\nFF PLAY 1 0 327")
+    os.write(write_fd, b"68 0\ngarbage\n")
+    os.close(write_fd)
+    reader.join(timeout=2)
+    assert not reader.is_alive() and reader.lines == 2
+    assert state.intensity() == pytest.approx((1.0, 0.5), abs=1e-4)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. Driver
+# ─────────────────────────────────────────────────────────────────────────────
+
+@pytest.mark.parametrize("use_pipe", [True, False])
+def test_driver_takes_the_back_channel_fd(null_driver, use_pipe):
+    read_fd, write_fd = os.pipe()
+    drv = null_driver(pass_fds=(write_fd,),
+                      HID_DRIVER_FEEDBACK_FD=str(write_fd) if use_pipe else "999")
+    os.close(write_fd)
+    t0 = time.monotonic()
+    drv.send("MOUSE_MOVE 1 1")
+    err = drv.finish()
+    assert ("rumble will not be forwarded" in err) != use_pipe, err
+    # The driver held the only write end: the reader sees EOF once it exits.
+    assert os.read(read_fd, 64) == b"" and time.monotonic() - t0 < 5
+    os.close(read_fd)
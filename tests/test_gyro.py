@@ -0,0 +1,132 @@
+"""
+test_gyro.py
+Gyro aiming: GyroMapper recovers known rotation rates about each camera
+axis from synthetic hands, holds still on a still hand and stops once when
+the hand is lost; the driver upsamples 30 Hz GYRO samples to 500 Hz
+reports with MSC_TIMESTAMP end to end (HID_DRIVER_SINK=null, read back
+from a flight recorder dump).
+"""
+
+import math
+import statistics
+import time
+
+import pytest
+
+from src.vision.gyro_mapper import (FRAME_ASPECT, GYRO_DEADBAND, GYRO_MAX_GAP, GyroMapper,
+                                    angular_velocity, hand_orientation)
+from tests.conftest import INDEX_MCP, MIDDLE_MCP, PINKY_MCP, WRIST, make_hand
+
+FRAME_MS = 1000 / 30
+
+# Palm facing the camera, fingers up, in camera space (x right, y up, z to the camera)
+PALM = {WRIST: (0.0, -0.10, 0.0), INDEX_MCP: (-0.04, 0.0, 0.0),
+        MIDDLE_MCP: (0.0, 0.01, 0.0), PINKY_MCP: (0.05, -0.01, 0.0)}
+
+
+def _rotation(axis: int, deg: float):
+    c, s = math.cos(math.radians(deg)), math.sin(math.radians(deg))
+    i, j = [(1, 2), (2, 0), (0, 1)][axis]
+    r = [[1.0 if a == b else 0.0 for b in range(3)] for a in range(3)]
+    r[i][i], r[i][j], r[j][i], r[j][j] = c, -s, s, c
+    return r
+
+
+def _hand(r, t_ms: float):
+    """The palm rotated by @r, back in landmark coordinates, seen at @t_ms."""
+    lms = {}
+    for idx, p in PALM.items():
+        x, y, z = (sum(r[i][k] * p[k] for k in range(3)) for i in range(3))
+        lms[idx] = (0.5 + x, 0.5 - y / FRAME_ASPECT, -z)
+    hand = make_hand(lms)
+    hand.timestamp_ms = t_ms
+    return hand
+
+
+def _rates(cmds):
+    assert len(cmds) == 1 and cmds[0].startswith("GYRO "), cmds
+    return tuple(float(f) for f in cmds[0].split()[1:])
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Orientation and rate estimate
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestEstimate:
+
+    def test_orientation_is_a_rotation(self):
+        r = hand_orientation(_hand(_rotation(1, 30), 0.0))
+        for i in range(3):
+            for j in range(3):
+                col = sum(r[k][i] * r[k][j] for k in range(3))
+                assert col == pytest.approx(1.0 if i == j else 0.0, abs=1e-9)
+
+    @pytest.mark.parametrize("axis", [0, 1, 2])
+    @pytest.mark.parametrize("dps", [-120.0, 15.0, 400.0])
+    def test_rate_about_each_axis(self, axis, dps):
+        r0 = hand_orientation(_hand(_rotation(axis, 10), 0.0))
+        r1 = hand_orientation(_hand(_rotation(axis, 10 + dps * FRAME_MS / 1000), FRAME_MS))
+        w = angular_velocity(r0, r1, FRAME_MS / 1000)
+        want = [0.0, 0.0, 0.0]
+        want[axis] = dps
+        assert w == pytest.approx(want, abs=1e-6 * abs(dps) + 1e-9)
+
+    def test_mapper_converges_to_a_steady_turn(self):
+        m = GyroMapper()
+        assert m.map(_hand(_rotation(1, 0), 0.0)) == []       # one orientation is no rate
+        for n in range(1, 12):
+            cmds = m.map(_hand(_rotation(1, 90 * n * FRAME_MS / 1000), n * FRAME_MS))
+        rx, ry, rz = _rates(cmds)
+        assert ry == pytest.approx(90, abs=0.1) and rx == 0 and rz == 0
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Mapper behaviour
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestMapper:
+
+    def test_still_hand_reports_zero(self):
+        m = GyroMapper()
+        m.map(_hand(_rotation(0, 5), 0.0))
+        # A wobble under the deadband is jitter, not aim.
+        tiny = GYRO_DEADBAND / 2 * FRAME_MS / 1000
+        assert _rates(m.map(_hand(_rotation(0, 5 + tiny), FRAME_MS))) == (0.0, 0.0, 0.0)
+
+    def test_gap_restarts_the_estimate(self):
+        m = GyroMapper()
+        m.map(_hand(_rotation(2, 0), 0.0))
+        assert m.map(_hand(_rotation(2, 90), GYRO_MAX_GAP * 1000 + 1)) == []
+        assert _rates(m.map(_hand(_rotation(2, 90), GYRO_MAX_GAP * 1000 + 1 + FRAME_MS))) == (0.0, 0.0, 0.0)
+
+    def test_lost_hand_stops_the_sensor_once(self):
+        m = GyroMapper()
+        assert m.lost() == []
+        m.map(_hand(_rotation(1, 0), 0.0))
+        m.map(_hand(_rotation(1, 3), FRAME_MS))
+        assert m.lost() == ["GYRO OFF"]
+        assert m.lost() == []
+        assert m.map(_hand(_rotation(1, 3), 2 * FRAME_MS)) == []
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. Driver upsampling
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_driver_upsamples_to_its_tick_rate(null_driver):
+    drv = null_driver()
+    for rx in (0, 30, 60, 90, 120, 150):                    # 30 Hz camera samples
+        drv.send(f"GYRO {rx} 0 0")
+        time.sleep(FRAME_MS / 1000)
+    time.sleep(0.4)                                        # goes stale, reports zero
+    drv.finish()
+
+    rxs = [e.value for e in drv.events(type=3, code=3)]            # ABS_RX
+    stamps = [e.value for e in drv.events(type=4, code=5)]         # MSC_TIMESTAMP
+    assert rxs[-1] == 0 and 150 * 16 in rxs, rxs
+    ramp = rxs[:rxs.index(150 * 16) + 1]
+    assert ramp == sorted(ramp) and len(ramp) > 30, rxs     # glides, many steps per sample
+    steps = [b - a for a, b in zip(stamps, stamps[1:])]
+    assert stamps[0] == 0 and all(s > 0 for s in steps), stamps
+    assert statistics.median(steps) == 2000, steps          # HID_DRIVER_GYRO_TICK_US
+    assert len(stamps) > 150, len(stamps)                   # ~0.4 s streamed at 500 Hz
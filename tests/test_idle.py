@@ -0,0 +1,172 @@
+"""
+test_idle.py
+Low-power idle mode: the IdleController state machine on a SimulatedClock,
+the detector loop's capture reconfiguration and wake latency against a fake
+camera and landmarker, and the driver's POWER IDLE back-off.
+"""
+
+import re
+import threading
+import time
+from types import SimpleNamespace
+
+import numpy as np
+import pytest
+
+from src.clock import SimulatedClock
+from src.idle import ACTIVE, IDLE, IdleController
+from src.vision.gesture_detector import GestureDetector
+
+
+
+def _controller(clock, usage=lambda: (0.0, 0), **kw):
+    return IdleController(idle_after_s=10.0, idle_fps=5.0, clock=clock, usage=usage, **kw)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. State machine
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestIdleController:
+
+    def test_idles_after_absence_and_wakes_on_first_hand(self):
+        clock = SimulatedClock(100.0)
+        idle  = _controller(clock)
+        clock.advance(9.9)
+        assert idle.observe(False) is None and idle.state == ACTIVE
+        clock.advance(0.1)
+        assert idle.observe(False) == IDLE
+        clock.advance(60.0)
+        assert idle.observe(False) is None and idle.idle
+        assert idle.observe(True) == ACTIVE
+        assert idle.observe(True) is None and not idle.idle
+
+    def test_hand_resets_the_absence_timer(self):
+        clock = SimulatedClock()
+        idle  = _controller(clock)
+        for _ in range(30):
+            clock.advance(5.0)
+            assert idle.observe(False) is None
+            assert idle.observe(True) is None
+        assert idle.state == ACTIVE
+
+    def test_zero_disables_idle(self):
+        clock = SimulatedClock()
+        idle  = IdleController(idle_after_s=0, clock=clock)
+        clock.advance(3600.0)
+        assert idle.observe(False) is None and not idle.enabled
+
+    def test_rejects_non_positive_rate(self):
+        with pytest.raises(ValueError):
+            IdleController(idle_fps=0)
+
+    def test_cost_and_wake_latency(self):
+        clock = SimulatedClock()
+        usage = SimpleNamespace(cpu=1.0, switches=100)
+        idle  = _controller(clock, usage=lambda: (usage.cpu, usage.switches))
+        clock.advance(10.0)
+        assert idle.observe(False) == IDLE
+
+        clock.advance(40.0)
+        usage.cpu, usage.switches = 1.2, 300
+        assert idle.in_progress().wakeups_per_s == pytest.approx(5.0)
+
+        grabbed = clock()
+        clock.advance(0.030)                              # low-rate inference
+        assert idle.observe(True, grabbed) == ACTIVE
+        period = idle.periods[-1]
+        assert period.seconds == pytest.approx(40.03)
+        assert period.cpu_percent == pytest.approx(0.5, rel=1e-3)
+
+        clock.advance(0.050)                              # reconfigure + full-rate frame
+        assert idle.result_published() is period
+        assert period.wake_latency == pytest.approx(0.080)
+        assert period.bound == pytest.approx(0.280)       # + one 5 fps frame period
+        assert "woke in 80 ms (bound 280 ms)" in period.summary()
+        assert idle.result_published() is None            # reported once
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Detector loop
+# ─────────────────────────────────────────────────────────────────────────────
+
+class _FakeCapture:
+    def __init__(self) -> None:
+        self.settings, self.reads = [], 0
+
+    def read(self):
+        self.reads += 1
+        time.sleep(0.002)
+        return True, np.zeros((48, 64, 3), dtype=np.uint8)
+
+    def set(self, prop, value):
+        self.settings.append((prop, value))
+
+    def release(self):
+        pass
+
+
+class _FakeLandmarker:
+    def __init__(self) -> None:
+        self.hand = threading.Event()
+
+    def detect_for_video(self, image, ts_ms):
+        lms = [[SimpleNamespace(x=0.5, y=0.5, z=0.0)] * 21] if self.hand.is_set() else []
+        return SimpleNamespace(hand_landmarks=lms, handedness=[[]] * len(lms))
+
+    def close(self):
+        pass
+
+
+def test_detector_throttles_when_idle_and_wakes_within_bound():
+    import cv2
+    idle = IdleController(idle_after_s=0.1, idle_fps=20.0)
+    det  = GestureDetector(frame_width=64, frame_height=48, idle=idle)
+    cap, lm = _FakeCapture(), _FakeLandmarker()
+    det._cap, det._landmarker = cap, lm
+    det._mp_image = (lambda image_format, data: data, SimpleNamespace(SRGB=0))
+
+    det.start()
+    try:
+        deadline = time.monotonic() + 2.0
+        while not cap.settings and time.monotonic() < deadline:     # set after the flip
+            time.sleep(0.01)
+        assert idle.idle
+        assert cap.settings[-3:] == [(cv2.CAP_PROP_FRAME_WIDTH, 320),
+                                     (cv2.CAP_PROP_FRAME_HEIGHT, 240),
+                                     (cv2.CAP_PROP_FPS, 20.0)]
+        before = cap.reads
+        time.sleep(0.5)
+        assert cap.reads - before <= 12                   # ~20 fps, not free-running
+
+        lm.hand.set()
+        deadline = time.monotonic() + 2.0
+        while not (idle.periods and idle.periods[-1].wake_latency is not None) \
+                and time.monotonic() < deadline:
+            time.sleep(0.005)
+    finally:
+        det.stop()
+
+    assert not idle.idle
+    assert cap.settings[-1] == (cv2.CAP_PROP_FPS, 60)
+    period = idle.periods[-1]
+    assert period.wake_latency < 0.1
+    assert period.bound == pytest.approx(0.05 + period.wake_latency)
+    assert det.queue.qsize() > 0
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. Driver back-off
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_driver_sleeps_its_timers_while_idle(null_driver):
+    drv = null_driver()
+    drv.send("MOUSE_MOVE 10 10", "POWER IDLE")
+    time.sleep(1.5)
+    drv.send("POWER ACTIVE", "MOUSE_MOVE 20 20")
+    err = drv.finish()
+
+    m = re.search(r"Idle for ([\d.]+) s: ([\d.]+)% CPU, ([\d.]+) wakeups/s", err)
+    assert m, err
+    assert float(m.group(1)) == pytest.approx(1.5, abs=0.3)
+    assert float(m.group(3)) < 20, err                  # ~200/s when active
@@ -0,0 +1,77 @@
+"""
+test_inertia.py
+Flick inertia: GestureMapper letting go of the cursor (MOUSE_RELEASE) when
+pointing ends or the hand is lost, and the driver coasting a flicked cursor
+and stopping it on new input end to end (HID_DRIVER_SINK=null, read back
+from a flight recorder dump).
+"""
+
+import time
+
+import pytest
+
+from src.clock import SimulatedClock
+from src.vision.gesture_mapper import CONFIRM_FRAMES, GestureMapper
+from tests.conftest import fist, map_all, pointing
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Mapper
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestRelease:
+
+    def test_lost_hand_releases_the_cursor_once(self):
+        m = GestureMapper(clock=SimulatedClock())
+        cmds = map_all(m, [pointing(0.3 + 0.05 * i) for i in range(CONFIRM_FRAMES + 2)])
+        assert cmds and all(c.startswith("MOUSE_MOVE") for c in cmds)
+        assert m.lost() == ["MOUSE_RELEASE"]
+        assert m.lost() == []
+
+    def test_a_gesture_that_does_not_track_releases_first(self):
+        m = GestureMapper(clock=SimulatedClock())
+        map_all(m, [pointing()] * CONFIRM_FRAMES)
+        cmds = map_all(m, [fist()] * CONFIRM_FRAMES)
+        assert cmds.count("MOUSE_RELEASE") == 1
+        assert cmds.index("MOUSE_RELEASE") < cmds.index("GAMEPAD_BTN A 1")
+
+    def test_nothing_to_release_without_pointing(self):
+        m = GestureMapper(clock=SimulatedClock())
+        assert m.lost() == []
+        assert "MOUSE_RELEASE" not in map_all(m, [fist()] * CONFIRM_FRAMES) + m.lost()
+
+    def test_pointing_again_after_a_loss_tracks_again(self):
+        m = GestureMapper(clock=SimulatedClock())
+        map_all(m, [pointing()] * CONFIRM_FRAMES)
+        m.lost()
+        assert m.map(pointing(0.6))[0].startswith("MOUSE_MOVE")
+        assert m.lost() == ["MOUSE_RELEASE"]
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Driver coast
+# ─────────────────────────────────────────────────────────────────────────────
+
+@pytest.mark.parametrize("cancel", [False, True])
+def test_driver_coasts_a_flick_until_new_input(null_driver, cancel):
+    drv = null_driver(HID_DRIVER_INERTIA_FRICTION="4")
+    for x in (100, 130, 160, 190):                          # ~30 px per 10 ms = 3000 px/s
+        drv.send(f"MOUSE_MOVE {x} 500")
+        time.sleep(0.01)
+    drv.send("MOUSE_RELEASE")
+    time.sleep(0.05)
+    if cancel:
+        drv.send("MOUSE_MOVE 400 800")
+    time.sleep(0.3)
+    drv.finish()
+
+    xs = [e.value for e in drv.events(type=3, code=0)]     # ABS_X; only the mouse is used
+    assert xs[:4] == [100, 130, 160, 190], xs
+    coast = xs[4:]
+    # How far it coasts depends on wall-clock pacing; only the shape is checked
+    if cancel:
+        # Whatever coast there was, then the new position, then nothing.
+        assert coast and coast[-1] == 400, coast
+        assert all(190 < x < 400 for x in coast[:-1]) and coast[:-1] == sorted(coast[:-1]), coast
+    else:
+        assert coast and coast[0] > 190 and coast == sorted(coast), coast
@@ -0,0 +1,193 @@
+"""
+test_latency_slo.py
+Tail-latency SLO tests under CPU contention.
+
+Pipeline (landmark → emit)
+    A HandResult is stamped when it "arrives from the detector", goes
+    through GestureMapper.map(), the bounded command queue and the real
+    CommandWriter thread from main.py, and is written into a pipe.  A child
+    process standing in for hid_driver's stdin stamps each line when it
+    becomes readable.  Both stamps use CLOCK_MONOTONIC, so they compare
+    across processes.
+
+Driver (receive → emit)
+    Covered natively by tests/driver/test_latency_slo.cpp (run from
+    test_driver_native.py); the two halves add up to the end-to-end budget.
+
+CPU-hog processes spin on the same core as the pipeline for the whole run.
+Every latency sample plus p50 / p99 / p99.9 is written to
+$GESTURELINK_RESULTS_DIR (default results/) as latency_slo_pipeline.json in
+the bench/results.py schema, for trend comparison with bench/compare.py.
+The realistic scenario's p99 is held to the README's "sub-15 ms" claim; the
+worst-case flood only has to degrade gracefully.  Override with GESTURELINK_SLO_<SCENARIO>_P99_MS / _P999_MS.
+"""
+
+import multiprocessing
+import os
+import queue
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+import pytest
+
+from tests.conftest import make_hand, INDEX_TIP, INDEX_PIP, INDEX_MCP
+from src.vision.gesture_mapper import GestureMapper
+from main import CommandWriter
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "bench"))
+import results  # noqa: E402
+
+HOG_PROCESSES = 2
+
+# Scenario name → (landmark fps, duration s, default p99 SLO ms, default p99.9 SLO ms)
+SCENARIOS = {
+    "realistic": (60,  4.0, 15.0, 25.0),    # camera rate
+    "worst":     (500, 2.0, 25.0, 50.0),    # far beyond any camera
+}
+
+
+def _slo_ms(scenario: str, quantile: str, default: float) -> float:
+    return float(os.environ.get(f"GESTURELINK_SLO_{scenario.upper()}_{quantile}_MS", default))
+
+
+# Child process standing in for hid_driver: stamp each line on arrival.
+_SINK_SCRIPT = r"""
+import sys, time
+print("ready", flush=True)
+out = []
+for line in sys.stdin:
+    out.append(f"{time.monotonic_ns()} {line.rstrip()}")
+sys.stdout.write("\n".join(out))
+"""
+
+
+def _hog(stop) -> None:
+    x = 0
+    while not stop.is_set():
+        x += 1
+
+
+def _percentile(values, q):
+    s = sorted(values)
+    return s[min(len(s) - 1, int(q * len(s)))]
+
+
+def _pointer_hand(nx: float):
+    return make_hand({
+        INDEX_TIP: (nx, 0.40, 0.0),
+        INDEX_PIP: (nx, 0.45, 0.0),
+        INDEX_MCP: (nx, 0.50, 0.0),
+    })
+
+
+def _run_scenario(fps: int, seconds: float) -> dict:
+    # A very wide virtual screen makes every smoothed MOUSE_MOVE unique, so
+    # each emitted line maps back to the landmark frame that produced it.
+    mapper = GestureMapper(screen_w=10_000_000, screen_h=1080)
+    cmd_q: queue.Queue = queue.Queue(maxsize=32)
+
+    sink = subprocess.Popen(
+        [sys.executable, "-c", _SINK_SCRIPT],
+        stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+    )
+    sink.stdout.readline()      # don't time the interpreter start-up
+    writer = CommandWriter(cmd_q, sink)
+    writer.start()
+
+    sent = {}
+    frames = int(fps * seconds)
+    period = 1.0 / fps
+    next_t = time.monotonic()
+    for i in range(frames):
+        next_t += period
+        delay = next_t - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        hand = _pointer_hand(0.05 + 0.9 * i / frames)
+        t_landmark = time.monotonic_ns()
+        for c in mapper.map(hand):
+            sent.setdefault(c, t_landmark)
+            try:
+                cmd_q.put_nowait(c)
+            except queue.Full:
+                pass   # main.py drops too; dropped frames are not sampled
+
+    deadline = time.monotonic() + 2.0
+    while not cmd_q.empty() and time.monotonic() < deadline:
+        time.sleep(0.01)
+    writer.stop()
+    writer.join(timeout=1.0)
+    out, _ = sink.communicate(timeout=5.0)
+
+    lat_ms = []
+    for row in out.decode().splitlines():
+        t_ns, cmd = row.split(" ", 1)
+        if cmd in sent:
+            lat_ms.append((int(t_ns) - sent[cmd]) / 1e6)
+    if not lat_ms:
+        return {"rate_hz": fps, "samples": 0}
+
+    return {
+        "rate_hz": fps,
+        "lat_ms":  lat_ms,
+        "samples": len(lat_ms),
+        "p50_ms":  _percentile(lat_ms, 0.50),
+        "p99_ms":  _percentile(lat_ms, 0.99),
+        "p999_ms": _percentile(lat_ms, 0.999),
+        "max_ms":  max(lat_ms),
+    }
+
+
+@pytest.fixture()
+def cpu_contention():
+    """Pin this process to one core and spin hog processes on it."""
+    old_affinity = os.sched_getaffinity(0)
+    cpu = min(old_affinity)
+    os.sched_setaffinity(0, {cpu})
+    ctx  = multiprocessing.get_context("fork")
+    stop = ctx.Event()
+    hogs = [ctx.Process(target=_hog, args=(stop,), daemon=True)
+            for _ in range(HOG_PROCESSES)]
+    for h in hogs:
+        h.start()
+    try:
+        yield cpu
+    finally:
+        stop.set()
+        for h in hogs:
+            h.join(timeout=2.0)
+            if h.is_alive():
+                h.terminate()
+        os.sched_setaffinity(0, old_affinity)
+
+
+def test_landmark_to_emit_latency_under_contention(cpu_contention):
+    outcome = {}
+    for name, (fps, secs, p99, p999) in SCENARIOS.items():
+        outcome[name] = _run_scenario(fps, secs)
+        outcome[name]["slo_ms"] = {
+            "p99":  _slo_ms(name, "P99", p99),
+            "p999": _slo_ms(name, "P999", p999),
+        }
+
+    results.write("latency_slo_pipeline", [
+        results.benchmark(
+            f"landmark_to_driver_stdin/{name}", "ms", r.get("lat_ms", []),
+            hog_processes=HOG_PROCESSES,
+            slo_p99_ms=r["slo_ms"]["p99"], slo_p999_ms=r["slo_ms"]["p999"],
+            **{k: v for k, v in r.items() if k not in ("lat_ms", "slo_ms", "samples")},
+        )
+        for name, r in outcome.items()
+    ])
+
+    for name, r in outcome.items():
+        assert r["samples"] > 0, f"{name}: no samples collected"
+        slo = r["slo_ms"]
+        assert r["p99_ms"] <= slo["p99"], (
+            f"{name}: p99 {r['p99_ms']:.2f} ms exceeds SLO {slo['p99']} ms"
+        )
+        assert r["p999_ms"] <= slo["p999"], (
+            f"{name}: p99.9 {r['p999_ms']:.2f} ms exceeds SLO {slo['p999']} ms"
+        )
@@ -0,0 +1,69 @@
+"""
+test_macro.py
+Driver macros end to end (HID_DRIVER_SINK=null, read back from a flight
+recorder dump): a MACRO line plays its compiled frames in order and never
+ahead of their defined times, MACRO_STOP releases what a cancelled macro
+holds, and a bad macro file stops the driver at startup with the offending
+line number.  Exact frame times are checked on a SimulatedClock by
+tests/driver/test_macro.cpp; wall-clock bounds here are loose on purpose.
+"""
+
+import subprocess
+import time
+
+BTN_SOUTH = 0x130
+BTN_TL = 0x136
+ABS_X = 0
+
+MACROS = """\
+# down, down-forward, forward + A
+[hadouken]
+0    GAMEPAD_STICK 0 32767
+40   GAMEPAD_STICK 23170 23170
+80   GAMEPAD_STICK 32767 0
+80   GAMEPAD_BTN A 1
+130  GAMEPAD_BTN A 0
+130  GAMEPAD_STICK 0 0
+
+[guard]
+0    GAMEPAD_BTN LB 1
+5000 GAMEPAD_BTN LB 0
+"""
+
+
+def test_macro_plays_at_its_defined_times(null_driver, tmp_path):
+    macros = tmp_path / "combos.conf"
+    macros.write_text(MACROS)
+    drv = null_driver(HID_DRIVER_MACROS=str(macros))
+    drv.send("MACRO hadouken", "MACRO guard")
+    time.sleep(0.3)
+    drv.send("MACRO_STOP guard")
+    time.sleep(0.1)
+    err = drv.finish()
+    assert "Macros: 2 from" in err
+
+    frames = [e.t_ns for e in drv.events(type=0)]
+    xs = [(e.t_ns, e.value) for e in drv.events(type=3, code=ABS_X)]
+    assert [v for _, v in xs] == [0, 23170, 32767, 0], xs
+    start = xs[0][0]
+    offsets = [(t - start) / 1e6 for t, _ in xs]
+    assert offsets == sorted(offsets), offsets
+    for got, want in zip(offsets, [0, 40, 80, 130]):
+        # At most Macro::kSlackNs (1 ms) early; a loaded machine may run late
+        assert want - 1.5 <= got <= want + 50.0, offsets
+    a = [(e.t_ns, e.value) for e in drv.events(type=1, code=BTN_SOUTH)]
+    assert [v for _, v in a] == [1, 0] and abs(a[0][0] - xs[2][0]) < 100_000, a   # same frame as the stick
+    lb = [e.value for e in drv.events(type=1, code=BTN_TL)]
+    assert lb == [1, 0], lb                                  # released by MACRO_STOP, not at 5 s
+    assert len(frames) >= 6
+
+
+def test_bad_macro_file_stops_the_driver(driver_bin, tmp_path):
+    macros = tmp_path / "bad.conf"
+    macros.write_text("[combo]\n0 GAMEPAD_BTN A 1\n50 GAMEPAD_BTN Z 1\n")
+    proc = subprocess.run([str(driver_bin)], input=b"QUIT\n", capture_output=True, timeout=5,
+                          env={"HID_DRIVER_SINK": "null", "HID_DRIVER_MACROS": str(macros)})
+    err = proc.stderr.decode()
+    assert proc.returncode == 1, err
+    assert f"{macros}: line 3: unknown gamepad button 'Z'" in err
+    assert "Ready" not in err
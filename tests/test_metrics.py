@@ -0,0 +1,124 @@
+"""
+test_metrics.py
+Tests for the pipeline metrics exporter (src/metrics.py): per-thread shard
+aggregation, Prometheus text rendering and serving over loopback HTTP and
+a Unix socket.  The driver's exporter is covered by tests/driver/test_metrics.cpp.
+"""
+
+import os
+import socket
+import threading
+import urllib.request
+
+import pytest
+
+from src import metrics
+
+
+@pytest.fixture
+def registry():
+    return metrics.Registry()
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Sharding and rendering
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestRendering:
+
+    def test_counter_sums_all_thread_shards(self, registry):
+        c = metrics.counter("t_commands_total", "help", registry=registry)
+
+        def work():
+            for _ in range(10_000):
+                c.inc(command="MOUSE_MOVE")
+
+        threads = [threading.Thread(target=work) for _ in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        c.inc(3, command="MOUSE_LEFT")
+
+        assert c.value(command="MOUSE_MOVE") == 40_000
+        text = registry.render()
+        assert '# TYPE t_commands_total counter' in text
+        assert 't_commands_total{command="MOUSE_MOVE"} 40000\n' in text
+        assert 't_commands_total{command="MOUSE_LEFT"} 3\n' in text
+
+    def test_histogram_buckets_are_cumulative(self, registry):
+        h = metrics.histogram("t_latency_seconds", "help", buckets=(0.001, 0.01), registry=registry)
+        for v in (0.0005, 0.005, 0.005, 2.0):
+            h.observe(v)
+        text = registry.render()
+        assert 't_latency_seconds_bucket{le="0.001"} 1\n' in text
+        assert 't_latency_seconds_bucket{le="0.01"} 3\n' in text
+        assert 't_latency_seconds_bucket{le="+Inf"} 4\n' in text
+        assert "t_latency_seconds_count 4\n" in text
+        assert "t_latency_seconds_sum 2.0105\n" in text
+
+    def test_gauge_callbacks_evaluated_at_scrape(self, registry):
+        g = metrics.gauge("t_queue_depth", "help", registry=registry)
+        depth = [5]
+        g.set_function(lambda: depth[0], queue="command")
+        g.set_function(lambda: 1 / 0, queue="broken")      # must not break the scrape
+        assert 't_queue_depth{queue="command"} 5\n' in registry.render()
+        depth[0] = 7
+        assert 't_queue_depth{queue="command"} 7\n' in registry.render()
+
+    def test_label_values_are_escaped(self, registry):
+        c = metrics.counter("t_escape_total", "help", registry=registry)
+        c.inc(v='a"b\\c')
+        assert 't_escape_total{v="a\\"b\\\\c"} 1\n' in registry.render()
+
+    def test_thread_cpu_uses_python_thread_names(self):
+        text = "\n".join(metrics.ThreadCpu().samples())
+        assert 'thread="MainThread",mode="user"' in text
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Exporter
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestExporter:
+
+    def test_loopback_http(self, registry):
+        metrics.counter("t_up_total", "help", registry=registry).inc()
+        exp = metrics.serve("127.0.0.1:0", registry=registry)
+        try:
+            host, port = exp.address
+            with urllib.request.urlopen(f"http://{host}:{port}/metrics", timeout=5) as r:
+                assert r.status == 200
+                assert r.headers["Content-Type"].startswith("text/plain; version=0.0.4")
+                assert "t_up_total 1\n" in r.read().decode()
+        finally:
+            exp.close()
+
+    def test_unix_socket(self, registry, tmp_path):
+        metrics.counter("t_up_total", "help", registry=registry).inc(2)
+        path = str(tmp_path / "m.sock")
+        exp = metrics.serve(f"unix:{path}", registry=registry)
+        try:
+            with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+                s.settimeout(5)
+                s.connect(path)
+                s.sendall(b"GET /metrics HTTP/1.0\r\n\r\n")
+                data = b""
+                while chunk := s.recv(4096):
+                    data += chunk
+            assert data.startswith(b"HTTP/1.0 200")
+            assert b"t_up_total 2\n" in data
+        finally:
+            exp.close()
+        assert not os.path.exists(path)
+
+    def test_unix_path_that_is_not_a_socket_is_kept(self, registry, tmp_path):
+        path = tmp_path / "notes.txt"
+        path.write_text("keep\n")
+        with pytest.raises(FileExistsError):
+            metrics.serve(f"unix:{path}", registry=registry)
+        assert path.read_text() == "keep\n"
+
+    def test_non_loopback_refused(self, registry):
+        with pytest.raises(ValueError):
+            metrics.serve("0.0.0.0:0", registry=registry)
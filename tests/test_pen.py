@@ -0,0 +1,122 @@
+"""
+test_pen.py
+Pen tablet mode: PenMapper's depth → pressure and orientation → tilt
+mapping, its contact latency against the driver's hysteresis thresholds,
+and the driver's glide ticks end to end (HID_DRIVER_SINK=null, read back
+from a flight recorder dump).
+"""
+
+import time
+
+import pytest
+
+from src.vision.pen_mapper import (PEN_DEPTH_FULL, PEN_DEPTH_HOVER, PEN_MAX_PRESSURE,
+                                   PEN_TILT_MAX, PenMapper, pen_pressure, pen_tilt)
+from tests.conftest import INDEX_MCP, INDEX_PIP, INDEX_TIP, make_hand
+
+# virtual_hid.h
+CONTACT_ON  = 410
+CONTACT_OFF = 205
+
+
+def _pen_hand(x=0.5, y=0.4, depth=0.0, lean=(0.0, 0.0)):
+    """Index finger extended upwards, tip pushed @depth ahead of the knuckle."""
+    return make_hand({
+        INDEX_TIP: (x, y, -depth),
+        INDEX_PIP: (x + lean[0], y + 0.05 + lean[1], -depth + 0.03),
+        INDEX_MCP: (x, y + 0.10, 0.0),
+    })
+
+
+def _fields(cmd):
+    name, x, y, p, tx, ty = cmd.split()
+    assert name == "PEN"
+    return float(x), float(y), int(p), int(tx), int(ty)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Features
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestFeatures:
+
+    def test_pressure_follows_depth_and_saturates(self):
+        mid = (PEN_DEPTH_HOVER + PEN_DEPTH_FULL) / 2
+        assert pen_pressure(_pen_hand(depth=0.0)) == 0.0
+        assert pen_pressure(_pen_hand(depth=mid)) == pytest.approx(0.5)
+        assert pen_pressure(_pen_hand(depth=PEN_DEPTH_FULL * 2)) == 1.0
+
+    def test_tilt_is_zero_pointing_at_the_camera_and_clamped(self):
+        assert pen_tilt(_pen_hand(lean=(0.0, -0.05))) == (0, 0)
+        tx, ty = pen_tilt(_pen_hand(lean=(0.03, -0.05)))
+        assert 0 < tx < PEN_TILT_MAX and ty == 0
+        assert pen_tilt(_pen_hand(lean=(-1.0, 1.0))) == (-PEN_TILT_MAX, PEN_TILT_MAX)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Mapper
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestPenMapper:
+
+    def test_fractional_position_from_the_first_frame(self):
+        m = PenMapper(1920, 1080)
+        (cmd,) = m.map(_pen_hand(x=0.1234, y=0.4321))
+        x, y, p, _, _ = _fields(cmd)
+        assert (x, y, p) == (pytest.approx(236.93, abs=0.01), pytest.approx(466.67, abs=0.01), 0)
+
+    def test_positions_stay_on_screen(self):
+        m = PenMapper(1920, 1080)
+        for x in (-0.5, 0.0, 1.0, 1.5):
+            px, py, *_ = _fields(m.map(_pen_hand(x=x, y=x))[0])
+            assert 0.0 <= px < 1920 and 0.0 <= py < 1080
+
+    def test_curled_finger_or_lost_hand_leaves_proximity_once(self):
+        m = PenMapper()
+        m.map(_pen_hand())
+        curled = make_hand({INDEX_TIP: (0.5, 0.7, 0.0), INDEX_PIP: (0.5, 0.6, 0.0),
+                            INDEX_MCP: (0.5, 0.55, 0.0)})
+        assert m.map(curled) == ["PEN OUT"]
+        assert m.map(curled) == [] and m.lost() == []
+        m.map(_pen_hand())
+        assert m.lost() == ["PEN OUT"] and m.lost() == []
+
+    def test_contact_latency_against_driver_hysteresis(self):
+        """A press step reaches contact on the next frame; release within two."""
+        m = PenMapper()
+        for _ in range(5):
+            m.map(_pen_hand(depth=0.0))
+        pressures = [_fields(m.map(_pen_hand(depth=PEN_DEPTH_FULL)).pop())[2] for _ in range(5)]
+        press_frames = next(i for i, p in enumerate(pressures) if p >= CONTACT_ON) + 1
+        pressures = [_fields(m.map(_pen_hand(depth=0.0)).pop())[2] for _ in range(5)]
+        release_frames = next(i for i, p in enumerate(pressures) if p < CONTACT_OFF) + 1
+        print(f"\n[pen] contact after {press_frames} frame(s), release after {release_frames}")
+        assert press_frames == 1
+        assert release_frames <= 2
+        assert pressures[-1] < 0.01 * PEN_MAX_PRESSURE
+
+    def test_full_press_reaches_full_pressure(self):
+        m = PenMapper()
+        for _ in range(30):
+            cmd = m.map(_pen_hand(depth=PEN_DEPTH_FULL))[0]
+        assert _fields(cmd)[2] == PEN_MAX_PRESSURE
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. Driver glide
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_driver_glides_between_samples_at_its_tick_rate(null_driver):
+    drv = null_driver(HID_DRIVER_PEN_TICK_US="4000")
+    drv.send("PEN 100 100 0 0 0")
+    time.sleep(0.03)                                       # one ~30 fps camera frame
+    drv.send("PEN 140 100 0 0 0")
+    time.sleep(0.2)
+    drv.finish()
+
+    xs = [e.value for e in drv.events(type=3, code=0)]     # ABS_X on the pen
+    assert xs[0] == 100 * 16 and xs[-1] == 140 * 16, xs
+    steps = xs[1:]
+    assert steps == sorted(steps) and len(set(steps)) == len(steps), xs
+    # ~30 ms / 4 ms ticks; generous bounds for a loaded host
+    assert 3 <= len(steps) <= 12, xs
@@ -0,0 +1,165 @@
+"""
+test_pointers.py
+Two-hand pointer mode: PointerMapper's per-hand ids, pinch hysteresis and
+releases, one POINTER line per frame, the detector publishing both hands of a
+frame as one HandFrame (and an empty one once they leave), and the driver
+writing each pointer to its own device end to end (HID_DRIVER_SINK=null, read
+back from a flight recorder dump).
+"""
+
+import queue
+import time
+from types import SimpleNamespace
+
+import numpy as np
+import pytest
+
+from main import map_result
+from src.vision.gesture_detector import GestureDetector
+from src.vision.gesture_mapper import PINCH_CLOSE_THRESHOLD, PINCH_OPEN_THRESHOLD
+from src.vision.pointer_mapper import PointerMapper
+from tests.conftest import INDEX_TIP, THUMB_TIP, make_hand
+
+
+def _hand(handedness, x=0.5, y=0.5, pinch=0.2):
+    """Index tip at (x, y), thumb tip @pinch to its left."""
+    return make_hand({INDEX_TIP: (x, y, 0.0), THUMB_TIP: (x - pinch, y, 0.0)}, handedness)
+
+
+def _items(cmds):
+    (cmd,) = cmds
+    name, *rest = cmd.split()
+    assert name == "POINTER"
+    out = []
+    while rest:
+        if rest[1] in ("DOWN", "UP"):
+            out.append((int(rest[0]), rest[1], rest[2]))
+        else:
+            out.append((int(rest[0]), int(rest[1]), int(rest[2])))
+        rest = rest[3:]
+    return out
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Mapper
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestPointerMapper:
+
+    def test_both_hands_in_one_line_by_handedness(self):
+        m = PointerMapper(1920, 1080)
+        items = _items(m.map_frame([_hand("Right", 0.75, 0.5), _hand("Left", 0.25, 0.5)]))
+        assert items == [(1, 1440, 540), (0, 480, 540)]
+
+    def test_positions_are_smoothed_and_stay_on_screen(self):
+        m = PointerMapper(1920, 1080)
+        m.map_frame([_hand("Left", 0.0, 0.0)])
+        assert _items(m.map_frame([_hand("Left", 1.0, 0.0)])) == [(0, 960, 0)]
+        for _ in range(20):
+            (item,) = _items(m.map_frame([_hand("Left", 1.5, 1.5)]))
+        assert item == (0, 1919, 1079)
+
+    def test_pinch_presses_with_hysteresis(self):
+        m = PointerMapper()
+        between = (PINCH_CLOSE_THRESHOLD + PINCH_OPEN_THRESHOLD) / 2
+        assert (1, "DOWN", "LEFT") in _items(m.map_frame([_hand("Right", pinch=0.01)]))
+        assert len(_items(m.map_frame([_hand("Right", pinch=between)]))) == 1
+        assert (1, "UP", "LEFT") in _items(m.map_frame([_hand("Right", pinch=0.2)]))
+
+    def test_each_hand_has_its_own_button(self):
+        m = PointerMapper()
+        items = _items(m.map_frame([_hand("Left", pinch=0.01), _hand("Right", pinch=0.2)]))
+        assert items == [(0, 960, 540), (0, "DOWN", "LEFT"), (1, 960, 540)]
+
+    def test_a_hand_leaving_releases_its_button_once(self):
+        m = PointerMapper()
+        m.map_frame([_hand("Left", pinch=0.01), _hand("Right", pinch=0.01)])
+        items = _items(m.map_frame([_hand("Right", pinch=0.01)]))
+        assert (0, "UP", "LEFT") in items
+        assert m.lost() == ["POINTER 1 UP LEFT"]
+        assert m.lost() == []
+
+    def test_unknown_handedness_is_ignored(self):
+        assert PointerMapper().map_frame([_hand("Unknown")]) == []
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Detector frames
+# ─────────────────────────────────────────────────────────────────────────────
+
+class _TwoHandCamera:
+    """Capture and landmarker stand-in: both hands in view while @in_view."""
+
+    def __init__(self, in_view=True) -> None:
+        self.in_view = in_view
+
+    def read(self):
+        time.sleep(0.002)
+        return True, np.zeros((48, 64, 3), dtype=np.uint8)
+
+    def set(self, prop, value):
+        pass
+
+    def release(self):
+        pass
+
+    def detect_for_video(self, image, ts_ms):
+        lms = [[SimpleNamespace(x=x, y=0.5, z=0.0)] * 21 for x in (0.75, 0.25) if self.in_view]
+        labels = [[SimpleNamespace(category_name=h)] for h in ("Right", "Left")][:len(lms)]
+        return SimpleNamespace(hand_landmarks=lms, handedness=labels)
+
+    def close(self):
+        pass
+
+
+def _detect(in_view, count=5):
+    det = GestureDetector(max_hands=2, frame_width=64, frame_height=48,
+                          output_queue=queue.Queue(maxsize=64))
+    det._cap = det._landmarker = _TwoHandCamera(in_view)
+    det._mp_image = (lambda image_format, data: data, SimpleNamespace(SRGB=0))
+    det.start()
+    try:
+        return [det.queue.get(timeout=2.0) for _ in range(count)]
+    finally:
+        det.stop()
+
+
+def test_detector_publishes_both_hands_as_one_frame():
+    frames = _detect(in_view=True)
+
+    assert [len(f.hands) for f in frames] == [2] * 5
+    assert [f.frame_id for f in frames] == list(range(frames[0].frame_id, frames[0].frame_id + 5))
+    m = PointerMapper(1920, 1080)
+    for f in frames:
+        items = _items(m.map_frame(f.hands))
+        assert {i[0] for i in items} == {0, 1}
+        assert not any(i[1] == "UP" for i in items)       # neither pointer flaps
+
+
+def test_detector_reports_a_lost_hand_with_an_empty_frame():
+    frames = _detect(in_view=False)
+    assert [f.hands for f in frames] == [[]] * 5
+    m = PointerMapper()
+    m.map_frame([_hand("Left", pinch=0.01)])
+    assert map_result(frames[0], m, None, pointers=True) == ["POINTER 0 UP LEFT"]
+    assert map_result(None, m, None, pointers=True) == []
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. Driver
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_driver_writes_each_pointer_to_its_own_device(null_driver):
+    drv = null_driver(HID_DRIVER_POINTERS="2")
+    drv.send("POINTER 0 100 200 1 1500 600", "POINTER 1 1510 600 1 DOWN LEFT", "POINTER 2 5 5")
+    err = drv.finish()
+
+    by_fd = {}
+    for e in drv.events():
+        by_fd.setdefault(e.fd, []).append((e.type, e.code, e.value))
+    assert len(by_fd) == 2, by_fd
+    first, second = (by_fd[fd] for fd in sorted(by_fd))
+    assert first == [(3, 0, 100), (3, 1, 200), (0, 0, 0)]
+    assert second == [(3, 0, 1500), (3, 1, 600), (0, 0, 0),
+                      (3, 0, 1510), (1, 272, 1), (0, 0, 0)]
+    assert "Unknown command" not in err
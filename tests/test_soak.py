@@ -0,0 +1,110 @@
+"""
+test_soak.py
+Growth detection of the soak harness (bench/soak.py) on synthetic series,
+plus a short end-to-end soak through mapper, writer and the driver's null
+sink.  Real soaks run for hours: python3 bench/soak.py --duration 4h
+"""
+
+import math
+import random
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "bench"))
+import soak  # noqa: E402
+
+TS = [i * 10.0 for i in range(360)]          # one hour at 10 s
+
+
+def _verdict(values, abs_tol=1024, rel_tol=0.0):
+    return soak.analyse(TS, values, abs_tol, rel_tol)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Growth detection
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestGrowthDetection:
+
+    def test_flat_noisy_series_passes(self):
+        rng = random.Random(1)
+        assert not _verdict([50_000 + rng.uniform(-300, 300) for _ in TS])["leak"]
+
+    def test_steady_leak_fails(self):
+        rng = random.Random(2)
+        v = _verdict([50_000 + 10 * i + rng.uniform(-300, 300) for i in range(len(TS))])
+        assert v["leak"]
+        assert v["slope_per_hour"] == pytest.approx(3600, rel=0.1)    # 10 kB per 10 s
+
+    def test_warmup_step_passes(self):
+        """Caches filling early (then flat) are not a leak."""
+        assert not _verdict([40_000 + min(i, 40) * 200 for i in range(len(TS))])["leak"]
+
+    def test_gc_sawtooth_passes(self):
+        assert not _verdict([50_000 + (i % 30) * 150 for i in range(len(TS))])["leak"]
+
+    def test_slow_leak_below_tolerance_passes(self):
+        assert not _verdict([50_000 + i for i in range(len(TS))], abs_tol=1024)["leak"]
+
+    def test_single_fd_leak_fails(self):
+        fds = [5 + i // 60 for i in range(len(TS))]                   # +1 fd every 10 min
+        assert soak.analyse(TS, fds, 0, 0.0)["leak"]
+
+    def test_constant_series_has_zero_rho(self):
+        assert soak.spearman(TS, [7] * len(TS)) == 0.0
+        assert math.isclose(soak.spearman(TS, TS), 1.0)
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Traffic
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestTraffic:
+
+    def test_trace_round_trips(self, tmp_path):
+        trace = soak.synthetic_trace()
+        soak.save_trace(trace, tmp_path / "t.jsonl")
+        assert soak.load_trace(tmp_path / "t.jsonl") == trace
+
+    def test_synthetic_trace_exercises_every_command(self):
+        from src.vision.gesture_detector import HandResult, Landmark
+        from src.vision.gesture_mapper import GestureMapper
+        from src.clock import SimulatedClock
+
+        clock, seen = SimulatedClock(), set()
+        mapper = GestureMapper(clock=clock)
+        for e in soak.synthetic_trace():
+            clock.advance(e["dt"])
+            if "lm" in e:
+                hand = HandResult([Landmark(*p) for p in e["lm"]], "Right")
+                seen.update(c.split()[0] + (" " + c.split()[1] if c.startswith("GAMEPAD_BTN") else "")
+                            for c in mapper.map(hand))
+        assert {"MOUSE_MOVE", "MOUSE_LEFT", "MOUSE_RIGHT", "MOUSE_SCROLL",
+                "GAMEPAD_BTN A", "GAMEPAD_BTN START", "GAMEPAD_STICK"} <= seen
+
+    def test_recorded_command_trace_is_current(self):
+        # The PGO training trace must match what the mapper emits today;
+        # regenerate with: python3 bench/soak.py --commands bench/traces/driver_commands.txt
+        path = Path(__file__).parent.parent / "bench" / "traces" / "driver_commands.txt"
+        lines = [l for l in path.read_text().splitlines() if not l.startswith("#")]
+        assert lines == soak.command_stream(soak.synthetic_trace())
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 3. End-to-end
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_short_soak_through_driver(driver_bin, tmp_path):
+    rc = soak.main(["--duration", "4", "--interval", "0.2", "--speed", "2",
+                    "--driver-bin", str(driver_bin),
+                    "--json", str(tmp_path / "soak.json"), "--csv", str(tmp_path / "soak.csv")])
+    assert rc == 0
+
+    rows = (tmp_path / "soak.csv").read_text().splitlines()
+    assert len(rows) >= 15
+    header = rows[0].split(",")
+    last   = dict(zip(header, rows[-1].split(",")))
+    assert int(last["frames"]) > 0 and int(last["commands"]) > 0
+    assert int(last["drv_threads"]) >= 1 and int(last["drv_fds"]) >= 3
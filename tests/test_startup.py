@@ -0,0 +1,121 @@
+"""
+test_startup.py
+Startup timeline, concurrent warm start and the driver readiness handshake.
+
+MediaPipe and a camera are not needed: warm start is exercised with a
+stand-in detector whose phases just sleep, against the real hid_driver in
+its null-sink mode.
+"""
+
+import argparse
+import json
+import threading
+import time
+
+import pytest
+
+from src.startup import StartupTimeline, process_age, run_concurrently
+from src.vision.gesture_detector import GestureDetector
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 1. Timeline
+# ─────────────────────────────────────────────────────────────────────────────
+
+class TestTimeline:
+
+    def test_origin_is_process_launch(self):
+        assert process_age() > 0
+        assert StartupTimeline().now() >= process_age() - 0.01
+
+    def test_phases_marks_and_report(self, tmp_path):
+        tl = StartupTimeline(age=0.0)
+        with tl.phase("camera_open"):
+            time.sleep(0.02)
+        tl.add("driver_start", 0.030, 0.040, "hid_driver", "mouse 1.0 ms, gamepad 1.0 ms")
+        assert tl.mark("ready") and not tl.mark("ready")       # first occurrence wins
+
+        cam = next(p for p in tl.phases if p.name == "camera_open")
+        assert cam.thread == threading.current_thread().name
+        assert cam.duration >= 0.02
+
+        report = tl.report()
+        assert "camera_open" in report and "mouse 1.0 ms" in report and "ready" in report
+
+        doc = json.loads(tl.write(tmp_path / "startup.json").read_text())
+        assert [p["name"] for p in doc["phases"]] == ["camera_open", "driver_start"]
+        assert doc["marks_ms"]["ready"] >= doc["phases"][0]["duration_ms"]
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Concurrent warm start
+# ─────────────────────────────────────────────────────────────────────────────
+
+class _FakeDetector:
+    """Same warm-start surface as GestureDetector; each phase takes 0.2 s."""
+
+    def __init__(self, fail: bool = False) -> None:
+        self.fail = fail
+
+    def warm_up(self) -> None:
+        time.sleep(0.2)
+        if self.fail:
+            raise RuntimeError("model missing")
+
+    def open_camera(self) -> None:
+        time.sleep(0.2)
+
+
+def _args(driver_bin=None) -> argparse.Namespace:
+    return argparse.Namespace(no_driver=driver_bin is None, driver_bin=str(driver_bin),
+                              width=1920, height=1080, inertia=0.0)
+
+
+class TestWarmStart:
+
+    def test_run_concurrently_overlaps_tasks(self):
+        tl = StartupTimeline(age=0.0)
+        t0 = time.monotonic()
+        out = run_concurrently({n: (lambda n=n: time.sleep(0.2) or n) for n in "abc"}, tl)
+        assert time.monotonic() - t0 < 0.45
+        assert out == {"a": "a", "b": "b", "c": "c"}
+        assert {p.thread for p in tl.phases} == {"Warm-a", "Warm-b", "Warm-c"}
+
+    def test_run_concurrently_reraises_after_all_finish(self):
+        done = []
+
+        def slow():
+            time.sleep(0.1)
+            done.append(1)
+
+        with pytest.raises(ValueError):
+            run_concurrently({"bad": lambda: int("x"), "slow": slow})
+        assert done == [1]
+
+    def test_timestamps_strictly_increase(self):
+        det = GestureDetector()
+        ts = [det._next_ts_ms() for _ in range(1000)]
+        assert all(b > a for a, b in zip(ts, ts[1:]))
+
+    def test_warm_start_brings_everything_up_concurrently(self, driver_bin, monkeypatch):
+        import main
+        monkeypatch.setenv("HID_DRIVER_SINK", "null")
+        tl = StartupTimeline(age=0.0)
+        t0 = time.monotonic()
+        proc = main.warm_start(_args(driver_bin), _FakeDetector(), tl)
+        elapsed = time.monotonic() - t0
+        try:
+            assert proc is not None and proc.poll() is None
+            names = {p.name for p in tl.phases}
+            assert {"landmarker", "camera", "driver", "driver_start"} <= names
+            assert elapsed < 0.35, f"phases ran serially ({elapsed:.2f} s)"
+            drv = next(p for p in tl.phases if p.name == "driver_start")
+            assert "mouse" in drv.detail and "gamepad" in drv.detail
+        finally:
+            proc.stdin.write(b"QUIT\n")
+            proc.stdin.close()
+            assert proc.wait(timeout=5) == 0
+
+    def test_warm_start_failure_exits(self):
+        import main
+        with pytest.raises(SystemExit):
+            main.warm_start(_args(), _FakeDetector(fail=True), StartupTimeline(age=0.0))
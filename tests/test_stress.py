@@ -66,6 +66,7 @@ class TestMapperStress:
             "MOUSE_LEFT":    1,
             "MOUSE_RIGHT":   1,
             "MOUSE_SCROLL":  2,
+            "MOUSE_RELEASE": 1,
             "GAMEPAD_BTN":   3,
             "GAMEPAD_STICK": 3,
         }
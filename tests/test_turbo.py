@@ -0,0 +1,64 @@
+"""
+test_turbo.py
+Gamepad autofire: GestureMapper sending GAMEPAD_TURBO for a held fist (and
+stopping it on release or a lost hand), and the driver pressing and releasing A
+end to end (HID_DRIVER_SINK=null, read back from a flight recorder dump;
+the exact rate is checked on a SimulatedClock by tests/driver/test_turbo.cpp).  Only an empty detector frame counts as a lost hand; a slow
+frame does not stop and restart autofire.
+"""
+
+import time
+
+from main import map_result
+from src.clock import SimulatedClock
+from src.vision.gesture_detector import HandFrame
+from src.vision.gesture_mapper import CONFIRM_FRAMES, TURBO_DUTY_PCT, GestureMapper
+from tests.conftest import fist, map_all, pointing
+
+BTN_SOUTH = 0x130
+
+
+class TestTurboMapping:
+
+    def test_fist_starts_and_stops_autofire_once(self):
+        m = GestureMapper(clock=SimulatedClock(), turbo_hz=15)
+        cmds = map_all(m, [fist()] * (CONFIRM_FRAMES + 5))
+        assert cmds == [f"GAMEPAD_TURBO A 15 {TURBO_DUTY_PCT}"]
+        assert "GAMEPAD_TURBO A 0" in map_all(m, [pointing()] * CONFIRM_FRAMES)
+
+    def test_lost_hand_stops_autofire(self):
+        m = GestureMapper(clock=SimulatedClock(), turbo_hz=15)
+        map_all(m, [fist()] * CONFIRM_FRAMES)
+        assert m.lost() == ["GAMEPAD_TURBO A 0"]
+        assert m.lost() == []
+
+    def test_only_an_empty_frame_stops_autofire(self):
+        m = GestureMapper(clock=SimulatedClock(), turbo_hz=15)
+        map_all(m, [fist()] * CONFIRM_FRAMES)
+        assert map_result(None, m, None, pointers=False) == []          # queue timeout
+        assert map_result(HandFrame(1, [fist()]), m, None, pointers=False) == []
+        assert map_result(HandFrame(2, []), m, None, pointers=False) == ["GAMEPAD_TURBO A 0"]
+
+    def test_without_turbo_the_fist_holds_a(self):
+        m = GestureMapper(clock=SimulatedClock())
+        assert map_all(m, [fist()] * CONFIRM_FRAMES) == ["GAMEPAD_BTN A 1"]
+        assert m.lost() == []
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# 2. Driver
+# ─────────────────────────────────────────────────────────────────────────────
+
+def test_driver_autofires_until_stopped(null_driver):
+    drv = null_driver()
+    drv.send("GAMEPAD_TURBO A 20 50")
+    time.sleep(0.5)
+    drv.send("GAMEPAD_TURBO A 0")
+    drv.finish()
+
+    # Only press/release pairs in order, and at least a few of them
+    edges = [(e.t_ns, e.value) for e in drv.events(type=1, code=BTN_SOUTH)]
+    presses = [t for t, v in edges if v == 1]
+    assert len(presses) >= 3, edges                        # ~10 at 20 Hz for 0.5 s
+    assert [v for _, v in edges] == [1, 0] * len(presses), edges
+    assert [t for t, _ in edges] == sorted(t for t, _ in edges), edges